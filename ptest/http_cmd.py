@@ -133,7 +133,7 @@ def create_radio_session_endpoint(radio_session, queue):
             vals.append(field_val["value"])
 
          # Create a new uplink packet
-        success = uplink_console.create_uplink(fields, vals, http_uplink_sbd_name, http_uplink_json_name) and os.path.exists(http_uplink_sbd_name)
+        success = uplink_console.create_uplink(fields, vals, http_uplink_sbd_name) and os.path.exists(http_uplink_sbd_name)
         if not success:
             return "Unable to send telemetry"
 
@@ -230,7 +230,7 @@ class RadioSession(object):
                     json.dump(self.statefield_dict, telem_file)
 
         # Create an uplink packet
-        success = self.uplink_console.create_uplink(fields, vals, self.uplink_sbd_name, self.uplink_json_name) and os.path.exists(self.uplink_sbd_name)
+        success = self.uplink_console.create_uplink(fields, vals, self.uplink_sbd_name) and os.path.exists(self.uplink_sbd_name)
 
         if success:
             # Send the uplink to Iridium
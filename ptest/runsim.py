@@ -224,7 +224,7 @@ def main(args):
 
     parser.add_argument('-ni', '--no-interactive', dest='interactive', action='store_false', help='If provided, disables the interactive console.')
     parser.add_argument('-i', '--interactive', dest='interactive', action='store_true', help='If provided, enables the interactive console.')
-    parser.add_argument('--clean', dest='clean', action='store_true', help='Starts a fresh run if in HOOTL (deletes the EEPROM file.)')
+    parser.add_argument('--clean', dest='clean', action='store_true', help='Starts a fresh run if in HOOTL (deletes the EEPROM files.)')
     parser.set_defaults(interactive=True)
 
     log_dir = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'logs')
@@ -234,11 +234,12 @@ def main(args):
     args = parser.parse_args(args)
 
     if args.clean:
-        print("Removing EEPROM file due to user request.")
-        try: 
-            os.remove("eeprom.json")
-        except OSError:
-            pass
+        print("Removing EEPROM files due to user request.")
+        for eeprom_file in ["eeprom_leader.bin", "eeprom_follower.bin"]:
+            try:
+                os.remove(eeprom_file)
+            except OSError:
+                pass
 
     try:
         with open(args.conf, 'r') as config_file:
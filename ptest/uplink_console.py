@@ -1,4 +1,4 @@
-import json, pty, subprocess, serial, os
+import json, subprocess, os
 from .data_consumers import Logger
 from . import get_pio_asset
 
@@ -10,9 +10,8 @@ class UplinkConsole(object):
 
     def __init__(self, data_dir):
         uplink_producer_filepath = get_pio_asset("gsw_uplink_producer")
-        master_fd, slave_fd = pty.openpty()
-        self.uplink_producer = subprocess.Popen([uplink_producer_filepath], stdin=master_fd, stdout=master_fd)
-        self.uplink_console = serial.Serial(os.ttyname(slave_fd), 9600, timeout=1)
+        self.uplink_producer = subprocess.Popen([uplink_producer_filepath, "--server"],
+            stdin=subprocess.PIPE, stdout=subprocess.PIPE, universal_newlines=True, bufsize=1)
 
         self.logger = Logger("UplinkConsole", data_dir)
 
@@ -36,31 +35,26 @@ class UplinkConsole(object):
             if val == "false": return False
         return None
 
-    def create_uplink(self, fields, vals, filename, json_filename):
+    def create_uplink(self, fields, vals, filename):
         """
-        Puts fields and values in a JSON document and sends the JSON 
-        object to the uplink producer console. This results in the creation
-        of an SBD file with the given filename holding an uplink packet
+        Sends fields and values to the uplink producer, which is kept running
+        in server mode, and writes the packet it responds with to an SBD file
+        with the given filename.
         """
 
-        # Create a JSON file with all the fields and values
         telem_json={}
         for field, value in zip(fields, vals):
             if value is not None:
                 telem_json[field]=value
             else:
                 logline = "Failed:   " + json.dumps(telem_json) + "\n"
-                logline += f"Error:    Unable to add {field}: {value} to uplink JSON file"
+                logline += f"Error:    Unable to add {field}: {value} to uplink"
                 self.logger.put(logline)
                 return False
-        with open(json_filename, 'w') as telem_file:
-            json.dump(telem_json, telem_file)
 
-        # Write the JSON file into Uplink Producer - should result in the creation of an sbd file
-        # holding the uplink packet.
-        self.uplink_console.write((json_filename+"\n").encode())
-        self.uplink_console.write((str(filename)+"\n").encode())
-        response = json.loads(self.uplink_console.readline().rstrip())
+        # Send the JSON object to the Uplink Producer, which responds with the
+        # packet inline.
+        response = self.create_packet(telem_json)
 
         # Check that the uplink was successfully created
         if 'error' in response:
@@ -69,9 +63,41 @@ class UplinkConsole(object):
             self.logger.put(logline)
             return False
 
+        with open(filename, 'wb') as sbd_file:
+            sbd_file.write(bytes.fromhex(response['packet']))
+
         self.logger.put("Uplink:   " + json.dumps(telem_json))
         return True
 
+    def create_packet(self, telem_json):
+        """
+        Sends a dictionary of fields and values to the uplink producer and
+        returns its response, which contains either the hex-encoded uplink
+        packet under 'packet' or the reason for failure under 'error'.
+        """
+        return self._request(telem_json)
+
+    def create_packets(self, telem_json, groups=None):
+        """
+        Sends a dictionary of fields and values to the uplink producer, which
+        splits it over as few uplink packets as possible. Fields in the same
+        group are kept in the same packet. Returns the producer's response,
+        which contains the hex-encoded packets under 'packets' or the reason
+        for failure under 'error'.
+        """
+        return self._request({'fields': telem_json, 'groups': groups or []})
+
+    def _request(self, request):
+        try:
+            self.uplink_producer.stdin.write(json.dumps(request) + "\n")
+            self.uplink_producer.stdin.flush()
+            line = self.uplink_producer.stdout.readline()
+        except (BrokenPipeError, ValueError):
+            line = ""
+        if not line:
+            return {'error': 'Uplink producer is not running'}
+        return json.loads(line)
+
     def close(self):
         if not hasattr(self, "stopped"):
             self.stopped = False
@@ -79,6 +105,5 @@ class UplinkConsole(object):
         if self.stopped: return
 
         self.uplink_producer.kill()
-        self.uplink_console.close()
         self.logger.stop()
         self.stopped = True
@@ -80,13 +80,13 @@ class USBSession(object):
         self.logger = Logger(device_name, simulation_run_dir)
         self.raw_logger = Logger(device_name + "_raw", simulation_run_dir)
         self.telem_save_dir = simulation_run_dir
+        self.radio_stats = None
 
         downlink_parser_filepath = get_pio_asset("gsw_downlink_parser")
         master_fd, slave_fd = pty.openpty()
         self.downlink_parser = subprocess.Popen([downlink_parser_filepath], stdin=master_fd, stdout=master_fd)
         self.dp_console = serial.Serial(os.ttyname(slave_fd), 9600, timeout=1)
         self.telem_save_dir = simulation_run_dir
-        self.uplink_json_name = "uplink"+self.radio_imei+".http"
         self.uplink_sbd_name = "uplink"+self.radio_imei+".sbd"
 
         # Open a connection to elasticsearch
@@ -189,6 +189,13 @@ class USBSession(object):
                     for byte in telem_bytes:
                         telem_file.write(int(byte, 16).to_bytes(1, byteorder='big'))
                     telem_file.close()
+                elif 'radio_stats' in data:
+                    # Radio link statistics dumped by setting radio.dump_stats. They aren't the
+                    # response to a request, so they're only logged.
+                    self.radio_stats = data['radio_stats']
+                    logline = f"[{data['time']}] Received radio link statistics from spacecraft.\n"
+                    logline += json.dumps(data['radio_stats'])
+                    self.logger.put(logline, add_time = False)
                 elif 'uplink' in data:
                     if data['uplink'] and data['len']:
                         logline = f"[{data['time']}] Successfully sent telemetry to FlightSoftware.\n"
@@ -411,16 +418,14 @@ class USBSession(object):
         ]
         fields, vals = zip(*field_val_pairs)
 
-        success = self.uplink_console.create_uplink(fields, vals, self.uplink_sbd_name, self.uplink_json_name)
+        success = self.uplink_console.create_uplink(fields, vals, self.uplink_sbd_name)
 
         # If the uplink packet exists, send it to the FlightSoftware console
         if success and os.path.exists(self.uplink_sbd_name):
             success &= self.send_uplink(self.uplink_sbd_name)
             os.remove(self.uplink_sbd_name) 
-            os.remove(self.uplink_json_name) 
             return success
         else:
-            if os.path.exists(self.uplink_json_name): os.remove(self.uplink_json_name) 
             return False
 
     def parsetelem(self):
@@ -0,0 +1,115 @@
+//
+// src/characterization/ssa_test.cpp
+// adcs
+//
+// Pathfinder for Autonomous Navigation
+// Space Systems Design Studio
+// Cornell Univeristy
+//
+#include <adcs/constants.hpp>
+#include <adcs/ssa.hpp>
+#include <adcs/ssa_config.hpp>
+#include <adcs/utl/logging.hpp>
+#include <Arduino.h>
+#include <lin.hpp>
+using namespace adcs;
+// Sun vector least squares as it was solved before the normal equations, by a
+// QR decomposition of the illuminated sensors' normals.
+static unsigned char qr_sun_vector(lin::Matrix<float, 5, 4> const &voltages,
+    unsigned char functional, lin::Vector3f &sun_vec) {
+  lin::Matrixf<0, 3, 20, 3> A, Q;
+  lin::Vectorf<0, 20> b;
+  lin::Matrix<float, 3, 3> R;
+  lin::Vector3f x;
+  lin::size_t k = 0;
+  for (lin::size_t i = 0; i < 5; i++) {
+    if (!(functional & (1 << i))) continue;
+    for (lin::size_t j = 4 * i; j < 4 * i + 4; j++) {
+      if (voltages(j) > ssa::sensor_voltage_thresh) {
+        lin::row(A, k) = lin::row(ssa::normals, j);
+        b(k) = voltages(j);
+        k++;
+      }
+    }
+  }
+  if (k < ssa::sensor_count_thresh) return SSAMode::SSA_FAILURE;
+  b.resize(k, 1);
+  A.resize(k, 3);
+  lin::qr(A, Q, R);
+  lin::backward_sub(R, x, (lin::transpose(Q) * b).eval());
+  sun_vec = x / lin::norm(x);
+  return SSAMode::SSA_COMPLETE;
+}
+// Uniform random number in [-1, 1]
+static float rand_unit() { return ((float)random(-100000, 100001)) / 100000.0f; }
+// Angle between two unit vectors in degrees, accurate for small angles
+static float angle(lin::Vector3f const &a, lin::Vector3f const &b) {
+  lin::Vector3f const c({
+    a(1) * b(2) - a(2) * b(1), a(2) * b(0) - a(0) * b(2), a(0) * b(1) - a(1) * b(0)
+  });
+  float const d = a(0) * b(0) + a(1) * b(1) + a(2) * b(2);
+  return atan2f(lin::norm(c), d) * 180.0f / PI;
+}
+void setup() {
+  // We want to initialize the serial port even if logging is off.
+  LOG_SERIAL.begin(9600);
+  LOG_INFO_header
+  LOG_INFO_println("Logging interface initialized with logging level "
+      + String(LOG_LEVEL))
+  LOG_INFO_header
+  LOG_INFO_printlnF("Waiting for fifteen seconds before starting the test...")
+  delay(15000);
+  // Enable the cycle counter
+  ARM_DEMCR |= ARM_DEMCR_TRCENA;
+  ARM_DWT_CTRL |= ARM_DWT_CTRL_CYCCNTENA;
+}
+void loop() {
+  // Columns: noise (V), trials, mode mismatches, sun vectors found, mean and
+  // max angle between the two solvers (deg), mean and max angle of the normal
+  // equations to the true sun vector (deg), mean cycles of the normal
+  // equations and of QR
+  static float const noises[3] = {0.0f, 0.01f, 0.05f};
+  for (float noise : noises) {
+    unsigned int trials = 0, mismatches = 0, solved = 0;
+    float sum_diff = 0.0f, max_diff = 0.0f, sum_err = 0.0f, max_err = 0.0f;
+    unsigned long long ne_cycles = 0, qr_cycles = 0;
+    for (unsigned int t = 0; t < 1000; t++) {
+      // Random sun direction and voltages, with an ADC failed every tenth trial
+      lin::Vector3f s({rand_unit(), rand_unit(), rand_unit()});
+      if (lin::norm(s) < 0.1f) continue;
+      s = s / lin::norm(s);
+      lin::Matrix<float, 5, 4> voltages;
+      for (lin::size_t j = 0; j < 20; j++) {
+        float const v = ssa::max_voltage_rd * (ssa::normals(j, 0) * s(0)
+            + ssa::normals(j, 1) * s(1) + ssa::normals(j, 2) * s(2));
+        voltages(j) = (v > 0.0f ? v : 0.0f) + noise * rand_unit();
+      }
+      unsigned char const functional = (t % 10 == 0) ? (0x1F & ~(1 << (t / 10 % 5))) : 0x1F;
+      lin::Vector3f ne, qr;
+      unsigned int start = ARM_DWT_CYCCNT;
+      unsigned char const ne_mode = ssa::solve_sun_vector(voltages, functional, ne);
+      ne_cycles += ARM_DWT_CYCCNT - start;
+      start = ARM_DWT_CYCCNT;
+      unsigned char const qr_mode = qr_sun_vector(voltages, functional, qr);
+      qr_cycles += ARM_DWT_CYCCNT - start;
+      trials++;
+      if (ne_mode != qr_mode) {
+        mismatches++;
+        continue;
+      }
+      if (ne_mode != SSAMode::SSA_COMPLETE) continue;
+      solved++;
+      float const diff = angle(ne, qr), err = angle(ne, s);
+      sum_diff += diff;
+      sum_err += err;
+      if (diff > max_diff) max_diff = diff;
+      if (err > max_err) max_err = err;
+    }
+    LOG_SERIAL.printf("%.2f,%u,%u,%u,%.3e,%.3e,%.3e,%.3e,%u,%u", noise, trials,
+        mismatches, solved, sum_diff / solved, max_diff, sum_err / solved, max_err,
+        (unsigned int)(ne_cycles / trials), (unsigned int)(qr_cycles / trials));
+    LOG_SERIAL.println();
+  }
+  // Delay for 5 minutes
+  delay(5 * 60 * 1000);
+}
@@ -55,11 +55,10 @@ static void update_mag1(unsigned char mag1_mode, float mag_flt) {
   if (!mag1.read()) return;
 
   // Read in data and transform to the body frame
-  data = {
-    utl::fp(mag1.get_b_x(), min_mag1_rd_mag, max_mag1_rd_mag),
-    utl::fp(mag1.get_b_y(), min_mag1_rd_mag, max_mag1_rd_mag),
-    utl::fp(mag1.get_b_z(), min_mag1_rd_mag, max_mag1_rd_mag)
-  };
+  signed short const raw[3] = { mag1.get_b_x(), mag1.get_b_y(), mag1.get_b_z() };
+  float f[3];
+  utl::fp(raw, f, 3, min_mag1_rd_mag, max_mag1_rd_mag);
+  data = { f[0], f[1], f[2] };
   data = (mag1_to_body * data).eval();
 
   // Update the filtered magnetic field reading for magnetometer one
@@ -88,11 +87,10 @@ static void update_mag2(unsigned char mag2_mode, float mag_flt) {
   if (!mag2.read()) return;
 
   // Read in data and transform to the body frame
-  data = {
-    utl::fp(mag2.get_b_x(), min_mag2_rd_mag, max_mag2_rd_mag),
-    utl::fp(mag2.get_b_y(), min_mag2_rd_mag, max_mag2_rd_mag),
-    utl::fp(mag2.get_b_z(), min_mag2_rd_mag, max_mag2_rd_mag)
-  };
+  signed short const raw[3] = { mag2.get_b_x(), mag2.get_b_y(), mag2.get_b_z() };
+  float f[3];
+  utl::fp(raw, f, 3, min_mag2_rd_mag, max_mag2_rd_mag);
+  data = { f[0], f[1], f[2] };
   data = (mag2_to_body * data).eval();
 
   // Update the filtered magnetic field reading for magnetometer two
@@ -130,11 +128,12 @@ static void update_gyr(float gyr_flt, float gyr_temp_target, float gyr_temp_flt,
   if(!gyr.read()) goto HEATER;
 
   // Read in angular rate data and transform to the body frame
-  data = {
-    utl::fp(gyr.get_omega_x(), min_rd_omega, max_rd_omega),
-    utl::fp(gyr.get_omega_y(), min_rd_omega, max_rd_omega),
-    utl::fp(gyr.get_omega_z(), min_rd_omega, max_rd_omega)
-  };
+  {
+    signed short const raw[3] = { gyr.get_omega_x(), gyr.get_omega_y(), gyr.get_omega_z() };
+    float f[3];
+    utl::fp(raw, f, 3, min_rd_omega, max_rd_omega);
+    data = { f[0], f[1], f[2] };
+  }
   data = (gyr_to_body * data).eval();
 
   // Read in temperature data and filter
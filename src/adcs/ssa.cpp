@@ -20,6 +20,8 @@
 #include "ssa_config.hpp"
 #include "utl/logging.hpp"
 
+#include <array>
+
 namespace adcs {
 namespace ssa {
 
@@ -114,36 +116,70 @@ void update_sensors(float adc_flt) {
   LOG_TRACE_printlnF("Complete")
 }
 
-unsigned char calculate_sun_vector(lin::Vector3f &sun_vec) {
-  lin::Matrixf<0, 3, 20, 3> A, Q;
-  lin::Vectorf<0, 20> b;
-  lin::Matrix<float, 3, 3> R;
-  lin::Vector3f x;
-
-  // Prepare the least squares problem
-  lin::size_t k = 0;
+/** Upper triangles of n n^T for each sun sensor normal n, in the order xx, xy,
+ *  xz, yy, yz, zz. These are the blocks each illuminated sensor adds to the
+ *  normal equations, and are fixed along with the normals. */
+static std::array<std::array<float, 6>, 20> const normal_blocks = [] {
+  std::array<std::array<float, 6>, 20> blocks;
+  for (lin::size_t j = 0; j < 20; j++) {
+    blocks[j] = {
+      normals(j, 0) * normals(j, 0), normals(j, 0) * normals(j, 1),
+      normals(j, 0) * normals(j, 2), normals(j, 1) * normals(j, 1),
+      normals(j, 1) * normals(j, 2), normals(j, 2) * normals(j, 2)
+    };
+  }
+  return blocks;
+}();
+
+unsigned char solve_sun_vector(lin::Matrix<float, 5, 4> const &voltages,
+    unsigned char functional, lin::Vector3f &sun_vec) {
+  // Accumulate the normal equations M x = r of the least squares problem
+  float M[6] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+  float r[3] = {0.0f, 0.0f, 0.0f};
+  unsigned int k = 0;
   for (lin::size_t i = 0; i < 5; i++) {
     // Skip ADCs that aren't functional
-    if (!adcs[i].is_functional()) continue;
+    if (!(functional & (1 << i))) continue;
 
     for (lin::size_t j = 4 * i; j < 4 * i + 4; j++) {
-      if (voltages(j) > sensor_voltage_thresh) {
-        lin::row(A, k) = lin::row(normals, j);
-        b(k) = voltages(j);
+      float const v = voltages(j);
+      if (v > sensor_voltage_thresh) {
+        for (unsigned int m = 0; m < 6; m++) M[m] += normal_blocks[j][m];
+        for (unsigned int m = 0; m < 3; m++) r[m] += v * normals(j, m);
         k++;
       }
     }
   }
   // Ensure system is overdefined
   if (k < sensor_count_thresh) return SSAMode::SSA_FAILURE;
-  // Calculate sun vector
-  b.resize(k, 1); // Hacky resize call
-  A.resize(k, 3);
-  lin::qr(A, Q, R);
-  lin::backward_sub(R, x, (lin::transpose(Q) * b).eval());
+
+  // Solve with the adjugate of the symmetric M. The solution is normalized
+  // below, so the division by the determinant is only needed for its sign.
+  float const a00 = M[3] * M[5] - M[4] * M[4];
+  float const a01 = M[2] * M[4] - M[1] * M[5];
+  float const a02 = M[1] * M[4] - M[2] * M[3];
+  float const a11 = M[0] * M[5] - M[2] * M[2];
+  float const a12 = M[1] * M[2] - M[0] * M[4];
+  float const a22 = M[0] * M[3] - M[1] * M[1];
+  float const det = M[0] * a00 + M[1] * a01 + M[2] * a02;
+  // Sensors that don't span all three axes can't determine a sun vector
+  if (!(det > min_normal_det)) return SSAMode::SSA_FAILURE;
+
+  lin::Vector3f const x({
+    a00 * r[0] + a01 * r[1] + a02 * r[2],
+    a01 * r[0] + a11 * r[1] + a12 * r[2],
+    a02 * r[0] + a12 * r[1] + a22 * r[2]
+  });
   // Return sun vector
   sun_vec = x / lin::norm(x);
   return SSAMode::SSA_COMPLETE;
 }
+
+unsigned char calculate_sun_vector(lin::Vector3f &sun_vec) {
+  unsigned char functional = 0;
+  for (unsigned int i = 0; i < 5; i++)
+    if (adcs[i].is_functional()) functional |= 1 << i;
+  return solve_sun_vector(voltages, functional, sun_vec);
+}
 }  // namespace ssa
 }  // namespace adcs
@@ -44,6 +44,18 @@ void setup();
  *  @param[in] adc_flt Exponential filter applied to the voltage readings. */
 void update_sensors(float adc_flt);
 
+/** @fn solve_sun_vector
+ *  Least squares fit of a sun vector to the given voltage readings, using only
+ *  sensors above the voltage threshold on functional ADCs. Rather than
+ *  factoring the system, the precomputed normal equation blocks of the
+ *  illuminated sensors are summed into a 3x3 system solved in closed form.
+ *  @param[in] voltages Sun sensor voltages, laid out as in voltages.
+ *  @param[in] functional Bit i is set if ADC i is functional.
+ *  @param[out] sun_vec Normalized vector in R3 is written to this reference.
+ *  @return Sun sensor resulting mode - i.e. COMPLETE or FAILURE. */
+unsigned char solve_sun_vector(lin::Matrix<float, 5, 4> const &voltages,
+    unsigned char functional, lin::Vector3f &sun_vec);
+
 /** @fn calculate
  *  Determines a sun vector given the current voltage readings. If an accurate
  *  sun vector cannot be determined at the current time, the function will
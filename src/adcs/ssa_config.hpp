@@ -61,6 +61,9 @@ static unsigned long const adcx_timeout = 10000;
 static unsigned int const sensor_count_thresh = 4;
 /** Voltage threshold for a sun sensor to be considered in view of the sun. */
 static float const sensor_voltage_thresh = 1.0f;
+/** Smallest determinant of the normal equations for which the sensors in view
+ *  of the sun are considered to span all three axes. */
+static float const min_normal_det = 1.0e-4f;
 
 static constexpr float s20 = std::cos(20.0);
 static constexpr float c20 = std::sin(20.0);
@@ -22,6 +22,7 @@
 #include "state.hpp"
 #include "state_controller.hpp"
 #include "state_registers.hpp"
+#include "telemetry.hpp"
 #include "utl/convert.hpp"
 #include "utl/logging.hpp"
 
@@ -513,6 +514,19 @@ void on_i2c_request() {
       break;
     }
 
+    case Register::TELEMETRY: {
+      // Pack everything the flight computer reads each cycle into a single
+      // transfer, encoded as in the individual registers
+      unsigned char block[telemetry::LENGTH];
+      telemetry::encode(registers, block);
+      endian_write(block);
+
+      LOG_INFO_header
+      LOG_INFO_println("TELEMETRY read with SSA_MODE " + String(block[telemetry::SSA_MODE]))
+
+      break;
+    }
+
     default: {
       LOG_WARN_header
       LOG_WARN_println("Invalid address requested over I2C: "
@@ -48,7 +48,8 @@ enum Register : unsigned char {
   IMU_GYR_TEMP_DESIRED,
   HAVT_READ,
   HAVT_COMMAND_RESET,
-  HAVT_COMMAND_DISABLE
+  HAVT_COMMAND_DISABLE,
+  TELEMETRY
 };
 }  // namespace adcs
 
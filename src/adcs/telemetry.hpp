@@ -0,0 +1,123 @@
+//
+// src/adcs/telemetry.hpp
+// FlightSoftware
+//
+// Pathfinder for Autonomous Navigation
+// Space Systems Design Studio
+// Cornell Univeristy
+//
+
+#ifndef SRC_ADCS_TELEMETRY_HPP_
+#define SRC_ADCS_TELEMETRY_HPP_
+
+#include "constants.hpp"
+#include "utl/convert.hpp"
+
+#include <common/constant_tracker.hpp>
+
+namespace adcs {
+namespace telemetry {
+
+/** Version of the telemetry block layout below. Must be incremented whenever
+ *  the layout changes so the flight computer rejects blocks it can't decode. */
+TRACKED_CONSTANT_SC(unsigned char, version, 1);
+
+/** \enum Offset
+ *  Byte offsets of the fields in the telemetry block read from the TELEMETRY
+ *  register. Multibyte values are little-endian and encoded exactly as in
+ *  their individual registers. The block ends with a CRC of all preceding
+ *  bytes. */
+enum Offset : unsigned char {
+  /** WHO_AM_I register value. */
+  WHO_AM_I = 0,
+  /** Layout version, see telemetry::version. */
+  VERSION = 1,
+  /** SSA_MODE register value. */
+  SSA_MODE = 2,
+  /** Reaction wheel speed reads, as in RWA_SPEED_RD. */
+  RWA_SPEED_RD = 3,
+  /** Reaction wheel ramp reads, as in RWA_SPEED_RD. */
+  RWA_RAMP_RD = 9,
+  /** Sun vector, as in SSA_SUN_VECTOR. Only valid if the SSA mode is
+   *  SSA_COMPLETE. */
+  SSA_SUN_VECTOR = 15,
+  /** Sun sensor voltages, as in SSA_VOLTAGE_READ. */
+  SSA_VOLTAGE_RD = 21,
+  /** Magnetometer, gyroscope and gyroscope temperature reads, as in
+   *  IMU_READ. */
+  IMU_RD = 41,
+  /** HAVT table, as in HAVT_READ. */
+  HAVT_RD = 61,
+  /** CRC-16/CCITT-FALSE of every byte before it. */
+  CRC = 65,
+  /** Total length of the block. */
+  LENGTH = 67
+};
+
+/** \fn crc
+ *  CRC-16/CCITT-FALSE (polynomial 0x1021, initial value 0xFFFF) of the given
+ *  bytes. A block of zeros, such as an unanswered read, never checks out. */
+inline unsigned short crc(unsigned char const *data, unsigned int len) {
+  unsigned short crc = 0xFFFF;
+  for (unsigned int i = 0; i < len; i++) {
+    crc ^= (unsigned short)(data[i] << 8);
+    for (unsigned int j = 0; j < 8; j++)
+      crc = (crc & 0x8000) ? (unsigned short)((crc << 1) ^ 0x1021) : (unsigned short)(crc << 1);
+  }
+  return crc;
+}
+
+/** \fn put
+ *  Writes an unsigned short into a block, little-endian, and returns a
+ *  pointer just past it. */
+inline unsigned char *put(unsigned char *dst, unsigned short us) {
+  dst[0] = (unsigned char)us;
+  dst[1] = (unsigned char)(us >> 8);
+  return dst + 2;
+}
+
+/** \fn encode
+ *  Packs the given registers into a telemetry block, CRC included. Templated
+ *  on the register struct so that the box firmware can pass its volatile
+ *  registers, and desktop models their own copy. */
+template <typename Registers>
+void encode(Registers const &r, unsigned char (&block)[LENGTH]) {
+  unsigned char *ptr;
+
+  block[WHO_AM_I] = r.who_am_i;
+  block[VERSION] = version;
+  block[SSA_MODE] = r.ssa.mode;
+
+  ptr = block + RWA_SPEED_RD;
+  for (unsigned int i = 0; i < 3; i++)
+    ptr = put(ptr, utl::us(r.rwa.momentum_rd[i], rwa::min_speed_read, rwa::max_speed_read));
+  for (unsigned int i = 0; i < 3; i++)
+    ptr = put(ptr, utl::us(r.rwa.ramp_rd[i], rwa::min_ramp_rd, rwa::max_ramp_rd));
+
+  ptr = block + SSA_SUN_VECTOR;
+  for (unsigned int i = 0; i < 3; i++)
+    ptr = put(ptr, utl::us(r.ssa.sun_vec_rd[i], -1.0f, 1.0f));
+
+  ptr = block + SSA_VOLTAGE_RD;
+  for (unsigned int i = 0; i < 20; i++)
+    *(ptr++) = utl::uc(r.ssa.voltage_rd[i], ssa::min_voltage_rd, ssa::max_voltage_rd);
+
+  ptr = block + IMU_RD;
+  for (unsigned int i = 0; i < 3; i++)
+    ptr = put(ptr, utl::us(r.imu.mag1_rd[i], imu::min_mag1_rd_mag, imu::max_mag1_rd_mag));
+  for (unsigned int i = 0; i < 3; i++)
+    ptr = put(ptr, utl::us(r.imu.mag2_rd[i], imu::min_mag2_rd_mag, imu::max_mag2_rd_mag));
+  for (unsigned int i = 0; i < 3; i++)
+    ptr = put(ptr, utl::us(r.imu.gyr_rd[i], imu::min_rd_omega, imu::max_rd_omega));
+  put(ptr, utl::us(r.imu.gyr_temp_rd, imu::min_rd_temp, imu::max_rd_temp));
+
+  for (unsigned int i = 0; i < 4; i++)
+    block[HAVT_RD + i] = (unsigned char)(r.havt.read_table >> (8 * i));
+
+  put(block + CRC, crc(block, CRC));
+}
+
+}  // namespace telemetry
+}  // namespace adcs
+
+#endif
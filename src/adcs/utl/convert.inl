@@ -31,6 +31,34 @@ inline float fp(unsigned short ui, float min, float max) {
   return min + ((float) ui) * (max - min) / 65535.0f;
 }
 
+inline void fp(signed char const *__restrict__ si, float *__restrict__ f, unsigned int n,
+    float min, float max) {
+  float const scale = (max - min) / 255.0f;
+  for (unsigned int i = 0; i < n; i++) f[i] = min + (((float) si[i]) + 128.0f) * scale;
+  for (unsigned int i = 0; i < n; i++) if (si[i] == 127) f[i] = max;
+}
+
+inline void fp(unsigned char const *__restrict__ ui, float *__restrict__ f, unsigned int n,
+    float min, float max) {
+  float const scale = (max - min) / 255.0f;
+  for (unsigned int i = 0; i < n; i++) f[i] = min + ((float) ui[i]) * scale;
+  for (unsigned int i = 0; i < n; i++) if (ui[i] == 255) f[i] = max;
+}
+
+inline void fp(signed short const *__restrict__ si, float *__restrict__ f, unsigned int n,
+    float min, float max) {
+  float const scale = (max - min) / 65535.0f;
+  for (unsigned int i = 0; i < n; i++) f[i] = min + (((float) si[i]) + 32768.0f) * scale;
+  for (unsigned int i = 0; i < n; i++) if (si[i] == 32767) f[i] = max;
+}
+
+inline void fp(unsigned short const *__restrict__ ui, float *__restrict__ f, unsigned int n,
+    float min, float max) {
+  float const scale = (max - min) / 65535.0f;
+  for (unsigned int i = 0; i < n; i++) f[i] = min + ((float) ui[i]) * scale;
+  for (unsigned int i = 0; i < n; i++) if (ui[i] == 65535) f[i] = max;
+}
+
 inline unsigned char uc(float f, float min, float max) {
   return (unsigned char)(255.0f * (f - min) / (max - min));
 }
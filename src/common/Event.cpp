@@ -5,11 +5,19 @@ ReadableStateField<unsigned int> *Event::ccno = nullptr;
 Event::Event(const std::string& name,
           std::vector<ReadableStateFieldBase*>& _data_fields,
           const char* (*_print_fn)(const unsigned int, std::vector<ReadableStateFieldBase*>&)) :
+          Event(name, _data_fields, _print_fn, true) {}
+
+Event::Event(const std::string& name,
+          std::vector<ReadableStateFieldBase*>& _data_fields,
+          const char* (*_print_fn)(const unsigned int, std::vector<ReadableStateFieldBase*>&),
+          bool has_field_data) :
           StateField<bool>(name, true, false),
           _name(name),
           data_fields(_data_fields),
           print_fn(_print_fn)
 {
+    if (!has_field_data) return;
+
     unsigned int field_data_size_bits = 0;
     for(const ReadableStateFieldBase* field : data_fields) {
         field_data_size_bits += field->bitsize();
@@ -96,3 +104,29 @@ bool Event::deserialize(const char *val) { return true; }
 unsigned int Event::eeprom_save_period() const { return 0; }
 unsigned int Event::get_eeprom_repr() const { return 0; }
 void Event::set_from_eeprom(unsigned int val) { }
+
+size_t Event::checkpoint_size() const {
+    return StateField<bool>::checkpoint_size() + (field_data->size() + 7) / 8;
+}
+
+void Event::save_checkpoint(unsigned char *dst) const {
+    StateField<bool>::save_checkpoint(dst);
+    pack_bits(*field_data, dst + StateField<bool>::checkpoint_size());
+}
+
+void Event::load_checkpoint(const unsigned char *src) {
+    StateField<bool>::load_checkpoint(src);
+    unpack_bits(src + StateField<bool>::checkpoint_size(), *field_data);
+}
+
+void Event::pack_bits(const bit_array &bits, unsigned char *dst) {
+    for (size_t i = 0; i < (bits.size() + 7) / 8; i++) dst[i] = 0;
+    for (size_t i = 0; i < bits.size(); i++) {
+        if (bits[i]) dst[i / 8] |= 1 << (i % 8);
+    }
+}
+
+void Event::unpack_bits(const unsigned char *src, bit_array &bits) {
+    for (size_t i = 0; i < bits.size(); i++)
+        bits[i] = (src[i / 8] >> (i % 8)) & 1;
+}
@@ -31,6 +31,30 @@ public:
      */
   virtual const bit_array &get_bit_array() const = 0;
 
+  /**
+     * @brief Called by the downlink producer before the event's bitset is
+     * written to a snapshot. Events that keep a history of occurrences use it
+     * to load the occurrences that haven't been downlinked yet.
+     *
+     * @return Number of occurrences that were loaded.
+     */
+  virtual size_t prepare_downlink() { return 0; }
+
+  /**
+     * @brief Called by the Quake Manager once the snapshot produced in the
+     * given control cycle has reached the ground. Events that keep a history
+     * of occurrences use it to forget the occurrences that snapshot carried.
+     */
+  virtual void confirm_downlink(unsigned int ccno) {}
+
+  /**
+     * @brief Called by the Quake Manager when the snapshot produced in the
+     * given control cycle is dropped before it reaches the ground. Events
+     * that keep a history of occurrences load the occurrences it carried
+     * again, along with those of the snapshots produced after it.
+     */
+  virtual void rewind_downlink(unsigned int ccno) {}
+
 #if defined(GSW) || defined(UNIT_TEST)
    /**
        * @brief Store the event's bitset into the event's fields' data
@@ -66,12 +90,25 @@ class Event : public ReadableStateFieldBase, public StateField<bool>, public Eve
           const char* (*_print_fn)(const unsigned int, std::vector<ReadableStateFieldBase*>&));
 
    /**
-     * @brief Move constructor, required for EventStorage.
+     * @brief Move constructor.
      * 
      * @param other 
      */
     Event(Event &&other);
 
+  protected:
+    /**
+     * @brief Construct an event that keeps its recorded data itself, so no
+     * bitset is allocated for it. Such events must override every function
+     * that uses the bitset.
+     */
+    Event(const std::string& name,
+          std::vector<ReadableStateFieldBase*>& _data_fields,
+          const char* (*_print_fn)(const unsigned int, std::vector<ReadableStateFieldBase*>&),
+          bool has_field_data);
+
+  public:
+
     const std::string &name() const override { return _name; }
     const std::vector<ReadableStateFieldBase*> &_data_fields() { return data_fields; }
 
@@ -96,10 +133,24 @@ class Event : public ReadableStateFieldBase, public StateField<bool>, public Eve
       unsigned int get_eeprom_repr() const override;
       void set_from_eeprom(unsigned int val) override;
 
+      /**
+       * @brief Checkpoint the event's flag along with its recorded data.
+       */
+      size_t checkpoint_size() const override;
+      void save_checkpoint(unsigned char *dst) const override;
+      void load_checkpoint(const unsigned char *src) override;
+
    static ReadableStateField<unsigned int> *ccno;
 
     virtual ~Event() {}
 
+  protected:
+    /**
+     * @brief Pack a bitset into bytes, LSB first, or unpack it from them.
+     */
+    static void pack_bits(const bit_array &bits, unsigned char *dst);
+    static void unpack_bits(const unsigned char *src, bit_array &bits);
+
   private:
     std::vector<ReadableStateFieldBase*>& data_fields;
     std::unique_ptr<bit_array> field_data;
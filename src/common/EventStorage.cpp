@@ -1,60 +1,217 @@
 #include "EventStorage.hpp"
+#include <common/FrameWriter.hpp>
+#include <cstdint>
+#include <cstring>
 #include <string>
 
+/**
+ * @brief Size of the serialized data of an event, i.e. of a record without
+ * its control cycle count.
+ */
+static size_t data_bits(const std::vector<ReadableStateFieldBase *> &data_fields)
+{
+    size_t bits = 0;
+    for (const ReadableStateFieldBase *field : data_fields)
+        bits += field->bitsize();
+    return bits;
+}
+
+/**
+ * @brief Number of bits needed to represent every value from 0 to n.
+ */
+static size_t bits_for(size_t n)
+{
+    size_t bits = 1;
+    while ((n >> bits) > 0) bits++;
+    return bits;
+}
+
+constexpr size_t EventStorage::max_pending;
+
 EventStorage::EventStorage(const std::string &name,
-                           const unsigned int storage_size,
+                           const size_t capacity_bytes,
+                           const size_t _window_size,
                            std::vector<ReadableStateFieldBase *> &_data_fields,
-                           const char *(*_print_fn)(const unsigned int, std::vector<ReadableStateFieldBase *> &))
+                           const char *(*_print_fn)(const unsigned int, std::vector<ReadableStateFieldBase *> &)) :
+    Event(name, _data_fields, _print_fn, false),
+    record_bits(ccno_bits + data_bits(_data_fields)),
+    record_bytes((record_bits + 7) / 8),
+    num_slots(capacity_bytes / record_bytes),
+    count_bits(bits_for(_window_size)),
+    window_size(_window_size),
+    log(num_slots * record_bytes, 0),
+    window(count_bits + _window_size * record_bits)
 {
-    assert(storage_size <= 99 && storage_size >= 0); // So that the suffixed event count doesn't have more than 2 digits
-    sub_events.reserve(storage_size);
-    for (unsigned char i = 1; i <= storage_size; i++)
-    {
-        char x[4];
-        memset(x, 0, 4);
-        x[0] = '.';
-        sprintf(x, ".%d", i % 100);
-        sub_events.emplace_back(name + std::string(x),
-                                _data_fields, _print_fn);
-    }
+    assert(num_slots > 0 && window_size > 0); // The log and the window must hold at least one record
+    for (size_t i = 0; i < window.size(); i++) window[i] = 0;
 }
 
 void EventStorage::add_events_to_registry(StateFieldRegistry &registry)
 {
-    for (Event &e : sub_events)
-    {
-        registry.add_event(&e);
+    registry.add_event(this);
+}
+
+size_t EventStorage::num_unseen() const
+{
+    const unsigned long long oldest = next_seq > num_slots ? next_seq - num_slots : 0;
+    return static_cast<size_t>(next_seq - (cursor_seq > oldest ? cursor_seq : oldest));
+}
+
+size_t EventStorage::num_unconfirmed() const
+{
+    const unsigned long long oldest = next_seq > num_slots ? next_seq - num_slots : 0;
+    return static_cast<size_t>(next_seq - (acked_seq > oldest ? acked_seq : oldest));
+}
+
+size_t EventStorage::window_count() const
+{
+    size_t count = 0;
+    for (size_t i = 0; i < count_bits; i++)
+        count |= static_cast<size_t>(window[i]) << i;
+    return count < window_size ? count : window_size;
+}
+
+void EventStorage::signal()
+{
+    // Serialize the record directly into its slot. The writer has no packet
+    // headers since the log isn't split into packets.
+    char *slot = reinterpret_cast<char *>(log.data()) + (next_seq % num_slots) * record_bytes;
+    FrameWriter writer(slot, SIZE_MAX);
+    writer.write(ccno->get(), ccno_bits);
+    for (ReadableStateFieldBase *field : _data_fields())
+        field->serialize_into(writer);
+    writer.finish();
+
+    next_seq++;
+}
+
+size_t EventStorage::prepare_downlink()
+{
+    // Records that were overwritten before they could be downlinked are lost.
+    const unsigned long long oldest = next_seq > num_slots ? next_seq - num_slots : 0;
+    if (cursor_seq < oldest) cursor_seq = oldest;
+    if (acked_seq < oldest) acked_seq = oldest;
+
+    // Nothing more is loaded while too many windows await confirmation.
+    const size_t max_count = num_pending < max_pending ? window_size : 0;
+
+    size_t count = 0;
+    size_t pos = count_bits;
+    for (; count < max_count && cursor_seq < next_seq; count++, cursor_seq++) {
+        const unsigned char *slot = log.data() + (cursor_seq % num_slots) * record_bytes;
+        for (size_t i = 0; i < record_bits; i++, pos++)
+            window[pos] = (slot[i / 8] >> (7 - i % 8)) & 1;
+    }
+    for (; pos < window.size(); pos++) window[pos] = 0;
+
+    for (size_t i = 0; i < count_bits; i++) window[i] = (count >> i) & 1;
+
+    if (count > 0) pending[num_pending++] = {ccno->get(), cursor_seq};
+    return count;
+}
+
+void EventStorage::confirm_downlink(unsigned int ccno)
+{
+    for (size_t i = 0; i < num_pending; i++) {
+        if (pending[i].ccno != ccno) continue;
+
+        // Snapshots reach the ground in the order they were produced, so the
+        // windows before this one were either confirmed or dropped already.
+        acked_seq = pending[i].end_seq;
+        for (size_t j = i + 1; j < num_pending; j++) pending[j - i - 1] = pending[j];
+        num_pending -= i + 1;
+        return;
+    }
+}
+
+void EventStorage::rewind_downlink(unsigned int ccno)
+{
+    for (size_t i = 0; i < num_pending; i++) {
+        if (pending[i].ccno != ccno) continue;
+
+        // Windows are loaded in order, so this one starts where the previous
+        // one ended. The windows after it are loaded again too.
+        cursor_seq = i > 0 ? pending[i - 1].end_seq : acked_seq;
+        num_pending = i;
+        return;
     }
 }
 
 size_t EventStorage::bitsize() const
 {
-    return sub_events[event_ptr].bitsize();
+    return window.size();
 }
 
 const bit_array &EventStorage::get_bit_array() const
 {
-    return sub_events[event_ptr].get_bit_array();
+    return window;
+}
+
+void EventStorage::set_bit_array(const bit_array &arr)
+{
+    assert(arr.size() == window.size());
+    for (size_t i = 0; i < arr.size(); i++) window[i] = arr[i];
 }
 
-#if defined(GSW) || defined(UNIT_TEST)
+size_t EventStorage::checkpoint_size() const
+{
+    return StateField<bool>::checkpoint_size() + sizeof(next_seq) + sizeof(acked_seq)
+        + log.size() + (window.size() + 7) / 8;
+}
 
-const char *EventStorage::print() const 
+void EventStorage::save_checkpoint(unsigned char *dst) const
 {
-    return sub_events[event_ptr].print();
+    StateField<bool>::save_checkpoint(dst);
+    dst += StateField<bool>::checkpoint_size();
+    std::memcpy(dst, &next_seq, sizeof(next_seq));
+    dst += sizeof(next_seq);
+    std::memcpy(dst, &acked_seq, sizeof(acked_seq));
+    dst += sizeof(acked_seq);
+    std::memcpy(dst, log.data(), log.size());
+    pack_bits(window, dst + log.size());
 }
 
-void EventStorage::deserialize() 
+void EventStorage::load_checkpoint(const unsigned char *src)
 {
-    sub_events[event_ptr].deserialize();
+    StateField<bool>::load_checkpoint(src);
+    src += StateField<bool>::checkpoint_size();
+    std::memcpy(&next_seq, src, sizeof(next_seq));
+    src += sizeof(next_seq);
+    std::memcpy(&acked_seq, src, sizeof(acked_seq));
+    src += sizeof(acked_seq);
+    std::memcpy(log.data(), src, log.size());
+    unpack_bits(src + log.size(), window);
+
+    // The snapshots that were in flight are gone, so their records are
+    // loaded again.
+    cursor_seq = acked_seq;
+    num_pending = 0;
 }
 
-#endif
+void EventStorage::deserialize_record(size_t i)
+{
+    size_t pos = count_bits + i * record_bits;
 
-void EventStorage::signal()
+    unsigned int event_ccno = 0;
+    for (size_t j = 0; j < ccno_bits; j++, pos++)
+        event_ccno |= static_cast<unsigned int>(window[pos]) << j;
+    ccno->set(event_ccno);
+
+    for (ReadableStateFieldBase *field : _data_fields())
+    {
+        bit_array &field_bits = field->get_bit_array();
+        for (size_t j = 0; j < field->bitsize(); j++, pos++)
+            field_bits[j] = window[pos];
+        field->deserialize();
+    }
+}
+
+void EventStorage::deserialize()
+{
+    if (window_count() > 0) deserialize_record(0);
+}
+
+const char *EventStorage::print() const
 {
-    sub_events[event_ptr].signal();
-    event_ptr++;
-    if (event_ptr == sub_events.size())
-        event_ptr = 0;
+    return Event::print();
 }
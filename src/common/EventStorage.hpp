@@ -3,58 +3,168 @@
 
 #include "Event.hpp"
 #include <common/StateFieldRegistry.hpp>
+#include <vector>
 
-class EventStorage : public EventBase
+/**
+ * @brief Log of the occurrences of an event, kept in a packed ring buffer.
+ *
+ * Every signal appends a record to the log, consisting of the 32-bit control
+ * cycle count followed by the serialized data fields, back to back. Records
+ * are byte aligned so that they can be written by a FrameWriter; the log holds
+ * as many records as fit in its capacity, and the oldest records are
+ * overwritten once it is full.
+ *
+ * The log is downlinked through a window of a fixed number of records. Each
+ * time a snapshot is produced, the window is loaded with the oldest records
+ * that haven't been loaded yet, so the ground drains the log in order rather
+ * than seeing whichever record happens to be current. The window starts with
+ * the number of valid records it contains; unused records are zero.
+ *
+ * Records stay in the log until the Quake Manager confirms that the snapshot
+ * carrying them reached the ground. If a snapshot carrying records is
+ * dropped instead, every unconfirmed record is loaded again, so the ground
+ * may see a record more than once but only misses records that were
+ * overwritten.
+ *
+ * The log keeps its window itself, so the Event base doesn't allocate a
+ * bitset of its own.
+ *
+ * Each log stores a single type of event, so the type of a record is implied
+ * by the name of the log under which it is downlinked.
+ */
+class EventStorage : public Event
 {
 public:
   /**
      * @brief Construct a new Event Storage object.
-     * 
-     * @param name Name of event. The sub events will be named "name.i" where i ranges from 1 to
-     *             storage_size.
-     * @param storage_size Number of sub-events to create.
+     *
+     * @param name Name of event.
+     * @param capacity_bytes Size of the log in bytes. Must hold at least one record.
+     * @param window_size Maximum number of records in each downlinked window.
      * @param _data_fields Data fields related to the event.
      * @param _print_fn Function for printing data about the event.
-     * @param int Reference to the control cycle count.
      */
   EventStorage(const std::string &name,
-               const unsigned int storage_size,
+               const size_t capacity_bytes,
+               const size_t window_size,
                std::vector<ReadableStateFieldBase *> &_data_fields,
                const char *(*_print_fn)(const unsigned int, std::vector<ReadableStateFieldBase *> &));
 
   /**
-     * @brief Add all stored sub-events to the state field registry.
-     * 
+     * @brief Add the event log to the state field registry.
+     *
      * @param registry
      */
   void add_events_to_registry(StateFieldRegistry &registry);
 
-  // The event storage uses the event it currently points to
-  // to provide the same interface as a single event.
+  /**
+     * @brief Number of records the log can hold.
+     */
+  size_t capacity() const { return num_slots; }
+
+  /**
+     * @brief Number of records in the log that haven't been loaded into a
+     * downlink window yet.
+     */
+  size_t num_unseen() const;
+
+  /**
+     * @brief Number of records in the log whose delivery hasn't been
+     * confirmed, including records waiting in downlink windows.
+     */
+  size_t num_unconfirmed() const;
+
+  /**
+     * @brief Number of valid records in the current downlink window.
+     */
+  size_t window_count() const;
+
+  // Functions from the EventBase interface. The bitset of the log is its
+  // downlink window.
+  void signal() override;
+  size_t prepare_downlink() override;
+  void confirm_downlink(unsigned int ccno) override;
+  void rewind_downlink(unsigned int ccno) override;
   size_t bitsize() const override;
   const bit_array &get_bit_array() const override;
+  void set_bit_array(const bit_array &arr) override;
 
-  #if defined(GSW) || defined(UNIT_TEST)
-  void deserialize() override;
-  const char *print() const override;
- #endif
+  /**
+     * @brief Checkpoint the log, its write position and the position of the
+     * oldest unconfirmed record, and the downlink window along with the event
+     * itself. Windows that were in flight are loaded again after a restore.
+     */
+  size_t checkpoint_size() const override;
+  void save_checkpoint(unsigned char *dst) const override;
+  void load_checkpoint(const unsigned char *src) override;
 
-  void signal() override;
+  /**
+     * @brief Store the i-th record of the downlink window into the control
+     * cycle count and the event's data fields.
+     */
+  void deserialize_record(size_t i);
 
-private:
   /**
-     * @brief Stores the sub-events that comprise the event storage.
+     * @brief Deserializes the first record of the downlink window, if any.
      */
-  std::vector<Event> sub_events;
+  void deserialize() override;
+  const char *print() const override;
 
-#ifdef UNIT_TEST
-public:
-#endif
+protected:
   /**
-     * @brief The sub-event towards which the event storage is currently pointing.
-     * 
+     * @brief The downlink window is the serialized form of the log, so there
+     * is nothing to serialize.
      */
-  size_t event_ptr = 0;
+  void serialize() override {}
+
+private:
+  // Bits used by the control cycle count at the start of each record.
+  static constexpr size_t ccno_bits = 32;
+
+  // Size of a record in bits, and the size of its slot in the log in bytes.
+  const size_t record_bits;
+  const size_t record_bytes;
+
+  // Number of records the log can hold.
+  const size_t num_slots;
+
+  // Number of bits used to store the number of records in the window.
+  const size_t count_bits;
+
+  // Number of records per downlink window.
+  const size_t window_size;
+
+  // Maximum number of loaded windows awaiting confirmation. No more records
+  // are loaded while this many are in flight.
+  static constexpr size_t max_pending = 8;
+
+  // Control cycle in which a window was loaded, and the sequence number
+  // following its last record.
+  struct PendingWindow {
+    unsigned int ccno;
+    unsigned long long end_seq;
+  };
+
+  // Windows awaiting confirmation, oldest first.
+  PendingWindow pending[max_pending];
+  size_t num_pending = 0;
+
+  // Packed records, indexed by sequence number modulo num_slots.
+  std::vector<unsigned char> log;
+
+  // Sequence number of the next record to be written.
+  unsigned long long next_seq = 0;
+
+  // Sequence number of the oldest record that hasn't been loaded into a
+  // window.
+  unsigned long long cursor_seq = 0;
+
+  // Sequence number of the oldest record whose delivery hasn't been
+  // confirmed.
+  unsigned long long acked_seq = 0;
+
+  // Downlink window.
+  bit_array window;
 };
 
 #endif
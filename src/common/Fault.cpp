@@ -1,4 +1,5 @@
 #include "Fault.hpp"
+#include <cstring>
 
 const unsigned int* Fault::cc = nullptr;
  
@@ -90,6 +91,35 @@ void Fault::process_commands(){
     }
 }
 
+size_t Fault::checkpoint_size() const {
+    return WritableStateField<bool>::checkpoint_size() + sizeof(last_fault_time)
+        + sizeof(num_consecutive_signals) + sizeof(prev_suppress) + sizeof(prev_override);
+}
+
+void Fault::save_checkpoint(unsigned char *dst) const {
+    WritableStateField<bool>::save_checkpoint(dst);
+    dst += WritableStateField<bool>::checkpoint_size();
+    std::memcpy(dst, &last_fault_time, sizeof(last_fault_time));
+    dst += sizeof(last_fault_time);
+    std::memcpy(dst, &num_consecutive_signals, sizeof(num_consecutive_signals));
+    dst += sizeof(num_consecutive_signals);
+    std::memcpy(dst, &prev_suppress, sizeof(prev_suppress));
+    dst += sizeof(prev_suppress);
+    std::memcpy(dst, &prev_override, sizeof(prev_override));
+}
+
+void Fault::load_checkpoint(const unsigned char *src) {
+    WritableStateField<bool>::load_checkpoint(src);
+    src += WritableStateField<bool>::checkpoint_size();
+    std::memcpy(&last_fault_time, src, sizeof(last_fault_time));
+    src += sizeof(last_fault_time);
+    std::memcpy(&num_consecutive_signals, src, sizeof(num_consecutive_signals));
+    src += sizeof(num_consecutive_signals);
+    std::memcpy(&prev_suppress, src, sizeof(prev_suppress));
+    src += sizeof(prev_suppress);
+    std::memcpy(&prev_override, src, sizeof(prev_override));
+}
+
 #ifdef UNIT_TEST
 unsigned int Fault::get_num_consecutive_signals(){
     return num_consecutive_signals;
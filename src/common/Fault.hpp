@@ -83,6 +83,13 @@ class Fault : public WritableStateField<bool> {
     
     static const unsigned int* cc; // Control cycle count
 
+    /**
+     * @brief Checkpoint the fault's flag along with its signal counters.
+     */
+    size_t checkpoint_size() const override;
+    void save_checkpoint(unsigned char *dst) const override;
+    void load_checkpoint(const unsigned char *src) override;
+
   private:
     // Make the get() and set() methods of the state field private,
     // so that the user is forced to use the signal() and unsignal()
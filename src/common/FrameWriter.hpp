@@ -0,0 +1,131 @@
+#ifndef FRAME_WRITER_HPP_
+#define FRAME_WRITER_HPP_
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Writes serialized values into a frame of packets, one after the
+ * other, at a running bit cursor.
+ *
+ * Bits are stored MSB-first within each byte of the frame. Every packet
+ * begins with a single header bit, which is one for the first packet of the
+ * frame and zero for all other packets. The writer inserts the header bits as
+ * the cursor crosses packet boundaries, so values may straddle two packets
+ * without any special handling by the caller.
+ *
+ * Values are written whole bytes at a time where possible, rather than bit by
+ * bit, and the writer does not allocate.
+ */
+class FrameWriter {
+  public:
+    /**
+     * @brief Construct a writer for the given frame buffer.
+     *
+     * @param frame       Buffer to write the frame into. Must be large enough
+     *                    to hold everything that will be written to it.
+     * @param packet_size Size of each packet in bits, including its header bit.
+     */
+    FrameWriter(char* frame, size_t packet_size) :
+        frame(reinterpret_cast<unsigned char*>(frame)),
+        packet_size(packet_size),
+        frame_offset(0),
+        packet_offset(0) {}
+
+    /**
+     * @brief Moves the cursor to the start of the frame and writes the header
+     * bit of the first packet.
+     */
+    void start_frame() {
+        frame_offset = 0;
+        packet_offset = 0;
+        write_bits(1, 1);
+        packet_offset = 1;
+    }
+
+    /**
+     * @brief Write the lowest num_bits bits of a serialized code, LSB first,
+     * which is the same order in which a bit_array stores the code.
+     *
+     * @param code     Serialized value.
+     * @param num_bits Number of bits to write; at most 64.
+     */
+    void write(unsigned long long code, size_t num_bits) {
+        while (num_bits > 0) {
+            if (packet_offset == packet_size) {
+                // Header bit of a continuation packet
+                write_bits(0, 1);
+                packet_offset = 1;
+            }
+
+            size_t n = 8 - frame_offset % 8;
+            if (n > num_bits) n = num_bits;
+            if (n > packet_size - packet_offset) n = packet_size - packet_offset;
+
+            // The code is LSB first but the frame is MSB first, so reverse the
+            // chunk before storing it.
+            write_bits(reverse(static_cast<unsigned char>(code)) >> (8 - n), n);
+            packet_offset += n;
+            code >>= n;
+            num_bits -= n;
+        }
+    }
+
+    /**
+     * @brief Write a sequence of bits, e.g. the contents of a bit_array.
+     */
+    void write(const std::vector<bool>& bits) {
+        const size_t size = bits.size();
+        for (size_t i = 0; i < size; i += 64) {
+            const size_t n = size - i < 64 ? size - i : 64;
+            unsigned long long code = 0;
+            for (size_t j = 0; j < n; j++) {
+                code |= static_cast<unsigned long long>(bits[i + j]) << j;
+            }
+            write(code, n);
+        }
+    }
+
+    /**
+     * @brief Fill the unused bits of the last byte with zeroes.
+     */
+    void finish() {
+        const size_t n = (8 - frame_offset % 8) % 8;
+        if (n > 0) write_bits(0, n);
+    }
+
+    /**
+     * @brief Number of bits written to the frame so far, including headers.
+     */
+    size_t offset() const { return frame_offset; }
+
+    /**
+     * @brief Number of bytes spanned by the frame so far.
+     */
+    size_t size_bytes() const { return (frame_offset + 7) / 8; }
+
+  protected:
+    unsigned char* frame;
+    const size_t packet_size;
+    size_t frame_offset;
+    size_t packet_offset;
+
+    static constexpr unsigned char reverse(unsigned char b) {
+        return static_cast<unsigned char>(
+            ((b * 0x0802LU & 0x22110LU) | (b * 0x8020LU & 0x88440LU)) * 0x10101LU >> 16);
+    }
+
+    /**
+     * @brief Write the lowest n bits of value, MSB first, without crossing a
+     * byte boundary.
+     */
+    void write_bits(unsigned char value, size_t n) {
+        const size_t shift = 8 - frame_offset % 8 - n;
+        const unsigned char mask = static_cast<unsigned char>(((1U << n) - 1) << shift);
+        unsigned char& c = frame[frame_offset / 8];
+        c = static_cast<unsigned char>((c & ~mask) | ((value << shift) & mask));
+        frame_offset += n;
+    }
+};
+
+#endif
@@ -0,0 +1,253 @@
+#ifdef DESKTOP
+
+#include "ReplayLog.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+ReplayLog::mode_t ReplayLog::_mode = ReplayLog::mode_t::off;
+
+static constexpr char magic[] = "PANRPLY";
+static constexpr unsigned char version = 2;
+
+static std::ofstream out;
+static std::ifstream in;
+
+/** @brief Number of control cycles between checkpoints while recording.
+ */
+static unsigned int checkpoint_period = 0;
+
+/** @brief Last clock reading, which the next one is stored relative to.
+ */
+static long long last_time_us = 0;
+
+/** @brief Cycle from which to resume the replay, and whether the log still
+ *         has to be skipped to its checkpoint.
+ */
+static unsigned int from_ccno = 0;
+static bool seek_pending = false;
+
+/** @brief Control cycle count of the last cycle marker.
+ */
+static unsigned int current_ccno = 0;
+
+static void fail(const std::string& msg) {
+    std::cerr << "replay log: " << msg << std::endl;
+    std::exit(1);
+}
+
+static void finish() {
+    std::cerr << "replay log: replay finished at cycle " << current_ccno << std::endl;
+    std::exit(0);
+}
+
+static void write_varint(unsigned long long val) {
+    while (val >= 0x80) {
+        out.put(static_cast<char>((val & 0x7F) | 0x80));
+        val >>= 7;
+    }
+    out.put(static_cast<char>(val));
+}
+
+static unsigned long long read_varint() {
+    unsigned long long val = 0;
+    for (unsigned int shift = 0; shift < 64; shift += 7) {
+        const int c = in.get();
+        if (c == EOF) finish();
+        val |= static_cast<unsigned long long>(c & 0x7F) << shift;
+        if (!(c & 0x80)) return val;
+    }
+    fail("malformed varint");
+    return 0;
+}
+
+static void write_blob(const std::vector<unsigned char>& blob) {
+    write_varint(blob.size());
+    out.write(reinterpret_cast<const char*>(blob.data()), blob.size());
+}
+
+static void read_blob(std::vector<unsigned char>& blob) {
+    blob.resize(read_varint());
+    in.read(reinterpret_cast<char*>(blob.data()), blob.size());
+    if (static_cast<size_t>(in.gcount()) != blob.size()) finish();
+}
+
+/**
+ * @brief Reads the tag of the next entry, which must be one of the expected
+ * tags. Otherwise the replay has diverged from the recording.
+ */
+static char expect(const char* tags) {
+    const int c = in.get();
+    if (c == EOF) finish();
+    for (const char* t = tags; *t; t++) {
+        if (c == *t) return static_cast<char>(c);
+    }
+    fail("replay diverged from the recording at cycle " + std::to_string(current_ccno)
+        + ": expected one of '" + tags + "' but found '" + static_cast<char>(c) + "'");
+    return 0;
+}
+
+/**
+ * @brief Skips the log to the newest checkpoint at or before from_ccno, and
+ * restores the registry from it.
+ */
+static void seek(StateFieldRegistry& registry, unsigned int& ccno) {
+    std::vector<unsigned char> blob, best_blob;
+    std::streampos best_pos = -1;
+    long long best_time_us = 0;
+    unsigned int best_ccno = 0;
+
+    while (true) {
+        const int c = in.get();
+        if (c == EOF) break;
+        if (c == 'c') {
+            current_ccno = static_cast<unsigned int>(read_varint());
+            if (current_ccno > from_ccno) break;
+        }
+        else if (c == 'k') {
+            const unsigned int k_ccno = static_cast<unsigned int>(read_varint());
+            read_blob(blob);
+            best_blob.swap(blob);
+            best_pos = in.tellg();
+            best_time_us = last_time_us;
+            best_ccno = k_ccno;
+        }
+        else if (c == 't') {
+            const unsigned long long zz = read_varint();
+            last_time_us += static_cast<long long>(zz >> 1) ^ -static_cast<long long>(zz & 1);
+        }
+        else if (c == 'l' || c == 'b') read_blob(blob);
+        else if (c != 'n') fail("malformed entry while seeking");
+    }
+
+    if (best_pos == std::streampos(-1))
+        fail("no checkpoint at or before cycle " + std::to_string(from_ccno));
+
+    in.clear();
+    in.seekg(best_pos);
+    last_time_us = best_time_us;
+    current_ccno = best_ccno;
+    ccno = best_ccno;
+    if (!registry.load_checkpoint(best_blob)) fail("checkpoint doesn't match the registry");
+}
+
+void ReplayLog::record(const std::string& path, unsigned int period) {
+    if (out.is_open()) out.close();
+    out.open(path, std::ios::binary | std::ios::trunc);
+    if (!out) fail("cannot open " + path);
+    out.write(magic, sizeof(magic));
+    out.put(static_cast<char>(version));
+    last_time_us = 0;
+    checkpoint_period = period > 0 ? period : 1;
+    _mode = mode_t::record;
+}
+
+void ReplayLog::replay(const std::string& path, unsigned int ccno) {
+    if (out.is_open()) out.close();
+    if (in.is_open()) in.close();
+    in.clear();
+    in.open(path, std::ios::binary);
+    if (!in) fail("cannot open " + path);
+
+    char header[sizeof(magic)] = {0};
+    in.read(header, sizeof(header));
+    if (std::string(header) != magic || in.get() != version) fail(path + " is not a replay log");
+
+    last_time_us = 0;
+    current_ccno = 0;
+    from_ccno = ccno;
+    seek_pending = ccno > 0;
+    _mode = mode_t::replay;
+}
+
+void ReplayLog::start_cycle(StateFieldRegistry& registry, unsigned int& ccno) {
+    static std::vector<unsigned char> blob;
+
+    if (_mode == mode_t::record) {
+        out.put('c');
+        write_varint(ccno);
+        if (ccno % checkpoint_period == 0) {
+            registry.save_checkpoint(blob);
+            out.put('k');
+            write_varint(ccno);
+            write_blob(blob);
+        }
+
+        // Keep the log complete up to the current cycle in case the run crashes.
+        out.flush();
+    }
+    else if (_mode == mode_t::replay) {
+        if (seek_pending) {
+            seek_pending = false;
+            seek(registry, ccno);
+            return;
+        }
+
+        expect("c");
+        current_ccno = static_cast<unsigned int>(read_varint());
+        if (current_ccno != ccno)
+            fail("replay diverged from the recording: cycle " + std::to_string(ccno)
+                + " was recorded as cycle " + std::to_string(current_ccno));
+
+        // Checkpoints are only needed when seeking.
+        if (in.peek() == 'k') {
+            in.get();
+            read_varint();
+            read_blob(blob);
+        }
+    }
+}
+
+long long ReplayLog::clock_us(long long now_us) {
+    if (_mode == mode_t::record) {
+        const long long delta = now_us - last_time_us;
+        out.put('t');
+        write_varint((static_cast<unsigned long long>(delta) << 1) ^ static_cast<unsigned long long>(delta >> 63));
+        last_time_us = now_us;
+    }
+    else if (_mode == mode_t::replay) {
+        expect("t");
+        const unsigned long long zz = read_varint();
+        last_time_us += static_cast<long long>(zz >> 1) ^ -static_cast<long long>(zz & 1);
+        return last_time_us;
+    }
+    return now_us;
+}
+
+bool ReplayLog::console_line(std::string& line, bool has_line) {
+    if (_mode == mode_t::record) {
+        if (has_line) {
+            out.put('l');
+            write_varint(line.size());
+            out.write(line.data(), line.size());
+        }
+        else out.put('n');
+    }
+    else if (_mode == mode_t::replay) {
+        if (expect("ln") == 'n') return false;
+        std::vector<unsigned char> blob;
+        read_blob(blob);
+        line.assign(blob.begin(), blob.end());
+        return true;
+    }
+    return has_line;
+}
+
+void ReplayLog::input(void* data, size_t len) {
+    if (_mode == mode_t::record) {
+        out.put('b');
+        write_varint(len);
+        out.write(static_cast<const char*>(data), len);
+    }
+    else if (_mode == mode_t::replay) {
+        expect("b");
+        std::vector<unsigned char> blob;
+        read_blob(blob);
+        if (blob.size() != len) fail("recorded input buffer has the wrong size");
+        std::copy(blob.begin(), blob.end(), static_cast<unsigned char*>(data));
+    }
+}
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef REPLAY_LOG_HPP_
+#define REPLAY_LOG_HPP_
+
+#ifdef DESKTOP
+
+#include "StateFieldRegistry.hpp"
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief Records every external input of a desktop flight software run, so
+ * that the run can be replayed deterministically.
+ *
+ * On desktop, the flight software only depends on the outside world through
+ * the debug console, the system clock, and a few raw buffers (the EEPROM image
+ * at boot and the process's memory use). Each of these inputs goes through
+ * this class. While recording, the inputs are appended to a binary log; while
+ * replaying, they are read back from the log in the same order instead of
+ * being taken from the outside world, and waits are skipped so that the run
+ * proceeds at CPU speed.
+ *
+ * The log starts with a header, followed by tagged entries:
+ *
+ *   'c' varint ccno            start of a control cycle
+ *   'k' varint ccno, blob      registry checkpoint, after some cycle markers.
+ *                              See StateFieldRegistry::save_checkpoint.
+ *   't' zigzag varint          clock reading, in us relative to the previous one
+ *   'l' varint len, bytes      console line
+ *   'n'                        no console line was available
+ *   'b' varint len, bytes      raw input buffer
+ *
+ * A replay may start from a checkpoint rather than from the first cycle. The
+ * boot sequence is always replayed, after which the log is skipped to the
+ * newest checkpoint at or before the requested cycle and the registry is
+ * restored exactly from it. State that isn't kept in the registry restarts
+ * from its value after boot, so only a replay from the first cycle is
+ * guaranteed to be exact.
+ *
+ * If the flight software asks for a different kind of input than the one that
+ * was recorded, the replay has diverged from the recording; this is reported
+ * and the process exits. The process also exits when the log runs out.
+ */
+class ReplayLog {
+  public:
+    enum class mode_t : unsigned char { off, record, replay };
+
+    /**
+     * @brief Start recording inputs to a file.
+     *
+     * @param path Path of the log.
+     * @param checkpoint_period Number of control cycles between checkpoints.
+     */
+    static void record(const std::string& path, unsigned int checkpoint_period);
+
+    /**
+     * @brief Start replaying inputs from a file.
+     *
+     * @param path Path of the log.
+     * @param from_ccno Control cycle from which to resume the run. The run is
+     *                  replayed from the newest checkpoint at or before it.
+     */
+    static void replay(const std::string& path, unsigned int from_ccno = 0);
+
+    static mode_t mode() { return _mode; }
+    static bool is_replaying() { return _mode == mode_t::replay; }
+
+    /**
+     * @brief Marks the start of a control cycle, and writes or restores a
+     * checkpoint of the registry if one is due. Must be called before any input
+     * of the cycle is read.
+     *
+     * @param registry Registry to checkpoint or restore.
+     * @param ccno Control cycle count. When replaying from a checkpoint, it is
+     *             set to the cycle count of the checkpoint.
+     */
+    static void start_cycle(StateFieldRegistry& registry, unsigned int& ccno);
+
+    /**
+     * @brief Clock reading, in microseconds.
+     *
+     * @param now_us Reading of the system clock. Ignored while replaying.
+     * @return The recorded reading while replaying, and now_us otherwise.
+     */
+    static long long clock_us(long long now_us);
+
+    /**
+     * @brief Line received by the debug console.
+     *
+     * @param line Line that was received. Set to the recorded line while replaying.
+     * @param has_line Whether a line was received. Ignored while replaying.
+     * @return Whether a line was received, or was recorded as received.
+     */
+    static bool console_line(std::string& line, bool has_line);
+
+    /**
+     * @brief Raw input buffer. While replaying, the buffer is overwritten with
+     * the recorded contents, which must have the same size.
+     */
+    static void input(void* data, size_t len);
+
+  private:
+    static mode_t _mode;
+};
+
+#endif
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef RING_BUFFER_HPP_
+#define RING_BUFFER_HPP_
+
+#include <atomic>
+#include <cstddef>
+
+/**
+ * @brief Fixed-capacity FIFO that is safe to share between one producer and
+ * one consumer without disabling interrupts, e.g. between an interrupt
+ * handler and the control loop.
+ *
+ * The producer only writes the head and the consumer only writes the tail.
+ * Both are free-running counts of the elements ever pushed and popped, so
+ * they also give each element a position in the stream, which lets another
+ * buffer refer to elements of this one.
+ *
+ * @tparam T Type of the elements.
+ * @tparam N Capacity, which must be a power of two.
+ */
+template <typename T, size_t N>
+class RingBuffer {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "Ring buffer capacity must be a power of two");
+
+   public:
+    RingBuffer() : head(0), tail(0) {}
+
+    /**
+     * @brief Appends an element. Must only be called by the producer.
+     *
+     * @return false if the buffer is full, in which case the element is dropped.
+     */
+    bool push(const T& value) {
+        const size_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) == N) return false;
+        data[h & (N - 1)] = value;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Removes the oldest element. Must only be called by the consumer.
+     *
+     * @return false if the buffer is empty.
+     */
+    bool pop(T& value) {
+        const size_t t = tail.load(std::memory_order_relaxed);
+        if (head.load(std::memory_order_acquire) == t) return false;
+        value = data[t & (N - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Removes up to n of the oldest elements into dst. Must only be
+     * called by the consumer.
+     *
+     * @return The number of elements removed.
+     */
+    size_t pop(T* dst, size_t n) {
+        const size_t t = tail.load(std::memory_order_relaxed);
+        const size_t available = head.load(std::memory_order_acquire) - t;
+        if (n > available) n = available;
+        for (size_t i = 0; i < n; i++) dst[i] = data[(t + i) & (N - 1)];
+        tail.store(t + n, std::memory_order_release);
+        return n;
+    }
+
+    /**
+     * @brief Looks at the oldest element without removing it. Must only be
+     * called by the consumer.
+     *
+     * @return false if the buffer is empty.
+     */
+    bool peek(T& value) const {
+        const size_t t = tail.load(std::memory_order_relaxed);
+        if (head.load(std::memory_order_acquire) == t) return false;
+        value = data[t & (N - 1)];
+        return true;
+    }
+
+    /**
+     * @brief Drops every element. Must only be called by the consumer.
+     */
+    void clear() { tail.store(head.load(std::memory_order_acquire), std::memory_order_release); }
+
+    size_t size() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+    bool empty() const { return size() == 0; }
+    static constexpr size_t capacity() { return N; }
+
+    /**
+     * @brief Number of elements ever pushed, i.e. the position in the stream
+     * of the next element to be pushed.
+     */
+    size_t pushed() const { return head.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Number of elements ever popped, i.e. the position in the stream
+     * of the next element to be popped.
+     */
+    size_t popped() const { return tail.load(std::memory_order_acquire); }
+
+   private:
+    T data[N];
+    std::atomic<size_t> head;
+    std::atomic<size_t> tail;
+};
+
+#endif
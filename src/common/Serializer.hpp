@@ -9,8 +9,33 @@
 #include <memory>
 #include <string>
 #include <cstring>
+#include <cassert>
 #include "GPSTime.hpp"
 #include "fixed_array.hpp"
+#include "FrameWriter.hpp"
+
+/**
+ * @brief Scratch buffer for the strings produced by serializers' print().
+ *
+ * The buffer is shared by all serializers rather than owned by each of them,
+ * since printing is only ever done right before the string is consumed (by the
+ * debug console or the ground software) and there are hundreds of
+ * serializers. The string returned by print() is therefore only valid until the
+ * next call to print() on any serializer.
+ */
+class SerializerPrintBuffer {
+   public:
+    /**
+     * @brief Size of the buffer, which must accommodate the longest printed
+     * value of any serializer. Longer values are truncated.
+     */
+    static constexpr size_t size = 128;
+
+    static char* get() {
+        static char buffer[size] = {0};
+        return buffer;
+    }
+};
 
 /**
  * @brief Base class that manages memory for a serializer. Specifically, it ensures that the
@@ -23,11 +48,6 @@
  */
 template <typename T>
 class SerializerBase {
-   private:
-     /**
-      * @brief Length of string returned by print().
-      */
-     size_t strlength;
    protected:
     /**
      * @brief Minima and maxima used for fixed-point compression of objects.
@@ -46,70 +66,66 @@ class SerializerBase {
     bit_array serialized_val;
 
     /**
-     * @brief Container for printed value of serialized object.
+     * @brief Container for printed value of serialized object. Points to the
+     * shared print buffer, so it holds at most SerializerPrintBuffer::size
+     * characters.
      */
-    char* printed_val = nullptr;
+    char* printed_val = SerializerPrintBuffer::get();
 
     /**
      * @brief Argumented constructor. This is protected to prevent construction of this
      * implementation-less base class.
+     *
+     * @param strlength Maximum length of the string returned by print(),
+     * including the null terminator.
      */
-    SerializerBase(T min, T max, size_t compressed_size, size_t _strlength) :
-        strlength(_strlength),
+    SerializerBase(T min, T max, size_t compressed_size, size_t strlength) :
         _min(min),
         _max(max),
         serialized_val()
     {
+        assert(strlength <= SerializerPrintBuffer::size);
         serialized_val.resize(compressed_size);
-
-        this->printed_val = new char[strlength];
-        memset(printed_val, '\0', strlength);
     }
 
     /**
      * @brief Copy constructor.
      */
-    SerializerBase(const SerializerBase& other) {
-        *this = other;
-    }
+    SerializerBase(const SerializerBase& other) :
+        _min(other._min),
+        _max(other._max),
+        serialized_val(other.serialized_val) {}
 
     /**
-     * @brief Copy assignment operator.
+     * @brief Copy assignment operator. The bit array is resized to match, since
+     * bit arrays only copy arrays of the same size.
      */
     SerializerBase& operator=(const SerializerBase& rhs) {
         _min = rhs._min;
         _max = rhs._max;
         serialized_val.resize(rhs.serialized_val.size());
         serialized_val = rhs.serialized_val;
-
-        delete[] printed_val;
-        strlength = rhs.strlength;
-        printed_val = new char[strlength];
-        memcpy(printed_val, rhs.printed_val, strlength);
-
         return *this;
     }
 
     /**
-     * @brief Move constructor.
+     * @brief Move constructor. The print buffer is shared, so only the bit
+     * array is taken over from the other serializer.
      */
-    SerializerBase(SerializerBase&& other) {
-        *this = other;
-    }
+    SerializerBase(SerializerBase&& other) :
+        _min(other._min),
+        _max(other._max),
+        serialized_val(std::move(other.serialized_val)) {}
 
     /**
-     * @brief Move assignment operator.
+     * @brief Move assignment operator. The bit array is resized to match, as
+     * in copy assignment, before it is taken over.
      */
     SerializerBase& operator=(SerializerBase&& rhs) {
         _min = rhs._min;
         _max = rhs._max;
         serialized_val.resize(rhs.serialized_val.size());
         serialized_val = std::move(rhs.serialized_val);
-
-        delete[] printed_val;
-        strlength = rhs.strlength;
-        printed_val = rhs.printed_val;
-        rhs.printed_val = nullptr;
         return *this;
     }
 
@@ -125,6 +141,21 @@ class SerializerBase {
      */
     virtual void serialize(const T& src) = 0;
 
+    /**
+     * @brief Serializes a given object directly into a frame, at the frame
+     * writer's cursor. The member bitset is updated as well, just as it is by
+     * serialize(). Serializers that can compute their serialized value as an
+     * integer code override this to write the code into the frame in whole
+     * bytes rather than copying the bitset bit by bit.
+     *
+     * @param src
+     * @param writer
+     */
+    virtual void serialize_into(const T& src, FrameWriter& writer) {
+        serialize(src);
+        writer.write(serialized_val);
+    }
+
     /**
      * @brief Deserializes the contents stored in the provided character array
      * and stores the result in the provided object pointer. Also updates
@@ -152,8 +183,8 @@ class SerializerBase {
      * @brief Outputs a string representation of the source value into
      * the given destination string.
      *
-     * In order to enable good use of memory, the maximum length of the string
-     * representation can be found in the member variable "str_len".
+     * The string is stored in the buffer shared by all serializers, so it is
+     * only valid until the next call to print().
      *
      * @param src  Source value
      *
@@ -197,9 +228,7 @@ class SerializerBase {
 };
 
 template <typename T>
-SerializerBase<T>::~SerializerBase() {
-    delete[] printed_val;
-}
+SerializerBase<T>::~SerializerBase() {}
 
 /**
  * @brief Public facing, constructible version of SerializerBase.
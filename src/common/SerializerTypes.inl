@@ -19,10 +19,13 @@ class Serializer<bool> : public SerializerBase<bool> {
 
     Serializer() : SerializerBase<bool>(false, true, 1, print_sz) {}
 
-    Serializer(const Serializer<bool>& other) : SerializerBase<bool>(other) {}
-
     void serialize(const bool& src) override { serialized_val[0] = src; }
 
+    void serialize_into(const bool& src, FrameWriter& writer) override {
+        serialized_val[0] = src;
+        writer.write(src, 1);
+    }
+
     bool deserialize(const char* val, bool* dest) override {
         if (strcmp(val, "false") == 0)
             *dest = false;
@@ -92,17 +95,30 @@ class IntegerSerializer : public SerializerBase<T> {
         return interval_per_bit;
     }
 
-    void serialize(const T& src) override {
+    /**
+     * @brief Computes the fixed-point code of the given value.
+     */
+    unsigned long long encode(const T& src) const {
         T src_copy = src;
         if (src_copy > this->_max) src_copy = this->_max;
         if (src_copy < this->_min) src_copy = this->_min;
 
         unsigned int resolution = _resolution();
         if (resolution != 0)
-            this->serialized_val.set_ullong((src_copy - this->_min) / resolution);
+            return (src_copy - this->_min) / resolution;
         else
             // Can't divide by zero!
-            this->serialized_val.set_ullong(0);
+            return 0;
+    }
+
+    void serialize(const T& src) override {
+        this->serialized_val.set_ullong(encode(src));
+    }
+
+    void serialize_into(const T& src, FrameWriter& writer) override {
+        const unsigned long long code = encode(src);
+        this->serialized_val.set_ullong(code);
+        writer.write(code, this->serialized_val.size());
     }
 
     bool deserialize(const char* val, T* dest) override {
@@ -122,9 +138,9 @@ class IntegerSerializer : public SerializerBase<T> {
 
     const char* print(const T& src) const override {
         if (std::is_same<T, unsigned int>::value || std::is_same<T, unsigned char>::value)
-            sprintf(this->printed_val, "%u", src);
+            snprintf(this->printed_val, SerializerPrintBuffer::size, "%u", src);
         else
-            sprintf(this->printed_val, "%d", src);
+            snprintf(this->printed_val, SerializerPrintBuffer::size, "%d", src);
         return this->printed_val;
     }
 };
@@ -222,7 +238,10 @@ class FloatDoubleSerializer : public SerializerBase<T> {
     }
 
   public:
-    void serialize(const T& src) override {
+    /**
+     * @brief Computes the fixed-point code of the given value.
+     */
+    unsigned long long encode(const T& src) const {
         const unsigned long long num_intervals = std::pow(2, this->serialized_val.size()) - 1;
 
         T src_copy = src;
@@ -232,9 +251,17 @@ class FloatDoubleSerializer : public SerializerBase<T> {
         T resolution = 0;
         if (num_intervals > 0) resolution = (this->_max - this->_min) / num_intervals;
 
-        const unsigned long long result_int = (src_copy - this->_min) / resolution;
+        return (src_copy - this->_min) / resolution;
+    }
+
+    void serialize(const T& src) override {
+        this->serialized_val.set_ullong(encode(src));
+    }
 
-        this->serialized_val.set_ullong(result_int);
+    void serialize_into(const T& src, FrameWriter& writer) override {
+        const unsigned long long code = encode(src);
+        this->serialized_val.set_ullong(code);
+        writer.write(code, this->serialized_val.size());
     }
 
     bool deserialize(const char* val, T* dest) override {
@@ -252,21 +279,27 @@ class FloatDoubleSerializer : public SerializerBase<T> {
         return true;
     }
 
-    void deserialize(T* dest) const override {
+    /**
+     * @brief Computes the value of the given fixed-point code.
+     */
+    T decode(unsigned long long f_bits) const {
         const unsigned long long num_intervals = std::pow(2, this->serialized_val.size()) - 1;
 
-        const unsigned long long f_bits = this->serialized_val.to_ullong();
         T resolution;
         if (num_intervals > 0)
             resolution = (this->_max - this->_min) / num_intervals;
         else
             resolution = 0;
 
-        *dest = this->_min + resolution * f_bits;
+        return this->_min + resolution * f_bits;
+    }
+
+    void deserialize(T* dest) const override {
+        *dest = decode(this->serialized_val.to_ullong());
     }
 
     const char* print(const T& src) const override {
-        sprintf(this->printed_val, "%6.6f", src);
+        snprintf(this->printed_val, SerializerPrintBuffer::size, "%6.6f", src);
         return this->printed_val;
     }
 };
@@ -304,8 +337,8 @@ namespace VectorSerializerFns
         static_assert(std::is_floating_point<T>::value, "");
 
         size_t str_idx = 0;
-        for (size_t i = 0; i < N; i++) {
-            str_idx += sprintf(dest + str_idx, "%6.6f,", src[i]);
+        for (size_t i = 0; i < N && str_idx < SerializerPrintBuffer::size; i++) {
+            str_idx += snprintf(dest + str_idx, SerializerPrintBuffer::size - str_idx, "%6.6f,", src[i]);
         }
         return dest;
     }
@@ -345,6 +378,30 @@ namespace VectorSerializerFns
         *dest = temp_dest;
         return true;
     }
+
+    /**
+     * Store the lowest num_bits bits of a fixed-point code into a bit array,
+     * LSB first, starting at the given offset.
+     */
+    inline void pack_code(std::vector<bool>& dest, size_t offset, unsigned long long code,
+        size_t num_bits)
+    {
+        for (size_t i = 0; i < num_bits; i++) dest[offset + i] = (code >> i) & 1;
+    }
+
+    /**
+     * Read a fixed-point code of num_bits bits from a bit array, starting at the
+     * given offset.
+     */
+    inline unsigned long long unpack_code(const std::vector<bool>& src, size_t offset,
+        size_t num_bits)
+    {
+        unsigned long long code = 0;
+        for (size_t i = 0; i < num_bits; i++) {
+            code |= static_cast<unsigned long long>(src[offset + i]) << i;
+        }
+        return code;
+    }
 };
 
 /**
@@ -431,31 +488,75 @@ class VectorSerializer : public SerializerBase<std::array<T, 3>> {
         this->_max[0] = max;
     }
 
-  public:
-    void serialize(const std::array<T,3>& src) override {
+  protected:
+    /**
+     * @brief Quantizes a vector into its quadrant bit and the fixed-point codes
+     * of its magnitude, theta and phi, without going through the component
+     * serializers' bitsets.
+     */
+    void encode(const std::array<T, 3>& src, bool* xsign, unsigned long long codes[3]) const {
         lin::Vector<T, 3> normalized_vec {src[0], src[1], src[2]};
         T magnitude = lin::norm(normalized_vec);
         normalized_vec = normalized_vec / magnitude;
 
         T theta = std::acos(normalized_vec(2));
         T phi = std::atan(normalized_vec(1) / normalized_vec(0));
-        bool xsign = normalized_vec(0) > 0;
+        *xsign = normalized_vec(0) > 0;
 
-        magnitude_serializer.serialize(magnitude);
-        theta_serializer.serialize(theta);
-        phi_serializer.serialize(phi);
+        codes[0] = magnitude_serializer.encode(magnitude);
+        codes[1] = theta_serializer.encode(theta);
+        codes[2] = phi_serializer.encode(phi);
+    }
 
-        bit_array::iterator serialized_position = this->serialized_val.begin();
-        serialized_position[0] = xsign;
-        serialized_position++;
-        auto copy_bits = [&serialized_position](Serializer<T>& sr) {
-            auto const& bit_array = sr.get_bit_array();
-            std::copy(bit_array.begin(), bit_array.end(), serialized_position);
-            std::advance(serialized_position, bit_array.size());
-        };
-        copy_bits(magnitude_serializer);
-        copy_bits(theta_serializer);
-        copy_bits(phi_serializer);
+    /**
+     * @brief Deserializes a vector stored in a bit buffer at the given offset.
+     */
+    void decode(const std::vector<bool>& src, size_t offset, std::array<T, 3>* dest) const {
+        bool xsign = src[offset];
+        offset++;
+
+        const size_t b_mag = magnitude_serializer.bitsize();
+        const size_t b_angle = theta_serializer.bitsize();
+        T magnitude = magnitude_serializer.decode(VectorSerializerFns::unpack_code(src, offset, b_mag));
+        offset += b_mag;
+        T theta = theta_serializer.decode(VectorSerializerFns::unpack_code(src, offset, b_angle));
+        offset += b_angle;
+        T phi = phi_serializer.decode(VectorSerializerFns::unpack_code(src, offset, b_angle));
+
+        int xfactor = xsign ? 1 : -1;
+        (*dest)[0] = xfactor * magnitude * std::sin(theta) * std::cos(phi);
+        (*dest)[1] = xfactor * magnitude * std::sin(theta) * std::sin(phi);
+        (*dest)[2] = magnitude * std::cos(theta);
+    }
+
+    void pack(bool xsign, const unsigned long long codes[3]) {
+        this->serialized_val[0] = xsign;
+        size_t offset = 1;
+        VectorSerializerFns::pack_code(this->serialized_val, offset, codes[0], magnitude_serializer.bitsize());
+        offset += magnitude_serializer.bitsize();
+        VectorSerializerFns::pack_code(this->serialized_val, offset, codes[1], theta_serializer.bitsize());
+        offset += theta_serializer.bitsize();
+        VectorSerializerFns::pack_code(this->serialized_val, offset, codes[2], phi_serializer.bitsize());
+    }
+
+  public:
+    void serialize(const std::array<T,3>& src) override {
+        bool xsign;
+        unsigned long long codes[3];
+        encode(src, &xsign, codes);
+        pack(xsign, codes);
+    }
+
+    void serialize_into(const std::array<T, 3>& src, FrameWriter& writer) override {
+        bool xsign;
+        unsigned long long codes[3];
+        encode(src, &xsign, codes);
+        pack(xsign, codes);
+
+        writer.write(xsign, 1);
+        writer.write(codes[0], magnitude_serializer.bitsize());
+        writer.write(codes[1], theta_serializer.bitsize());
+        writer.write(codes[2], phi_serializer.bitsize());
     }
 
     bool deserialize(const char* val, std::array<T, 3>* dest) override {
@@ -465,30 +566,7 @@ class VectorSerializer : public SerializerBase<std::array<T, 3>> {
     }
 
     void deserialize(std::array<T, 3>* dest) const override {
-        bit_array::const_iterator serialized_position = this->serialized_val.begin();
-        bool xsign = serialized_position[0];
-        serialized_position++;
-        auto copy_bits = [&serialized_position](Serializer<T>& sr) {
-            auto& bit_array = sr.get_bit_array();
-            for(size_t i = 0; i < bit_array.size(); i++)
-            {
-                bit_array[i] = *serialized_position;
-                serialized_position++;
-            }
-        };
-        copy_bits(magnitude_serializer);
-        copy_bits(theta_serializer);
-        copy_bits(phi_serializer);
-
-        T magnitude, theta, phi;
-        magnitude_serializer.deserialize(&magnitude);
-        theta_serializer.deserialize(&theta);
-        phi_serializer.deserialize(&phi);
-        
-        int xfactor = xsign ? 1 : -1;
-        (*dest)[0] = xfactor * magnitude * std::sin(theta) * std::cos(phi);
-        (*dest)[1] = xfactor * magnitude * std::sin(theta) * std::sin(phi);
-        (*dest)[2] = magnitude * std::cos(theta);
+        decode(this->serialized_val, 0, dest);
     }
 
     const char* print(const std::array<T, 3>& src) const override {
@@ -541,13 +619,17 @@ class QuaternionSerializer : public SerializerBase<std::array<T, 4>> {
         }
     }
 
-  public:
-    void serialize(const std::array<T, 4>& src) override {
+    /**
+     * @brief Computes the serialized code of a quaternion: the index of its
+     * largest component in the lowest two bits, followed by the fixed-point
+     * codes of the three other components.
+     */
+    unsigned long long encode(const std::array<T, 4>& src) const {
         lin::Vector<T, 4> normalized_quat {src[0], src[1], src[2], src[3]};
         normalized_quat = normalized_quat / lin::norm(normalized_quat);
         std::array<T, 4> src_normalized(src);
         for(unsigned int i = 0; i<4; i++) src_normalized[i] = normalized_quat(i);
-        
+
         // Get and store index of maximum-valued component
         T max_element_mag = 0;
         unsigned int max_component_idx = 0;
@@ -558,15 +640,10 @@ class QuaternionSerializer : public SerializerBase<std::array<T, 4>> {
                 max_component_idx = i;
             }
         }
-
-        std::bitset<2> max_component(max_component_idx);
-
-        bit_array::iterator serialized_position = this->serialized_val.begin();
-        this->serialized_val[0] = max_component[0];
-        this->serialized_val[1] = max_component[1];
-        std::advance(serialized_position, 2);
+        unsigned long long code = max_component_idx;
 
         // Store serialized non-maximal components
+        size_t shift = 2;
         size_t component_number = 0;
         for (size_t i = 0; i < 4; i++) {
             if (i != max_component_idx) {
@@ -574,64 +651,59 @@ class QuaternionSerializer : public SerializerBase<std::array<T, 4>> {
                 // Thus to indicate sign of the largest component, negate all other components.
                 if(src[max_component_idx] < 0) src_normalized[i] *= -1;
 
-                auto& element_sr = quaternion_element_serializers[component_number];
-
-                element_sr->serialize(src_normalized[i]);
-
-                std::copy(element_sr->get_bit_array().begin(),
-                          element_sr->get_bit_array().end(),
-                          serialized_position);
-                std::advance(serialized_position, element_sr->bitsize());
+                const auto& element_sr = quaternion_element_serializers[component_number];
+                code |= element_sr->encode(src_normalized[i]) << shift;
+                shift += quat_component_sz();
                 component_number++;
             }
-        }      
-    }
-
-    bool deserialize(const char* val, std::array<T, 4>* dest) override {
-        bool success = VectorSerializerFns::deserialize_vector_str<T, 4>(val, dest);
-        if (success) serialize(*dest);
-        return success;
+        }
+        return code;
     }
 
-    void deserialize(std::array<T, 4>* dest) const override {
-        bit_array::const_iterator serialized_position = this->serialized_val.begin();
-
-        // read which component index is highest into a bitset for later use
-        std::bitset<2> max_component;
-        for(size_t i = 0; i<max_component.size(); i++){
-            max_component[i] = *serialized_position;
-            serialized_position++;
-        }
-        unsigned int max_idx = max_component.to_ulong();
+    /**
+     * @brief Computes the quaternion given by a serialized code.
+     */
+    void decode(unsigned long long code, std::array<T, 4>* dest) const {
+        const unsigned int max_idx = code & 0b11;
+        code >>= 2;
 
         if (std::is_same<T, float>::value) (*dest)[max_idx] = 1.0f;
         else (*dest)[max_idx] = 1.0;
 
-        // loop through each serializer
-        for(unsigned int i = 0; i<3; i++){
-            auto& element_sr = quaternion_element_serializers[i];
-            auto& element_bitarray = element_sr->get_bit_array();
-
-            // loop through each bit belonging to the serializer
-            for(size_t j = 0; j < element_sr->bitsize(); j++){       
-                element_bitarray[j] = *serialized_position;
-                serialized_position++;
-            }
-
-            element_sr->set_bit_array(element_bitarray);
-        }
-
+        const unsigned long long component_mask = (1ULL << quat_component_sz()) - 1;
         size_t j = 0; // Index of current component being processed
         for (size_t i = 0; i < 4; i++) {
             if (i != max_idx) {
-                quaternion_element_serializers[j]->deserialize(&(*dest)[i]);
+                (*dest)[i] = quaternion_element_serializers[j]->decode(code & component_mask);
                 (*dest)[max_idx] -= (*dest)[i] * (*dest)[i];
+                code >>= quat_component_sz();
                 j++;
             }
         }
         (*dest)[max_idx] = sqrt((*dest)[max_idx]);
     }
 
+  public:
+    void serialize(const std::array<T, 4>& src) override {
+        VectorSerializerFns::pack_code(this->serialized_val, 0, encode(src), this->bitsize());
+    }
+
+    void serialize_into(const std::array<T, 4>& src, FrameWriter& writer) override {
+        const unsigned long long code = encode(src);
+        VectorSerializerFns::pack_code(this->serialized_val, 0, code, this->bitsize());
+        writer.write(code, this->bitsize());
+    }
+
+    bool deserialize(const char* val, std::array<T, 4>* dest) override {
+        bool success = VectorSerializerFns::deserialize_vector_str<T, 4>(val, dest);
+        if (success) serialize(*dest);
+        return success;
+    }
+
+    void deserialize(std::array<T, 4>* dest) const override {
+        decode(VectorSerializerFns::unpack_code(this->serialized_val, 0, this->bitsize()), dest);
+    }
+
     const char* print(const std::array<T, 4>& src) const override {
         return VectorSerializerFns::vector_print<T, 4>(src, this->printed_val);
     }
@@ -723,6 +795,11 @@ class LinVectorSerializer :  public SerializerBase<lin::Vector<T, N>> {
         return _arr_sr->print(src_cpy);
     }
 
+    void serialize_into(const lin::Vector<T, N>& src, FrameWriter& writer) override {
+        serialize(src);
+        writer.write(_arr_sr->get_bit_array());
+    }
+
     const bit_array& get_bit_array() const { return _arr_sr->get_bit_array(); }
     bit_array& get_bit_array() { return _arr_sr->get_bit_array(); }
 
@@ -824,7 +901,7 @@ class Serializer<gps_time_t> : public SerializerBase<gps_time_t> {
     }
 
     const char* print(const gps_time_t& src) const override {
-        sprintf(this->printed_val, "%hu,%d,%d", src.wn, src.tow, src.ns);
+        snprintf(this->printed_val, SerializerPrintBuffer::size, "%hu,%d,%d", src.wn, src.tow, src.ns);
         return this->printed_val;
     }
 };
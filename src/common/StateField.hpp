@@ -7,6 +7,8 @@
 #define STATE_FIELD_HPP_
 
 #include "StateFieldBase.hpp"
+#include <cstring>
+#include <type_traits>
 
 /**
  * @brief A lightweight container around state fields that allows thread-safe
@@ -55,6 +57,31 @@ class StateField : public virtual StateFieldBase {
      */
     void set(const T &t) { _val = t; }
 
+    /**
+     * @brief Checkpoint the field's value. Pointers only refer to the
+     * process that created them, so pointer-valued fields aren't checkpointed.
+     *
+     * @{
+     */
+    size_t checkpoint_size() const override {
+      return std::is_pointer<T>::value ? 0 : sizeof(T);
+    }
+
+    // The size is looked up non-virtually, since subclasses that checkpoint
+    // more than the value call these for the value alone.
+    void save_checkpoint(unsigned char *dst) const override {
+      static_assert(std::is_trivially_copyable<T>::value,
+        "State field values must be trivially copyable to be checkpointed.");
+      std::memcpy(dst, &_val, StateField<T>::checkpoint_size());
+    }
+
+    void load_checkpoint(const unsigned char *src) override {
+      std::memcpy(&_val, src, StateField<T>::checkpoint_size());
+    }
+    /**
+     * @}
+     */
+
     /**
      * @brief Accessors.
      *
@@ -2,6 +2,7 @@
 #define STATE_FIELD_BASE_HPP_
 
 #include "Nameable.hpp"
+#include <cstddef>
 
 /**
  * @brief Dummy class so that we can create pointers of type StateFieldBase that point to objects of
@@ -13,6 +14,15 @@ class StateFieldBase : public Nameable {
     virtual bool is_writable() const = 0;
    public:
     virtual ~StateFieldBase() {};
+
+    /**
+     * @brief Number of bytes needed to store the exact state of the field in
+     * a registry checkpoint, and functions to copy that state to and from
+     * the checkpoint. See StateFieldRegistry::save_checkpoint.
+     */
+    virtual size_t checkpoint_size() const { return 0; }
+    virtual void save_checkpoint(unsigned char *dst) const {}
+    virtual void load_checkpoint(const unsigned char *src) {}
 };
 
 #endif
\ No newline at end of file
@@ -1,5 +1,8 @@
 #include "StateFieldRegistry.hpp"
 
+static constexpr unsigned char checkpoint_version = 1;
+static constexpr size_t checkpoint_header_size = 5;
+
 StateFieldRegistry::StateFieldRegistry() {}
 
 InternalStateFieldBase*
@@ -98,3 +101,55 @@ bool StateFieldRegistry::add_fault(Fault* fault) {
     faults.push_back(fault);
     return true;
 }
+
+template<typename Fn>
+void StateFieldRegistry::for_each_checkpointed(Fn fn) const {
+    for (InternalStateFieldBase* field : internal_fields) fn(field);
+    for (ReadableStateFieldBase* field : readable_fields) fn(field);
+    for (Event* event : events) fn(event);
+}
+
+unsigned int StateFieldRegistry::checkpoint_fingerprint() const {
+    unsigned int hash = 2166136261u;
+    auto mix = [&hash](unsigned char byte) { hash = (hash ^ byte) * 16777619u; };
+    for_each_checkpointed([&mix](const StateFieldBase* field) {
+        for (char c : field->name()) mix(static_cast<unsigned char>(c));
+        mix(0);
+        const size_t size = field->checkpoint_size();
+        for (unsigned int k = 0; k < 4; k++) mix((size >> (8 * k)) & 0xFF);
+    });
+    return hash;
+}
+
+void StateFieldRegistry::save_checkpoint(std::vector<unsigned char>& blob) const {
+    size_t size = checkpoint_header_size;
+    for_each_checkpointed([&size](const StateFieldBase* field) { size += field->checkpoint_size(); });
+
+    blob.resize(size);
+    blob[0] = checkpoint_version;
+    const unsigned int fingerprint = checkpoint_fingerprint();
+    for (unsigned int k = 0; k < 4; k++) blob[1 + k] = (fingerprint >> (8 * k)) & 0xFF;
+
+    size_t pos = checkpoint_header_size;
+    for_each_checkpointed([&blob, &pos](const StateFieldBase* field) {
+        field->save_checkpoint(blob.data() + pos);
+        pos += field->checkpoint_size();
+    });
+}
+
+bool StateFieldRegistry::load_checkpoint(const std::vector<unsigned char>& blob) {
+    size_t size = checkpoint_header_size;
+    for_each_checkpointed([&size](const StateFieldBase* field) { size += field->checkpoint_size(); });
+    if (blob.size() != size || blob[0] != checkpoint_version) return false;
+
+    unsigned int fingerprint = 0;
+    for (unsigned int k = 0; k < 4; k++) fingerprint |= static_cast<unsigned int>(blob[1 + k]) << (8 * k);
+    if (fingerprint != checkpoint_fingerprint()) return false;
+
+    size_t pos = checkpoint_header_size;
+    for_each_checkpointed([&blob, &pos](StateFieldBase* field) {
+        field->load_checkpoint(blob.data() + pos);
+        pos += field->checkpoint_size();
+    });
+    return true;
+}
@@ -114,6 +114,41 @@ class StateFieldRegistry {
      * @param fault Data fault
      */
     bool add_fault(Fault* fault);
+
+    /**
+     * @brief Saves the values of every internal field, readable field, and
+     * event in the registry into a binary checkpoint.
+     *
+     * The checkpoint starts with a version byte and a fingerprint of the names
+     * and checkpoint sizes of the fields, followed by each field's checkpoint
+     * in registration order. Values are stored in the host's byte order, so a
+     * checkpoint can only be restored on the kind of machine that saved it.
+     *
+     * @param[out] blob Checkpoint. Its storage is reused across calls.
+     */
+    void save_checkpoint(std::vector<unsigned char>& blob) const;
+
+    /**
+     * @brief Restores every field from a checkpoint saved by a registry with
+     * the same fields.
+     *
+     * @param blob Checkpoint.
+     * @return False, leaving the fields unchanged, if the checkpoint was saved
+     *         by a different version or by a registry with different fields.
+     */
+    bool load_checkpoint(const std::vector<unsigned char>& blob);
+
+  private:
+    /**
+     * @brief Calls fn on every field that is part of a checkpoint, in order.
+     */
+    template<typename Fn>
+    void for_each_checkpointed(Fn fn) const;
+
+    /**
+     * @brief FNV-1a hash of the name and checkpoint size of every field.
+     */
+    unsigned int checkpoint_fingerprint() const;
 };
 
 #endif
@@ -1,4 +1,5 @@
 #include "Serializer.hpp"
+#include "StaticSerializer.hpp"
 #include "StateField.hpp"
 
 /**
@@ -28,6 +29,16 @@ class InternalStateField : public StateField<T>, public InternalStateFieldBase {
 class SerializableStateFieldBase : virtual public StateFieldBase {
    public:
     virtual void serialize() = 0;
+
+    /**
+     * @brief Serialize field data directly into a frame at the writer's cursor.
+     * By default this goes through the field's bitset.
+     */
+    virtual void serialize_into(FrameWriter& writer) {
+      serialize();
+      writer.write(get_bit_array());
+    }
+
     virtual void deserialize() = 0;
     virtual bool deserialize(const char *val) = 0;
     virtual const char *print() const = 0;
@@ -173,6 +184,12 @@ class SerializableStateField : public StateField<T>, virtual public Serializable
      */
     void serialize() override { _serializer.serialize(this->_val); }
 
+    /**
+     * @brief Serialize field data directly into a frame. The internal bitset
+     * is updated as well.
+     */
+    void serialize_into(FrameWriter& writer) override { _serializer.serialize_into(this->_val, writer); }
+
     /**
      * @brief Deserialize field data from the internally contained bitset and store
      * into the state field value.
@@ -253,3 +270,46 @@ class WritableStateField : public SerializableStateField<T>, public WritableStat
      */
     virtual bool is_writable_field() const { return true; }
 };
+
+/**
+ * @brief A readable or writable state field whose serialization is done by a
+ * StaticSerializer. This is a drop-in replacement for its base field type:
+ * registry lookups, bounds queries and string parsing behave exactly as they
+ * would for the base type, but serialization and deserialization skip the
+ * virtual serializer calls and the runtime resolution computations.
+ *
+ * The field still holds the dynamic serializer of its base type, which
+ * provides the bit array, the bounds queries and string parsing, and which
+ * the ground software relies on when it casts fields to their base type. A
+ * static field therefore uses as much memory as a dynamic one; the savings
+ * are in execution time only.
+ *
+ * @tparam Field Base field type, i.e. ReadableStateField<T> or WritableStateField<T>.
+ * @tparam S     StaticSerializer for the field's type.
+ */
+template <typename Field, typename S>
+class StaticSerializedStateField : public Field {
+  public:
+    StaticSerializedStateField(const std::string &name)
+        : Field(name, S::make_serializer()) {}
+
+    StaticSerializedStateField(const std::string &name, unsigned int eeprom_save_period)
+        : Field(name, S::make_serializer(), eeprom_save_period) {}
+
+    void serialize() override { S::serialize(this->_val, this->_serializer.get_bit_array()); }
+    void deserialize() override { S::deserialize(this->_serializer.get_bit_array(), &(this->_val)); }
+    void serialize_into(FrameWriter& writer) override {
+        const unsigned long long code = S::encode(this->_val);
+        this->_serializer.get_bit_array().set_ullong(code);
+        writer.write(code, S::bitsize);
+    }
+    using Field::deserialize;
+};
+
+template <typename S>
+using StaticReadableStateField =
+    StaticSerializedStateField<ReadableStateField<typename S::value_type>, S>;
+
+template <typename S>
+using StaticWritableStateField =
+    StaticSerializedStateField<WritableStateField<typename S::value_type>, S>;
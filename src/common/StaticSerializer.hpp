@@ -0,0 +1,150 @@
+#ifndef STATIC_SERIALIZER_HPP_
+#define STATIC_SERIALIZER_HPP_
+
+#include <type_traits>
+#include "Serializer.hpp"
+
+/**
+ * @brief Serializer whose bounds and bitsize are known at compile time.
+ *
+ * The fixed-point encoding is identical to the one used by Serializer<T>
+ * with the same bounds and bitsize, so statically and dynamically serialized
+ * fields can be mixed freely in downlinks, uplinks and the ground software.
+ * The number of intervals and the resolution are compile-time constants, so
+ * encoding and decoding reduce to a clamp, a scale and an offset.
+ *
+ * Since C++14 doesn't allow floating point template parameters, the bounds
+ * are integers regardless of the serialized type.
+ *
+ * @tparam T    Type of value to serialize.
+ * @tparam Min  Minimum value of the serialized range.
+ * @tparam Max  Maximum value of the serialized range.
+ * @tparam Bits Size of the serialized value in bits.
+ */
+template <typename T, long long Min, long long Max, size_t Bits>
+class StaticSerializer {
+    static_assert(std::is_same<T, bool>::value ||
+                  std::is_same<T, unsigned int>::value ||
+                  std::is_same<T, signed int>::value ||
+                  std::is_same<T, unsigned char>::value ||
+                  std::is_same<T, signed char>::value ||
+                  std::is_floating_point<T>::value,
+                  "Static serializers only support booleans, integers, chars, floats and doubles.");
+    static_assert(Min <= Max, "Minimum of a static serializer must not exceed its maximum.");
+    static_assert(Bits > 0 && Bits < 64, "Static serializers must have between 1 and 63 bits.");
+    static_assert(std::is_floating_point<T>::value || Bits <= 8 * sizeof(T),
+                  "Static serializer bitsize exceeds the size of its integer type.");
+    static_assert(!std::is_same<T, bool>::value || (Min == 0 && Max == 1 && Bits == 1),
+                  "Boolean static serializers must be StaticSerializer<bool, 0, 1, 1>.");
+
+  public:
+    using value_type = T;
+
+    static constexpr long long min = Min;
+    static constexpr long long max = Max;
+    static constexpr size_t bitsize = Bits;
+
+    /**
+     * @brief Largest serialized code, i.e. the number of intervals the
+     * range is divided into.
+     */
+    static constexpr unsigned long long num_intervals = (1ULL << Bits) - 1;
+
+    /**
+     * @brief Resolution of integer serializers, rounded up so that the
+     * maximum is always representable. Matches IntegerSerializer.
+     */
+    static constexpr unsigned long long int_resolution =
+        (static_cast<unsigned long long>(Max - Min) + num_intervals - 1) / num_intervals;
+
+    /**
+     * @brief Construct a dynamic serializer with the same encoding, for use by
+     * code that inspects a field's bounds at runtime. Static serialized state
+     * fields are built around one, so they take no less memory than regular
+     * fields.
+     */
+    static Serializer<T> make_serializer() {
+        return _make_serializer(std::integral_constant<bool, std::is_same<T, bool>::value>());
+    }
+
+    /**
+     * @brief Compute the serialized code of a value.
+     */
+    static unsigned long long encode(const T& src) {
+        return _encode(src, std::is_floating_point<T>());
+    }
+
+    /**
+     * @brief Compute the value of a serialized code.
+     */
+    static T decode(unsigned long long code) {
+        return _decode(code, std::is_floating_point<T>());
+    }
+
+    /**
+     * @brief Serialize a value into a bit array of size Bits.
+     */
+    static void serialize(const T& src, bit_array& dest) {
+        const unsigned long long code = encode(src);
+        for (size_t i = 0; i < Bits; i++) dest[i] = (code >> i) & 1;
+    }
+
+    /**
+     * @brief Deserialize a value from a bit array of size Bits.
+     */
+    static void deserialize(const bit_array& src, T* dest) {
+        unsigned long long code = 0;
+        for (size_t i = 0; i < Bits; i++) code |= static_cast<unsigned long long>(src[i]) << i;
+        *dest = decode(code);
+    }
+
+  private:
+    static Serializer<T> _make_serializer(std::true_type) { return Serializer<T>(); }
+    static Serializer<T> _make_serializer(std::false_type) {
+        return Serializer<T>(static_cast<T>(Min), static_cast<T>(Max), Bits);
+    }
+
+    static unsigned long long _encode(const T& src, std::false_type) {
+        long long x = static_cast<long long>(src);
+        if (x > Max) x = Max;
+        if (x < Min) x = Min;
+        if (int_resolution == 0) return 0; // Min == Max, so there's nothing to encode.
+        return static_cast<unsigned long long>(x - Min) / int_resolution;
+    }
+
+    static unsigned long long _encode(const T& src, std::true_type) {
+        T x = src;
+        if (x > static_cast<T>(Max)) x = static_cast<T>(Max);
+        if (x < static_cast<T>(Min)) x = static_cast<T>(Min);
+        return static_cast<unsigned long long>((x - static_cast<T>(Min)) / float_resolution());
+    }
+
+    static T _decode(unsigned long long code, std::false_type) {
+        return static_cast<T>(Min + static_cast<long long>(code * int_resolution));
+    }
+
+    static T _decode(unsigned long long code, std::true_type) {
+        return static_cast<T>(Min) + float_resolution() * code;
+    }
+
+    /**
+     * @brief Resolution of floating point serializers, computed in T so that
+     * it matches FloatDoubleSerializer bit for bit.
+     */
+    static constexpr T float_resolution() {
+        return static_cast<T>(Max - Min) / num_intervals;
+    }
+};
+
+template <typename T, long long Min, long long Max, size_t Bits>
+constexpr long long StaticSerializer<T, Min, Max, Bits>::min;
+template <typename T, long long Min, long long Max, size_t Bits>
+constexpr long long StaticSerializer<T, Min, Max, Bits>::max;
+template <typename T, long long Min, long long Max, size_t Bits>
+constexpr size_t StaticSerializer<T, Min, Max, Bits>::bitsize;
+template <typename T, long long Min, long long Max, size_t Bits>
+constexpr unsigned long long StaticSerializer<T, Min, Max, Bits>::num_intervals;
+template <typename T, long long Min, long long Max, size_t Bits>
+constexpr unsigned long long StaticSerializer<T, Min, Max, Bits>::int_resolution;
+
+#endif
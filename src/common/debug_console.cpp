@@ -8,6 +8,7 @@
 #include <cstdint>
 
 #ifdef DESKTOP
+    #include "ReplayLog.hpp"
     #include <chrono>
     #include <condition_variable>
     #include <deque>
@@ -143,6 +144,12 @@ void debug_console::open() {
     if (is_open) return;
 
 #ifdef DESKTOP
+    // Console input is taken from the log while replaying.
+    if (ReplayLog::is_replaying()) {
+        is_open = true;
+        return;
+    }
+
     std::cin.tie(nullptr);
     reader_thread_is_running = true;
     reader_thread = std::thread([&]() -> void {
@@ -246,7 +253,8 @@ void debug_console::process_commands(const StateFieldRegistry& registry) {
 
 #ifdef DESKTOP
     std::string input;
-    {
+    bool has_input = false;
+    if (!ReplayLog::is_replaying()) {
         std::unique_lock<std::mutex> lock{input_queue_mutex};
 
         // If requested, block until a new packet has arrived
@@ -254,13 +262,17 @@ void debug_console::process_commands(const StateFieldRegistry& registry) {
             while (!input_queue.size())
                 input_queue_is_not_empty.wait(lock);
 
-        // Only check if a packet is there otherwise return
-        else if (input_queue.size() == 0)
-            return;
-
-        input = input_queue[0];
-        input_queue.pop_front();
+        // Only check if a packet is there
+        has_input = input_queue.size() > 0;
+        if (has_input) {
+            input = input_queue[0];
+            input_queue.pop_front();
+        }
     }
+
+    // Record the packet, or take it from the replay log
+    if (!ReplayLog::console_line(input, has_input))
+        return;
     input.copy(buf, sizeof(buf));
 #else
     char lastchar = '?';
@@ -5,6 +5,7 @@
 #include <array>
 #include <bitset>
 #include <cmath>
+#include <utility>
 #include <vector>
 
 /**
@@ -60,6 +61,12 @@ class fixed_array_base : public std::vector<T> {
         *this = arr;
     }
 
+    /**
+     * @brief Move constructor. Takes over the other array's storage, leaving
+     * it empty.
+     */
+    fixed_array_base(fixed_array_base<T>&& arr) : std::vector<T>(std::move(arr)) {}
+
     /**
      * @brief Allows assignment-by-value using another fixed array. If the arrays are not of the
      * same length, nothing happens.
@@ -88,6 +95,16 @@ class fixed_array_base : public std::vector<T> {
         return *this;
     }
 
+    /**
+     * @brief Move assignment. Like copy assignment, nothing happens if the
+     * arrays are not of the same length.
+     */
+    fixed_array_base& operator=(fixed_array_base<T>&& arr) {
+        if (arr.size() != this->size()) return *this;
+        std::vector<T>::operator=(std::move(arr));
+        return *this;
+    }
+
    private:
     /*
      * Make all length-changing functions unavailable to class's users and children, except for
@@ -119,6 +136,9 @@ class fixed_array : public fixed_array_base<T> {
     explicit fixed_array(const size_t size) : fixed_array_base<T>(size) {}
     fixed_array(const fixed_array<T>& arr) : fixed_array_base<T>(arr) {}
     fixed_array(const std::vector<T>& arr) : fixed_array_base<T>(arr) {}
+    fixed_array(fixed_array<T>&& arr) : fixed_array_base<T>(std::move(arr)) {}
+    fixed_array& operator=(const fixed_array<T>& arr) = default;
+    fixed_array& operator=(fixed_array<T>&& arr) = default;
 };
 
 /**
@@ -134,6 +154,9 @@ class fixed_array<bool> : public fixed_array_base<bool> {
     explicit fixed_array(const size_t size) : fixed_array_base<bool>(size) {}
     fixed_array(const fixed_array<bool>& arr) : fixed_array_base<bool>(arr) {}
     fixed_array(const std::vector<bool>& arr) : fixed_array_base<bool>(arr) {}
+    fixed_array(fixed_array<bool>&& arr) : fixed_array_base<bool>(std::move(arr)) {}
+    fixed_array& operator=(const fixed_array<bool>& arr) = default;
+    fixed_array& operator=(fixed_array<bool>&& arr) = default;
 
     /**
      * @brief Explicit copy constructor for a bitset. Constructs the fixed array to be of the same
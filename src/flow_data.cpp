@@ -22,7 +22,7 @@ const std::vector<DownlinkProducer::FlowData> PAN::flow_data = {
 {15, true, {"adcs_monitor.rwa_speed_rd.x", "adcs_monitor.rwa_speed_rd.y", "adcs_monitor.rwa_speed_rd.z", "adcs_monitor.rwa_torque_rd.x", "adcs_monitor.rwa_torque_rd.y", "adcs_monitor.rwa_torque_rd.z", "adcs_monitor.ssa_mode"}},
 {16, false, {"prop.tank1.valve_choice", "prop.tank2.pressure", "prop.tank2.temp", "prop.tank1.temp", "prop.num_prop_firings"}},
 {17, true, {"attitude.pointer_vec1_current", "attitude.pointer_vec1_desired", "attitude.pointer_vec2_current", "attitude.pointer_vec2_desired"}},
-{18, true, {"radio.err", "radio.last_comms_ccno"}},
+{18, true, {"radio.err", "radio.last_comms_ccno", "radio.mo_depth", "radio.mo_dropped"}},
 {19, true, {"adcs_monitor.mag1_vec.x", "adcs_monitor.mag1_vec.y", "adcs_monitor.mag1_vec.z", "adcs_monitor.mag2_vec.x", "adcs_monitor.mag2_vec.y", "adcs_monitor.mag2_vec.z", "adcs_monitor.gyr_vec.x", "adcs_monitor.gyr_vec.y", "adcs_monitor.gyr_vec.z", "adcs_monitor.ssa_vec"}},
 {20, false, {"adcs_monitor.speed_rd_flag", "adcs_monitor.torque_rd_flag", "adcs_monitor.mag1_vec_flag", "adcs_monitor.mag2_vec_flag", "adcs_monitor.gyr_vec_flag", "adcs_monitor.gyr_temp_flag"}},
 {21, false, {"piksi.pos", "piksi.vel", "piksi.baseline_pos", "piksi.fix_error_count", "piksi.time", "piksi.microdelta"}},
@@ -47,5 +47,6 @@ const std::vector<DownlinkProducer::FlowData> PAN::flow_data = {
 {40, false, {"radio.max_transceive", "radio.max_wait"}},
 {41, false, {"piksi_fh.no_cdpgs_max_wait", "piksi_fh.cdpgs_delay_max_wait", "piksi_fh.enabled"}},
 {42, false, {"prop.max_venting_cycles", "prop.ctrl_cycles_per_closing", "prop.max_pressurizing_cycles", "prop.threshold_firing_pressure", "prop.ctrl_cycles_per_filling", "prop.ctrl_cycles_per_cooling"}},
-{43, false, {"docksys.is_turning", "docksys.config_cmd", "docksys.step_angle", "docksys.step_delay", "docksys.dock_config"}}
+{43, false, {"docksys.is_turning", "docksys.config_cmd", "docksys.step_angle", "docksys.step_delay", "docksys.dock_config"}},
+{44, false, {"radio.sbdix_attempts", "radio.sbdix_successes", "radio.sbdix_success_avg", "radio.mo_bytes", "radio.mt_bytes", "radio.delivery_latency", "radio.delivery_latency_avg", "radio.cycles.config", "radio.cycles.write", "radio.cycles.transceive", "radio.cycles.read", "radio.cycles.wait"}}
 };
@@ -4,9 +4,11 @@
 #include <adcs/havt_devices.hpp>
 #include <gnc/constants.hpp>
 
-ADCSBoxMonitor::ADCSBoxMonitor(StateFieldRegistry &registry, Devices::ADCS &_adcs)
+ADCSBoxMonitor::ADCSBoxMonitor(StateFieldRegistry &registry, Devices::ADCS &_adcs,
+        Devices::I2CScheduler *_scheduler)
     : TimedControlTask<void>(registry, "adcs_monitor"),
     adcs_system(_adcs),
+    scheduler(_scheduler),
     dummy_vec_sr(0, 1, 1),
     rwa_speed_rd_component_sr(adcs::rwa::min_speed_read,adcs::rwa::max_speed_read, 12),
     rwa_speed_rd_f("adcs_monitor.rwa_speed_rd", dummy_vec_sr),
@@ -162,36 +164,51 @@ static lin::Vector<float, N> to_linvector(const std::array<float, N>& src) {
 }
 
 void ADCSBoxMonitor::execute(){
-    //create internal containers to read data
-    f_vector_t rwa_speed_rd;
-    f_vector_t rwa_torque_rd;
-    unsigned char ssa_mode = 0;
-    f_vector_t ssa_vec;
-
-    std::array<float, adcs::ssa::num_sun_sensors> ssa_voltages;
-    ssa_voltages.fill(0);
-
-    f_vector_t mag1_vec;
-    f_vector_t mag2_vec;
-    f_vector_t gyr_vec;
-    float gyr_temp = 0.0;
+    //create internal container to read data
+    Devices::ADCS::telemetry_t telem;
+    telem.ssa_mode = 0;
+    telem.ssa_voltages.fill(0);
+    telem.gyr_temp_rd = 0.0;
     
     // Determine whether a fault has occurred. Evaluating faults before reading from the adcs
     // system allows us to test fault responses in ptest.
     adcs_functional_fault.evaluate(!adcs_is_functional.get());
 
-    //ask the driver to fill in values
-    adcs_is_functional.set(adcs_system.i2c_ping());
+    //take the block read in the background since last cycle; a valid block
+    //carries the box's WHO_AM_I, so it stands in for the ping
+    if(scheduler && adcs_system.take_telemetry(&telem)){
+        adcs_is_functional.set(true);
+    }
+    else{
+        //ask the driver to fill in values
+        adcs_is_functional.set(adcs_system.i2c_ping());
+
+        //read everything in one transaction, falling back to the individual
+        //registers if the telemetry block is corrupt or unsupported by the box
+        if(!adcs_system.get_telemetry(&telem)){
+            adcs_system.get_rwa(&telem.rwa_speed_rd,&telem.rwa_ramp_rd);
+            adcs_system.get_ssa_voltage(&telem.ssa_voltages);
+            adcs_system.get_imu(&telem.mag1_rd, &telem.mag2_rd, &telem.gyr_rd, &telem.gyr_temp_rd);
+            adcs_system.get_ssa_mode(&telem.ssa_mode);
+            if(telem.ssa_mode == adcs::SSAMode::SSA_COMPLETE)
+                adcs_system.get_ssa_vector(&telem.ssa_sun_vec);
+            adcs_system.get_havt(&telem.havt_table);
+        }
+    }
+
+    //start reading next cycle's block
+    if(scheduler) adcs_system.queue_telemetry(*scheduler);
 
-    adcs_system.get_rwa(&rwa_speed_rd,&rwa_torque_rd);
-    adcs_system.get_ssa_voltage(&ssa_voltages);
-    adcs_system.get_imu(&mag1_vec, &mag2_vec, &gyr_vec, &gyr_temp);
+    const f_vector_t& rwa_speed_rd = telem.rwa_speed_rd;
+    const f_vector_t& rwa_torque_rd = telem.rwa_ramp_rd;
+    const f_vector_t& mag1_vec = telem.mag1_rd;
+    const f_vector_t& mag2_vec = telem.mag2_rd;
+    const f_vector_t& gyr_vec = telem.gyr_rd;
+    const float gyr_temp = telem.gyr_temp_rd;
 
     //only update the ssa_vector if and only if the mode was COMPLETE
-    adcs_system.get_ssa_mode(&ssa_mode);
-    if(ssa_mode == adcs::SSAMode::SSA_COMPLETE){
-        adcs_system.get_ssa_vector(&ssa_vec);
-        ssa_vec_f.set(to_linvector(ssa_vec));
+    if(telem.ssa_mode == adcs::SSAMode::SSA_COMPLETE){
+        ssa_vec_f.set(to_linvector(telem.ssa_sun_vec));
     }
     else{
         ssa_vec_f.set(lin::nans<lin::Vector3f>());
@@ -200,7 +217,7 @@ void ADCSBoxMonitor::execute(){
     //set statefields from internal containers
     rwa_speed_rd_f.set(to_linvector(rwa_speed_rd));
     rwa_torque_rd_f.set(to_linvector(rwa_torque_rd));
-    ssa_mode_f.set(ssa_mode);
+    ssa_mode_f.set(telem.ssa_mode);
 
     //populate components
     rwa_speed_rd_x_f.set(rwa_speed_rd[0]);
@@ -225,7 +242,7 @@ void ADCSBoxMonitor::execute(){
 
 
     for(unsigned int i = 0; i<adcs::ssa::num_sun_sensors; i++){
-        ssa_voltages_f[i].set(ssa_voltages[i]);
+        ssa_voltages_f[i].set(telem.ssa_voltages[i]);
     }
     
     // Determine whether a fault has occurred. Evaluating faults before reading from the adcs
@@ -236,11 +253,9 @@ void ADCSBoxMonitor::execute(){
     wheel_pot_fault.evaluate(havt_read_vector[adcs::havt::Index::RWA_POT].get() == false);
 
     // set vector of device availability
-    std::bitset<adcs::havt::max_devices> havt_read(0);
-    adcs_system.get_havt(&havt_read);
     for(unsigned int idx = adcs::havt::Index::IMU_GYR; idx < adcs::havt::Index::_LENGTH; idx++ )
     {
-        havt_read_vector[idx].set(havt_read.test(idx));
+        havt_read_vector[idx].set(telem.havt_table.test(idx));
     }
 
     mag1_vec_f.set(to_linvector(mag1_vec));
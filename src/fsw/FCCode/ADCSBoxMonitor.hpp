@@ -17,12 +17,19 @@ public:
      * 
      * @param registry input StateField registry
      * @param _adcs the input adcs system
+     * @param _scheduler if given, the telemetry block is read in the
+     * background on this scheduler and taken the next cycle, see
+     * Devices::ADCS::queue_telemetry()
      */
-    ADCSBoxMonitor(StateFieldRegistry &registry, Devices::ADCS &_adcs);
+    ADCSBoxMonitor(StateFieldRegistry &registry, Devices::ADCS &_adcs,
+        Devices::I2CScheduler *_scheduler = nullptr);
 
     /** ADCS Driver. **/
     Devices::ADCS& adcs_system;
 
+    /** Scheduler of the ADCS box's wire, or nullptr to read it blocking. **/
+    Devices::I2CScheduler* const scheduler;
+
     /**
     * @brief Gets inputs from the ADCS box and dumps them into the state
     * fields listed below.
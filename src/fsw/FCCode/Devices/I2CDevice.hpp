@@ -33,6 +33,7 @@
  */
 
 #include "Device.hpp"
+#include "I2CScheduler.hpp"
 
 /* Note that I2C_AUTO_RETRY should be enabled - I2CDevice makes no calls to
  * resetBus internally.
@@ -43,6 +43,7 @@ void I2CDevice::i2c_receive_data(T *data, std::size_t len, i2c_stop s) {
 
 inline void I2CDevice::i2c_begin_transmission() {
 #ifndef DESKTOP
+    I2CScheduler::finish_attached();
     this->wire.beginTransmission(this->addr);
 #endif
 }
@@ -62,6 +63,7 @@ inline void I2CDevice::i2c_send_transmission(i2c_stop s) {
 
 inline void I2CDevice::i2c_request_from(std::size_t len, i2c_stop s) {
 #ifndef DESKTOP
+    I2CScheduler::finish_attached();
     bool err = (this->wire.requestFrom(this->addr, len, s, this->timeout) == 0);
     this->recent_errors = (this->recent_errors || err);
 #endif
@@ -112,6 +114,7 @@ inline void I2CDevice::i2c_write_to_subaddr(unsigned char subaddr, const unsigne
 
 inline void I2CDevice::i2c_send_request(std::size_t len, i2c_stop s) {
 #ifndef DESKTOP
+    I2CScheduler::finish_attached();
     this->wire.sendRequest(this->addr, len, s);
 #endif
 }
@@ -0,0 +1,254 @@
+/** @file I2CScheduler.cpp
+ * @brief Contains implementation for I2CScheduler, which runs queued I2C
+ * transactions in the background of the control cycle.
+ */
+
+#include "I2CScheduler.hpp"
+
+#include <cstring>
+
+#ifdef DESKTOP
+#include <common/ReplayLog.hpp>
+#include <algorithm>
+#include <chrono>
+#else
+#include <Arduino.h>
+#endif
+
+using namespace Devices;
+
+const constexpr unsigned int I2CScheduler::MAX_TRANSACTIONS;
+const constexpr unsigned int I2CScheduler::MAX_WRITE_LEN;
+const constexpr unsigned int I2CScheduler::FINISH_TIMEOUT_US;
+#ifdef DESKTOP
+const constexpr unsigned int I2CScheduler::BUS_FREQUENCY;
+#endif
+
+static_assert((I2CScheduler::MAX_TRANSACTIONS & (I2CScheduler::MAX_TRANSACTIONS - 1)) == 0,
+    "MAX_TRANSACTIONS must be a power of two");
+
+I2CScheduler *I2CScheduler::_attached = nullptr;
+
+#ifdef DESKTOP
+static long long system_clock_us() {
+    const long long now_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    return ReplayLog::clock_us(now_us);
+}
+
+I2CScheduler::I2CScheduler() : clock_us(system_clock_us) {
+    std::fill(targets, targets + 128, nullptr);
+}
+
+void I2CScheduler::attach(I2CScheduler *scheduler) { _attached = scheduler; }
+
+void I2CScheduler::attach_target(unsigned char addr, I2CTarget *target) {
+    targets[addr & 0x7F] = target;
+}
+
+long long I2CScheduler::duration_us(const transaction_t &t) const {
+    // A start condition, the address byte, the data bytes and a stop
+    // condition, each byte followed by an acknowledge bit, per phase.
+    long long bits = 0;
+    if (t.subaddr_len > 0 || !t.dest) bits += 2 + 9 * (1 + t.subaddr_len);
+    if (t.dest) bits += 2 + 9 * (1 + t.len);
+    return (bits * 1000000 + BUS_FREQUENCY - 1) / BUS_FREQUENCY;
+}
+
+void I2CScheduler::start() {
+    // Queued transactions follow each other on the bus without a gap
+    running = true;
+    const long long duration = duration_us(queue[active % MAX_TRANSACTIONS]);
+    end_us += duration;
+    _stats.bus_us += duration;
+}
+
+void I2CScheduler::transfer() {
+    transaction_t &t = queue[active % MAX_TRANSACTIONS];
+    I2CTarget *target = targets[t.addr & 0x7F];
+    if (target) {
+        if (t.subaddr_len > 0 || !t.dest) target->receive(t.subaddr, t.subaddr_len);
+        if (t.dest) target->request(t.dest, t.len);
+    }
+    complete(target != nullptr);
+}
+
+void I2CScheduler::poll() {
+    const long long now = clock_us();
+    if (!running && active != end) {
+        // The bus has been idle until now
+        end_us = now;
+        start();
+    }
+    while (running && end_us <= now) transfer();
+}
+
+void I2CScheduler::finish() {
+    poll();
+    if (!running) return;
+
+    // Nothing runs in the background on desktop, so run the rest of the queue
+    // now and account for the time the caller would have waited.
+    const long long now = clock_us();
+    long long last_us = end_us;
+    while (running) {
+        last_us = end_us;
+        transfer();
+    }
+    _stats.wait_us += std::max(0LL, last_us - now);
+}
+#else
+I2CScheduler::I2CScheduler(i2c_t3 &wire) : wire(wire) {}
+
+void I2CScheduler::attach(I2CScheduler *scheduler) {
+    _attached = scheduler;
+    if (!scheduler) return;
+    scheduler->wire.onTransmitDone(on_transmit_done);
+    scheduler->wire.onReqFromDone(on_request_done);
+    scheduler->wire.onError(on_error);
+}
+
+void I2CScheduler::start() {
+    running = true;
+    const transaction_t &t = queue[active % MAX_TRANSACTIONS];
+    if (t.subaddr_len > 0 || !t.dest) {
+        reading = false;
+        wire.beginTransmission(t.addr);
+        wire.write(t.subaddr, t.subaddr_len);
+        wire.sendTransmission(t.dest ? I2C_NOSTOP : I2C_STOP);
+    }
+    else {
+        reading = true;
+        wire.sendRequest(t.addr, t.len, I2C_STOP);
+    }
+}
+
+void I2CScheduler::on_transmit_done() {
+    I2CScheduler *s = _attached;
+    if (!s || !s->running) return;
+    const transaction_t &t = s->queue[s->active % MAX_TRANSACTIONS];
+    if (!t.dest) {
+        s->complete(true);
+        return;
+    }
+    s->reading = true;
+    s->wire.sendRequest(t.addr, t.len, I2C_STOP);
+}
+
+void I2CScheduler::on_request_done() {
+    I2CScheduler *s = _attached;
+    if (!s || !s->running) return;
+    const transaction_t &t = s->queue[s->active % MAX_TRANSACTIONS];
+    const bool ok = s->wire.read(t.dest, t.len) == t.len;
+    s->complete(ok);
+}
+
+void I2CScheduler::on_error() {
+    I2CScheduler *s = _attached;
+    if (!s || !s->running) return;
+    s->complete(false);
+}
+
+void I2CScheduler::poll() {
+    // The wire may still be busy with a non-blocking I2CDevice call
+    noInterrupts();
+    if (!running && active != end && wire.done()) start();
+    interrupts();
+}
+
+void I2CScheduler::finish() {
+    const unsigned long start_us = micros();
+    while (!idle()) {
+        poll();
+        if (micros() - start_us > FINISH_TIMEOUT_US) {
+            // The bus is stuck; fail everything that is left
+            noInterrupts();
+            while (active != end) {
+                queue[active % MAX_TRANSACTIONS].ok = false;
+                _stats.transactions++;
+                _stats.failures++;
+                active = active + 1;
+            }
+            running = false;
+            interrupts();
+            wire.resetBus();
+            break;
+        }
+    }
+    _stats.wait_us += micros() - start_us;
+}
+#endif
+
+I2CScheduler::~I2CScheduler() {
+    if (_attached == this) attach(nullptr);
+}
+
+void I2CScheduler::finish_attached() {
+    if (_attached) _attached->finish();
+}
+
+bool I2CScheduler::enqueue(const transaction_t &t) {
+    if (end - first >= MAX_TRANSACTIONS) return false;
+    queue[end % MAX_TRANSACTIONS] = t;
+    #ifndef DESKTOP
+    noInterrupts();
+    #endif
+    end++;
+    #ifndef DESKTOP
+    interrupts();
+    #endif
+    poll();
+    return true;
+}
+
+bool I2CScheduler::write(unsigned char addr, const unsigned char *data, size_t len,
+                         callback_t callback, void *context) {
+    if (len > MAX_WRITE_LEN) return false;
+    transaction_t t;
+    t.addr = addr;
+    std::memcpy(t.subaddr, data, len);
+    t.subaddr_len = len;
+    t.dest = nullptr;
+    t.len = 0;
+    t.callback = callback;
+    t.context = context;
+    t.ok = false;
+    return enqueue(t);
+}
+
+bool I2CScheduler::read(unsigned char addr, const unsigned char *subaddr, size_t subaddr_len,
+                        unsigned char *dest, size_t len, callback_t callback, void *context) {
+    if (subaddr_len > MAX_WRITE_LEN) return false;
+    transaction_t t;
+    t.addr = addr;
+    if (subaddr_len > 0) std::memcpy(t.subaddr, subaddr, subaddr_len);
+    t.subaddr_len = subaddr_len;
+    t.dest = dest;
+    t.len = len;
+    t.callback = callback;
+    t.context = context;
+    t.ok = false;
+    return enqueue(t);
+}
+
+void I2CScheduler::complete(bool ok) {
+    queue[active % MAX_TRANSACTIONS].ok = ok;
+    _stats.transactions++;
+    if (!ok) _stats.failures++;
+    running = false;
+    active = active + 1;
+    if (active != end) start();
+}
+
+void I2CScheduler::dispatch() {
+    poll();
+    // Only the interrupt moves active, and only forwards
+    const unsigned int completed = active;
+    while (first != completed) {
+        const transaction_t &t = queue[first % MAX_TRANSACTIONS];
+        if (t.callback) t.callback(t.context, t.ok);
+        first++;
+    }
+}
+
+bool I2CScheduler::idle() const { return !running && active == end; }
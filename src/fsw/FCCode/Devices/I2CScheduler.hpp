@@ -0,0 +1,214 @@
+/** @file I2CScheduler.hpp
+ * @brief Contains declaration for I2CScheduler, which runs queued I2C
+ * transactions in the background of the control cycle.
+ */
+
+#ifndef PAN_DEVICES_I2CSCHEDULER_HPP_
+#define PAN_DEVICES_I2CSCHEDULER_HPP_
+
+#include <common/constant_tracker.hpp>
+#include <cstddef>
+
+#ifndef DESKTOP
+#include <i2c_t3.h>
+#endif
+
+/** \namespace Devices **/
+namespace Devices {
+
+#ifdef DESKTOP
+/** \class I2CTarget
+ *  @brief Device model the desktop scheduler runs transactions against. The
+ *  scheduler models and counts the bus time of the transactions, so targets
+ *  shouldn't wait on or count it. **/
+class I2CTarget {
+   public:
+    /** @brief A write transaction of len bytes to the device. **/
+    virtual void receive(const unsigned char *data, size_t len) = 0;
+    /** @brief A read transaction of len bytes from the device. **/
+    virtual void request(unsigned char *data, size_t len) = 0;
+
+    virtual ~I2CTarget() = default;
+};
+#endif
+
+/** \class I2CScheduler
+ *  @brief Queue of I2C transactions that run while the flight computer does
+ *  other work.
+ *
+ *  Control tasks enqueue transactions with a completion callback. On the
+ *  Teensy, the wire must run in I2C_OP_MODE_ISR and each transaction is
+ *  started from the interrupt that ends the previous one, so the bus stays
+ *  busy without the CPU waiting on it. Callbacks are not run from the interrupt:
+ *  dispatch() runs those of the completed transactions, in order, and is
+ *  called once at the start of each control cycle, so results are consumed
+ *  the cycle after they were requested.
+ *
+ *  Blocking I2CDevice calls share the bus with the queue. They first wait for
+ *  the queue of the attached scheduler to drain, see finish_attached().
+ *
+ *  On desktop, transactions run against I2CTarget models instead and take as
+ *  long as they would at BUS_FREQUENCY. They complete as the clock passes
+ *  their end time, which poll() and dispatch() check. **/
+class I2CScheduler {
+   public:
+    /** @brief Called with the context given at enqueue time and whether the
+     *  transaction was acknowledged and completed in full. **/
+    typedef void (*callback_t)(void *context, bool ok);
+
+    /** Number of transactions the queue holds, completed ones included until
+     *  they are dispatched. Must be a power of two. **/
+    TRACKED_CONSTANT_SC(unsigned int, MAX_TRANSACTIONS, 8);
+    /** Longest write a transaction can carry. **/
+    TRACKED_CONSTANT_SC(unsigned int, MAX_WRITE_LEN, 8);
+    /** Longest time finish() waits for the queue to drain, in microseconds. **/
+    TRACKED_CONSTANT_SC(unsigned int, FINISH_TIMEOUT_US, 20000);
+    #ifdef DESKTOP
+    TRACKED_CONSTANT_SC(unsigned int, BUS_FREQUENCY, 400000);
+    #endif
+
+    /** Counters for measuring bus usage. **/
+    struct stats_t {
+        unsigned int transactions = 0;
+        unsigned int failures = 0;
+        /** Time the bus was busy with queued transactions. **/
+        long long bus_us = 0;
+        /** Time callers of finish() spent waiting for the queue. **/
+        long long wait_us = 0;
+    };
+
+    #ifdef DESKTOP
+    I2CScheduler();
+    #else
+    /** @brief Constructs a scheduler for a wire that has been started in
+     *  I2C_OP_MODE_ISR or I2C_OP_MODE_DMA. **/
+    explicit I2CScheduler(i2c_t3 &wire);
+    #endif
+
+    /** @brief Detaches the scheduler if it is attached. **/
+    ~I2CScheduler();
+
+    /**
+     * @brief Scheduler that blocking I2CDevice calls wait for, or nullptr. On
+     * the Teensy, only the attached scheduler receives the wire's interrupts.
+     */
+    static I2CScheduler *attached() { return _attached; }
+    static void attach(I2CScheduler *scheduler);
+
+    /**
+     * @brief Waits for the queue of the attached scheduler, if any, to drain.
+     */
+    static void finish_attached();
+
+    #ifdef DESKTOP
+    /**
+     * @brief Replaces the clock of the bus model, in microseconds. By default,
+     * the model reads the system clock through the replay log.
+     */
+    void set_clock(long long (*clock_us)()) { this->clock_us = clock_us; }
+
+    /**
+     * @brief Sets the model that answers transactions to the given address.
+     * Transactions to addresses without a model are not acknowledged.
+     */
+    void attach_target(unsigned char addr, I2CTarget *target);
+    #endif
+
+    /**
+     * @brief Enqueues a write of len bytes to the device at addr.
+     * @return false if the queue is full or the write is too long.
+     */
+    bool write(unsigned char addr, const unsigned char *data, size_t len,
+               callback_t callback = nullptr, void *context = nullptr);
+
+    /**
+     * @brief Enqueues a read of len bytes from the device at addr into dest,
+     * preceded by a write of subaddr_len bytes without a stop condition if
+     * subaddr_len isn't zero. dest must stay valid until the callback.
+     * @return false if the queue is full or the write is too long.
+     */
+    bool read(unsigned char addr, const unsigned char *subaddr, size_t subaddr_len,
+              unsigned char *dest, size_t len,
+              callback_t callback = nullptr, void *context = nullptr);
+
+    /**
+     * @brief Runs the callbacks of the transactions completed so far, in the
+     * order they were enqueued, and frees their slots.
+     */
+    void dispatch();
+
+    /**
+     * @brief Blocks until every enqueued transaction has completed, or until
+     * FINISH_TIMEOUT_US has passed, in which case the remaining transactions
+     * fail. Callbacks still only run from dispatch().
+     */
+    void finish();
+
+    /**
+     * @brief Starts the next transaction if the bus is idle. On desktop, also
+     * completes the transactions whose end time has passed.
+     */
+    void poll();
+
+    /** @brief True if no transaction is running or waiting to. **/
+    bool idle() const;
+
+    const stats_t &stats() const { return _stats; }
+
+   private:
+    static I2CScheduler *_attached;
+
+    struct transaction_t {
+        unsigned char addr;
+        unsigned char subaddr[MAX_WRITE_LEN];
+        size_t subaddr_len;
+        /** Destination of a read, or nullptr for a write. **/
+        unsigned char *dest;
+        size_t len;
+        callback_t callback;
+        void *context;
+        bool ok;
+    };
+
+    /** Slots [first, active) have completed and await dispatch, and slots
+     *  [active, end) are running or waiting to. Indices grow without bound
+     *  and are taken modulo MAX_TRANSACTIONS. On the Teensy, active and
+     *  running are only written with interrupts off or from the interrupt. **/
+    transaction_t queue[MAX_TRANSACTIONS];
+    unsigned int first = 0;
+    volatile unsigned int active = 0;
+    unsigned int end = 0;
+    /** Whether the transaction at active is on the bus. **/
+    volatile bool running = false;
+    stats_t _stats;
+
+    #ifdef DESKTOP
+    long long (*clock_us)();
+    I2CTarget *targets[128];
+    /** Time the running transaction ends at. **/
+    long long end_us = 0;
+
+    long long duration_us(const transaction_t &t) const;
+    /** @brief Runs the transaction at active against its target and
+     *  completes it. **/
+    void transfer();
+    #else
+    i2c_t3 &wire;
+    /** Whether the running transaction is past its subaddress write. **/
+    volatile bool reading = false;
+
+    static void on_transmit_done();
+    static void on_request_done();
+    static void on_error();
+    #endif
+
+    bool enqueue(const transaction_t &t);
+    /** @brief Starts the transaction at active; the bus must be idle. **/
+    void start();
+    /** @brief Marks the transaction at active as completed and starts the
+     *  next one. **/
+    void complete(bool ok);
+};
+}  // namespace Devices
+
+#endif
@@ -41,7 +41,7 @@ class DockingController : public TimedControlTask<void> {
 
     //field for step angle which should be constant based on its setup
     //values written to be taken from testing data
-    WritableStateField<float> docking_step_angle_f;
+    StaticWritableStateField<StaticSerializer<float, 0, 180, 16>> docking_step_angle_f;
 
     //field for step delay to change the speed/torque of the motor and how long it will turn
     //values written to be taken from testing data
@@ -2,18 +2,33 @@
 #include <algorithm>
 #include <set>
 
+const constexpr unsigned char DownlinkProducer::normal_priority;
+const constexpr unsigned char DownlinkProducer::event_priority;
+
 DownlinkProducer::DownlinkProducer(StateFieldRegistry& r) : TimedControlTask<void>(r, "downlink_ct"),
                                  snapshot_ptr_f("downlink.ptr"),
-                                 snapshot_size_bytes_f("downlink.snap_size")
+                                 snapshot_size_bytes_f("downlink.snap_size"),
+                                 snapshot_priority_f("downlink.priority")
 {
     cycle_count_fp = find_readable_field<unsigned int>("pan.cycle_no", __FILE__, __LINE__);
 
     // Add snapshot fields to the registry
     add_internal_field(snapshot_ptr_f);
     add_internal_field(snapshot_size_bytes_f);
+    add_internal_field(snapshot_priority_f);
+    snapshot_priority_f.set(normal_priority);
 }
 
-void DownlinkProducer::init_flows(const std::vector<FlowData>& flow_data) {
+void DownlinkProducer::init_flows(const std::vector<FlowData>& flow_data,
+    const std::vector<TelemetryCompressor::FieldModel>& telemetry_model)
+{
+    compressor = TelemetryCompressor(telemetry_model);
+    compressed_field_bits.reserve(TelemetryCompressor::max_encoded_size(
+        TelemetryCompressor::max_field_bits));
+    compress_fp = std::make_unique<WritableStateField<bool>>("downlink.compress", Serializer<bool>());
+    add_writable_field(*compress_fp);
+    compress_fp->set(false);
+
     toggle_flow_id_fp = std::make_unique<WritableStateField<unsigned char>>("downlink.toggle_id", Serializer<unsigned char>(flow_data.size()));
     shift_flows_id1_fp = std::make_unique<WritableStateField<unsigned char>>("downlink.shift_id1", Serializer<unsigned char>(flow_data.size()));
     shift_flows_id2_fp = std::make_unique<WritableStateField<unsigned char>>("downlink.shift_id2", Serializer<unsigned char>(flow_data.size()));
@@ -34,7 +49,7 @@ void DownlinkProducer::init_flows(const std::vector<FlowData>& flow_data) {
             printf(debug_severity::error, "Two flows share the same ID: %d", flow.id);
             assert(false);
         }
-        flows.emplace_back(_registry, flow, num_flows); 
+        flows.emplace_back(_registry, flow, num_flows, compressor);
         if (flow.is_active) num_active_flows++;
     }
 
@@ -50,9 +65,11 @@ void DownlinkProducer::init_flows(const std::vector<FlowData>& flow_data) {
 size_t DownlinkProducer::compute_downlink_size(const bool compute_max) const {
     size_t downlink_max_size_bits = 0;
 
+    // The maximum size must leave room for compression being turned on later.
+    const bool compressed = compute_max || (compress_fp && compress_fp->get());
     for (const Flow& flow : flows) {
         if (flow.is_active || compute_max)
-            downlink_max_size_bits += flow.get_packet_size();
+            downlink_max_size_bits += flow.get_packet_size(compressed);
     }
 
     // Compute additional bits in the downlink size due to header information.
@@ -71,100 +88,64 @@ size_t DownlinkProducer::compute_max_downlink_size() const {
     return compute_downlink_size(true);
 }
 
-static void add_bits_to_downlink_frame(const bit_array& field_bits,
-                                       char* snapshot_ptr,
-                                       size_t& packet_offset,
-                                       size_t& downlink_frame_offset)
-{
-    const size_t field_size = field_bits.size();
-    const int field_overflow = (field_size + packet_offset)
-        - DownlinkProducer::num_bits_in_packet; // Number of bits in field that run past the packet end
-
-    if(field_overflow <= 0) {
-        // Contiguously write field to snapshot buffer
-        field_bits.to_string(snapshot_ptr, downlink_frame_offset);
-        downlink_frame_offset += field_size;
-        packet_offset += field_size;
-    }
-    else {
-        // Split field across two packets
-        const int x = field_size - field_overflow; // # of bits in field that don't overrun a packet
-
-        // Copy first part of field
-        field_bits.to_string(snapshot_ptr, downlink_frame_offset, 0, x);
-        downlink_frame_offset += x;
-        packet_offset = 0;
-
-        // Mark the header for a new packet
-        char& packet_start = snapshot_ptr[(downlink_frame_offset / 70)];
-        packet_start = bit_array::modify_bit(packet_start, 7, 0);
-        downlink_frame_offset += 1;
-        packet_offset += 1;
-
-        // Copy the rest of the field
-        field_bits.to_string(snapshot_ptr, downlink_frame_offset, x, field_size);
-        downlink_frame_offset += field_overflow;
-        packet_offset += field_overflow;
-    }
-}
-
 void DownlinkProducer::execute() {
     // Set the snapshot size in order to let the Quake Manager know about
     // the size of the current downlink.
     snapshot_size_bytes_f.set(compute_downlink_size());
+    const bool compressed = compress_fp->get() && !compressor.empty();
 
     char* snapshot_ptr = snapshot_ptr_f.get();
-    // Create the required iterators
-    size_t downlink_frame_offset = 0; // Bit offset from the beginning
-                                      // of the snapshot buffer
-    size_t packet_offset = 0;         // Bit offset from the beginning
-                                      // of the current downlink packet
+    unsigned char priority = normal_priority;
 
-    // Add initial packet header
-    snapshot_ptr[0] = bit_array::modify_bit(snapshot_ptr[0], 7, 1);
-    downlink_frame_offset += 1;
-    packet_offset += 1;
+    // Fields are serialized straight into the snapshot. The writer takes care
+    // of adding a downlink packet delimeter whenever the current packet size
+    // exceeds 70 bytes.
+    FrameWriter writer(snapshot_ptr, num_bits_in_packet);
+    writer.start_frame();
 
     // Add control cycle count to the initial packet
-    cycle_count_fp->serialize();
-    const bit_array& cycle_count_bits = cycle_count_fp->get_bit_array();
-    add_bits_to_downlink_frame(cycle_count_bits, snapshot_ptr, packet_offset,
-            downlink_frame_offset);
+    cycle_count_fp->serialize_into(writer);
+    if (compressed) {
+        // Flag the frame as compressed using the spare bit of the cycle count
+        const size_t flag_offset = 1 + compressed_flag_bit;
+        char& flag_char = snapshot_ptr[flag_offset / 8];
+        flag_char = bit_array::modify_bit(flag_char, 7 - (flag_offset % 8), 1);
+    }
 
     for(auto const& flow : flows) {
         if (!flow.is_active) continue;
 
-        // Add a flow field one at a time to the snapshot, taking
-        // care to add a downlink packet delimeter if the current
-        // packet size exceeds 70 bytes.
-        const bit_array& flow_id_bits = flow.id_sr.get_bit_array();
-        add_bits_to_downlink_frame(flow_id_bits, snapshot_ptr, packet_offset,
-            downlink_frame_offset);
+        writer.write(flow.id_sr.get_bit_array());
 
-        for(auto& field : flow.field_list) {
+        for(size_t i = 0; i < flow.field_list.size(); i++) {
+            ReadableStateFieldBase* field = flow.field_list[i];
+            const TelemetryCompressor::FieldModel* model = flow.field_models[i];
             Event* event = _registry.find_event(field->name());
             if (event) {
                 // Event should be serialized when it is signaled
-                const bit_array& event_bits = event->get_bit_array();
-                add_bits_to_downlink_frame(event_bits, snapshot_ptr, packet_offset,
-                    downlink_frame_offset);
+                if (event->prepare_downlink() > 0) priority = event_priority;
+                writer.write(event->get_bit_array());
             }
-            else{
+            else if (compressed && model) {
                 field->serialize();
-                const bit_array& field_bits = field->get_bit_array();
-                add_bits_to_downlink_frame(field_bits, snapshot_ptr, packet_offset,
-                    downlink_frame_offset);
+                TelemetryCompressor::encode(field->get_bit_array(), *model,
+                    compressed_field_bits);
+                writer.write(compressed_field_bits);
+            }
+            else {
+                field->serialize_into(writer);
             }
         }
     }
 
     // If there are bits remaining in the last character of the downlink frame,
     // fill them with zeroes.
-    const unsigned int num_remaining_bits = 8 - (downlink_frame_offset % 8); 
-    for(int i = num_remaining_bits - 1; i >= 0; i--) {
-        char& last_char = snapshot_ptr[(downlink_frame_offset / 8)];
-        last_char = bit_array::modify_bit(last_char, i, 0);
-    }
+    writer.finish();
+    snapshot_priority_f.set(priority);
+
+    // A compressed snapshot usually ends well before its worst-case size, so
+    // report how many bytes were actually used.
+    if (compressed) snapshot_size_bytes_f.set(writer.size_bytes());
 
     // Shift flow priorities
     if (shift_flows_id1_fp->get()>0 && shift_flows_id2_fp->get()>0) {
@@ -187,11 +168,16 @@ DownlinkProducer::~DownlinkProducer() {
 const std::vector<DownlinkProducer::Flow>& DownlinkProducer::get_flows() const {
     return flows;
 }
+
+const TelemetryCompressor& DownlinkProducer::get_compressor() const {
+    return compressor;
+}
 #endif
 
 DownlinkProducer::Flow::Flow(const StateFieldRegistry& r,
                         const FlowData& flow_data,
-                        const size_t num_flows) : id_sr(num_flows),
+                        const size_t num_flows,
+                        const TelemetryCompressor& compressor) : id_sr(num_flows),
                                                   is_active(flow_data.is_active)
 {
     if (flow_data.id > num_flows || flow_data.id == 0) {
@@ -207,9 +193,18 @@ DownlinkProducer::Flow::Flow(const StateFieldRegistry& r,
         if (event_ptr && !field_ptr) {
             ReadableStateFieldBase* casted_event_ptr = dynamic_cast<ReadableStateFieldBase*>(event_ptr);
             field_list.push_back(casted_event_ptr);
+            field_models.push_back(nullptr);
         }
         else if (field_ptr && !event_ptr){
             field_list.push_back(field_ptr);
+
+            const TelemetryCompressor::FieldModel* model = compressor.find(field_name);
+            if (model && field_ptr->bitsize() > TelemetryCompressor::max_field_bits) {
+                printf(debug_severity::error,
+                    "Field %s is too wide to be compressed.", field_name.c_str());
+                model = nullptr;
+            }
+            field_models.push_back(model);
         }
         else {
             printf(debug_severity::error, 
@@ -228,13 +223,17 @@ DownlinkProducer::Flow::Flow(const StateFieldRegistry& r,
     }
 }
 
-size_t DownlinkProducer::Flow::get_packet_size() const {
+size_t DownlinkProducer::Flow::get_packet_size(const bool compressed) const {
     // Get bitcount of all fields in the flow
     size_t packet_size = 0;
     packet_size += id_sr.bitsize();
 
-    for(auto const& field: field_list) {
-        packet_size += field->get_bit_array().size();
+    for(size_t i = 0; i < field_list.size(); i++) {
+        const size_t field_size = field_list[i]->get_bit_array().size();
+        if (compressed && field_models[i])
+            packet_size += TelemetryCompressor::max_encoded_size(field_size);
+        else
+            packet_size += field_size;
     }
 
     return packet_size;
@@ -2,12 +2,28 @@
 #define DOWNLINK_PRODUCER_HPP_
 
 #include "TimedControlTask.hpp"
+#include "TelemetryCompressor.hpp"
 #include <common/constant_tracker.hpp>
 
 class DownlinkProducer : public TimedControlTask<void> {
    public:
     TRACKED_CONSTANT_SC(unsigned int, num_bits_in_packet, 560);
 
+    /**
+     * @brief Bit of the control cycle count that is set when the rest of the
+     * snapshot is compressed. The cycle count won't reach 2^31 within the
+     * mission, so the most significant bit is free to act as a frame flag.
+     */
+    TRACKED_CONSTANT_SC(unsigned int, compressed_flag_bit, 31);
+
+    /**
+     * @brief Downlink priorities of a snapshot. A snapshot has event priority
+     * if it carries event occurrences that no earlier snapshot carried, since
+     * they are lost unless this particular snapshot is downlinked.
+     */
+    TRACKED_CONSTANT_SC(unsigned char, normal_priority, 0);
+    TRACKED_CONSTANT_SC(unsigned char, event_priority, 1);
+
     /**
      * @brief Flow data object, used in order to specify the
      * - The flow ID. Note: flow IDs must be greater than zero; a
@@ -43,8 +59,12 @@ class DownlinkProducer : public TimedControlTask<void> {
      * state fields.
      * 
      * @param flow_data 
+     * @param telemetry_model Ground-trained model used to compress snapshots
+     *                        when downlink.compress is set. Empty by default,
+     *                        in which case snapshots are never compressed.
      */
-    void init_flows(const std::vector<FlowData>& flow_data);
+    void init_flows(const std::vector<FlowData>& flow_data,
+        const std::vector<TelemetryCompressor::FieldModel>& telemetry_model = {});
 
     /**
      * @brief Compute the size of the downlink snapshot.
@@ -87,10 +107,13 @@ class DownlinkProducer : public TimedControlTask<void> {
          * @param flow_data  Data about the flow.
          * @param num_flows  Total number of flows. This is used to
          *                   create the flow ID # serializer
+         * @param compressor Telemetry compressor, used to look up the model
+         *                   entry of each field in the flow.
          */
         Flow(const StateFieldRegistry& r,
              const FlowData& flow_data,
-             const size_t num_flows);
+             const size_t num_flows,
+             const TelemetryCompressor& compressor);
 
         //! Flow ID #
         Serializer<unsigned char> id_sr;
@@ -101,8 +124,17 @@ class DownlinkProducer : public TimedControlTask<void> {
         //! List of fields within the flow
         std::vector<ReadableStateFieldBase*> field_list;
 
-        //! Number of bits in the entire flow packet, including the flow ID.
-        size_t get_packet_size() const;
+        //! Compression model entry of each field in field_list, or null
+        //! pointer if the field is always sent raw.
+        std::vector<const TelemetryCompressor::FieldModel*> field_models;
+
+        /**
+         * @brief Number of bits in the entire flow packet, including the flow ID.
+         *
+         * @param compressed If true, returns the worst-case size of the flow
+         * packet in a compressed snapshot.
+         */
+        size_t get_packet_size(const bool compressed = false) const;
 
         /**
         * @brief Move assignment operator.
@@ -110,9 +142,8 @@ class DownlinkProducer : public TimedControlTask<void> {
         Flow& operator=(Flow&& rhs) {
             is_active = std::move(rhs.is_active);
             id_sr = std::move(rhs.id_sr);
-            for (size_t i = 0; i<rhs.field_list.size(); i++) {
-                field_list[i] = rhs.field_list[i];
-            }
+            field_list = rhs.field_list;
+            field_models = rhs.field_models;
             return *this;
         }
 
@@ -132,12 +163,14 @@ class DownlinkProducer : public TimedControlTask<void> {
             is_active = rhs.is_active;
             id_sr = std::move(rhs.id_sr);
             field_list = rhs.field_list;
+            field_models = rhs.field_models;
             return *this;
         }
     };
 
     #if defined GSW || defined DESKTOP
     const std::vector<Flow>& get_flows() const;
+    const TelemetryCompressor& get_compressor() const;
     #endif
 
     /**
@@ -157,11 +190,12 @@ class DownlinkProducer : public TimedControlTask<void> {
 
     /**
      * @brief Fields used by the Quake manager to know from where to copy a downlink
-     * snapshot, and the length of the snapshot.
+     * snapshot, the length of the snapshot, and its downlink priority.
      */
     char* snapshot = nullptr;
     InternalStateField<char*> snapshot_ptr_f;
     InternalStateField<size_t> snapshot_size_bytes_f;
+    InternalStateField<unsigned char> snapshot_priority_f;
 
     /**
      * @brief Actual flow data.
@@ -180,6 +214,23 @@ class DownlinkProducer : public TimedControlTask<void> {
      * @brief Statefield used to toggle flow's active status. Default is 0 (no flow can have an id of 0)
      */
     std::unique_ptr<WritableStateField<unsigned char>> toggle_flow_id_fp;
+
+    /**
+     * @brief Compresses snapshots against the ground-trained telemetry model.
+     */
+    TelemetryCompressor compressor;
+
+    /**
+     * @brief Scratch buffer holding the compressed bits of a single field.
+     * Its capacity is reserved once so that compression never allocates.
+     */
+    std::vector<bool> compressed_field_bits;
+
+    /**
+     * @brief Statefield used to turn snapshot compression on or off. Default
+     * is off.
+     */
+    std::unique_ptr<WritableStateField<bool>> compress_fp;
 };
 
 #endif
@@ -8,6 +8,8 @@
 
 #include <adcs/constants.hpp>
 #include <adcs/state_registers.hpp>
+#include <adcs/telemetry.hpp>
+#include <adcs/utl/convert.hpp>
 #include <common/constant_tracker.hpp>
 
 #include <cstring>
@@ -17,10 +19,10 @@ using namespace Devices;
 #ifndef DESKTOP
 TRACKED_CONSTANT_SC(unsigned int, adcs_i2c_timeout, 1000);
 ADCS::ADCS(i2c_t3 &i2c_wire, unsigned char address)
-    : I2CDevice("adcs", i2c_wire, address, adcs_i2c_timeout) {}
+    : I2CDevice("adcs", i2c_wire, address, adcs_i2c_timeout), address(address) {}
 #else
-ADCS::ADCS()
-    : I2CDevice("adcs", 0) {}
+ADCS::ADCS(ADCSBoxEmulator *box)
+    : I2CDevice("adcs", 0), box(box) {}
 #endif
 
 bool ADCS::i2c_ping() {
@@ -32,52 +34,65 @@ bool ADCS::i2c_ping() {
 template <typename T>
 void ADCS::i2c_point_and_read(unsigned char data_register, T* data, std::size_t len) {
     set_read_ptr(data_register);
+    #ifdef DESKTOP
+    I2CScheduler::finish_attached();
+    if (box) box->read(reinterpret_cast<unsigned char*>(data), len);
+    #else
     i2c_request_from(len);
     i2c_read(data, len);
-}
-inline float fp(signed char si, float min, float max) {
-  return min + (((float) si) + 128.0f) * (max - min) / 255.0f;
-}
-
-inline float fp(unsigned char ui, float min, float max) {
-  return min + ((float) ui) * (max - min) / 255.0f;
-}
-
-inline float fp(signed short si, float min, float max) {
-  return min + (((float) si) + 32768.0f) * (max - min) / 65535.0f;
-}
-
-inline float fp(unsigned short ui, float min, float max) {
-  return min + ((float) ui) * (max - min) / 65535.0f;
+    #endif
 }
 
-inline unsigned char uc(float f, float min, float max) {
-  return (unsigned char)(255.0f * (f - min) / (max - min));
+bool ADCS::mocked() const {
+    #if defined(UNIT_TEST) && defined(DESKTOP)
+    return !box;
+    #elif defined(UNIT_TEST)
+    return true;
+    #else
+    return false;
+    #endif
 }
 
-inline signed char sc(float f, float min, float max) {
-  return (signed char)(255.0f * (f - min) / (max - min) - 128.0f);
+void ADCS::write_register(unsigned char data_register, const unsigned char *data, std::size_t len) {
+    #ifdef DESKTOP
+    if (!box) return;
+    I2CScheduler::finish_attached();
+    // no register is longer than six bytes
+    unsigned char buffer[1 + 6];
+    buffer[0] = data_register;
+    std::memcpy(buffer + 1, data, len);
+    box->write(buffer, 1 + len);
+    #else
+    i2c_write_to_subaddr(data_register, data, len);
+    #endif
 }
 
-inline unsigned short us(float f, float min, float max) {
-  return (unsigned short)(65535.0f * (f - min) / (max - min));
+void ADCS::write_register(unsigned char data_register, unsigned char data) {
+    write_register(data_register, &data, 1);
 }
+using adcs::utl::uc;
+using adcs::utl::us;
 
-inline signed short ss(float f, float min, float max) {
-  return (signed short)(65535.0f * (f - min) / (max - min) - 32768.0f);
+// Decodes three little-endian unsigned shorts mapping onto [min, max]
+static void decode_vector(const unsigned char* readin, std::array<float, 3>* vec, float min, float max) {
+    unsigned short c[3];
+    for(int i=0;i<3;i++){
+        c[i] = (((unsigned short)readin[2*i+1]) << 8) | (0xFF & readin[2*i]);
+    }
+    adcs::utl::fp(c, vec->data(), 3, min, max);
 }
 
 void ADCS::set_mode(const unsigned char mode) {
-    i2c_write_to_subaddr(adcs::ADCS_MODE, mode);
+    write_register(adcs::ADCS_MODE, mode);
 }
 
 void ADCS::set_read_ptr(const unsigned char read_ptr){
-    i2c_write_to_subaddr(adcs::READ_POINTER, read_ptr);
+    write_register(adcs::READ_POINTER, read_ptr);
 
 }
 
 void ADCS::set_rwa_mode(const unsigned char rwa_mode,const std::array<float,3>& rwa_cmd){
-    i2c_write_to_subaddr(adcs::RWA_MODE, rwa_mode);
+    write_register(adcs::RWA_MODE, rwa_mode);
 
     unsigned char cmd[6];
     for(int i = 0;i<3;i++){
@@ -89,21 +104,21 @@ void ADCS::set_rwa_mode(const unsigned char rwa_mode,const std::array<float,3>&
         cmd[2*i] = comp;
         cmd[2*i+1] = comp >> 8;
     }
-    i2c_write_to_subaddr(adcs::RWA_COMMAND,cmd,6);
+    write_register(adcs::RWA_COMMAND,cmd,6);
 }
 
 void ADCS::set_rwa_speed_filter(const float mom_filter){
     unsigned char comp = uc(mom_filter,0.0f,1.0f);
-    i2c_write_to_subaddr(adcs::RWA_SPEED_FILTER, comp);
+    write_register(adcs::RWA_SPEED_FILTER, comp);
 }
 
 void ADCS::set_ramp_filter(const float ramp_filter){
     unsigned char comp = uc(ramp_filter,0.0f,1.0f);
-    i2c_write_to_subaddr(adcs::RWA_RAMP_FILTER, comp);
+    write_register(adcs::RWA_RAMP_FILTER, comp);
 }
 
 void ADCS::set_mtr_mode(const unsigned char mtr_mode){
-    i2c_write_to_subaddr(adcs::MTR_MODE, mtr_mode);
+    write_register(adcs::MTR_MODE, mtr_mode);
 }
 
 void ADCS::set_mtr_cmd(const std::array<float, 3> &mtr_cmd){
@@ -113,7 +128,7 @@ void ADCS::set_mtr_cmd(const std::array<float, 3> &mtr_cmd){
         cmd[2*i] = comp;
         cmd[2*i+1] = comp >> 8; 
     }
-    i2c_write_to_subaddr(adcs::MTR_COMMAND,cmd,6);
+    write_register(adcs::MTR_COMMAND,cmd,6);
 }
 
 void ADCS::set_mtr_limit(const float mtr_limit){
@@ -121,39 +136,39 @@ void ADCS::set_mtr_limit(const float mtr_limit){
     unsigned short comp = us(mtr_limit,adcs::mtr::min_moment,adcs::mtr::max_moment);
     cmd[0] = comp;
     cmd[1] = comp >> 8; 
-    i2c_write_to_subaddr(adcs::MTR_LIMIT, cmd, 2);
+    write_register(adcs::MTR_LIMIT, cmd, 2);
 }
 
 void ADCS::set_ssa_mode(const unsigned char ssa_mode) {
-    i2c_write_to_subaddr(adcs::SSA_MODE, ssa_mode);
+    write_register(adcs::SSA_MODE, ssa_mode);
 }
 
 void ADCS::set_ssa_voltage_filter(const float voltage_filter) {
     unsigned char comp = uc(voltage_filter,0.0f,1.0f);
-    i2c_write_to_subaddr(adcs::SSA_VOLTAGE_FILTER, comp);
+    write_register(adcs::SSA_VOLTAGE_FILTER, comp);
 }
 
 void ADCS::set_mag1_mode(const unsigned char mode){
-    i2c_write_to_subaddr(adcs::IMU_MAG1_MODE, mode);
+    write_register(adcs::IMU_MAG1_MODE, mode);
 }
 
 void ADCS::set_mag2_mode(const unsigned char mode){
-    i2c_write_to_subaddr(adcs::IMU_MAG2_MODE, mode);
+    write_register(adcs::IMU_MAG2_MODE, mode);
 }
 
 void ADCS::set_imu_mag_filter(const float mag_filter){
     unsigned char comp = uc(mag_filter,0.0f,1.0f);
-    i2c_write_to_subaddr(adcs::IMU_MAG_FILTER, comp);
+    write_register(adcs::IMU_MAG_FILTER, comp);
 }
 
 void ADCS::set_imu_gyr_filter(const float gyr_filter){
     unsigned char comp = uc(gyr_filter,0.0f,1.0f);
-    i2c_write_to_subaddr(adcs::IMU_GYR_FILTER, comp);
+    write_register(adcs::IMU_GYR_FILTER, comp);
 }
 
 void ADCS::set_imu_gyr_temp_filter(const float temp_filter){
     unsigned char comp = uc(temp_filter,0.0f,1.0f);
-    i2c_write_to_subaddr(adcs::IMU_GYR_TEMP_FILTER, comp);
+    write_register(adcs::IMU_GYR_TEMP_FILTER, comp);
 }
 
 void float_decomp(const float input, unsigned char* temp){
@@ -162,12 +177,12 @@ void float_decomp(const float input, unsigned char* temp){
 }
 
 void ADCS::set_imu_gyr_temp_pwm(const unsigned char pwm){
-    i2c_write_to_subaddr(adcs::IMU_GYR_TEMP_PWM, pwm);
+    write_register(adcs::IMU_GYR_TEMP_PWM, pwm);
 }
 
 void ADCS::set_imu_gyr_temp_desired(const float desired){
     unsigned char cmd = uc(desired,adcs::imu::min_eq_temp,adcs::imu::max_eq_temp);
-    i2c_write_to_subaddr(adcs::IMU_GYR_TEMP_DESIRED,cmd);
+    write_register(adcs::IMU_GYR_TEMP_DESIRED,cmd);
 }
 
 void ADCS::set_havt_reset(const std::bitset<adcs::havt::max_devices>& table){
@@ -182,7 +197,7 @@ void ADCS::set_havt_reset(const std::bitset<adcs::havt::max_devices>& table){
         cmd[i] = encoded_ptr[i];
     }
 
-    i2c_write_to_subaddr(adcs::HAVT_COMMAND_RESET, cmd, 4);
+    write_register(adcs::HAVT_COMMAND_RESET, cmd, 4);
 }
 
 void ADCS::set_havt_disable(const std::bitset<adcs::havt::max_devices>& table){
@@ -197,7 +212,7 @@ void ADCS::set_havt_disable(const std::bitset<adcs::havt::max_devices>& table){
         cmd[i] = encoded_ptr[i];
     }
 
-    i2c_write_to_subaddr(adcs::HAVT_COMMAND_DISABLE, cmd, 4);
+    write_register(adcs::HAVT_COMMAND_DISABLE, cmd, 4);
 }
 
 void ADCS::get_who_am_i(unsigned char* who_am_i) {
@@ -208,117 +223,82 @@ void ADCS::get_rwa(std::array<float, 3>* rwa_speed_rd, std::array<float, 3>* rwa
     unsigned char readin[12];
     std::memset(readin, 0, sizeof(readin));
 
-    #ifdef UNIT_TEST
-    for(int i = 0;i<12;i++){
-        readin[i] = 255;
+    if (mocked()) {
+        for(int i = 0;i<12;i++){
+            readin[i] = 255;
+        }
     }
-    #else
-    i2c_point_and_read(adcs::RWA_SPEED_RD, readin, 12);
-    #endif
+    else i2c_point_and_read(adcs::RWA_SPEED_RD, readin, 12);
 
-    for(int i=0;i<3;i++){
-        unsigned short a = readin[2*i+1] << 8;
-        unsigned short b = 0xFF & readin[2*i];
-        unsigned short c = a | b;
-        (*rwa_speed_rd)[i] = fp(c,adcs::rwa::min_speed_read,adcs::rwa::max_speed_read);
-    }
-    for(int i=0;i<3;i++){
-        unsigned short a = readin[2*i+1+6] << 8;
-        unsigned short b = 0xFF & readin[2*i+6];
-        unsigned short c = a | b;
-        (*rwa_ramp_rd)[i] = fp(c,adcs::rwa::min_ramp_rd, adcs::rwa::max_ramp_rd);
-    }
+    decode_vector(readin, rwa_speed_rd, adcs::rwa::min_speed_read, adcs::rwa::max_speed_read);
+    decode_vector(readin + 6, rwa_ramp_rd, adcs::rwa::min_ramp_rd, adcs::rwa::max_ramp_rd);
 }
 
 void ADCS::get_imu(std::array<float,3>* mag1_rd, std::array<float,3>* mag2_rd, std::array<float,3>* gyr_rd,float* gyr_temp_rd){
     unsigned char readin[20]; // 6+6+6+2
     std::memset(readin, 0, sizeof(readin));
 
-    #ifdef UNIT_TEST
-    for(int i = 0;i<20;i++){
-        readin[i] = 255;
+    if (mocked()) {
+        for(int i = 0;i<20;i++){
+            readin[i] = 255;
+        }
     }
-    #else
-    i2c_point_and_read(adcs::IMU_READ, readin, 20);
-    #endif
+    else i2c_point_and_read(adcs::IMU_READ, readin, 20);
 
-    for(int i=0;i<3;i++){
-        unsigned short a = readin[2*i+1] << 8;
-        unsigned short b = 0xFF & readin[2*i];
-        unsigned short c = a | b;        
-        (*mag1_rd)[i] = fp(c,adcs::imu::min_mag1_rd_mag,adcs::imu::max_mag1_rd_mag);
-    }
-
-    for(int i=0;i<3;i++){
-        unsigned short a = readin[2*i+1+6] << 8;
-        unsigned short b = 0xFF & readin[2*i+6];
-        unsigned short c = a | b;        
-        (*mag2_rd)[i] = fp(c,adcs::imu::min_mag2_rd_mag,adcs::imu::max_mag2_rd_mag);
-    }
-
-    for(int i=0;i<3;i++){
-        unsigned short a = readin[2*i+1+12] << 8;
-        unsigned short b = 0xFF & readin[2*i+12];
-        unsigned short c = a | b;
-        (*gyr_rd)[i] = fp(c,adcs::imu::min_rd_omega,adcs::imu::max_rd_omega);
-    } 
+    decode_vector(readin, mag1_rd, adcs::imu::min_mag1_rd_mag, adcs::imu::max_mag1_rd_mag);
+    decode_vector(readin + 6, mag2_rd, adcs::imu::min_mag2_rd_mag, adcs::imu::max_mag2_rd_mag);
+    decode_vector(readin + 12, gyr_rd, adcs::imu::min_rd_omega, adcs::imu::max_rd_omega);
 
     unsigned short c = (((unsigned short)readin[19]) << 8) | (0xFF & readin[18]);
-    *gyr_temp_rd = fp(c,adcs::imu::min_rd_temp, adcs::imu::max_rd_temp);
+    *gyr_temp_rd = adcs::utl::fp(c,adcs::imu::min_rd_temp, adcs::imu::max_rd_temp);
 }
 
 void ADCS::get_ssa_mode(unsigned char* a) {
-    #ifdef UNIT_TEST
-    //acceleration control mode, mocking output
-    *a = mock_ssa_mode;
-    #else
-    i2c_point_and_read(adcs::SSA_MODE, a, 1);
-    #endif
+    if (mocked()) {
+        #ifdef UNIT_TEST
+        //acceleration control mode, mocking output
+        *a = mock_ssa_mode;
+        #endif
+    }
+    else i2c_point_and_read(adcs::SSA_MODE, a, 1);
 }
 
 void ADCS::get_ssa_vector(std::array<float, 3>* ssa_sun_vec) {
     unsigned char readin[6];
     std::memset(readin, 0, sizeof(readin));
 
-    #ifdef UNIT_TEST
-    for(int i = 0;i<6;i++){
-        readin[i] = 255;
-    }
-    #else
-    i2c_point_and_read(adcs::SSA_SUN_VECTOR, readin,6);
-    #endif
-
-    for(int i=0;i<3;i++){
-        unsigned short c = (((unsigned short)readin[2*i+1]) << 8) | (0xFF & readin[2*i]);
-
-        (*ssa_sun_vec)[i] = fp(c,-1.0f,1.0f);
+    if (mocked()) {
+        for(int i = 0;i<6;i++){
+            readin[i] = 255;
+        }
     }
+    else i2c_point_and_read(adcs::SSA_SUN_VECTOR, readin,6);
 
+    decode_vector(readin, ssa_sun_vec, -1.0f, 1.0f);
 }
 
 void ADCS::get_ssa_voltage(std::array<float, adcs::ssa::num_sun_sensors>* voltages){
     unsigned char temp[adcs::ssa::num_sun_sensors];
     std::memset(temp, 0, sizeof(temp));
 
-    #ifdef UNIT_TEST
-    for(int i = 0;i<adcs::ssa::num_sun_sensors;i++){
-        temp[i] = 255;
+    if (mocked()) {
+        for(int i = 0;i<adcs::ssa::num_sun_sensors;i++){
+            temp[i] = 255;
+        }
     }
-    #else
-    i2c_point_and_read(adcs::SSA_VOLTAGE_READ,temp,adcs::ssa::num_sun_sensors);
-    #endif
+    else i2c_point_and_read(adcs::SSA_VOLTAGE_READ,temp,adcs::ssa::num_sun_sensors);
     
-    for(int i = 0;i<adcs::ssa::num_sun_sensors;i++){
-        (*voltages)[i] = fp(temp[i], adcs::ssa::min_voltage_rd, adcs::ssa::max_voltage_rd);
-    }
+    adcs::utl::fp(temp, voltages->data(), adcs::ssa::num_sun_sensors, adcs::ssa::min_voltage_rd, adcs::ssa::max_voltage_rd);
 }
 
 void ADCS::get_havt(std::bitset<adcs::havt::max_devices>* havt_table){
     // mocking return
-    #ifdef UNIT_TEST
-    (*havt_table) = mock_havt_read;
-    return;
-    #endif
+    if (mocked()) {
+        #ifdef UNIT_TEST
+        (*havt_table) = mock_havt_read;
+        #endif
+        return;
+    }
     
     //4 because 32/8 = 4
     unsigned char temp[4];
@@ -336,6 +316,96 @@ void ADCS::get_havt(std::bitset<adcs::havt::max_devices>* havt_table){
     (*havt_table) = std::bitset<adcs::havt::max_devices>(encoded);
 }
 
+void ADCS::mock_telemetry(unsigned char* readin) const {
+    #ifdef UNIT_TEST
+    using namespace adcs::telemetry;
+    // pack the same readings as the individual mocks
+    std::memset(readin, 255, LENGTH);
+    readin[WHO_AM_I] = WHO_AM_I_EXPECTED;
+    readin[VERSION] = version;
+    readin[SSA_MODE] = mock_ssa_mode;
+    unsigned int mock_havt = (unsigned int)mock_havt_read.to_ulong();
+    for (unsigned int i = 0; i < 4; i++) readin[HAVT_RD + i] = mock_havt >> (8 * i);
+    unsigned short mock_crc = crc(readin, CRC);
+    readin[CRC] = mock_crc;
+    readin[CRC + 1] = mock_crc >> 8;
+    if (mock_telemetry_corrupt) readin[SSA_VOLTAGE_RD] ^= 0xFF;
+    #endif
+}
+
+// Checks and decodes a telemetry block
+static bool decode_telemetry(const unsigned char* readin, ADCS::telemetry_t* telem){
+    using namespace adcs::telemetry;
+
+    // A failed or partial read, or a box without the TELEMETRY register,
+    // fails at least one of these checks
+    unsigned short c = (((unsigned short)readin[CRC + 1]) << 8) | (0xFF & readin[CRC]);
+    if (readin[WHO_AM_I] != ADCS::WHO_AM_I_EXPECTED || readin[VERSION] != version || c != crc(readin, CRC))
+        return false;
+
+    telem->ssa_mode = readin[SSA_MODE];
+    decode_vector(readin + RWA_SPEED_RD, &telem->rwa_speed_rd, adcs::rwa::min_speed_read, adcs::rwa::max_speed_read);
+    decode_vector(readin + RWA_RAMP_RD, &telem->rwa_ramp_rd, adcs::rwa::min_ramp_rd, adcs::rwa::max_ramp_rd);
+    decode_vector(readin + SSA_SUN_VECTOR, &telem->ssa_sun_vec, -1.0f, 1.0f);
+    adcs::utl::fp(readin + SSA_VOLTAGE_RD, telem->ssa_voltages.data(), adcs::ssa::num_sun_sensors, adcs::ssa::min_voltage_rd, adcs::ssa::max_voltage_rd);
+    decode_vector(readin + IMU_RD, &telem->mag1_rd, adcs::imu::min_mag1_rd_mag, adcs::imu::max_mag1_rd_mag);
+    decode_vector(readin + IMU_RD + 6, &telem->mag2_rd, adcs::imu::min_mag2_rd_mag, adcs::imu::max_mag2_rd_mag);
+    decode_vector(readin + IMU_RD + 12, &telem->gyr_rd, adcs::imu::min_rd_omega, adcs::imu::max_rd_omega);
+    c = (((unsigned short)readin[IMU_RD + 19]) << 8) | (0xFF & readin[IMU_RD + 18]);
+    telem->gyr_temp_rd = adcs::utl::fp(c, adcs::imu::min_rd_temp, adcs::imu::max_rd_temp);
+
+    unsigned int encoded = 0;
+    for (unsigned int i = 0; i < 4; i++) encoded |= ((unsigned int)readin[HAVT_RD + i]) << (8 * i);
+    telem->havt_table = std::bitset<adcs::havt::max_devices>(encoded);
+    return true;
+}
+
+bool ADCS::get_telemetry(telemetry_t* telem){
+    unsigned char readin[adcs::telemetry::LENGTH];
+    std::memset(readin, 0, sizeof(readin));
+
+    if (mocked()) mock_telemetry(readin);
+    else i2c_point_and_read(adcs::TELEMETRY, readin, adcs::telemetry::LENGTH);
+    return decode_telemetry(readin, telem);
+}
+
+void ADCS::on_telemetry_read(void* context, bool ok) {
+    ADCS* adcs = static_cast<ADCS*>(context);
+    adcs->telemetry_state = ok ? TELEMETRY_READY : TELEMETRY_FAILED;
+}
+
+bool ADCS::queue_telemetry(I2CScheduler& scheduler){
+    if (telemetry_state == TELEMETRY_QUEUED) return false;
+    std::memset(telemetry_block, 0, sizeof(telemetry_block));
+
+    if (mocked()) {
+        mock_telemetry(telemetry_block);
+        telemetry_state = TELEMETRY_READY;
+        return true;
+    }
+
+    #ifdef DESKTOP
+    const unsigned char address = ADDRESS;
+    #endif
+    // Point at the block, then read it, as i2c_point_and_read does. If the
+    // pointer write fails, the block read from wherever the pointer was
+    // fails its checks in take_telemetry().
+    const unsigned char pointer[2] = {adcs::READ_POINTER, adcs::TELEMETRY};
+    if (!scheduler.write(address, pointer, 2)) return false;
+    if (!scheduler.read(address, nullptr, 0, telemetry_block, adcs::telemetry::LENGTH,
+            on_telemetry_read, this))
+        return false;
+    telemetry_state = TELEMETRY_QUEUED;
+    return true;
+}
+
+bool ADCS::take_telemetry(telemetry_t* telem){
+    if (telemetry_state == TELEMETRY_QUEUED) return false;
+    const bool ready = telemetry_state == TELEMETRY_READY;
+    telemetry_state = TELEMETRY_IDLE;
+    return ready && decode_telemetry(telemetry_block, telem);
+}
+
 #ifdef UNIT_TEST
 void ADCS::set_mock_havt_read(const std::bitset<adcs::havt::max_devices>& havt_input){
     mock_havt_read = havt_input;
@@ -348,4 +418,8 @@ void ADCS::set_mock_ssa_mode(const unsigned char ssa_mode) {
 void ADCS::set_mock_adcs_functional(const bool functional) {
     adcs_functionality = functional;
 }
+
+void ADCS::set_mock_telemetry_corrupt(const bool corrupt) {
+    mock_telemetry_corrupt = corrupt;
+}
 #endif
\ No newline at end of file
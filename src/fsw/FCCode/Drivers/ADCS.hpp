@@ -8,8 +8,12 @@
 #define PAN_LIB_DRIVERS_ADCS_HPP_
 
 #include <adcs/constants.hpp>
+#include <adcs/telemetry.hpp>
 #include <fsw/FCCode/Devices/I2CDevice.hpp>
 #include <common/constant_tracker.hpp>
+#ifdef DESKTOP
+#include "ADCSBoxEmulator.hpp"
+#endif
 
 #include <array>
 #include <bitset>
@@ -25,7 +29,25 @@ class ADCS : public I2CDevice {
     unsigned int mock_ssa_mode = adcs::SSAMode::SSA_IN_PROGRESS;
     std::bitset<adcs::havt::max_devices> mock_havt_read;
     bool adcs_functionality = true;
+    bool mock_telemetry_corrupt = false;
     #endif
+
+    /**
+     * @brief Everything read from the ADCS box each control cycle. See
+     * get_telemetry().
+     */
+    struct telemetry_t {
+        std::array<float, 3> rwa_speed_rd;
+        std::array<float, 3> rwa_ramp_rd;
+        unsigned char ssa_mode;
+        std::array<float, 3> ssa_sun_vec;
+        std::array<float, adcs::ssa::num_sun_sensors> ssa_voltages;
+        std::array<float, 3> mag1_rd;
+        std::array<float, 3> mag2_rd;
+        std::array<float, 3> gyr_rd;
+        float gyr_temp_rd;
+        std::bitset<adcs::havt::max_devices> havt_table;
+    };
     /**
      * @brief quickly tests that the device is active and working on i2c
      * 
@@ -39,11 +61,13 @@ class ADCS : public I2CDevice {
      * @param name The name
      * @param i2c_wire The assoicated i2c wire
      * @param address The address on i2c bus
+     * @param box On desktop, the emulated ADCS box to talk to. Without one,
+     * reads return zeros, or mocked values in unit tests.
      */
     #ifndef DESKTOP
     ADCS(i2c_t3 &i2c_wire, unsigned char address);
     #else
-    ADCS();
+    ADCS(ADCSBoxEmulator *box = ADCSBoxEmulator::attached());
     #endif
 
     /**
@@ -317,6 +341,42 @@ class ADCS : public I2CDevice {
      */
     void get_havt(std::bitset<adcs::havt::max_devices>* havt_table);
 
+    /**
+     * @brief Get all of the readings above in a single I2C transaction.
+     * 
+     * The ADCS box packs them into a versioned block ending in a CRC, see
+     * adcs/telemetry.hpp. The sun vector is only meaningful if the ssa mode
+     * is SSA_COMPLETE.
+     * 
+     * @param telem Pointer to output readings
+     * @return false if the block is corrupt or from an incompatible ADCS box,
+     * in which case telem is left unchanged and the individual getters should
+     * be used instead.
+     */
+    bool get_telemetry(telemetry_t* telem);
+
+    /**
+     * @brief Queues the single transaction read of get_telemetry() on the
+     * scheduler instead of waiting for it. The block can be taken with
+     * take_telemetry() once the scheduler has dispatched the read, which is
+     * at the start of the next control cycle.
+     * 
+     * @param scheduler Scheduler of the wire the ADCS box is on
+     * @return false if a read is already queued or the queue is full.
+     */
+    bool queue_telemetry(I2CScheduler& scheduler);
+
+    /**
+     * @brief Decodes the block of the last queue_telemetry(), as
+     * get_telemetry() does.
+     * 
+     * @param telem Pointer to output readings
+     * @return false if the read hasn't completed yet, failed or returned a
+     * corrupt block, in which case telem is left unchanged. A block is only
+     * taken once.
+     */
+    bool take_telemetry(telemetry_t* telem);
+
 
     #ifdef UNIT_TEST
     /**
@@ -337,7 +397,49 @@ class ADCS : public I2CDevice {
      * 
      */
     void set_mock_adcs_functional(const bool functional);
+
+    /**
+     * @brief A mocking method that makes the telemetry block fail its CRC
+     */
+    void set_mock_telemetry_corrupt(const bool corrupt);
     #endif
+
+  private:
+    #ifdef DESKTOP
+    ADCSBoxEmulator *const box;
+    #else
+    const unsigned char address;
+    #endif
+
+    /** Progress of the read queued by queue_telemetry(). **/
+    enum telemetry_state_t {
+        TELEMETRY_IDLE,
+        TELEMETRY_QUEUED,
+        TELEMETRY_READY,
+        TELEMETRY_FAILED,
+    };
+    telemetry_state_t telemetry_state = TELEMETRY_IDLE;
+    /** Destination of the queued read. **/
+    unsigned char telemetry_block[adcs::telemetry::LENGTH];
+
+    static void on_telemetry_read(void* context, bool ok);
+
+    /**
+     * @brief Fills a telemetry block with the individual mocked readings.
+     */
+    void mock_telemetry(unsigned char* readin) const;
+
+    /**
+     * @brief Whether reads should return mocked values rather than go to the
+     * ADCS box, which is the case in unit tests without an emulated box.
+     */
+    bool mocked() const;
+
+    /**
+     * @brief Writes len bytes of data to the given register.
+     */
+    void write_register(unsigned char data_register, const unsigned char *data, std::size_t len);
+    void write_register(unsigned char data_register, unsigned char data);
 };
 
 }  // namespace Devices
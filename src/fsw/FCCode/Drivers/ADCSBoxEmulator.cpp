@@ -0,0 +1,375 @@
+#ifdef DESKTOP
+
+#include "ADCSBoxEmulator.hpp"
+#include <adcs/constants.hpp>
+#include <adcs/havt_devices.hpp>
+#include <adcs/state_registers.hpp>
+#include <adcs/telemetry.hpp>
+#include <adcs/utl/convert.hpp>
+#include <common/ReplayLog.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+using namespace Devices;
+
+const constexpr unsigned int ADCSBoxEmulator::BUS_FREQUENCY;
+
+ADCSBoxEmulator *ADCSBoxEmulator::_attached = nullptr;
+
+static long long system_clock_us() {
+    const long long now_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    return ReplayLog::clock_us(now_us);
+}
+
+typedef std::array<double, 3> vec_t;
+
+static vec_t cross(const vec_t &a, const vec_t &b) {
+    return {{a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]}};
+}
+
+static double dot(const vec_t &a, const vec_t &b) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+
+/**
+ * @brief Rotates v by the quaternion q = {x, y, z, w}.
+ */
+static vec_t rotate(const std::array<double, 4> &q, const vec_t &v) {
+    const vec_t qv = {{q[0], q[1], q[2]}};
+    vec_t t = cross(qv, v);
+    for (auto &x : t) x *= 2;
+    const vec_t u = cross(qv, t);
+    vec_t r;
+    for (int i = 0; i < 3; i++) r[i] = v[i] + q[3] * t[i] + u[i];
+    return r;
+}
+
+static double clamp(double x, double limit) { return std::max(-limit, std::min(limit, x)); }
+
+/**
+ * @brief Normals of the sun sensors in the body frame: four on each face but
+ * the -z one, tilted 20 degrees away from the face normal, in the order of
+ * the SSA_VOLTAGE_READ register.
+ */
+static const std::array<vec_t, 20> &ssa_normals() {
+    static std::array<vec_t, 20> normals;
+    static bool init = false;
+    if (!init) {
+        const double c = std::cos(20.0 * M_PI / 180.0), s = std::sin(20.0 * M_PI / 180.0);
+        const vec_t faces[5] = {{{1, 0, 0}}, {{0, -1, 0}}, {{-1, 0, 0}}, {{0, 1, 0}}, {{0, 0, 1}}};
+        for (int f = 0; f < 5; f++) {
+            // Two directions perpendicular to the face normal
+            const vec_t &n = faces[f];
+            const vec_t a = (f == 4) ? vec_t{{1, 0, 0}} : vec_t{{0, 0, 1}};
+            const vec_t b = cross(n, a);
+            const vec_t tilts[4] = {a, {{-a[0], -a[1], -a[2]}}, b, {{-b[0], -b[1], -b[2]}}};
+            for (int k = 0; k < 4; k++)
+                for (int i = 0; i < 3; i++) normals[4 * f + k][i] = c * n[i] + s * tilts[k][i];
+        }
+        init = true;
+    }
+    return normals;
+}
+
+ADCSBoxEmulator::ADCSBoxEmulator(const config_t &config)
+    : config(config), clock_us(system_clock_us), rng(config.seed), regs{0x0F}, w(config.rate) {
+    regs.rwa.momentum_flt = 1.0f;
+    regs.rwa.ramp_flt = 1.0f;
+    regs.mtr.moment_limit = adcs::mtr::max_moment;
+    regs.ssa.voltage_flt = 1.0f;
+    regs.imu.mag_flt = 1.0f;
+    regs.imu.gyr_flt = 1.0f;
+    regs.imu.gyr_temp_flt = 1.0f;
+    update_sensors();
+}
+
+void ADCSBoxEmulator::advance() {
+    const long long t = clock_us();
+    if (now_us < 0) now_us = t;
+
+    // Catching up on more than a second means the run was paused, and the
+    // model is better off skipping the gap than spending seconds on it.
+    const long long elapsed = std::min(t - now_us, 1000000LL);
+    if (elapsed > 0) step(elapsed / 1e6);
+    now_us = t;
+}
+
+void ADCSBoxEmulator::occupy_bus(size_t len) {
+    // A start condition, the address byte, the data bytes and a stop
+    // condition, each byte followed by an acknowledge bit.
+    const long long bits = 2 + 9 * (1 + len);
+    const long long bus_us = (bits * 1000000 + BUS_FREQUENCY - 1) / BUS_FREQUENCY;
+    _stats.bus_us += bus_us;
+
+    if (config.realtime) {
+        const auto end = std::chrono::steady_clock::now() + std::chrono::microseconds(bus_us);
+        while (std::chrono::steady_clock::now() < end) {}
+    }
+}
+
+void ADCSBoxEmulator::step(double dt) {
+    // Fixed substeps keep the integration stable for any control cycle
+    const double max_dt = 0.001;
+    while (dt > 0) {
+        const double h = std::min(dt, max_dt);
+        dt -= h;
+
+        const bool active = regs.mode == adcs::ADCSMode::ADCS_ACTIVE;
+        const double wheel_inertia = adcs::rwa::moment_of_inertia;
+
+        // Torque applied to each wheel by its motor
+        vec_t wheel_torque = {{0, 0, 0}};
+        for (int i = 0; i < 3; i++) {
+            if (!active) break;
+            if (regs.rwa.mode == adcs::RWAMode::RWA_ACCEL_CTRL)
+                wheel_torque[i] = regs.rwa.cmd[i];
+            else if (regs.rwa.mode == adcs::RWAMode::RWA_SPEED_CTRL)
+                wheel_torque[i] = wheel_inertia * (regs.rwa.cmd[i] - wheel[i]) / h;
+            wheel_torque[i] = clamp(wheel_torque[i], adcs::rwa::max_torque);
+        }
+        for (int i = 0; i < 3; i++) {
+            wheel[i] = clamp(wheel[i] + wheel_torque[i] / wheel_inertia * h, adcs::rwa::max_speed_read);
+            regs.rwa.ramp_rd[i] = std::fabs(wheel_torque[i]);
+        }
+
+        // Magnetorquer torque in the body field
+        const vec_t b = rotate(q, config.mag_field);
+        vec_t moment = {{0, 0, 0}};
+        if (active && regs.mtr.mode == adcs::MTRMode::MTR_ENABLED) {
+            for (int i = 0; i < 3; i++) moment[i] = clamp(regs.mtr.cmd[i], regs.mtr.moment_limit);
+        }
+        const vec_t mtr_torque = cross(moment, b);
+
+        // Euler's equations with the wheels' momentum
+        vec_t h_total;
+        for (int i = 0; i < 3; i++) h_total[i] = config.inertia[i] * w[i] + wheel_inertia * wheel[i];
+        const vec_t gyro = cross(w, h_total);
+        for (int i = 0; i < 3; i++)
+            w[i] += (mtr_torque[i] - wheel_torque[i] - gyro[i]) / config.inertia[i] * h;
+
+        // q_body_eci evolves as dq/dt = -1/2 [w, 0] q
+        const std::array<double, 4> p = q;
+        q[0] -= 0.5 * h * (w[1] * p[2] - w[2] * p[1] + p[3] * w[0]);
+        q[1] -= 0.5 * h * (w[2] * p[0] - w[0] * p[2] + p[3] * w[1]);
+        q[2] -= 0.5 * h * (w[0] * p[1] - w[1] * p[0] + p[3] * w[2]);
+        q[3] -= 0.5 * h * -(w[0] * p[0] + w[1] * p[1] + w[2] * p[2]);
+        const double n = std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+        for (auto &x : q) x /= n;
+    }
+    update_sensors();
+}
+
+void ADCSBoxEmulator::update_sensors() {
+    std::normal_distribution<double> gyr_noise(0, config.gyr_noise);
+    std::normal_distribution<double> mag_noise(0, config.mag_noise);
+
+    const vec_t b = rotate(q, config.mag_field);
+    for (int i = 0; i < 3; i++) {
+        regs.rwa.momentum_rd[i] = wheel[i];
+        regs.imu.gyr_rd[i] = w[i] + (config.gyr_noise > 0 ? gyr_noise(rng) : 0);
+        regs.imu.mag1_rd[i] = b[i] + (config.mag_noise > 0 ? mag_noise(rng) : 0);
+        regs.imu.mag2_rd[i] = b[i] + (config.mag_noise > 0 ? mag_noise(rng) : 0);
+    }
+    regs.imu.gyr_temp_rd = config.gyr_temp;
+
+    const vec_t s = rotate(q, config.sun_vec);
+    const double s_norm = std::sqrt(dot(s, s));
+    for (int i = 0; i < 20; i++) {
+        const double v = s_norm > 0 ? adcs::ssa::max_voltage_rd * dot(ssa_normals()[i], s) / s_norm : 0;
+        regs.ssa.voltage_rd[i] = std::max(0.0, v);
+    }
+
+    unsigned int functional = 0;
+    for (unsigned int i = 0; i < adcs::havt::Index::_LENGTH; i++) functional |= 1u << i;
+    regs.havt.read_table = functional & ~failed;
+}
+
+void ADCSBoxEmulator::update_sun_vector() {
+    // Like the box, needs enough sensors in view of the sun for its least
+    // squares fit. The fit of noiseless voltages is the sun vector itself.
+    const float sensor_voltage_thresh = 1.0f;
+    const unsigned int sensor_count_thresh = 4;
+    unsigned int count = 0;
+    for (int i = 0; i < 20; i++)
+        if (regs.ssa.voltage_rd[i] > sensor_voltage_thresh) count++;
+    if (count < sensor_count_thresh) {
+        regs.ssa.mode = adcs::SSAMode::SSA_FAILURE;
+        return;
+    }
+
+    const vec_t s = rotate(q, config.sun_vec);
+    const double s_norm = std::sqrt(dot(s, s));
+    for (int i = 0; i < 3; i++) regs.ssa.sun_vec_rd[i] = s[i] / s_norm;
+    regs.ssa.mode = adcs::SSAMode::SSA_COMPLETE;
+}
+
+void ADCSBoxEmulator::write(const unsigned char *data, size_t len) {
+    occupy_bus(len);
+    receive(data, len);
+}
+
+void ADCSBoxEmulator::read(unsigned char *data, size_t len) {
+    occupy_bus(len);
+    request(data, len);
+}
+
+void ADCSBoxEmulator::receive(const unsigned char *data, size_t len) {
+    advance();
+    _stats.writes++;
+    _stats.bytes += len;
+    if (len < 1) return;
+
+    using adcs::utl::fp;
+    const unsigned char *payload = data + 1;
+    const size_t available = len - 1;
+    auto read_us = [payload](size_t i) {
+        return (unsigned short)(payload[2 * i] | (payload[2 * i + 1] << 8));
+    };
+
+    switch (data[0]) {
+    case adcs::Register::ADCS_MODE:
+        if (available >= 1) regs.mode = payload[0];
+        break;
+    case adcs::Register::READ_POINTER:
+        if (available >= 1) regs.read_ptr = payload[0];
+        break;
+    case adcs::Register::RWA_MODE:
+        if (available >= 1) regs.rwa.mode = payload[0];
+        break;
+    case adcs::Register::RWA_COMMAND:
+        if (available < 6) break;
+        for (int i = 0; i < 3; i++) {
+            if (regs.rwa.mode == adcs::RWAMode::RWA_ACCEL_CTRL)
+                regs.rwa.cmd[i] = fp(read_us(i), adcs::rwa::min_torque, adcs::rwa::max_torque);
+            else if (regs.rwa.mode == adcs::RWAMode::RWA_SPEED_CTRL)
+                regs.rwa.cmd[i] = fp(read_us(i), adcs::rwa::min_speed_command, adcs::rwa::max_speed_command);
+        }
+        regs.rwa.cmd_flg = adcs::CMDFlag::UPDATED;
+        break;
+    case adcs::Register::RWA_SPEED_FILTER:
+        if (available >= 1) regs.rwa.momentum_flt = fp(payload[0], 0.0f, 1.0f);
+        break;
+    case adcs::Register::RWA_RAMP_FILTER:
+        if (available >= 1) regs.rwa.ramp_flt = fp(payload[0], 0.0f, 1.0f);
+        break;
+    case adcs::Register::MTR_MODE:
+        if (available >= 1) regs.mtr.mode = payload[0];
+        break;
+    case adcs::Register::MTR_COMMAND:
+        if (available < 6) break;
+        for (int i = 0; i < 3; i++)
+            regs.mtr.cmd[i] = fp(read_us(i), adcs::mtr::min_moment, adcs::mtr::max_moment);
+        regs.mtr.cmd_flg = adcs::CMDFlag::UPDATED;
+        break;
+    case adcs::Register::MTR_LIMIT:
+        if (available < 2) break;
+        regs.mtr.moment_limit = fp(read_us(0), adcs::mtr::min_moment, adcs::mtr::max_moment);
+        break;
+    case adcs::Register::SSA_MODE:
+        // A new conversion can only be started once the last one is over
+        if (available < 1) break;
+        if (regs.ssa.mode == adcs::SSAMode::SSA_COMPLETE || regs.ssa.mode == adcs::SSAMode::SSA_FAILURE)
+            regs.ssa.mode = payload[0];
+        if (regs.ssa.mode == adcs::SSAMode::SSA_IN_PROGRESS) update_sun_vector();
+        break;
+    case adcs::Register::SSA_VOLTAGE_FILTER:
+        if (available >= 1) regs.ssa.voltage_flt = fp(payload[0], 0.0f, 1.0f);
+        break;
+    case adcs::Register::IMU_MAG1_MODE:
+        if (available >= 1) regs.imu.mag1_mode = payload[0];
+        break;
+    case adcs::Register::IMU_MAG2_MODE:
+        if (available >= 1) regs.imu.mag2_mode = payload[0];
+        break;
+    case adcs::Register::IMU_MAG_FILTER:
+        if (available >= 1) regs.imu.mag_flt = fp(payload[0], 0.0f, 1.0f);
+        break;
+    case adcs::Register::IMU_GYR_FILTER:
+        if (available >= 1) regs.imu.gyr_flt = fp(payload[0], 0.0f, 1.0f);
+        break;
+    case adcs::Register::IMU_GYR_TEMP_FILTER:
+        if (available >= 1) regs.imu.gyr_temp_flt = fp(payload[0], 0.0f, 1.0f);
+        break;
+    case adcs::Register::IMU_GYR_TEMP_PWM:
+        if (available >= 1) regs.imu.gyr_temp_pwm = payload[0];
+        break;
+    case adcs::Register::IMU_GYR_TEMP_DESIRED:
+        if (available >= 1)
+            regs.imu.gyr_desired_temp = fp(payload[0], adcs::imu::min_eq_temp, adcs::imu::max_eq_temp);
+        break;
+    case adcs::Register::HAVT_COMMAND_RESET:
+        if (available < 4) break;
+        std::memcpy(&regs.havt.cmd_reset_table, payload, 4);
+        failed &= ~regs.havt.cmd_reset_table;
+        break;
+    case adcs::Register::HAVT_COMMAND_DISABLE:
+        if (available < 4) break;
+        std::memcpy(&regs.havt.cmd_disable_table, payload, 4);
+        failed |= regs.havt.cmd_disable_table;
+        break;
+    default:
+        break;
+    }
+    update_sensors();
+}
+
+void ADCSBoxEmulator::request(unsigned char *data, size_t len) {
+    advance();
+    _stats.reads++;
+    _stats.bytes += len;
+
+    using adcs::utl::uc;
+    using adcs::utl::us;
+    unsigned char out[adcs::telemetry::LENGTH];
+    size_t n = 0;
+    auto put_us = [&out, &n](unsigned short x) {
+        out[n++] = (unsigned char)x;
+        out[n++] = (unsigned char)(x >> 8);
+    };
+
+    switch (regs.read_ptr) {
+    case adcs::Register::WHO_AM_I:
+        out[n++] = regs.who_am_i;
+        break;
+    case adcs::Register::RWA_SPEED_RD:
+        for (int i = 0; i < 3; i++)
+            put_us(us(regs.rwa.momentum_rd[i], adcs::rwa::min_speed_read, adcs::rwa::max_speed_read));
+        for (int i = 0; i < 3; i++)
+            put_us(us(regs.rwa.ramp_rd[i], adcs::rwa::min_ramp_rd, adcs::rwa::max_ramp_rd));
+        break;
+    case adcs::Register::SSA_MODE:
+        out[n++] = regs.ssa.mode;
+        break;
+    case adcs::Register::SSA_SUN_VECTOR:
+        for (int i = 0; i < 3; i++) put_us(us(regs.ssa.sun_vec_rd[i], -1.0f, 1.0f));
+        break;
+    case adcs::Register::SSA_VOLTAGE_READ:
+        for (int i = 0; i < 20; i++)
+            out[n++] = uc(regs.ssa.voltage_rd[i], adcs::ssa::min_voltage_rd, adcs::ssa::max_voltage_rd);
+        break;
+    case adcs::Register::IMU_READ:
+        for (int i = 0; i < 3; i++)
+            put_us(us(regs.imu.mag1_rd[i], adcs::imu::min_mag1_rd_mag, adcs::imu::max_mag1_rd_mag));
+        for (int i = 0; i < 3; i++)
+            put_us(us(regs.imu.mag2_rd[i], adcs::imu::min_mag2_rd_mag, adcs::imu::max_mag2_rd_mag));
+        for (int i = 0; i < 3; i++)
+            put_us(us(regs.imu.gyr_rd[i], adcs::imu::min_rd_omega, adcs::imu::max_rd_omega));
+        put_us(us(regs.imu.gyr_temp_rd, adcs::imu::min_rd_temp, adcs::imu::max_rd_temp));
+        break;
+    case adcs::Register::HAVT_READ:
+        for (int i = 0; i < 4; i++) out[n++] = (unsigned char)(regs.havt.read_table >> (8 * i));
+        break;
+    case adcs::Register::TELEMETRY:
+        adcs::telemetry::encode(regs, out);
+        n = adcs::telemetry::LENGTH;
+        break;
+    default:
+        break;
+    }
+
+    std::memset(data, 0, len);
+    std::memcpy(data, out, std::min(n, len));
+}
+
+#endif
@@ -0,0 +1,156 @@
+#ifndef ADCSBoxEmulator_hpp
+#define ADCSBoxEmulator_hpp
+
+#ifdef DESKTOP
+
+#include <adcs/state.hpp>
+#include <common/constant_tracker.hpp>
+#include <fsw/FCCode/Devices/I2CScheduler.hpp>
+#include <array>
+#include <cstddef>
+#include <random>
+
+namespace Devices {
+
+/**
+ * @brief In-process model of the ADCS box, which the ADCS driver talks to in
+ * place of the I2C bus on desktop.
+ *
+ * The model implements the umbilical register map of the box firmware (see
+ * adcs::Register and adcs::umb). A write transaction starts with a register
+ * address and sets that register as on_i2c_recieve does, and a read
+ * transaction returns the register at the read pointer, encoded as
+ * on_i2c_request does. Behind the registers, a rigid body with three reaction
+ * wheels and three magnetorquers rotates in a constant magnetic field and
+ * sunlight, and the box's sensors read its state.
+ *
+ * Each transaction of the driver occupies the bus for as long as it would at
+ * 400 kHz. The bus time is counted so that the I2C time of the control tasks
+ * can be measured, and the model can also wait that long so that the run time
+ * of the control tasks is realistic.
+ *
+ * The model is also an I2CTarget, so that transactions queued on a desktop
+ * I2CScheduler reach it. The scheduler models and counts the bus time of
+ * those, so they neither wait nor add to bus_us.
+ */
+class ADCSBoxEmulator : public I2CTarget {
+  public:
+    struct config_t {
+        /** Principal moments of inertia of the spacecraft, in kg m^2. **/
+        std::array<double, 3> inertia = {{0.035, 0.035, 0.015}};
+        /** Initial angular rate in the body frame, in rad/s. **/
+        std::array<double, 3> rate = {{0.0, 0.0, 0.0}};
+        /** Magnetic field in the inertial frame, in T. **/
+        std::array<double, 3> mag_field = {{2.0e-5, -1.0e-5, 3.5e-5}};
+        /** Direction of the sun in the inertial frame, or zero in eclipse. **/
+        std::array<double, 3> sun_vec = {{1.0, 0.0, 0.0}};
+        /** Standard deviation of the gyroscope noise, in rad/s. **/
+        double gyr_noise = 0.0;
+        /** Standard deviation of the magnetometer noise, in T. **/
+        double mag_noise = 0.0;
+        /** Gyroscope temperature, in degrees C. **/
+        float gyr_temp = 25.0f;
+        /** Whether transactions take as long as they would on the bus. **/
+        bool realtime = false;
+        /** Seed of the sensor noise. **/
+        unsigned int seed = 0;
+    };
+
+    /** Counters for measuring bus usage. **/
+    struct stats_t {
+        unsigned int writes = 0;
+        unsigned int reads = 0;
+        unsigned int bytes = 0;
+        /** Bus time of the driver's transactions, queued ones excluded. **/
+        long long bus_us = 0;
+    };
+
+    TRACKED_CONSTANT_SC(unsigned int, BUS_FREQUENCY, 400000);
+
+    explicit ADCSBoxEmulator(const config_t &config);
+
+    /**
+     * @brief Box that ADCS drivers constructed without an explicit box should
+     * talk to, or nullptr if they should keep returning mocked values.
+     */
+    static ADCSBoxEmulator *attached() { return _attached; }
+    static void attach(ADCSBoxEmulator *box) { _attached = box; }
+
+    /**
+     * @brief Replaces the clock of the model, in microseconds. By default, the
+     * model reads the system clock through the replay log.
+     */
+    void set_clock(long long (*clock_us)()) { this->clock_us = clock_us; }
+
+    /**
+     * @brief I2C interface used by the driver. write() is a write
+     * transaction, whose first byte is the register address. read() is a read
+     * transaction of len bytes from the register at the read pointer; bytes
+     * the register doesn't have read as zero.
+     *
+     * Both first advance the model to the time of the clock.
+     */
+    void write(const unsigned char *data, size_t len);
+    void read(unsigned char *data, size_t len);
+
+    /**
+     * @brief The same transactions, run by an I2CScheduler without occupying
+     * the bus.
+     */
+    void receive(const unsigned char *data, size_t len) override;
+    void request(unsigned char *data, size_t len) override;
+
+    /**
+     * @brief Advances the model by dt seconds.
+     */
+    void step(double dt);
+
+    /**
+     * @brief Marks the devices set in the table as not functional, as their
+     * HAVT reads would. Disabling through HAVT_COMMAND_DISABLE has the same
+     * effect, and HAVT_COMMAND_RESET makes devices functional again.
+     */
+    void fail_devices(unsigned int table) { failed |= table; }
+
+    const stats_t &stats() const { return _stats; }
+    const adcs::Registers &registers() const { return regs; }
+
+    /** @brief Attitude of the body, as a quaternion {x, y, z, w} rotating
+     *  inertial vectors into the body frame. **/
+    const std::array<double, 4> &q_body_eci() const { return q; }
+    /** @brief Angular rate of the body, in the body frame, in rad/s. **/
+    const std::array<double, 3> &rate() const { return w; }
+    /** @brief Speeds of the reaction wheels, in rad/s. **/
+    const std::array<double, 3> &wheel_speed() const { return wheel; }
+
+  private:
+    static ADCSBoxEmulator *_attached;
+
+    const config_t config;
+    long long (*clock_us)();
+    std::mt19937 rng;
+
+    adcs::Registers regs;
+    /** Devices failed through fail_devices() or HAVT_COMMAND_DISABLE. **/
+    unsigned int failed = 0;
+
+    std::array<double, 4> q = {{0.0, 0.0, 0.0, 1.0}};
+    std::array<double, 3> w;
+    std::array<double, 3> wheel = {{0.0, 0.0, 0.0}};
+
+    /** Time up to which the model has been advanced, or -1 before the first
+     *  transaction. **/
+    long long now_us = -1;
+    stats_t _stats;
+
+    void advance();
+    void occupy_bus(size_t len);
+    void update_sensors();
+    void update_sun_vector();
+};
+
+}
+
+#endif
+
+#endif
@@ -28,33 +28,68 @@ Piksi::Piksi(const std::string &name, HardwareSerial &serial_port)
     : Device(name), _serial_port(serial_port) {}
 IntervalTimer check_buffer_timer = IntervalTimer();
 #else
-Piksi::Piksi(const std::string &name) {
+PiksiSbpLog *Piksi::_log = nullptr;
+
+Piksi::Piksi(const std::string &name, PiksiSbpLog *log) {
     _read_return = 2; // this is the no fix return condition
+    _log = log;
 }
 #endif
 
+const constexpr size_t Piksi::RX_BUFFER_SIZE;
+RingBuffer<unsigned char, Piksi::RX_BUFFER_SIZE> Piksi::_rx_bytes;
+RingBuffer<Piksi::frame_arrival_t, 64> Piksi::_rx_frames;
+
+// First byte of every SBP frame. See sbp.c
+static constexpr unsigned char sbp_preamble = 0x55;
+
+// Offset of the next byte within the SBP frame it belongs to, or 0 if the
+// next byte should be a preamble, and the number of bytes left in the frame
+// once its length is known. Only used by check_bytes().
+static unsigned int frame_offset = 0;
+static unsigned int frame_remaining = 0;
+
+unsigned long Piksi::_clock_us() {
 #ifndef DESKTOP
-static volatile int last_bytes = 0;
-static volatile unsigned long interrupt_count = 0;
-static volatile unsigned long last_interrupt_count;
+    return micros();
+#else
+    return _log ? static_cast<unsigned long>(_log->now_us()) : 0;
 #endif
+}
 
 void Piksi::check_bytes(){
 #ifndef DESKTOP
-    interrupt_count++;
-    int bytes = Serial4.available();
-
-    // if bytes are entering the buffer, update the timestamp
-    if (bytes > last_bytes) {
-        // if there is a break of 10ms, new packet has arrived
-        if (interrupt_count - last_interrupt_count > 100) {
-            interrupt_count = 0;
+    HardwareSerial &port = Serial4;
+#else
+    if (!_log) return;
+    PiksiSbpLog &port = *_log;
+#endif
+    const unsigned long now = _clock_us();
+    for (int available = port.available(); available > 0; available--) {
+        if (_rx_bytes.size() == _rx_bytes.capacity()) break; // Leave the rest on the port until there's room
+        const unsigned char byte = port.read();
+
+        // Track SBP frame boundaries: preamble, type (2), sender (2), length,
+        // payload and CRC (2).
+        if (frame_offset == 0) {
+            if (byte == sbp_preamble) {
+                _rx_frames.push({_rx_bytes.pushed(), now});
+                frame_offset = 1;
+            }
+        }
+        else if (frame_offset < 5) {
+            frame_offset++;
+        }
+        else if (frame_offset == 5) {
+            frame_offset++;
+            frame_remaining = byte + 2;
+        }
+        else if (--frame_remaining == 0) {
+            frame_offset = 0;
         }
 
-        last_bytes = bytes;
-        last_interrupt_count = interrupt_count;
-   }
-#endif
+        _rx_bytes.push(byte);
+    }
 }
 
 
@@ -74,6 +109,7 @@ bool Piksi::setup() {
     _serial_port.begin(BAUD_RATE);
     #endif
 
+    clear_bytes();
     start_interrupt();
 
     clear_log();
@@ -308,39 +344,30 @@ unsigned char Piksi::process_buffer_msg_len() {
 }
 
 unsigned char Piksi::read_all() {
-  //  #if defined(UNIT_TEST) || defined(DESKTOP) 
     #ifdef DESKTOP
-    return _read_return;
-    #else
-
-    noInterrupts();
-
-    int bytes = last_bytes;
-    last_bytes = 0;
-
-    buffer_begin = buffer;
-    buffer_end = buffer;
-    // copy buffer up to available
-    for (int i = 0; i < bytes; i++){
-        *(buffer_end++) = Serial4.read();
-    }
+    if (!_log) return _read_return;
+    // There's no timer interrupt on desktop, so pick up the bytes that
+    // have arrived so far.
+    check_bytes();
+    #endif
 
-    microdelta = interrupt_count*100; //convert to us
+    // Only process the bytes that have arrived so far, parsing them straight
+    // out of the ring buffer while check_bytes() keeps filling it.
+    const size_t end = _rx_bytes.pushed();
 
-    interrupts();
-
-    
     _gps_time_update = false;
     _pos_ecef_update = false;
     _vel_ecef_update = false;
     _baseline_ecef_update = false;
     
-    if(buffer_begin < buffer_end){ 
+    if(_rx_bytes.popped() != end){ 
         bool crc_error = false;
-        while(buffer_begin < buffer_end){
+        while(static_cast<long>(end - _rx_bytes.popped()) > 0){
             crc_error |= process_buffer() < 0;
         }
 
+        microdelta = _clock_us() - (_gps_time_update ? _gps_time_arrival_us : _frame_arrival_us);
+
         if(crc_error)
             return 3;
         else if(_gps_time_update && _pos_ecef_update && _vel_ecef_update && !_baseline_ecef_update)
@@ -356,39 +383,44 @@ unsigned char Piksi::read_all() {
     else
         //no bytes return condition
         return 4;
-    #endif
 }
 
 u32 Piksi::bytes_available() { 
     #ifndef DESKTOP
-    return _serial_port.available(); 
+    return _rx_bytes.size() + _serial_port.available(); 
     #else
-
+    return _rx_bytes.size() + (_log ? _log->available() : 0);
     #endif
-    return 0;
 }
 
 void Piksi::clear_bytes() { 
     #ifndef DESKTOP
-    _serial_port.clear(); 
+    // The port is also read by check_bytes(), so keep it from running while
+    // the port is cleared.
+    noInterrupts();
+    _serial_port.clear();
+    #endif
+    frame_offset = 0;
+    _rx_bytes.clear();
+    _rx_frames.clear();
+    #ifndef DESKTOP
+    interrupts();
     #endif
     }
 
 u32 Piksi::_uart_read(u8 *buff, u32 n, void *context) {
-    #ifndef DESKTOP
-    Piksi *piksi = (Piksi *)context; // so it can access serial port
+    Piksi *piksi = (Piksi *)context;
 
-    u32 i;
-    for (i = 0; i < n; i++) {
-        if (piksi->buffer_begin < piksi->buffer_end)
-            buff[i] = *(piksi->buffer_begin++);
-        else
-            break;
+    const size_t begin = _rx_bytes.popped();
+    const u32 count = _rx_bytes.pop(buff, n);
+
+    // Note the arrival time of the frame these bytes belong to.
+    frame_arrival_t frame;
+    while (_rx_frames.peek(frame) && static_cast<long>(begin + count - frame.pos) > 0) {
+        piksi->_frame_arrival_us = frame.time_us;
+        _rx_frames.pop(frame);
     }
-    return i;
-    #else
-    return 0;
-    #endif
+    return count;
 }
 
 u32 Piksi::_uart_write(u8 *buff, u32 n, void *context) {
@@ -430,6 +462,7 @@ void Piksi::_gps_time_callback(u16 sender_id, u8 len, u8 msg[], void *context) {
     Piksi *piksi = (Piksi *)context;
     memcpy((u8 *)(&(piksi->_gps_time)), msg, sizeof(msg_gps_time_t));
     piksi->_gps_time_update = true;
+    piksi->_gps_time_arrival_us = piksi->_frame_arrival_us;
 }
 
 void Piksi::_dops_callback(u16 sender_id, u8 len, u8 msg[], void *context) {
@@ -6,11 +6,13 @@
 #include <HardwareSerial.h>
 #include "../Devices/Device.hpp"
 #else
+#include "PiksiSbpLog.hpp"
 #include <iostream>
 #include <string>
 #endif
 
 #include <common/GPSTime.hpp>
+#include <common/RingBuffer.hpp>
 #include <array>
 #include <libsbp/logging.h>
 #include <libsbp/navigation.h>
@@ -37,6 +39,8 @@ class Piksi {
     // Driver limit for max processing time of read_all()
     // Choose 900 us to large safety bound over average read time of 600 us
     TRACKED_CONSTANT_SC(unsigned int, READ_ALL_LIMIT, 900);
+    //! Capacity of the receive ring buffer, in bytes.
+    TRACKED_CONSTANT_SC(size_t, RX_BUFFER_SIZE, 1024);
 
     /**
      * @brief Construct a new Piksi object
@@ -47,8 +51,13 @@ class Piksi {
     Piksi(const std::string &name, HardwareSerial &serial_port);
     #else
     using String = std::string;
-    //Piksi();
-    Piksi(const std::string &name);
+    /**
+     * @brief Construct a new Piksi object
+     *
+     * @param log SBP log to read in place of a serial port. Without a log,
+     * read_all() returns the value given to set_read_return().
+     */
+    Piksi(const std::string &name, PiksiSbpLog *log = PiksiSbpLog::attached());
     #endif
 
     // Standard device functions
@@ -326,32 +335,38 @@ class Piksi {
     void clear_log();
 
     /**
-     * @brief Returns the number of bytes available on the serial port to read
+     * @brief Returns the number of bytes received from the Piksi that are
+     * waiting to be processed
      *
      * @return u32 number of bytes available
      */
     u32 bytes_available();
 
     /**
-     * @brief Clears all the bytes waiting to be read on the serial port
+     * @brief Clears all the bytes waiting to be processed
      *
      */
     void clear_bytes();
 
     /**
-     * @brief Check if bytes are entering the buffer
+     * @brief Moves the bytes that arrived on the serial port into the receive
+     * ring buffer, and timestamps the start of each SBP frame. This is the
+     * only producer of the ring buffer, and runs in an interrupt. On desktop,
+     * read_all() calls it instead.
      * 
      */
     static void check_bytes();
 
     /**
-     * @brief Begin checking bytes in buffer at set interval
+     * @brief Begin moving bytes into the receive ring buffer at set interval
      * 
      */
     void start_interrupt();
 
     /**
-     * @brief Get microdelta (time delay between now and time data entered buffer)
+     * @brief Get microdelta (time delay between now and the arrival of the
+     * frame that carried the latest GPS time, or of the latest frame
+     * processed if there was no GPS time)
      * 
      * @return unsigned long 
      */
@@ -432,10 +447,25 @@ class Piksi {
     bool _heartbeat_update;
     bool _user_data_update;
 
-#ifndef DESKTOP
-    unsigned char buffer[SERIAL4_RX_BUFFER_SIZE]; 
-    unsigned char* buffer_begin;
-    unsigned char* buffer_end;
+    struct frame_arrival_t {
+        size_t pos;             // Position of the frame's preamble in the byte stream
+        unsigned long time_us;  // Time at which the preamble was received
+    };
+
+    // Bytes received from the Piksi, filled by check_bytes() and drained by
+    // process_buffer(), and the arrival times of the frames they contain.
+    static RingBuffer<unsigned char, RX_BUFFER_SIZE> _rx_bytes;
+    static RingBuffer<frame_arrival_t, 64> _rx_frames;
+
+    // Arrival times of the frame being processed and of the latest GPS time.
+    unsigned long _frame_arrival_us = 0;
+    unsigned long _gps_time_arrival_us = 0;
+
+    // Clock used to timestamp frames, in microseconds.
+    static unsigned long _clock_us();
+
+#ifdef DESKTOP
+    static PiksiSbpLog *_log;
 #endif
     unsigned long microdelta = 0;
 
@@ -0,0 +1,121 @@
+#ifdef DESKTOP
+
+#include "PiksiSbpLog.hpp"
+#include "Piksi.hpp"
+#include <common/ReplayLog.hpp>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+
+using namespace Devices;
+
+PiksiSbpLog *PiksiSbpLog::_attached = nullptr;
+
+static long long system_clock_us() {
+    const long long now_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    return ReplayLog::clock_us(now_us);
+}
+
+PiksiSbpLog::PiksiSbpLog(const std::vector<unsigned char> &bytes, const config_t &config)
+    : bytes(bytes), config(config), clock_us(system_clock_us) {}
+
+bool PiksiSbpLog::load(const std::string &path, std::vector<unsigned char> &bytes) {
+    bool ok = true;
+    if (!ReplayLog::is_replaying()) {
+        std::ifstream file(path, std::ios::binary);
+        ok = file.good();
+        bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    size_t len = ok ? bytes.size() : 0;
+    ReplayLog::input(&len, sizeof(len));
+    bytes.resize(len);
+    if (len > 0) ReplayLog::input(bytes.data(), len);
+    return ok || ReplayLog::is_replaying();
+}
+
+static u32 append_bytes(u8 *buff, u32 n, void *context) {
+    std::vector<unsigned char> *bytes = static_cast<std::vector<unsigned char> *>(context);
+    bytes->insert(bytes->end(), buff, buff + n);
+    return n;
+}
+
+void PiksiSbpLog::generate(unsigned int epochs, bool rtk, std::vector<unsigned char> &bytes) {
+    sbp_state_t state;
+    sbp_state_init(&state);
+    sbp_state_set_io_context(&state, &bytes);
+
+    // Circular equatorial orbit at 400 km altitude
+    const double mu = 3.986004418e14;
+    const double r = 6.778e6;
+    const double omega = std::sqrt(mu / (r * r * r));
+
+    for (unsigned int i = 0; i < epochs; i++) {
+        const unsigned int tow = 100 * i;
+        const double theta = omega * tow / 1000.0;
+
+        msg_gps_time_t time = {};
+        time.wn = 2100;
+        time.tow = tow;
+        sbp_send_message(&state, SBP_MSG_GPS_TIME, 0, sizeof(time), (u8 *)&time, append_bytes);
+
+        msg_pos_ecef_t pos = {};
+        pos.tow = tow;
+        pos.x = r * std::cos(theta);
+        pos.y = r * std::sin(theta);
+        pos.n_sats = 8;
+        pos.flags = rtk ? 1 : 0;
+        sbp_send_message(&state, SBP_MSG_POS_ECEF, 0, sizeof(pos), (u8 *)&pos, append_bytes);
+
+        msg_vel_ecef_t vel = {};
+        vel.tow = tow;
+        vel.x = static_cast<s32>(-1000 * r * omega * std::sin(theta));
+        vel.y = static_cast<s32>(1000 * r * omega * std::cos(theta));
+        vel.n_sats = 8;
+        sbp_send_message(&state, SBP_MSG_VEL_ECEF, 0, sizeof(vel), (u8 *)&vel, append_bytes);
+
+        if (rtk) {
+            msg_baseline_ecef_t baseline = {};
+            baseline.tow = tow;
+            baseline.x = 100000;
+            baseline.n_sats = 8;
+            baseline.flags = 1;
+            sbp_send_message(&state, SBP_MSG_BASELINE_ECEF, 0, sizeof(baseline), (u8 *)&baseline, append_bytes);
+        }
+
+        msg_heartbeat_t heartbeat = {};
+        sbp_send_message(&state, SBP_MSG_HEARTBEAT, 0, sizeof(heartbeat), (u8 *)&heartbeat, append_bytes);
+    }
+}
+
+size_t PiksiSbpLog::arrived() {
+    if (config.speed <= 0) return config.loop ? pos + bytes.size() : bytes.size();
+
+    const long long now = clock_us();
+    if (start_us < 0) start_us = now;
+
+    // The serial line carries 10 bits per byte.
+    const double rate = config.speed * Piksi::BAUD_RATE / 10.0;
+    const double count = (now - start_us) * rate / 1e6;
+    if (!config.loop && count >= bytes.size()) return bytes.size();
+    return static_cast<size_t>(count);
+}
+
+int PiksiSbpLog::available() {
+    if (bytes.empty()) return 0;
+    end = arrived();
+    const size_t count = end - pos;
+    return count > INT32_MAX ? INT32_MAX : static_cast<int>(count);
+}
+
+int PiksiSbpLog::read() {
+    // Like a serial port, only bytes that have arrived can be read. Polling
+    // the clock once per available() keeps bulk reads cheap.
+    if (pos >= end) return -1;
+    return bytes[pos++ % bytes.size()];
+}
+
+#endif
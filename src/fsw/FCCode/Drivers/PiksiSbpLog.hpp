@@ -0,0 +1,96 @@
+#ifndef PiksiSbpLog_hpp
+#define PiksiSbpLog_hpp
+
+#ifdef DESKTOP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace Devices {
+
+/**
+ * @brief Stream of SBP bytes that the Piksi driver reads in place of its
+ * serial port on desktop, so that recorded or generated receiver output goes
+ * through the same ring buffer, libsbp parser and callbacks as on hardware.
+ *
+ * Bytes become available at the serial rate of the Piksi, scaled by a speed
+ * factor, so that read_all() sees the same partial frames across control
+ * cycles as it would on hardware.
+ */
+class PiksiSbpLog {
+  public:
+    struct config_t {
+        /** Multiple of the Piksi's serial rate at which bytes arrive. 0 makes
+         *  the whole log available at once. **/
+        double speed = 1.0;
+        /** Whether to start over at the end of the log. **/
+        bool loop = false;
+    };
+
+    PiksiSbpLog(const std::vector<unsigned char> &bytes, const config_t &config);
+
+    /**
+     * @brief Log that Piksi drivers constructed without an explicit log
+     * should read, or nullptr if they should keep returning canned values.
+     */
+    static PiksiSbpLog *attached() { return _attached; }
+    static void attach(PiksiSbpLog *log) { _attached = log; }
+
+    /**
+     * @brief Reads a raw SBP binary log, such as one captured from the
+     * receiver's serial port. The contents go through the replay log.
+     *
+     * @return false if the file can't be read.
+     */
+    static bool load(const std::string &path, std::vector<unsigned char> &bytes);
+
+    /**
+     * @brief Appends the output of a receiver on a circular orbit to bytes:
+     * a GPS time, position, velocity and heartbeat per 100 ms epoch, and a
+     * baseline if rtk is set.
+     */
+    static void generate(unsigned int epochs, bool rtk, std::vector<unsigned char> &bytes);
+
+    /**
+     * @brief Replaces the clock of the log, in microseconds. By default, the
+     * log reads the system clock through the replay log.
+     */
+    void set_clock(long long (*clock_us)()) { this->clock_us = clock_us; }
+    long long now_us() const { return clock_us(); }
+
+    /**
+     * @brief Whether every byte of the log has been read. Never true when
+     * looping.
+     */
+    bool done() const { return !config.loop && pos >= bytes.size(); }
+
+    /**
+     * @brief Serial port interface used by the driver.
+     */
+    int available();
+    int read();
+
+  private:
+    static PiksiSbpLog *_attached;
+
+    const std::vector<unsigned char> bytes;
+    const config_t config;
+    long long (*clock_us)();
+
+    /** Time at which the first byte was polled for, or -1 before then. **/
+    long long start_us = -1;
+    /** Position of the next byte to be read in the stream. **/
+    size_t pos = 0;
+    /** Number of bytes that had arrived when available() was last called. **/
+    size_t end = 0;
+
+    /** Number of bytes of the stream that have arrived by now. **/
+    size_t arrived();
+};
+
+}
+
+#endif
+
+#endif
@@ -24,9 +24,16 @@ using namespace Devices;
         return PORT_UNAVAILABLE;}
 
 #ifdef DESKTOP
+// Without an emulated modem, every command succeeds immediately.
+#define RETURN_OK_WITHOUT_MODEM() \
+    if (!port) {                  \
+        return OK;}
+
 using F = std::string;
-QLocate::QLocate(const std::string &name) : Device(name) {}
+QLocate::QLocate(const std::string &name, QLocateModem *modem) : Device(name), port(modem) {}
 #else
+#define RETURN_OK_WITHOUT_MODEM()
+
 
 QLocate::QLocate(const std::string &name, HardwareSerial *const port, int timeout)
         : Device(name), port(port), timeout(timeout) {}
@@ -56,9 +63,8 @@ int QLocate::query_config_1() {
 }
 
 int QLocate::query_config_2() {
-#ifndef DESKTOP
+    RETURN_OK_WITHOUT_MODEM()
     CHECK_PORT_AVAILABLE()
-#endif
     // Disable flow control, disable DTR, disable echo, 
     // set numeric responses, and
     // disable "RING" alerts
@@ -79,11 +85,10 @@ int QLocate::query_sbdwb_1(int len) {
     // Check the length of the message.
     if (len <= 0 || len > MAX_MSG_SIZE)
         return WRONG_LENGTH;
-#ifndef DESKTOP
+    RETURN_OK_WITHOUT_MODEM()
     port->clear();
     if (port->printf("AT+SBDWB=%d\r", len) == 0)
         return WRITE_FAIL;
-#endif
     return OK;
 }
 
@@ -125,7 +130,7 @@ void dbg_print_hex(char const *buf, size_t len)
 #endif
 
 int QLocate::query_sbdwb_2(char const *c, int len) {
-#ifndef DESKTOP
+    RETURN_OK_WITHOUT_MODEM()
     int status = consume(F("READY\r\n"));
     if (status != OK)
         return status;
@@ -147,14 +152,11 @@ int QLocate::query_sbdwb_2(char const *c, int len) {
     if (port->write((uint8_t) s) != 1)
         return WRITE_FAIL;
     port->flush();
-#endif
     return OK;
 }
 
 int QLocate::get_sbdwb() {
-#ifdef DESKTOP
-    return OK;
-#else
+    RETURN_OK_WITHOUT_MODEM()
     // If it is a timeout, then port will not be available anyway
     CHECK_PORT_AVAILABLE()
     char buf[6]{};
@@ -175,7 +177,6 @@ int QLocate::get_sbdwb() {
         return UNEXPECTED_RESPONSE;
 
     return status;
-#endif
 }
 
 int QLocate::query_sbdix_1() {
@@ -187,9 +188,7 @@ int QLocate::query_sbdix_1() {
 
 // Requires 15 seconds
 int QLocate::get_sbdix() {
-#ifdef DESKTOP
-    return OK;
-#else
+    RETURN_OK_WITHOUT_MODEM()
     CHECK_PORT_AVAILABLE()
     size_t msg_size = port->available();
     // min message length is 26 excluding the final 0\r
@@ -202,7 +201,6 @@ int QLocate::get_sbdix() {
     // Parse SBDIX output
     port->readBytes(buf, msg_size);
     return parse_ints(buf + 8, sbdix_r);
-#endif
 }
 
 // Parses the result buffer of sbdix into sbdix_r
@@ -225,13 +223,15 @@ int QLocate::query_sbdrb_1() {
 }
 
 int QLocate::get_sbdrb() {
-#ifndef DESKTOP
-    // sbdix_r[4] is the length of the MT message + 2B checksum + 2B length
-    if (port->available() + 4 < sbdix_r[4])
+    RETURN_OK_WITHOUT_MODEM()
+    // sbdix_r[4] is the length of the MT message, which is preceded by a 2B
+    // length and followed by a 2B checksum
+    if (port->available() < sbdix_r[4] + 4)
         return PORT_UNAVAILABLE;
 
-    // get the message size
-    size_t msg_size = 256 * port->read() + port->read();
+    // get the message size; the reads are sequenced since the high byte comes first
+    size_t msg_size = 256 * port->read();
+    msg_size += port->read();
     if (msg_size > MAX_MSG_SIZE)
         return WRONG_LENGTH;
         
@@ -244,22 +244,18 @@ int QLocate::get_sbdrb() {
 #endif
 
     // get the checksum
-    uint16_t msg_checksum = 256 * port->read() + port->read();
+    uint16_t msg_checksum = 256 * port->read();
+    msg_checksum += port->read();
 
     // check the checksum
     if (msg_checksum == checksum(mt_message, msg_size))
         return OK;
 
     return BAD_CHECKSUM;
-#else
-    return OK;
-#endif
 }
 
 int QLocate::consume(const String &expected) {
-#ifdef DESKTOP
-    return OK;
-#else
+    RETURN_OK_WITHOUT_MODEM()
     // Make sure there are at least as many bytes at port as in expected
     size_t expected_len = expected.length();
     if ((size_t)port->available() < expected_len) {
@@ -285,24 +281,20 @@ int QLocate::consume(const String &expected) {
 
     // CONSUME_FAIL can only happen when data read != expected
     return CONSUME_FAIL;
-#endif
 }
 
 int QLocate::sendCommand(const char *cmd) {
-#ifdef DESKTOP
-    return OK;
-#else
+    RETURN_OK_WITHOUT_MODEM()
     port->clear();
     // port->print returns the number of characters printed
     return (port->print(F(cmd)) != 0) ? OK : WRITE_FAIL;
-#endif
 }
 
 // Calculate checksum
 uint16_t QLocate::checksum(char const *c, size_t len) {
     uint16_t checksum = 0;
     for (size_t i = 0; i < len; ++i) {
-        checksum += (uint16_t) c[i];
+        checksum += (uint8_t) c[i];
     }
     return checksum;
 }
@@ -18,6 +18,7 @@
 
 #else
 
+#include "QLocateModem.hpp"
 #include <iostream>
 #include <string>
 
@@ -88,7 +89,10 @@ namespace Devices {
 #else
         using String = std::string;
 
-        explicit QLocate(const std::string &);
+        /*! On desktop, the driver talks to an emulated modem if one is given,
+         *  and otherwise every command succeeds immediately.
+         */
+        explicit QLocate(const std::string &, QLocateModem *modem = nullptr);
 
 #endif
 
@@ -192,6 +196,8 @@ namespace Devices {
 #ifndef DESKTOP
         HardwareSerial *const port;
         int timeout;
+#else
+        QLocateModem *const port;
 #endif
 
         /*! Attempts to read [expected] from the QLocate's serial port.
@@ -0,0 +1,352 @@
+#ifdef DESKTOP
+
+#include "QLocateModem.hpp"
+#include "QLocate.hpp"
+#include <common/ReplayLog.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <dirent.h>
+#include <fstream>
+#include <iterator>
+#include <sys/stat.h>
+
+using namespace Devices;
+
+QLocateModem *QLocateModem::_attached = nullptr;
+
+static long long system_clock_us() {
+    const long long now_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    return ReplayLog::clock_us(now_us);
+}
+
+/**
+ * @brief Names of the regular files in a directory, in order.
+ */
+static std::vector<std::string> list_dir(const std::string &dir) {
+    std::vector<std::string> names;
+    DIR *d = opendir(dir.c_str());
+    if (!d) return names;
+    while (const dirent *entry = readdir(d)) {
+        if (entry->d_name[0] != '.') names.push_back(entry->d_name);
+    }
+    closedir(d);
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+QLocateModem::QLocateModem(const config_t &config)
+    : config(config), clock_us(system_clock_us), rng(config.seed) {}
+
+void QLocateModem::set_mailbox_dir(const std::string &dir) {
+    mailbox_dir = dir;
+    mkdir(dir.c_str(), 0755);
+    mkdir((dir + "/mt").c_str(), 0755);
+    mkdir((dir + "/mo").c_str(), 0755);
+}
+
+bool QLocateModem::inject_mt(const char *msg, size_t len) {
+    if (len > QLocate::MAX_MSG_SIZE || mt_queue.size() >= config.mt_queue_depth)
+        return false;
+    mt_queue.emplace_back(msg, len);
+    return true;
+}
+
+bool QLocateModem::collect_mo(std::string &msg) {
+    if (mo_queue.empty()) return false;
+    msg = std::move(mo_queue.front());
+    mo_queue.pop_front();
+    return true;
+}
+
+int QLocateModem::available() {
+    const long long now = clock_us();
+    int count = 0;
+    for (const tx_byte_t &b : tx) {
+        if (b.time_us > now) break;
+        count++;
+    }
+    return count;
+}
+
+int QLocateModem::read() {
+    if (tx.empty() || tx.front().time_us > clock_us()) return -1;
+    const unsigned char byte = tx.front().byte;
+    tx.pop_front();
+    return byte;
+}
+
+size_t QLocateModem::readBytes(char *buf, size_t len) {
+    const long long now = clock_us();
+    size_t i = 0;
+    for (; i < len && !tx.empty() && tx.front().time_us <= now; i++) {
+        buf[i] = tx.front().byte;
+        tx.pop_front();
+    }
+    return i;
+}
+
+size_t QLocateModem::write(const char *buf, size_t len) {
+    for (size_t i = 0; i < len; i++) receive(buf[i]);
+    return len;
+}
+
+size_t QLocateModem::write(uint8_t byte) {
+    receive(static_cast<char>(byte));
+    return 1;
+}
+
+size_t QLocateModem::print(const std::string &str) {
+    return write(str.data(), str.size());
+}
+
+int QLocateModem::printf(const char *format, ...) {
+    char buf[64];
+    va_list args;
+    va_start(args, format);
+    const int len = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    if (len <= 0) return 0;
+    return print(std::string(buf, std::min<size_t>(len, sizeof(buf) - 1)));
+}
+
+void QLocateModem::clear() {
+    // Like a serial port, only drop the bytes that have already arrived.
+    const long long now = clock_us();
+    while (!tx.empty() && tx.front().time_us <= now) tx.pop_front();
+}
+
+void QLocateModem::send(const std::string &data, long long delay_us) {
+    long long time = std::max(clock_us() + delay_us, tx_end_us);
+    for (char c : data) {
+        if (config.byte_rate > 0) time += 1000000LL / config.byte_rate;
+        tx.push_back({time, c});
+    }
+    tx_end_us = time;
+}
+
+void QLocateModem::send_result(bool ok) {
+    if (verbose) send(ok ? "\r\nOK\r\n" : "\r\nERROR\r\n");
+    else send(ok ? "0\r" : "4\r");
+}
+
+void QLocateModem::receive(char c) {
+    if (sbdwb_remaining > 0) {
+        rx.push_back(c);
+        if (--sbdwb_remaining == 0) finish_sbdwb();
+        return;
+    }
+
+    if (echo) send(std::string(1, c));
+    if (c != '\r') {
+        if (rx.size() < 128) rx.push_back(c);
+        return;
+    }
+
+    const std::string cmd = rx;
+    rx.clear();
+    execute(cmd);
+}
+
+void QLocateModem::execute(const std::string &cmd) {
+    if (cmd.empty()) return;
+    if (cmd.size() < 2 || (cmd.compare(0, 2, "AT") && cmd.compare(0, 2, "at"))) {
+        send_result(false);
+        return;
+    }
+    const std::string body = cmd.substr(2);
+
+    if (!body.compare(0, 7, "+SBDWB=")) {
+        const int len = std::atoi(body.c_str() + 7);
+        if (len < 1 || len > QLocate::MAX_MSG_SIZE) {
+            send("3\r\n");
+            send_result(true);
+            return;
+        }
+        send("READY\r\n");
+        sbdwb_remaining = len + 2;
+        return;
+    }
+    if (body == "+SBDIX") {
+        start_sbdix();
+        return;
+    }
+    if (body == "+SBDRB") {
+        std::string response;
+        response.push_back(static_cast<char>(mt_buffer.size() >> 8));
+        response.push_back(static_cast<char>(mt_buffer.size() & 0xFF));
+        response.append(mt_buffer.begin(), mt_buffer.end());
+        unsigned int checksum = 0;
+        for (char c : mt_buffer) checksum += static_cast<unsigned char>(c);
+        response.push_back(static_cast<char>((checksum >> 8) & 0xFF));
+        response.push_back(static_cast<char>(checksum & 0xFF));
+        send(response);
+        send_result(true);
+        return;
+    }
+
+    // Other commands may be chained with semicolons.
+    std::string response;
+    size_t start = 0;
+    while (true) {
+        const size_t end = body.find(';', start);
+        if (!execute_one(body.substr(start, end - start), response)) {
+            send(response);
+            send_result(false);
+            return;
+        }
+        if (end == std::string::npos) break;
+        start = end + 1;
+    }
+    send(response);
+    send_result(true);
+}
+
+bool QLocateModem::execute_one(const std::string &cmd, std::string &response) {
+    if (cmd.empty() || cmd == "&K0" || cmd == "&K3" || cmd == "&D0" || cmd == "&D1"
+        || cmd == "&D2" || cmd == "+SBDMTA=0" || cmd == "+SBDMTA=1")
+        return true;
+
+    if (cmd == "&F0" || cmd == "&F") {
+        echo = true;
+        verbose = true;
+        return true;
+    }
+    if (cmd == "E0" || cmd == "E" || cmd == "E1") {
+        echo = cmd == "E1";
+        return true;
+    }
+    if (cmd == "V0" || cmd == "V" || cmd == "V1") {
+        verbose = cmd == "V1";
+        return true;
+    }
+    if (cmd == "+SBDD0" || cmd == "+SBDD1" || cmd == "+SBDD2") {
+        if (cmd != "+SBDD1") mo_buffer.clear();
+        if (cmd != "+SBDD0") mt_buffer.clear();
+        response += "0\r\n";
+        return true;
+    }
+    return false;
+}
+
+void QLocateModem::finish_sbdwb() {
+    const size_t len = rx.size() - 2;
+    unsigned int checksum = 0;
+    for (size_t i = 0; i < len; i++) checksum += static_cast<unsigned char>(rx[i]);
+    const unsigned int received = (static_cast<unsigned char>(rx[len]) << 8)
+        | static_cast<unsigned char>(rx[len + 1]);
+
+    const bool valid = (checksum & 0xFFFF) == received;
+    if (valid) mo_buffer.assign(rx.begin(), rx.begin() + len);
+    rx.clear();
+
+    send(valid ? "0\r\n" : "2\r\n");
+    send_result(true);
+}
+
+void QLocateModem::start_sbdix() {
+    _stats.sessions++;
+    poll_mailbox_dir();
+
+    size_t mo_waiting = mo_queue.size();
+    if (!mailbox_dir.empty()) {
+        if (!ReplayLog::is_replaying()) mo_waiting = list_dir(mailbox_dir + "/mo").size();
+        ReplayLog::input(&mo_waiting, sizeof(mo_waiting));
+    }
+
+    const bool reached_network = std::uniform_real_distribution<double>(0, 1)(rng) >= config.failure_rate;
+    const bool mailbox_full = !mo_buffer.empty() && mo_waiting >= config.mo_queue_depth;
+
+    // MO status 32 means there was no network service, and 10 that the
+    // gateway didn't complete the session. MT status 2 means the mailbox
+    // couldn't be checked.
+    int mo_status = 0, mt_status = 0;
+    const unsigned int session_momsn = momsn;
+    size_t bytes_moved = 0;
+    if (!reached_network || mailbox_full) {
+        mo_status = reached_network ? 10 : 32;
+        mt_status = 2;
+        _stats.failed_sessions++;
+    }
+    else {
+        if (!mo_buffer.empty()) {
+            const std::string msg(mo_buffer.begin(), mo_buffer.end());
+            if (mailbox_dir.empty()) mo_queue.push_back(msg);
+            else write_mailbox_dir(msg);
+            _stats.mo_messages++;
+            _stats.mo_bytes += msg.size();
+            bytes_moved += msg.size();
+            momsn++;
+        }
+        if (!mt_queue.empty()) {
+            mt_buffer.assign(mt_queue.front().begin(), mt_queue.front().end());
+            mt_queue.pop_front();
+            _stats.mt_messages++;
+            _stats.mt_bytes += mt_buffer.size();
+            bytes_moved += mt_buffer.size();
+            mtmsn++;
+            mt_status = 1;
+        }
+    }
+
+    char response[64];
+    snprintf(response, sizeof(response), "+SBDIX: %d, %u, %d, %u, %u, %u\r\n",
+        mo_status, session_momsn, mt_status, mtmsn,
+        mt_status == 1 ? static_cast<unsigned int>(mt_buffer.size()) : 0,
+        static_cast<unsigned int>(mt_queue.size()));
+
+    long long duration_us = 1000LL * config.session_latency_ms;
+    if (config.byte_rate > 0) duration_us += 1000000LL * bytes_moved / config.byte_rate;
+    send(response, duration_us);
+    send_result(true);
+
+    if (!mailbox_dir.empty() && !ReplayLog::is_replaying()) {
+        std::ofstream stats_file(mailbox_dir + "/stats", std::ios::trunc);
+        stats_file << "sessions " << _stats.sessions << "\n"
+                   << "failed_sessions " << _stats.failed_sessions << "\n"
+                   << "mo_messages " << _stats.mo_messages << "\n"
+                   << "mo_bytes " << _stats.mo_bytes << "\n"
+                   << "mt_messages " << _stats.mt_messages << "\n"
+                   << "mt_bytes " << _stats.mt_bytes << "\n";
+    }
+}
+
+void QLocateModem::poll_mailbox_dir() {
+    if (mailbox_dir.empty()) return;
+
+    // The directory is an external input, so its contents go through the
+    // replay log and it is left alone while replaying.
+    std::vector<std::string> msgs;
+    if (!ReplayLog::is_replaying()) {
+        const std::string mt_dir = mailbox_dir + "/mt/";
+        for (const std::string &name : list_dir(mt_dir)) {
+            if (mt_queue.size() + msgs.size() >= config.mt_queue_depth) break;
+            std::ifstream file(mt_dir + name, std::ios::binary);
+            msgs.emplace_back(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            std::remove((mt_dir + name).c_str());
+        }
+    }
+
+    size_t count = msgs.size();
+    ReplayLog::input(&count, sizeof(count));
+    msgs.resize(count);
+    for (std::string &msg : msgs) {
+        size_t len = msg.size();
+        ReplayLog::input(&len, sizeof(len));
+        msg.resize(len);
+        if (len > 0) ReplayLog::input(&msg[0], len);
+        inject_mt(msg.data(), msg.size());
+    }
+}
+
+void QLocateModem::write_mailbox_dir(const std::string &msg) {
+    if (ReplayLog::is_replaying()) return;
+    std::ofstream file(mailbox_dir + "/mo/" + std::to_string(momsn) + ".sbd",
+        std::ios::binary | std::ios::trunc);
+    file.write(msg.data(), msg.size());
+}
+
+#endif
@@ -0,0 +1,165 @@
+#ifndef QLocateModem_hpp
+#define QLocateModem_hpp
+
+#ifdef DESKTOP
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace Devices {
+
+/**
+ * @brief In-process model of the Iridium 9602 modem inside the QLocate, which
+ * the QLocate driver talks to in place of a serial port on desktop.
+ *
+ * The model speaks the subset of the AT command set used by the driver
+ * (AT, &F0, &K0, &D0, E, V, +SBDMTA, +SBDD, +SBDWB, +SBDIX and +SBDRB),
+ * including command echo, numeric and verbose result codes, and the binary
+ * transfers of SBDWB and SBDRB. Bytes sent by the modem only become available
+ * to the driver once they would have arrived, so that the driver sees the
+ * same partial responses across control cycles as it would on hardware.
+ *
+ * SBD sessions exchange messages with a local mailbox. MO messages sent by a
+ * session are queued for collection, and MT messages injected into the
+ * mailbox are delivered by the following sessions. The mailbox can also be a
+ * directory, which lets another process inject MT messages and collect MO
+ * messages while the flight software runs.
+ */
+class QLocateModem {
+  public:
+    struct config_t {
+        /** Time between the start of an SBD session and its result. **/
+        unsigned int session_latency_ms = 5000;
+        /** Probability that an SBD session fails to reach the network. **/
+        double failure_rate = 0.0;
+        /** Number of collected MO messages the mailbox holds before further
+         *  sessions fail to deliver theirs. **/
+        size_t mo_queue_depth = 16;
+        /** Number of MT messages the mailbox holds before further
+         *  injections are refused. **/
+        size_t mt_queue_depth = 16;
+        /** Rate, in bytes per second, at which data moves over the serial
+         *  line and over the air during a session. 0 means unlimited. **/
+        unsigned int byte_rate = 0;
+        /** Seed of the generator deciding which sessions fail. **/
+        unsigned int seed = 0;
+    };
+
+    /** Counters for measuring throughput. **/
+    struct stats_t {
+        unsigned int sessions = 0;
+        unsigned int failed_sessions = 0;
+        unsigned int mo_messages = 0;
+        unsigned int mo_bytes = 0;
+        unsigned int mt_messages = 0;
+        unsigned int mt_bytes = 0;
+    };
+
+    explicit QLocateModem(const config_t &config);
+
+    /**
+     * @brief Modem that QLocate drivers constructed without an explicit port
+     * should use, or nullptr if they should not emulate a modem.
+     */
+    static QLocateModem *attached() { return _attached; }
+    static void attach(QLocateModem *modem) { _attached = modem; }
+
+    /**
+     * @brief Replaces the clock of the modem, in microseconds. By default, the
+     * modem reads the system clock through the replay log.
+     */
+    void set_clock(long long (*clock_us)()) { this->clock_us = clock_us; }
+
+    /**
+     * @brief Uses a directory as the mailbox. MT messages are picked up from
+     * files in <dir>/mt, in name order, and removed once queued. Each MO
+     * message is written to <dir>/mo/<MOMSN>.sbd, and the counters are
+     * written to <dir>/stats after every session.
+     */
+    void set_mailbox_dir(const std::string &dir);
+
+    /**
+     * @brief Queues an MT message for delivery by a future session.
+     *
+     * @return false if the message is too long or the MT queue is full.
+     */
+    bool inject_mt(const char *msg, size_t len);
+
+    /**
+     * @brief Takes the oldest MO message delivered by a session.
+     *
+     * @return false if no message is waiting.
+     */
+    bool collect_mo(std::string &msg);
+
+    const stats_t &stats() const { return _stats; }
+
+    /**
+     * @brief Serial port interface used by the driver.
+     */
+    void begin(unsigned int) {}
+    void setTimeout(int) {}
+    int available();
+    int read();
+    size_t readBytes(char *buf, size_t len);
+    size_t write(const char *buf, size_t len);
+    size_t write(uint8_t byte);
+    size_t print(const std::string &str);
+    int printf(const char *format, ...);
+    void clear();
+    void flush() {}
+
+  private:
+    static QLocateModem *_attached;
+
+    const config_t config;
+    long long (*clock_us)();
+    std::mt19937 rng;
+    std::string mailbox_dir;
+
+    struct tx_byte_t {
+        long long time_us;
+        char byte;
+    };
+    /** Bytes sent by the modem, with the time at which each one arrives. **/
+    std::deque<tx_byte_t> tx;
+    /** Arrival time of the last byte sent by the modem. **/
+    long long tx_end_us = 0;
+
+    /** Command being received, or binary data while in SBDWB. **/
+    std::string rx;
+    /** Number of bytes (message and checksum) SBDWB still expects. **/
+    size_t sbdwb_remaining = 0;
+
+    bool echo = true;
+    bool verbose = true;
+
+    std::vector<char> mo_buffer;
+    std::vector<char> mt_buffer;
+    unsigned int momsn = 0;
+    unsigned int mtmsn = 0;
+
+    std::deque<std::string> mo_queue;
+    std::deque<std::string> mt_queue;
+    stats_t _stats;
+
+    void send(const std::string &data, long long delay_us = 0);
+    void send_result(bool ok);
+    void receive(char c);
+    void execute(const std::string &cmd);
+    bool execute_one(const std::string &cmd, std::string &response);
+    void finish_sbdwb();
+    void start_sbdix();
+    void poll_mailbox_dir();
+    void write_mailbox_dir(const std::string &msg);
+};
+
+}
+
+#endif
+
+#endif
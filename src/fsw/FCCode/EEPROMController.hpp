@@ -5,10 +5,30 @@
 
 #include <common/StateFieldRegistry.hpp>
 #include "TimedControlTask.hpp"
-#ifdef DESKTOP
-#include <json.hpp>
-#endif
+#include <string>
+#include <vector>
 
+/**
+ * @brief Saves the values of the EEPROM-saved fields across reboots.
+ *
+ * The EEPROM is used as a log of records, each holding the values of the
+ * fields that changed since they were last saved:
+ *
+ *   sequence number (4 bytes) | number of entries n (1 byte) |
+ *   n x (field index (1 byte) | value (4 bytes)) | CRC-16 (2 bytes)
+ *
+ * Multi-byte values are little endian. The EEPROM is split into two halves,
+ * and records are appended to the active half with consecutive sequence
+ * numbers. When the active half is full, the log is compacted: a record
+ * holding every saved field is written at the start of the other half, which
+ * becomes the active half. Every cell is therefore written once per pass
+ * through the EEPROM, rather than every save period, and the previous half
+ * stays intact until the compacted record has been written.
+ *
+ * At boot, the newest half is the one whose first record is valid and has
+ * the larger sequence number. Its records are read until one is invalid or
+ * out of sequence, so the scan is bounded by the size of a half.
+ */
 class EEPROMController : public TimedControlTask<void>
 {
 #ifdef UNIT_TEST
@@ -24,14 +44,36 @@ public:
      */
     EEPROMController(StateFieldRegistry &registry);
 
+#ifdef DESKTOP
+    /**
+     * @brief Construct a new EEPROM Controller object whose EEPROM image is
+     * the given file.
+     *
+     * @param registry
+     * @param image_path
+     */
+    EEPROMController(StateFieldRegistry &registry, const std::string &image_path);
+
+    ~EEPROMController();
+
     /**
-     * @brief Sets up addresses for the set of EEPROM-saved fields.
+     * @brief Sets the EEPROM image used by controllers constructed without
+     * one. Defaults to eeprom_leader.bin or eeprom_follower.bin in the
+     * working directory, so that the two satellites of a simulation don't
+     * share an EEPROM.
+     */
+    static void set_default_image_path(const std::string &image_path);
+#endif
+
+    /**
+     * @brief Sets up the log for the set of EEPROM-saved fields, and restores
+     * their values from the EEPROM.
      */
     void init();
 
     /**
-     * @brief Writes to the EEPROM after a certain number of 
-     * control cycles given by the period.
+     * @brief Writes a record with the fields whose save period has elapsed
+     * and whose value has changed since it was last saved.
      */
     void execute() override;
 
@@ -42,17 +84,18 @@ public:
     void read_EEPROM();
 
     /**
-     * @brief Writes the value of the statefields to the field's 
-     * respective address in EEPROM
-     * @param position refers to the location of the statefield pointer, 
-     * its address in the EEPROM, and its period in their respective vectors
+     * @brief Appends a record with the values of the given statefields to the
+     * log, compacting the log into the other half of the EEPROM if needed.
+     * @param positions refers to the locations of the statefield pointers in
+     * the registry's list of EEPROM-saved fields
      */
-    void update_EEPROM(unsigned int position);
+    void update_EEPROM(const std::vector<unsigned int> &positions);
 
     /**
-     * @brief Checks if the EEPROM is empty or not. The default value
-     * of the EEPROM is 0xFF, or 255 in decimal. Returns true if empty
-     * and false if values are stored in the EEPROM.
+     * @brief Checks if the EEPROM contains a log, by checking the first record
+     * of each half. Returns true if neither is valid, e.g. if the EEPROM
+     * only holds its default value of 0xFF. Otherwise, selects the newest half
+     * as the active half of the log.
      */
     bool check_empty();
 
@@ -60,18 +103,73 @@ public:
     TRACKED_CONSTANT_SC(unsigned int, eeprom_size, 4096);
 
 protected:
-    //the locations in the EEPROM in which the field values will be stored
-    std::vector<int> addresses;
+    // Size of each half of the EEPROM.
+    static constexpr unsigned int half_size = eeprom_size / 2;
+
+    // Size of the parts of a record.
+    static constexpr unsigned int header_size = 5;
+    static constexpr unsigned int entry_size = 5;
+    static constexpr unsigned int crc_size = 2;
+
+    /**
+     * @brief Size of a record with the given number of entries.
+     */
+    static constexpr unsigned int record_size(unsigned int num_entries) {
+        return header_size + num_entries * entry_size + crc_size;
+    }
+
+    /**
+     * @brief Reads the saved values of all fields from the active half of
+     * the log, and finds where the next record will be written.
+     */
+    void load_log();
+
+    /**
+     * @brief Checks that a valid record starts at the given address and ends
+     * before the bound, and gets its sequence number and size.
+     */
+    bool read_record(unsigned int address, unsigned int bound,
+                     unsigned int &seq, unsigned int &size) const;
+
+    /**
+     * @brief Writes a record with the saved values of the given fields at the
+     * write address.
+     */
+    void write_record(const std::vector<unsigned int> &positions);
+
+    /**
+     * @brief Reads or writes a single byte of the EEPROM. Writes are skipped
+     * if the byte already holds the value.
+     */
+    unsigned char read_byte(unsigned int address) const;
+    void write_byte(unsigned int address, unsigned char value);
+
+    // Last saved value of each field, and whether it has been saved at all.
+    std::vector<unsigned int> saved_values;
+    std::vector<bool> is_saved;
+
+    // Start of the active half, address of the next record and its sequence
+    // number.
+    unsigned int log_start = 0;
+    unsigned int write_address = 0;
+    unsigned int next_seq = 0;
+
+    // Buffers for the fields to be saved and for the record being written.
+    std::vector<unsigned int> due_fields;
+    std::vector<unsigned int> all_fields;
+    std::vector<unsigned char> record_buffer;
 
 #ifdef DESKTOP
-    // Store EEPROM data in JSON so that it can be written to a file.
-    static nlohmann::json data;
-    // Saves EEPROM data to file if FSW program quits.
-    // Validity of saved state value in json does not matter as invalid
-    // state values will be rejected at reboot.
-    static void save_data(int signal);
-    // Get EEPROM data in file and store it in "data".
-    static void get_file_data();
+    // Image of the EEPROM, mapped from the image file. Records are written to
+    // the file as soon as they are appended, so they survive the process
+    // being killed at any point; a record that is cut short fails its CRC
+    // check. Controllers mapping the same file see the same image.
+    unsigned char* data = nullptr;
+    // Maps the EEPROM image file into memory, creating an empty EEPROM if
+    // needed. Exits the process if the file can't be mapped.
+    void map_data(const std::string &image_path);
+
+    static std::string default_image_path;
 #endif
 };
 
@@ -1,29 +1,181 @@
 #include "EEPROMController.hpp"
+#include "mission_state_t.enum"
+#include <algorithm>
+
+/**
+ * @brief Updates a CRC-16/CCITT-FALSE checksum with one byte.
+ */
+static unsigned int crc16_update(unsigned int crc, unsigned char byte) {
+  crc ^= static_cast<unsigned int>(byte) << 8;
+  for (int i = 0; i < 8; i++)
+    crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) & 0xFFFF : (crc << 1) & 0xFFFF;
+  return crc;
+}
 
 void EEPROMController::init() {
-  assert(_registry.eeprom_saved_fields.size() <= eeprom_size / 5);
+  const size_t num_fields = _registry.eeprom_saved_fields.size();
 
-  for (size_t i = 0; i<_registry.eeprom_saved_fields.size(); i++){
-    // add the address of the pointer to the address array
-    addresses.push_back(i*5);
-  }
+  // Field indices must fit in a byte, and a compacted record must fit in a half.
+  assert(num_fields < 255);
+  assert(record_size(num_fields) <= half_size);
 
-  // if we find stored information from previous control cycles when the control task 
+  saved_values.assign(num_fields, 0);
+  is_saved.assign(num_fields, false);
+  due_fields.reserve(num_fields);
+  all_fields.reserve(num_fields);
+  record_buffer.reserve(record_size(num_fields));
+
+  // if we find stored information from previous control cycles when the control task
   // is initialized, then set all the statefields to those stored values
-  if (!check_empty()) {
-    read_EEPROM();
+  read_EEPROM();
+}
+
+void EEPROMController::execute() {
+  //if enough control cycles have passed and the field has changed, save its value
+  due_fields.clear();
+  for (unsigned int i = 0; i<_registry.eeprom_saved_fields.size(); i++) {
+    const ReadableStateFieldBase* field = _registry.eeprom_saved_fields[i];
+    if(control_cycle_count % field->eeprom_save_period() != 0) continue;
+    if(is_saved[i] && saved_values[i] == field->get_eeprom_repr()) continue;
+    due_fields.push_back(i);
+  }
+
+  update_EEPROM(due_fields);
+}
+
+void EEPROMController::read_EEPROM() {
+  load_log();
+
+  for (unsigned int i = 0; i < _registry.eeprom_saved_fields.size(); i++) {
+    if (!is_saved[i]) continue;
+    const unsigned int field_val = saved_values[i];
+
+    const bool is_docking = field_val == static_cast<unsigned int>(mission_state_t::docking);
+    const bool is_docked = field_val == static_cast<unsigned int>(mission_state_t::docked);
+    if (_registry.eeprom_saved_fields[i]->name() == "pan.state" && !is_docking && !is_docked)
+      continue;
+
+    _registry.eeprom_saved_fields[i]->set_from_eeprom(field_val);
   }
-  else {
-    // Otherwise, that means we have just started the satellite for the first time 
-    // and the EEPROM should be empty
+}
+
+void EEPROMController::update_EEPROM(const std::vector<unsigned int> &positions) {
+  if (positions.empty()) return;
+
+  for (unsigned int i : positions) {
+    saved_values[i] = _registry.eeprom_saved_fields[i]->get_eeprom_repr();
+    is_saved[i] = true;
   }
+
+  if (write_address + record_size(positions.size()) <= log_start + half_size) {
+    write_record(positions);
+    return;
+  }
+
+  // The active half is full, so compact the log into the other half. The
+  // record holds every saved field, so the old half is no longer needed once
+  // it has been written.
+  all_fields.clear();
+  for (unsigned int i = 0; i < is_saved.size(); i++) {
+    if (is_saved[i]) all_fields.push_back(i);
+  }
+  log_start = (log_start == 0) ? half_size : 0;
+  write_address = log_start;
+  write_record(all_fields);
 }
 
-void EEPROMController::execute() {
-  //if enough control cycles have passed, write the field values to EEPROM
-  for (size_t i = 0; i<_registry.eeprom_saved_fields.size(); i++) {
-    if(control_cycle_count % _registry.eeprom_saved_fields[i]->eeprom_save_period() == 0) {
-      update_EEPROM(i);
+bool EEPROMController::check_empty() {
+  unsigned int seq0 = 0, seq1 = 0, size = 0;
+  const bool valid0 = read_record(0, half_size, seq0, size);
+  const bool valid1 = read_record(half_size, eeprom_size, seq1, size);
+
+  if (!valid0 && !valid1) {
+    log_start = 0;
+    return true;
+  }
+
+  log_start = (valid1 && (!valid0 || seq1 > seq0)) ? half_size : 0;
+  return false;
+}
+
+void EEPROMController::load_log() {
+  std::fill(is_saved.begin(), is_saved.end(), false);
+  write_address = 0;
+  next_seq = 0;
+  if (check_empty()) return;
+
+  const unsigned int bound = log_start + half_size;
+  unsigned int address = log_start;
+  unsigned int seq = 0, size = 0;
+  read_record(address, bound, seq, size);
+  next_seq = seq;
+
+  // Apply records in order until the end of the log, so that the newest value
+  // of each field is kept.
+  while (read_record(address, bound, seq, size) && seq == next_seq) {
+    const unsigned int num_entries = read_byte(address + 4);
+    for (unsigned int j = 0; j < num_entries; j++) {
+      const unsigned int entry = address + header_size + j * entry_size;
+      unsigned int value = 0;
+      for (unsigned int k = 0; k < 4; k++)
+        value |= static_cast<unsigned int>(read_byte(entry + 1 + k)) << (8 * k);
+
+      const unsigned int i = read_byte(entry);
+      saved_values[i] = value;
+      is_saved[i] = true;
     }
+
+    address += size;
+    next_seq++;
+  }
+  write_address = address;
+}
+
+bool EEPROMController::read_record(unsigned int address, unsigned int bound,
+                                   unsigned int &seq, unsigned int &size) const {
+  if (address + record_size(1) > bound) return false;
+
+  const unsigned int num_entries = read_byte(address + 4);
+  if (num_entries == 0 || num_entries > is_saved.size()) return false;
+  size = record_size(num_entries);
+  if (address + size > bound) return false;
+
+  unsigned int crc = 0xFFFF;
+  for (unsigned int i = 0; i < size - crc_size; i++)
+    crc = crc16_update(crc, read_byte(address + i));
+  const unsigned int stored_crc = read_byte(address + size - 2)
+    | (static_cast<unsigned int>(read_byte(address + size - 1)) << 8);
+  if (crc != stored_crc) return false;
+
+  for (unsigned int j = 0; j < num_entries; j++) {
+    if (read_byte(address + header_size + j * entry_size) >= is_saved.size()) return false;
   }
+
+  seq = 0;
+  for (unsigned int k = 0; k < 4; k++)
+    seq |= static_cast<unsigned int>(read_byte(address + k)) << (8 * k);
+  return true;
+}
+
+void EEPROMController::write_record(const std::vector<unsigned int> &positions) {
+  record_buffer.clear();
+  for (unsigned int k = 0; k < 4; k++)
+    record_buffer.push_back((next_seq >> (8 * k)) & 0xFF);
+  record_buffer.push_back(static_cast<unsigned char>(positions.size()));
+  for (unsigned int i : positions) {
+    record_buffer.push_back(static_cast<unsigned char>(i));
+    for (unsigned int k = 0; k < 4; k++)
+      record_buffer.push_back((saved_values[i] >> (8 * k)) & 0xFF);
+  }
+
+  unsigned int crc = 0xFFFF;
+  for (unsigned char byte : record_buffer) crc = crc16_update(crc, byte);
+  record_buffer.push_back(crc & 0xFF);
+  record_buffer.push_back(crc >> 8);
+
+  for (unsigned int k = 0; k < record_buffer.size(); k++)
+    write_byte(write_address + k, record_buffer[k]);
+
+  write_address += record_buffer.size();
+  next_seq++;
 }
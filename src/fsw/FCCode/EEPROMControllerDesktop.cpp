@@ -1,58 +1,84 @@
 #ifdef DESKTOP
 
 #include "EEPROMController.hpp"
-#include <json.hpp>
+#include <common/ReplayLog.hpp>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
-#include <fstream>
-#include <csignal>
-#include "mission_state_t.enum"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-nlohmann::json EEPROMController::data;
+#if defined(PAN_LEADER)
+std::string EEPROMController::default_image_path = "eeprom_leader.bin";
+#elif defined(PAN_FOLLOWER)
+std::string EEPROMController::default_image_path = "eeprom_follower.bin";
+#else
+std::string EEPROMController::default_image_path = "eeprom.bin";
+#endif
+
+static void fail(const std::string& msg) {
+    std::cerr << "eeprom: " << msg << ": " << std::strerror(errno) << std::endl;
+    std::exit(1);
+}
 
 EEPROMController::EEPROMController(StateFieldRegistry &registry)
+    : EEPROMController(registry, default_image_path)
+{}
+
+EEPROMController::EEPROMController(StateFieldRegistry &registry, const std::string &image_path)
     : TimedControlTask<void>(registry, "eeprom_ct")
 {
-    std::ifstream in("eeprom.json");
-    if (!in.fail()) in >> data;
-    in.close();
-
-    std::signal(SIGTERM, EEPROMController::save_data);
-    std::signal(SIGINT, EEPROMController::save_data);
+    map_data(image_path);
 }
 
-void EEPROMController::read_EEPROM(){
-  for (unsigned int i = 0; i < _registry.eeprom_saved_fields.size(); i++) {
-    const std::string& field_name = _registry.eeprom_saved_fields[i]->name();
-    if (data.find(field_name) != data.end()) {
-      const unsigned int field_val = data[field_name];
+EEPROMController::~EEPROMController() {
+  munmap(data, eeprom_size);
+}
 
-      const bool is_docking = field_val == static_cast<unsigned int>(mission_state_t::docking);
-      const bool is_docked = field_val == static_cast<unsigned int>(mission_state_t::docked);
-      if (field_name == "pan.state" && !is_docking && !is_docked) continue;
+void EEPROMController::set_default_image_path(const std::string &image_path) {
+  default_image_path = image_path;
+}
 
-      _registry.eeprom_saved_fields[i]->set_from_eeprom(field_val);
-    }
+void EEPROMController::map_data(const std::string &image_path) {
+  // The EEPROM image is an input of the run. While replaying, the recorded
+  // image is used and the file isn't touched.
+  if (ReplayLog::is_replaying()) {
+    void* p = mmap(nullptr, eeprom_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) fail("cannot map the replayed image");
+    data = static_cast<unsigned char*>(p);
+    ReplayLog::input(data, eeprom_size);
+    return;
   }
-}
 
-void EEPROMController::update_EEPROM(unsigned int position) {
-  const std::string& field_name = _registry.eeprom_saved_fields[position]->name();
-  const unsigned int field_val = _registry.eeprom_saved_fields[position]->get_eeprom_repr();
-  data[field_name] = field_val;
-}
+  const int fd = ::open(image_path.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd < 0) fail("cannot open " + image_path);
 
-bool EEPROMController::check_empty() {
-  return data.size() == 0;
+  // A missing file, or one with the wrong size, is replaced with an empty
+  // EEPROM.
+  struct stat st;
+  if (fstat(fd, &st) != 0) fail("cannot stat " + image_path);
+  const bool is_new = static_cast<unsigned int>(st.st_size) != eeprom_size;
+  if (is_new && (ftruncate(fd, 0) != 0 || ftruncate(fd, eeprom_size) != 0))
+    fail("cannot resize " + image_path);
+
+  void* p = mmap(nullptr, eeprom_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (p == MAP_FAILED) fail("cannot map " + image_path);
+  ::close(fd);
+
+  data = static_cast<unsigned char*>(p);
+  if (is_new) std::memset(data, 255, eeprom_size);
+  ReplayLog::input(data, eeprom_size);
 }
 
-void EEPROMController::save_data(int signal) {
-  std::ofstream out("eeprom.json");
-  out << data;
-  out.close();
+unsigned char EEPROMController::read_byte(unsigned int address) const {
+  return data[address];
+}
 
-  #ifndef UNIT_TEST
-    std::exit(0);
-  #endif
+void EEPROMController::write_byte(unsigned int address, unsigned char value) {
+  if (data[address] != value) data[address] = value;
 }
 
 #endif
@@ -7,29 +7,44 @@
 // Include for calculating memory use.
 #ifdef DESKTOP
     #include <memuse.h>
+    #include <common/ReplayLog.hpp>
 #else
     extern "C" char* sbrk(int incr);
 #endif
 
 #ifdef DESKTOP
     #define PIKSI_INITIALIZATION piksi("piksi")
+    #define I2C_SCHEDULER_INITIALIZATION i2c_scheduler()
     #define ADCS_INITIALIZATION adcs()
 #else
     #include <HardwareSerial.h>
     TRACKED_CONSTANT_S(HardwareSerial&, piksi_serial, Serial4);
     #define PIKSI_INITIALIZATION piksi("piksi", piksi_serial)
+    #define I2C_SCHEDULER_INITIALIZATION i2c_scheduler(Wire)
     #define ADCS_INITIALIZATION adcs(Wire, Devices::ADCS::ADDRESS)
 #endif
 
+// Queued I2C reads need the wire in I2C_OP_MODE_ISR, which hasn't been run on
+// a Teensy yet. Until it has, Teensy builds only queue reads when built with
+// I2C_ISR, and otherwise keep the blocking reads in I2C_OP_MODE_IMM.
+#if defined(DESKTOP) || defined(I2C_ISR)
+    #define I2C_QUEUED
+    #define ADCS_MONITOR_INITIALIZATION adcs_monitor(registry, adcs, &i2c_scheduler)
+#else
+    #define ADCS_MONITOR_INITIALIZATION adcs_monitor(registry, adcs)
+#endif
+
 MainControlLoop::MainControlLoop(StateFieldRegistry& registry,
-        const std::vector<DownlinkProducer::FlowData>& flow_data)
+        const std::vector<DownlinkProducer::FlowData>& flow_data,
+        const std::vector<TelemetryCompressor::FieldModel>& telemetry_model)
     : ControlTask<void>(registry),
       field_creator_task(registry),
       clock_manager(registry, PAN::control_cycle_time),
       PIKSI_INITIALIZATION,
       piksi_control_task(registry, piksi),
+      I2C_SCHEDULER_INITIALIZATION,
       ADCS_INITIALIZATION,
-      adcs_monitor(registry, adcs),
+      ADCS_MONITOR_INITIALIZATION,
       debug_task(registry),
       estimators(registry),
       gomspace(&hk, &config, &config2),
@@ -63,8 +78,19 @@ MainControlLoop::MainControlLoop(StateFieldRegistry& registry,
     TRACKED_CONSTANT_SC(i2c_pins, i2c_pin_nos, I2C_PINS_18_19);
     TRACKED_CONSTANT_SC(i2c_pullup, i2c_pullups, I2C_PULLUP_EXT);
     TRACKED_CONSTANT_SC(unsigned int, i2c_rate, 400000);
+    #ifdef I2C_QUEUED
+    // Interrupt driven, so that queued transactions run in the background
+    TRACKED_CONSTANT_SC(i2c_op_mode, i2c_op, I2C_OP_MODE_ISR);
+    #else
     TRACKED_CONSTANT_SC(i2c_op_mode, i2c_op, I2C_OP_MODE_IMM);
+    #endif
     Wire.begin(i2c_mode_sel, 0x00, i2c_pin_nos, i2c_pullups, i2c_rate, i2c_op);
+    #else
+    if (Devices::ADCSBoxEmulator::attached())
+        i2c_scheduler.attach_target(Devices::ADCS::ADDRESS, Devices::ADCSBoxEmulator::attached());
+    #endif
+    #ifdef I2C_QUEUED
+    Devices::I2CScheduler::attach(&i2c_scheduler);
     #endif
     
     //setup I2C devices
@@ -83,7 +109,7 @@ MainControlLoop::MainControlLoop(StateFieldRegistry& registry,
     mission_manager.init(); // init after eeprom so that boot count is incremented.
 
     // Since all telemetry fields have been added to the registry, initialize flows
-    downlink_producer.init_flows(flow_data);
+    downlink_producer.init_flows(flow_data, telemetry_model);
     
     // grab downlink sizes, intialize MO buffers
     quake_manager.init();
@@ -114,21 +140,40 @@ MainControlLoop::MainControlLoop(StateFieldRegistry& registry,
     }
 
 void MainControlLoop::execute() {
+    #ifdef DESKTOP
+    ReplayLog::start_cycle(_registry, TimedControlTaskBase::control_cycle_count);
+    #endif
 
     // Compute memory usage
     #ifdef DESKTOP
-    memory_use_f.set(getCurrentRSS());
+    unsigned int memory_use = getCurrentRSS();
+    ReplayLog::input(&memory_use, sizeof(memory_use));
+    memory_use_f.set(memory_use);
     #else
     char top;
     memory_use_f.set(&top - reinterpret_cast<char*>(sbrk(0)));
     #endif
 
+    // Hand the I2C reads queued last cycle to their tasks
+    i2c_scheduler.dispatch();
+
     TRACKED_CONSTANT_SC(unsigned int, piksi_duration, 6400);
+    #ifdef I2C_QUEUED
+    // The ADCS box monitor no longer waits on its reads, which took 1731 us of
+    // bus time per cycle against the desktop box model. That time goes to the
+    // estimators.
+    TRACKED_CONSTANT_SC(unsigned int, adcs_monitor_duration, 26300);
+    #else
     TRACKED_CONSTANT_SC(unsigned int, adcs_monitor_duration, 28000);
+    #endif
     TRACKED_CONSTANT_SC(unsigned int, debug_duration, 16400);
     TRACKED_CONSTANT_SC(unsigned int, gomspace_duration, 15000);
     TRACKED_CONSTANT_SC(unsigned int, uplink_duration, 10000);
+    #ifdef I2C_QUEUED
+    TRACKED_CONSTANT_SC(unsigned int, attitude_estimator_duration, 6700);
+    #else
     TRACKED_CONSTANT_SC(unsigned int, attitude_estimator_duration, 5000);
+    #endif
     TRACKED_CONSTANT_SC(unsigned int, mission_duration, 1000);
     TRACKED_CONSTANT_SC(unsigned int, dcdc_duration, 1000);
     TRACKED_CONSTANT_SC(unsigned int, attitude_controller_duration, 1000);
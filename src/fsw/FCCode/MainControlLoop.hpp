@@ -35,6 +35,7 @@ class MainControlLoop : public ControlTask<void> {
     Devices::Piksi piksi;
     PiksiControlTask piksi_control_task;
 
+    Devices::I2CScheduler i2c_scheduler;
     Devices::ADCS adcs;
     ADCSBoxMonitor adcs_monitor;
 
@@ -99,9 +100,11 @@ class MainControlLoop : public ControlTask<void> {
      * 
      * @param registry State field registry
      * @param flow_data Metadata for telemetry flows.
+     * @param telemetry_model Ground-trained model for compressing telemetry.
      */
     MainControlLoop(StateFieldRegistry& registry,
-        const std::vector<DownlinkProducer::FlowData>& flow_data);
+        const std::vector<DownlinkProducer::FlowData>& flow_data,
+        const std::vector<TelemetryCompressor::FieldModel>& telemetry_model = {});
 
     /**
      * @brief Processes state field commands present in the serial buffer.
@@ -1,11 +1,11 @@
 #include "MainFaultHandler.hpp"
-#include "SimpleFaultHandler.hpp"
 #include "PropFaultHandler.h"
 #include "QuakeFaultHandler.hpp"
 #include "PiksiFaultHandler.hpp"
 
 MainFaultHandler::MainFaultHandler(StateFieldRegistry &r)
     : FaultHandlerMachine(r),
+      mission_state_fp(nullptr),
       fault_handler_enabled_f("fault_handler.enabled", Serializer<bool>())
 {
     add_writable_field(fault_handler_enabled_f);
@@ -15,6 +15,8 @@ MainFaultHandler::MainFaultHandler(StateFieldRegistry &r)
 void MainFaultHandler::init()
 {
     // Populate inputs (and retrieve pointer for some outputs)
+    mission_state_fp = FIND_WRITABLE_FIELD(unsigned char, pan.state);
+
     std::array<Fault *, 1> const active_list_0_safehold_super_simple_faults{
         FIND_FAULT(gomspace.low_batt.base)
     };
@@ -34,35 +36,21 @@ void MainFaultHandler::init()
         FIND_FAULT(attitude_estimator.fault.base)
     };
 
+    std::array<unsigned int, 4> active_state_masks;
+    for (size_t i = 0; i < active_state_masks.size(); i++)
+        active_state_masks[i] = SimpleFaultHandler::active_state_mask(SimpleFaultHandler::active_state_lists[i]);
+
     for (auto *fault : active_list_0_safehold_super_simple_faults)
-    {
-        fault_handler_machines.push_back(
-            std::make_unique<SuperSimpleFaultHandler>(_registry, fault,
-                SimpleFaultHandler::active_state_lists[0], mission_state_t::safehold)
-        );
-    }
+        simple_faults.add(fault, active_state_masks[0], mission_state_t::safehold);
 
     for (auto *fault : active_list_1_safehold_super_simple_faults)
-    {
-        fault_handler_machines.push_back(
-            std::make_unique<SuperSimpleFaultHandler>(_registry, fault,
-                SimpleFaultHandler::active_state_lists[1], mission_state_t::safehold)
-        );
-    }
+        simple_faults.add(fault, active_state_masks[1], mission_state_t::safehold);
 
-    for(auto *fault : active_list_2_standby_super_simple_faults) {
-        fault_handler_machines.push_back(
-            std::make_unique<SuperSimpleFaultHandler>(_registry, fault,
-                SimpleFaultHandler::active_state_lists[2], mission_state_t::standby)
-        );
-    }
+    for (auto *fault : active_list_2_standby_super_simple_faults)
+        simple_faults.add(fault, active_state_masks[2], mission_state_t::standby);
 
-    for (auto *fault : active_list_3_safehold_super_simple_faults) {
-        fault_handler_machines.push_back(
-            std::make_unique<SuperSimpleFaultHandler>(_registry, fault,
-                SimpleFaultHandler::active_state_lists[3], mission_state_t::safehold)
-        );
-    }
+    for (auto *fault : active_list_3_safehold_super_simple_faults)
+        simple_faults.add(fault, active_state_masks[3], mission_state_t::safehold);
 
     fault_handler_machines.push_back(std::make_unique<QuakeFaultHandler>(_registry));
     fault_handler_machines.push_back(std::make_unique<PiksiFaultHandler>(_registry));
@@ -76,6 +64,10 @@ fault_response_t MainFaultHandler::execute()
     if (!fault_handler_enabled_f.get())
         return ret;
 
+    ret = simple_faults.evaluate(static_cast<mission_state_t>(mission_state_fp->get()));
+    if (ret == fault_response_t::safehold)
+        return ret;
+
     for (std::unique_ptr<FaultHandlerMachine> &m : fault_handler_machines)
     {
         const fault_response_t response = m->execute();
@@ -2,6 +2,7 @@
 #define MAIN_FAULT_HANDLER_HPP_
 
 #include "FaultHandlerMachine.hpp"
+#include "SimpleFaultHandler.hpp"
 #include <vector>
 
 class MainFaultHandler : public FaultHandlerMachine {
@@ -23,16 +24,23 @@ class MainFaultHandler : public FaultHandlerMachine {
     void init();
 
     /**
-     * @brief Steps through all of the underlying fault state machines and
-     * combines their recommended mission state outputs.
+     * @brief Evaluates the table of simple faults and steps through all of the
+     * underlying fault state machines, and combines their recommended mission
+     * state outputs.
      * 
-     * If the recommended mission state from any underlying fault machine is safehold,
-     * we immediately return that state. Otherwise, recommend standby if any fault
-     * machine recommends standby. Otherwise, return no recommendation.
+     * If the recommended mission state from any simple fault or underlying fault
+     * machine is safehold, we immediately return that state. Otherwise, recommend
+     * standby if any of them recommends standby. Otherwise, return no recommendation.
      */
     fault_response_t execute() override;
 
   protected:
+    const WritableStateField<unsigned char>* mission_state_fp;
+
+    // Faults that only depend on their own flag. These are evaluated before
+    // the fault handler machines.
+    SimpleFaultTable simple_faults;
+
     std::vector<std::unique_ptr<FaultHandlerMachine>> fault_handler_machines;
 
     // Flag that can be used by HOOTL/HITL to disable/enable fault handling
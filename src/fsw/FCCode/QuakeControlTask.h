@@ -23,7 +23,7 @@ public:
       }
   #else
   QuakeControlTask() :
-      quake("Quake"),
+      quake("Quake", Devices::QLocateModem::attached()),
       fnSeqNum(0),
       MO_msg_p(nullptr),
       MO_msg_len(0) {}
@@ -2,6 +2,7 @@
 #include "Drivers/QLocate.hpp"
 
 #include "radio_state_t.enum"
+#include "DownlinkProducer.hpp"
 
 // Include I/O functions for telemetry dumping during functional testing.
 #ifndef FLIGHT
@@ -26,6 +27,9 @@
  * 
  */
 
+const constexpr unsigned int QuakeManager::mo_queue_capacity;
+const constexpr float QuakeManager::stats_avg_weight;
+
 // Quake driver setup is initialized when QuakeController constructor is called
 QuakeManager::QuakeManager(StateFieldRegistry &registry)
     : TimedControlTask<void>(registry, "quake"),
@@ -36,10 +40,29 @@ QuakeManager::QuakeManager(StateFieldRegistry &registry)
       radio_mt_len_f("uplink.len"),
       radio_state_f("radio.state", Serializer<unsigned char>()),
       last_checkin_cycle_f("radio.last_comms_ccno", Serializer<unsigned int>()), // Last communication control cycle #
+      mo_queue_depth_f("radio.mo_depth", Serializer<unsigned int>(mo_queue_capacity)),
+      mo_dropped_bytes_f("radio.mo_dropped", Serializer<unsigned int>()),
+      sbdix_attempts_f("radio.sbdix_attempts", Serializer<unsigned int>()),
+      sbdix_successes_f("radio.sbdix_successes", Serializer<unsigned int>()),
+      mo_bytes_f("radio.mo_bytes", Serializer<unsigned int>()),
+      mt_bytes_f("radio.mt_bytes", Serializer<unsigned int>()),
+      sbdix_success_avg_f("radio.sbdix_success_avg", Serializer<float>(0, 1, 8)),
+      delivery_latency_f("radio.delivery_latency", Serializer<unsigned int>(PAN::one_day_ccno)),
+      delivery_latency_avg_f("radio.delivery_latency_avg", Serializer<float>(0, PAN::one_day_ccno, 16)),
+      config_cycles_f("radio.cycles.config", Serializer<unsigned int>()),
+      write_cycles_f("radio.cycles.write", Serializer<unsigned int>()),
+      transceive_cycles_f("radio.cycles.transceive", Serializer<unsigned int>()),
+      read_cycles_f("radio.cycles.read", Serializer<unsigned int>()),
+      wait_cycles_f("radio.cycles.wait", Serializer<unsigned int>()),
+      dump_stats_f("radio.dump_stats", Serializer<bool>()),
       dump_telemetry_f("telem.dump", Serializer<bool>()),
       qct(),
+      mo_buffers(nullptr),
+      mo_seq(0),
+      mo_current(mo_queue_capacity),
       mo_idx(0),
-      unexpected_flag(false)
+      unexpected_flag(false),
+      num_deliveries(0)
 {
     add_writable_field(max_wait_cycles_f);
     add_writable_field(max_transceive_cycles_f);
@@ -48,11 +71,27 @@ QuakeManager::QuakeManager(StateFieldRegistry &registry)
     add_internal_field(radio_mt_len_f);
     add_readable_field(radio_state_f);
     add_readable_field(last_checkin_cycle_f);
+    add_readable_field(mo_queue_depth_f);
+    add_readable_field(mo_dropped_bytes_f);
+    add_readable_field(sbdix_attempts_f);
+    add_readable_field(sbdix_successes_f);
+    add_readable_field(mo_bytes_f);
+    add_readable_field(mt_bytes_f);
+    add_readable_field(sbdix_success_avg_f);
+    add_readable_field(delivery_latency_f);
+    add_readable_field(delivery_latency_avg_f);
+    add_readable_field(config_cycles_f);
+    add_readable_field(write_cycles_f);
+    add_readable_field(transceive_cycles_f);
+    add_readable_field(read_cycles_f);
+    add_readable_field(wait_cycles_f);
+    add_writable_field(dump_stats_f);
     add_writable_field(dump_telemetry_f);
 
     // Retrieve fields from registry
     snapshot_size_fp = find_internal_field<size_t>("downlink.snap_size", __FILE__, __LINE__);
     radio_mo_packet_fp = find_internal_field<char *>("downlink.ptr", __FILE__, __LINE__);
+    snapshot_priority_fp = find_internal_field<unsigned char>("downlink.priority", __FILE__, __LINE__);
     radio_power_cycle_fp = find_writable_field<bool>("gomspace.power_cycle_output3_cmd", __FILE__, __LINE__);
 
     cycle_of_entry = control_cycle_count;
@@ -63,6 +102,21 @@ QuakeManager::QuakeManager(StateFieldRegistry &registry)
     last_checkin_cycle_f.set(control_cycle_count);
     radio_mt_packet_f.set(qct.get_MT_msg());
     radio_mt_len_f.set(0);
+    mo_queue_depth_f.set(0);
+    mo_dropped_bytes_f.set(0);
+    sbdix_attempts_f.set(0);
+    sbdix_successes_f.set(0);
+    mo_bytes_f.set(0);
+    mt_bytes_f.set(0);
+    sbdix_success_avg_f.set(0);
+    delivery_latency_f.set(0);
+    delivery_latency_avg_f.set(0);
+    config_cycles_f.set(0);
+    write_cycles_f.set(0);
+    transceive_cycles_f.set(0);
+    read_cycles_f.set(0);
+    wait_cycles_f.set(0);
+    dump_stats_f.set(false);
     // Radio initializes to the disabled state
     radio_state_f.set(static_cast<unsigned int>(radio_state_t::disabled));
     dump_telemetry_f.set(false);
@@ -70,13 +124,14 @@ QuakeManager::QuakeManager(StateFieldRegistry &registry)
 
 void QuakeManager::init(){
     // Setup MO Buffers
-    max_snapshot_size = std::max(snapshot_size_fp->get() + 1, static_cast<size_t>(packet_size));
-    mo_buffer_copy = new char[max_snapshot_size]();
+    const size_t max_packets = std::max((snapshot_size_fp->get() + packet_size - 1) / packet_size, static_cast<size_t>(1));
+    max_snapshot_size = max_packets * packet_size;
+    mo_buffers = new char[mo_queue_capacity * max_snapshot_size]();
 }
 
 QuakeManager::~QuakeManager()
 {
-    delete[] mo_buffer_copy;
+    delete[] mo_buffers;
 }
 
 #ifndef FLIGHT
@@ -101,6 +156,32 @@ void QuakeManager::dump_debug_telemetry(char *buffer, size_t size){
     Serial.print("\"}\n");
     #endif
 }
+
+void QuakeManager::dump_link_stats(){
+    const unsigned int values[] = {
+        sbdix_attempts_f.get(), sbdix_successes_f.get(), mo_bytes_f.get(), mt_bytes_f.get(),
+        delivery_latency_f.get(), mo_queue_depth_f.get(), mo_dropped_bytes_f.get(),
+        config_cycles_f.get(), write_cycles_f.get(), transceive_cycles_f.get(),
+        read_cycles_f.get(), wait_cycles_f.get()};
+    const char *names[] = {
+        "sbdix_attempts", "sbdix_successes", "mo_bytes", "mt_bytes",
+        "delivery_latency", "mo_depth", "mo_dropped",
+        "config_cycles", "write_cycles", "transceive_cycles",
+        "read_cycles", "wait_cycles"};
+    #ifdef DESKTOP
+    std::cout << "{\"t\":" << debug_console::_get_elapsed_time() << ",\"radio_stats\":{";
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++)
+        std::cout << "\"" << names[i] << "\":" << values[i] << ",";
+    std::cout << "\"sbdix_success_avg\":" << sbdix_success_avg_f.get()
+              << ",\"delivery_latency_avg\":" << delivery_latency_avg_f.get() << "}}\n";
+    #else
+    Serial.printf("{\"t\":%d,\"radio_stats\":{", debug_console::_get_elapsed_time());
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++)
+        Serial.printf("\"%s\":%u,", names[i], values[i]);
+    Serial.printf("\"sbdix_success_avg\":%f,\"delivery_latency_avg\":%f}}\n",
+        sbdix_success_avg_f.get(), delivery_latency_avg_f.get());
+    #endif
+}
 #endif
 
 void QuakeManager::execute()
@@ -113,8 +194,20 @@ void QuakeManager::execute()
 
         dump_debug_telemetry(snapshot, snapshot_size_fp->get());
     }
+    if (dump_stats_f.get())
+    {
+        dump_stats_f.set(false);
+        dump_link_stats();
+    }
 #endif
 
+    // Occurrences of events are only carried by the snapshot produced when
+    // they were loaded, so that snapshot is queued right away.
+    if (snapshot_priority_fp->get() != DownlinkProducer::normal_priority)
+    {
+        enqueue_snapshot(snapshot_priority_fp->get());
+    }
+
     const auto radio_state = static_cast<radio_state_t>(radio_state_f.get());
     switch (radio_state)
     {
@@ -122,18 +215,23 @@ void QuakeManager::execute()
         dispatch_disabled();
         break;
     case radio_state_t::config:
+        config_cycles_f.set(config_cycles_f.get() + 1);
         dispatch_config();
         break;
     case radio_state_t::wait:
+        wait_cycles_f.set(wait_cycles_f.get() + 1);
         dispatch_wait();
         break;
     case radio_state_t::transceive:
+        transceive_cycles_f.set(transceive_cycles_f.get() + 1);
         dispatch_transceive();
         break;
     case radio_state_t::read:
+        read_cycles_f.set(read_cycles_f.get() + 1);
         dispatch_read();
         break;
     case radio_state_t::write:
+        write_cycles_f.set(write_cycles_f.get() + 1);
         dispatch_write();
         break;
     default:
@@ -169,7 +267,7 @@ void QuakeManager::dispatch_config()
     // If we have finished executing this command, then transition to write
     if (has_finished())
     {
-        mo_idx = 0; // make sure to write a new snapshot
+        enqueue_snapshot(DownlinkProducer::normal_priority); // make sure to write a new snapshot after the current one
         return transition_radio_state(radio_state_t::write);
     }
 }
@@ -196,7 +294,7 @@ void QuakeManager::dispatch_wait()
     }
     else
     {
-        mo_idx = 0; // make sure to always write a new snapshot
+        enqueue_snapshot(DownlinkProducer::normal_priority); // make sure to write a new snapshot after the current one
         transition_radio_state(radio_state_t::write);
     }
 }
@@ -209,13 +307,13 @@ void QuakeManager::dispatch_write()
         return handle_err(Devices::TIMEOUT);
     }
 
-    // If we just entered write, copy the current message to our local buf
+    // If we just entered write, point the MO message to the next packet
     if (has_just_entered())
     {
-        // If mo_idx is 0 then copy a new snapshot into our local buffer
-        if (mo_idx == 0)
+        // If the current snapshot has been fully written, move on to the next one in the queue
+        if (mo_current == mo_queue_capacity || mo_idx == mo_queue[mo_current].num_packets)
         {
-            copy_next_snapshot();
+            load_next_snapshot();
         }
         // Set MO pointer to the next block
         copy_next_packet();
@@ -241,19 +339,165 @@ bool QuakeManager::has_just_entered() const
 void QuakeManager::copy_next_packet()
 {
     // load the current 70 bytes of the buffer
-    qct.set_downlink_msg(mo_buffer_copy + (packet_size * mo_idx), packet_size);
+    char *packet = mo_buffers + mo_current * max_snapshot_size + packet_size * mo_idx;
+    qct.set_downlink_msg(packet, packet_size);
     #if !defined(FLIGHT) && defined(AUTOTELEM)
     // printf(debug_severity::error, "Attempting to Dump Telemetry\n");
-    dump_debug_telemetry(mo_buffer_copy + (packet_size * mo_idx), packet_size);
+    dump_debug_telemetry(packet, packet_size);
     #endif
-    assert(max_snapshot_size / packet_size != 0);
-    mo_idx = (mo_idx + 1) % (max_snapshot_size / packet_size);
+    assert(mo_idx < mo_queue[mo_current].num_packets);
+    mo_idx++;
+}
+
+void QuakeManager::enqueue_snapshot(unsigned char priority)
+{
+    // A queued normal snapshot only holds older values of the fields in a
+    // new one, so it's replaced. Otherwise use a free slot, or else the
+    // oldest snapshot of the lowest priority. The current snapshot is never
+    // replaced or dropped since it's partially downlinked, and an event
+    // snapshot doesn't push out one of the same priority, whose occurrences
+    // have to be confirmed first.
+    size_t slot = mo_queue_capacity;
+    bool supersedes = false;
+    if (priority == DownlinkProducer::normal_priority)
+    {
+        for (size_t i = 0; i < mo_queue_capacity; i++)
+        {
+            if (i != mo_current && mo_queue[i].num_packets > 0 &&
+                mo_queue[i].priority == DownlinkProducer::normal_priority)
+            {
+                slot = i;
+                supersedes = true;
+                break;
+            }
+        }
+    }
+    for (size_t i = 0; i < mo_queue_capacity && !supersedes; i++)
+    {
+        if (i == mo_current)
+            continue;
+        if (mo_queue[i].num_packets == 0)
+        {
+            slot = i;
+            break;
+        }
+        if (slot == mo_queue_capacity || mo_queue[i].priority < mo_queue[slot].priority ||
+            (mo_queue[i].priority == mo_queue[slot].priority && mo_queue[i].seq < mo_queue[slot].seq))
+        {
+            slot = i;
+        }
+    }
+
+    const size_t snapshot_size = std::min(snapshot_size_fp->get(), max_snapshot_size);
+    const size_t num_packets = std::max((snapshot_size + packet_size - 1) / packet_size, static_cast<size_t>(1));
+    if (slot == mo_queue_capacity || (!supersedes && mo_queue[slot].num_packets > 0 &&
+                                       mo_queue[slot].priority >= priority))
+    {
+        // The occurrences of an event snapshot stay in their logs and are
+        // loaded again once there's room, so it isn't counted as dropped.
+        if (priority == DownlinkProducer::normal_priority)
+            drop_snapshot(priority, control_cycle_count, num_packets);
+        else
+            rewind_events(control_cycle_count);
+        return;
+    }
+    if (mo_queue[slot].num_packets > 0)
+    {
+        if (!supersedes)
+            drop_snapshot(mo_queue[slot].priority, mo_queue[slot].ccno, mo_queue[slot].num_packets);
+        mo_queue_depth_f.set(mo_queue_depth_f.get() - 1);
+    }
+
+    char *data = mo_buffers + slot * max_snapshot_size;
+    memset(data, 0, max_snapshot_size);
+    memcpy(data, radio_mo_packet_fp->get(), snapshot_size);
+    mo_queue[slot].num_packets = num_packets;
+    mo_queue[slot].seq = mo_seq++;
+    mo_queue[slot].priority = priority;
+    mo_queue[slot].ccno = control_cycle_count;
+    mo_queue_depth_f.set(mo_queue_depth_f.get() + 1);
+}
+
+void QuakeManager::drop_snapshot(unsigned char priority, unsigned int ccno, size_t num_packets)
+{
+    mo_dropped_bytes_f.set(mo_dropped_bytes_f.get() + num_packets * packet_size);
+    if (priority != DownlinkProducer::normal_priority)
+        rewind_events(ccno);
+}
+
+void QuakeManager::rewind_events(unsigned int ccno)
+{
+    for (Event *event : _registry.events)
+        event->rewind_downlink(ccno);
 }
 
-void QuakeManager::copy_next_snapshot()
+void QuakeManager::load_next_snapshot()
 {
-    memset(mo_buffer_copy, 0, sizeof(*mo_buffer_copy) * max_snapshot_size);
-    memcpy(mo_buffer_copy, radio_mo_packet_fp->get(), max_snapshot_size);
+    if (mo_current != mo_queue_capacity)
+    {
+        mo_queue[mo_current].num_packets = 0;
+        mo_queue_depth_f.set(mo_queue_depth_f.get() - 1);
+        mo_current = mo_queue_capacity;
+    }
+    if (mo_queue_depth_f.get() == 0)
+    {
+        enqueue_snapshot(DownlinkProducer::normal_priority);
+    }
+
+    // Highest priority first, then oldest first. At most one normal snapshot
+    // is waiting, since newer ones replace it, and event snapshots are sent
+    // in the order their occurrences were loaded.
+    for (size_t i = 0; i < mo_queue_capacity; i++)
+    {
+        if (mo_queue[i].num_packets == 0)
+            continue;
+        if (mo_current == mo_queue_capacity || mo_queue[i].priority > mo_queue[mo_current].priority ||
+            (mo_queue[i].priority == mo_queue[mo_current].priority && mo_queue[i].seq < mo_queue[mo_current].seq))
+        {
+            mo_current = i;
+        }
+    }
+    mo_idx = 0;
+}
+
+void QuakeManager::rewind_packet()
+{
+    if (mo_current != mo_queue_capacity && mo_idx > 0)
+    {
+        mo_idx--;
+    }
+}
+
+void QuakeManager::record_sbdix(bool success)
+{
+    const float sample = success ? 1.0f : 0.0f;
+    if (sbdix_attempts_f.get() <= 1)
+        sbdix_success_avg_f.set(sample);
+    else
+        sbdix_success_avg_f.set(stats_avg_weight * sample + (1 - stats_avg_weight) * sbdix_success_avg_f.get());
+    if (!success)
+        return;
+
+    sbdix_successes_f.set(sbdix_successes_f.get() + 1);
+    mo_bytes_f.set(mo_bytes_f.get() + qct.MO_msg_len);
+
+    // The snapshot is delivered once the session carrying its last packet reaches the network
+    if (mo_current != mo_queue_capacity && mo_idx == mo_queue[mo_current].num_packets)
+    {
+        const unsigned int latency = control_cycle_count - mo_queue[mo_current].ccno;
+        num_deliveries++;
+        if (num_deliveries == 1)
+            delivery_latency_avg_f.set(latency);
+        else
+            delivery_latency_avg_f.set(stats_avg_weight * latency + (1 - stats_avg_weight) * delivery_latency_avg_f.get());
+        delivery_latency_f.set(latency);
+
+        if (mo_queue[mo_current].priority != DownlinkProducer::normal_priority)
+        {
+            for (Event *event : _registry.events)
+                event->confirm_downlink(mo_queue[mo_current].ccno);
+        }
+    }
 }
 
 void QuakeManager::dispatch_transceive()
@@ -266,16 +510,23 @@ void QuakeManager::dispatch_transceive()
         return handle_err(Devices::TIMEOUT);
     }
 
+    const bool starting = qct.get_fn_num() == 0;
     int err_code = qct.execute(radio_state_t::transceive);
 
     if (is_actual_error(err_code))
     {
         return handle_err(err_code);
     }
+    if (starting && qct.get_fn_num() == 1)
+    {
+        sbdix_attempts_f.set(sbdix_attempts_f.get() + 1);
+    }
 
     // If we have finished executing SBDIX, then see if we have a message
     if (has_finished())
     {
+        record_sbdix(qct.get_MO_status() <= 4);
+
         // Case 1: We have no comms --> try again until we run out of cycles
         if (qct.get_MO_status() > 4)
         {
@@ -311,7 +562,9 @@ void QuakeManager::handle_no_comms()
     }
     else
     {
-        mo_idx = 0; // Make sure we get a new snapshot
+        // The packet wasn't sent, so write it again, and queue a new snapshot to follow the current one
+        rewind_packet();
+        enqueue_snapshot(DownlinkProducer::normal_priority);
         return transition_radio_state(radio_state_t::write);
     }
 }
@@ -352,6 +605,7 @@ void QuakeManager::dispatch_read()
                "[Quake Info] SBDRB finished, transitioning to SBDWB");
 
         radio_mt_len_f.set(qct.get_MT_length());
+        mt_bytes_f.set(mt_bytes_f.get() + qct.get_MT_length());
 
         transition_radio_state(radio_state_t::write);
     }
@@ -365,6 +619,18 @@ bool QuakeManager::is_actual_error(int err_code)
 
 void QuakeManager::handle_err(int err_code)
 {
+    // A packet that was being written or sent may not have made it out
+    const auto radio_state = static_cast<radio_state_t>(radio_state_f.get());
+    if (radio_state == radio_state_t::write || radio_state == radio_state_t::transceive)
+    {
+        rewind_packet();
+    }
+    // An SBDIX session that was interrupted didn't reach the network
+    if (radio_state == radio_state_t::transceive && qct.get_fn_num() == 1)
+    {
+        record_sbdix(false);
+    }
+
     radio_err_f.set(err_code);
     unexpected_flag = true;
     transition_radio_state(radio_state_t::wait);
@@ -25,15 +25,28 @@
 /**
  * Comms Protocol Implementation:
  *  
- * If we have written the entire snapshot, load the next snapshot
- * Otherwise, increment mo_idx to point to the next 70 bytes
+ * Snapshots wait in a bounded queue until they are downlinked. A snapshot
+ * with event priority is queued in the cycle it is produced, since it carries
+ * event occurrences that later snapshots won't; otherwise the current
+ * snapshot is queued whenever the queue runs dry, or when a failure means
+ * fresh data should go out after the snapshot being downlinked.
  * 
- * Essentially points mo_buffer_copy + mo_idx*packet_size to the next
- * 70 bytes of data that should be downlinked.
+ * Snapshots are downlinked one at a time, highest priority first and then
+ * oldest first, so that the packets of a snapshot stay contiguous on the
+ * ground. mo_idx points to the next 70 bytes of the current snapshot that
+ * should be downlinked. When the queue is full, the oldest snapshot of a
+ * lower priority is dropped. An event snapshot that finds the queue full of
+ * event snapshots waits instead: its occurrences stay in their logs and are
+ * loaded again in a later cycle.
  */
 class QuakeManager : public TimedControlTask<void>
 {
 public:
+   /**
+    * @brief Number of snapshots the MO queue can hold.
+    */
+   TRACKED_CONSTANT_SC(unsigned int, mo_queue_capacity, 4);
+
    QuakeManager(StateFieldRegistry &registry);
    
    /**
@@ -48,6 +61,8 @@ public:
 #ifndef FLIGHT
 
    void dump_debug_telemetry(char *buffer, size_t size);
+
+   void dump_link_stats();
 #endif
 
    void execute() override;
@@ -73,14 +88,14 @@ public:
       return cycle_of_entry;
    }
 
-   char *dbg_get_mo_buffer_copy()
+   size_t &dbg_get_mo_idx()
    {
-      return mo_buffer_copy;
+      return mo_idx;
    }
 
-   size_t &dbg_get_mo_idx()
+   void dbg_enqueue_snapshot(unsigned char priority)
    {
-      return mo_idx;
+      enqueue_snapshot(priority);
    }
 
    bool &dbg_get_unexpected_flag()
@@ -104,6 +119,11 @@ public:
      */
    const InternalStateField<char *> *radio_mo_packet_fp;
 
+   /**
+    * @brief Downlink priority of the snapshot, provided by DownlinkProducer.
+    */
+   const InternalStateField<unsigned char> *snapshot_priority_fp;
+
    /**
     * @brief Pointer to gomspace output, to check for power loss.
     */
@@ -141,6 +161,53 @@ public:
      */
    ReadableStateField<unsigned int> last_checkin_cycle_f;
 
+   /**
+     * @brief Number of snapshots waiting to be downlinked, including the
+     * one being downlinked, and the number of snapshot bytes dropped from
+     * the queue before they could be downlinked. Normal-priority snapshots
+     * superseded by newer ones, and event snapshots waiting for room,
+     * aren't counted as dropped.
+     */
+   ReadableStateField<unsigned int> mo_queue_depth_f;
+   ReadableStateField<unsigned int> mo_dropped_bytes_f;
+
+   /**
+     * @brief Link statistics: SBDIX sessions started and sessions that
+     * reached the network, and the MO and MT bytes they moved.
+     */
+   ReadableStateField<unsigned int> sbdix_attempts_f;
+   ReadableStateField<unsigned int> sbdix_successes_f;
+   ReadableStateField<unsigned int> mo_bytes_f;
+   ReadableStateField<unsigned int> mt_bytes_f;
+
+   /**
+     * @brief Moving average of the fraction of SBDIX sessions that reached
+     * the network.
+     */
+   ReadableStateField<float> sbdix_success_avg_f;
+
+   /**
+     * @brief Number of control cycles from the production of the last
+     * delivered snapshot to the session that delivered its last packet, and
+     * its moving average.
+     */
+   ReadableStateField<unsigned int> delivery_latency_f;
+   ReadableStateField<float> delivery_latency_avg_f;
+
+   /**
+     * @brief Number of control cycles spent in each radio state.
+     */
+   ReadableStateField<unsigned int> config_cycles_f;
+   ReadableStateField<unsigned int> write_cycles_f;
+   ReadableStateField<unsigned int> transceive_cycles_f;
+   ReadableStateField<unsigned int> read_cycles_f;
+   ReadableStateField<unsigned int> wait_cycles_f;
+
+   /**
+     * @brief This flag can be used by the sim to dump the link statistics over the USB line.
+     */
+   WritableStateField<bool> dump_stats_f;
+
    /**
      * @brief This flag can be used by the sim to dump telemetry over the USB line.
      */
@@ -202,10 +269,45 @@ protected:
    void copy_next_packet();
 
    /**
-     * Copies snapshot_size bytes of data from radio_mo_packet_fp to a local buffer that is max_snapshot size
-     * This is executed whenever mo_idx == 0
+     * Copies snapshot_size bytes of data from radio_mo_packet_fp into a free slot of the queue, dropping the
+     * oldest snapshot of a lower priority if there are none. The new snapshot is the one dropped if every
+     * other queued snapshot has the same or a higher priority.
+     * A new normal-priority snapshot replaces a queued normal-priority snapshot that isn't being downlinked,
+     * since it carries newer values of the same fields. This isn't counted as a drop.
+     * A new event snapshot that doesn't fit isn't counted as a drop either: the events load its occurrences
+     * again, and they are queued in a later cycle.
+     */
+   void enqueue_snapshot(unsigned char priority);
+
+   /**
+     * Frees the slot of the current snapshot and makes the next queued snapshot current, queueing the current
+     * snapshot from DownlinkProducer first if the queue is empty.
+     * This is executed whenever the current snapshot has been fully written
+     */
+   void load_next_snapshot();
+
+   /**
+     * Moves mo_idx back to the last packet written, so that it is written again if it may not have been sent
+     */
+   void rewind_packet();
+
+   /**
+     * Updates the link statistics with the result of an SBDIX session, and confirms the delivery of the
+     * event occurrences carried by the current snapshot once its last packet has been sent
+     */
+   void record_sbdix(bool success);
+
+   /**
+     * Counts the snapshot produced in cycle ccno as dropped. If it carried event occurrences, the events
+     * load them again.
+     */
+   void drop_snapshot(unsigned char priority, unsigned int ccno, size_t num_packets);
+
+   /**
+     * Has the events load again the occurrences carried by the snapshot produced in cycle ccno, and by
+     * the snapshots produced after it.
      */
-   void copy_next_snapshot();
+   void rewind_events(unsigned int ccno);
 
 private:
    QuakeControlTask qct;
@@ -255,20 +357,43 @@ private:
    unsigned int cycle_of_entry;
 
    /**
-     * Local copy of max_snapshot_size given by DownlinkProducer
+     * Size of a queue slot: the max snapshot size given by DownlinkProducer,
+     * rounded up to a whole number of packets
      */
    size_t max_snapshot_size;
 
    /**
-     * Temporary buffer of size max_snapshot_size + 1
-     * Only SBDWB may write to mo_buffer_copy or mo_idx
+     * Storage for the mo_queue_capacity slots of the queue, each of size max_snapshot_size
+     */
+   char *mo_buffers;
+
+   struct mo_snapshot_t
+   {
+      /** Number of packets in the snapshot, or 0 if the slot is free **/
+      size_t num_packets = 0;
+      /** Order in which the snapshot was queued **/
+      unsigned int seq = 0;
+      unsigned char priority = 0;
+      /** Control cycle at which the snapshot was produced **/
+      unsigned int ccno = 0;
+   };
+   mo_snapshot_t mo_queue[mo_queue_capacity];
+
+   /**
+     * Sequence number of the next snapshot to be queued
+     */
+   unsigned int mo_seq;
+
+   /**
+     * Slot of the snapshot being downlinked, or mo_queue_capacity if there is none
+     * Only SBDWB may change mo_current or mo_idx
      */
-   char *mo_buffer_copy;
+   size_t mo_current;
 
    /**
-     * The index into mo_buffer_copy in multiples of max_packet_size 
+     * The index into the current snapshot in multiples of max_packet_size 
      * SBDWB will send the next 70 bytes that start at mo_idx*max_packet_size
-     * from the beginning of mo_buffer_copy
+     * from the beginning of the current snapshot
      */
    size_t mo_idx;
 
@@ -280,6 +405,11 @@ private:
      */
    bool unexpected_flag;
 
+   /**
+     * Number of snapshots delivered, which seeds the delivery latency average with its first sample
+     */
+   unsigned int num_deliveries;
+
    /**
      * Max cycles that each radio_state state is allowed to waste before being 
      * transitioned. 
@@ -292,4 +422,10 @@ public:
    TRACKED_CONSTANT_SC(unsigned int, max_read_cycles, 5);
 
    TRACKED_CONSTANT_SC(size_t, packet_size, 70);
+
+   /**
+    * @brief Weight of the newest sample in the moving averages of the link
+    * statistics.
+    */
+   TRACKED_CONSTANT_SC(float, stats_avg_weight, 0.1f);
 };
@@ -5,7 +5,7 @@ SimpleFaultHandler::SimpleFaultHandler(StateFieldRegistry& r, Fault* f,
     mission_state_t rs) :
         FaultHandlerMachine(r),
         fault(f),
-        active_states(_active_states),
+        active_states(active_state_mask(_active_states)),
         recommended_state(rs)
 {
     assert(rs == mission_state_t::safehold || rs == mission_state_t::standby);
@@ -15,7 +15,7 @@ SimpleFaultHandler::SimpleFaultHandler(StateFieldRegistry& r, Fault* f,
 fault_response_t SimpleFaultHandler::determine_recommended_state() const {
     const mission_state_t state = static_cast<mission_state_t>(mission_state_fp->get());
 
-    if (std::find(active_states.begin(), active_states.end(), state) == active_states.end())
+    if (!(active_states & (1U << static_cast<unsigned int>(state))))
         return fault_response_t::none;
 
     if (fault->is_faulted()) {
@@ -29,6 +29,12 @@ fault_response_t SimpleFaultHandler::determine_recommended_state() const {
     else return fault_response_t::none;
 }
 
+unsigned int SimpleFaultHandler::active_state_mask(const std::vector<mission_state_t>& states) {
+    unsigned int mask = 0;
+    for (mission_state_t state : states) mask |= 1U << static_cast<unsigned int>(state);
+    return mask;
+}
+
 const std::vector<std::vector<mission_state_t>> SimpleFaultHandler::active_state_lists {
     // List 0 is used by the Gomspace's low-battery fault and overpressure fault
     {
@@ -77,3 +83,24 @@ SuperSimpleFaultHandler::SuperSimpleFaultHandler(StateFieldRegistry& r, Fault* f
 fault_response_t SuperSimpleFaultHandler::execute() {
     return determine_recommended_state();
 }
+
+void SimpleFaultTable::add(Fault* f, unsigned int active_state_mask, mission_state_t rs) {
+    assert(rs == mission_state_t::safehold || rs == mission_state_t::standby);
+    faults.push_back(f);
+    active_states.push_back(active_state_mask);
+    responses.push_back(rs == mission_state_t::standby ? fault_response_t::standby : fault_response_t::safehold);
+}
+
+fault_response_t SimpleFaultTable::evaluate(mission_state_t state) {
+    const unsigned int state_bit = 1U << static_cast<unsigned int>(state);
+    fault_response_t ret = fault_response_t::none;
+
+    for (size_t i = 0; i < faults.size(); i++) {
+        if (!(active_states[i] & state_bit) || !faults[i]->is_faulted())
+            continue;
+        if (responses[i] == fault_response_t::safehold)
+            return fault_response_t::safehold;
+        ret = fault_response_t::standby;
+    }
+    return ret;
+}
@@ -2,6 +2,7 @@
 #define SIMPLE_FAULT_HANDLER_HPP_
 
 #include "FaultHandlerMachine.hpp"
+#include <vector>
 
 /**
  * @brief Class for a simple fault handler that depends only on a single
@@ -37,6 +38,12 @@ class SimpleFaultHandler : public FaultHandlerMachine {
 
     static const std::vector<std::vector<mission_state_t>> active_state_lists;
 
+    /**
+     * @brief Convert a list of mission states into a bitmask, in which bit i
+     * is set if mission state i is in the list.
+     */
+    static unsigned int active_state_mask(const std::vector<mission_state_t>& states);
+
   protected:
     /**
      * @brief Determines the recommended state to the main fault handler
@@ -50,7 +57,7 @@ class SimpleFaultHandler : public FaultHandlerMachine {
     Fault* fault;
 
   private:
-    const std::vector<mission_state_t>& active_states;
+    const unsigned int active_states;
     mission_state_t recommended_state;
 };
 
@@ -63,4 +70,48 @@ class SuperSimpleFaultHandler : public SimpleFaultHandler {
     fault_response_t execute() override;
 };
 
+/**
+ * @brief Table of faults that, like the ones checked by SuperSimpleFaultHandler,
+ * each depend only on their own fault flag.
+ *
+ * The faults are stored as a structure of arrays, with their active states as
+ * bitmasks, so that the whole table is evaluated in a single loop rather than
+ * through one fault handler machine and one search of its active states per
+ * fault.
+ */
+class SimpleFaultTable {
+  #ifdef UNIT_TEST
+    friend class TestFixtureMainFHMocked;
+  #endif
+
+  public:
+    /**
+     * @brief Add a fault to the table.
+     *
+     * @param f Fault to check.
+     * @param active_state_mask Mission states during which the fault can produce
+     *                          a fault response, as built by
+     *                          SimpleFaultHandler::active_state_mask.
+     * @param rs Recommended state if the fault is signaled.
+     */
+    void add(Fault* f, unsigned int active_state_mask, mission_state_t rs);
+
+    /**
+     * @brief Combine the fault responses of all faults in the table, in the
+     * order in which they were added. Returns safehold as soon as any active
+     * fault recommends it; otherwise returns standby if any active fault
+     * recommends it.
+     *
+     * @param state Current mission state.
+     */
+    fault_response_t evaluate(mission_state_t state);
+
+    size_t size() const { return faults.size(); }
+
+  protected:
+    std::vector<Fault*> faults;
+    std::vector<unsigned int> active_states;
+    std::vector<fault_response_t> responses;
+};
+
 #endif
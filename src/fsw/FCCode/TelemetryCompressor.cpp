@@ -0,0 +1,126 @@
+#include "TelemetryCompressor.hpp"
+#include <algorithm>
+
+/**
+ * @brief Zigzag-encode the modular difference between a code and its
+ * reference, so that small positive and negative deltas both map to small
+ * unsigned values.
+ */
+static unsigned long long zigzag(unsigned long long code, unsigned long long reference) {
+    const unsigned long long d = code - reference;
+    return (d << 1) ^ (0ULL - (d >> 63));
+}
+
+static unsigned long long unzigzag(unsigned long long u, unsigned long long reference) {
+    const unsigned long long d = (u >> 1) ^ (0ULL - (u & 1));
+    return reference + d;
+}
+
+/**
+ * @brief Returns true if the Rice code of u is strictly shorter than the raw
+ * field, i.e. q + 1 + k < bitsize.
+ */
+static bool rice_is_shorter(unsigned long long u, size_t bitsize, unsigned char k) {
+    if (k + 1U >= bitsize) return false;
+    return (u >> k) < bitsize - 1 - k;
+}
+
+TelemetryCompressor::TelemetryCompressor() : model() {}
+
+TelemetryCompressor::TelemetryCompressor(const std::vector<FieldModel>& m) : model(m) {
+    std::sort(model.begin(), model.end(),
+        [](const FieldModel& a, const FieldModel& b) { return a.name < b.name; });
+}
+
+const TelemetryCompressor::FieldModel* TelemetryCompressor::find(const std::string& name) const {
+    auto it = std::lower_bound(model.begin(), model.end(), name,
+        [](const FieldModel& m, const std::string& n) { return m.name < n; });
+    if (it == model.end() || it->name != name) return nullptr;
+    return &(*it);
+}
+
+size_t TelemetryCompressor::encoded_size(unsigned long long code, size_t bitsize,
+    const FieldModel& m)
+{
+    const unsigned long long u = zigzag(code, m.reference);
+    if (rice_is_shorter(u, bitsize, m.k)) return 1 + (u >> m.k) + 1 + m.k;
+    return 1 + bitsize;
+}
+
+size_t TelemetryCompressor::encode(const bit_array& field_bits, const FieldModel& m,
+    std::vector<bool>& dest)
+{
+    const size_t bitsize = field_bits.size();
+    dest.clear();
+
+    const unsigned long long u = zigzag(field_bits.to_ullong(), m.reference);
+    if (!rice_is_shorter(u, bitsize, m.k)) {
+        dest.push_back(false);
+        dest.insert(dest.end(), field_bits.begin(), field_bits.end());
+        return dest.size();
+    }
+
+    dest.push_back(true);
+    for (unsigned long long q = u >> m.k; q > 0; q--) dest.push_back(true);
+    dest.push_back(false);
+    for (unsigned char i = 0; i < m.k; i++) dest.push_back((u >> i) & 1);
+    return dest.size();
+}
+
+size_t TelemetryCompressor::decode(const std::vector<bool>& src, size_t offset,
+    const FieldModel& m, bit_array& field_bits)
+{
+    const size_t bitsize = field_bits.size();
+    size_t pos = offset;
+    if (pos >= src.size()) return 0;
+
+    if (!src[pos++]) {
+        if (pos + bitsize > src.size()) return 0;
+        for (size_t i = 0; i < bitsize; i++) field_bits[i] = src[pos + i];
+        return 1 + bitsize;
+    }
+
+    // The encoder guarantees q + 1 + k < bitsize, so a longer quotient can only
+    // come from a corrupted frame.
+    unsigned long long q = 0;
+    while (pos < src.size() && src[pos]) {
+        if (++q + 1 + m.k >= bitsize) return 0;
+        pos++;
+    }
+    if (pos + 1 + m.k > src.size()) return 0;
+    pos++;
+
+    unsigned long long u = q << m.k;
+    for (unsigned char i = 0; i < m.k; i++) {
+        if (src[pos + i]) u |= 1ULL << i;
+    }
+    pos += m.k;
+
+    const unsigned long long code = unzigzag(u, m.reference);
+    for (size_t i = 0; i < bitsize; i++) field_bits[i] = (code >> i) & 1;
+    return pos - offset;
+}
+
+bool TelemetryCompressor::train(const std::string& name, size_t bitsize,
+    const std::vector<unsigned long long>& codes, FieldModel* m)
+{
+    if (codes.empty() || bitsize > max_field_bits || bitsize < 3) return false;
+
+    std::vector<unsigned long long> sorted(codes);
+    std::nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end());
+
+    FieldModel candidate {name, sorted[sorted.size() / 2], 0};
+    size_t best_size = codes.size() * bitsize;
+    bool found = false;
+    for (size_t k = 0; k + 2 < bitsize; k++) {
+        candidate.k = static_cast<unsigned char>(k);
+        size_t total = 0;
+        for (unsigned long long code : codes) total += encoded_size(code, bitsize, candidate);
+        if (total < best_size) {
+            best_size = total;
+            *m = candidate;
+            found = true;
+        }
+    }
+    return found;
+}
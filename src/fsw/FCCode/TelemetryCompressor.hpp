@@ -0,0 +1,142 @@
+#ifndef TELEMETRY_COMPRESSOR_HPP_
+#define TELEMETRY_COMPRESSOR_HPP_
+
+#include <common/fixed_array.hpp>
+#include <common/constant_tracker.hpp>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Optional entropy coding stage for downlink snapshots.
+ *
+ * Fields are fixed-point encoded by their serializers, so a field whose value
+ * sits near the same point for most of the mission still spends its full bit
+ * width in every snapshot. The compressor re-encodes a field's serialized code
+ * as the difference from a static, ground-trained reference code using a
+ * Golomb-Rice code.
+ *
+ * Every modeled field is preceded by a single mode bit:
+ * - 0: the raw serialized bits follow, exactly as in an uncompressed snapshot.
+ * - 1: a Rice code follows; the zigzag-encoded delta is split into a unary
+ *      quotient (ones terminated by a zero) and a k-bit remainder, LSB first.
+ *
+ * The encoder only picks the Rice code when it is strictly shorter than the raw
+ * field, so a modeled field never costs more than one extra bit. The reference
+ * is static rather than the previous snapshot's value so that losing a frame
+ * over the radio never corrupts the decoding of the next one.
+ */
+class TelemetryCompressor {
+  public:
+    /**
+     * @brief Fields wider than this are never modeled, since their codes do
+     * not fit into a single integer (e.g. high-precision vectors).
+     */
+    TRACKED_CONSTANT_SC(size_t, max_field_bits, 64);
+
+    /**
+     * @brief Ground-trained model of a single telemetry field.
+     */
+    struct FieldModel {
+        //! Name of the readable field this entry describes.
+        std::string name;
+
+        //! Expected serialized code of the field; deltas are taken from this.
+        unsigned long long reference;
+
+        //! Golomb-Rice parameter, i.e. the width of the remainder in bits.
+        unsigned char k;
+    };
+
+    /**
+     * @brief Construct a compressor with an empty model. Every field is then
+     * written uncompressed.
+     */
+    TelemetryCompressor();
+
+    /**
+     * @brief Construct a compressor from a ground-trained model.
+     */
+    explicit TelemetryCompressor(const std::vector<FieldModel>& model);
+
+    /**
+     * @brief Find the model entry for the field of the given name.
+     *
+     * @return Pointer to the model entry, or null pointer if the field isn't
+     * modeled.
+     */
+    const FieldModel* find(const std::string& name) const;
+
+    /**
+     * @brief Returns true if the model contains no fields.
+     */
+    bool empty() const { return model.empty(); }
+
+    /**
+     * @brief Returns the ground-trained model, sorted by field name.
+     */
+    const std::vector<FieldModel>& get_model() const { return model; }
+
+    /**
+     * @brief Worst-case number of bits a modeled field of the given width
+     * occupies in a compressed snapshot.
+     */
+    static constexpr size_t max_encoded_size(size_t bitsize) { return bitsize + 1; }
+
+    /**
+     * @brief Number of bits the given serialized code occupies once encoded,
+     * including the mode bit.
+     *
+     * @param code    Serialized code of the field.
+     * @param bitsize Width of the field's serializer.
+     * @param m       Model entry for the field.
+     */
+    static size_t encoded_size(unsigned long long code, size_t bitsize, const FieldModel& m);
+
+    /**
+     * @brief Encode the serialized bits of a field.
+     *
+     * @param field_bits Serialized bits of the field; at most max_field_bits wide.
+     * @param m          Model entry for the field.
+     * @param dest       Receives the encoded bits. The vector is cleared, not
+     *                   reallocated, if it has sufficient capacity.
+     * @return Number of bits written to dest.
+     */
+    static size_t encode(const bit_array& field_bits, const FieldModel& m, std::vector<bool>& dest);
+
+    /**
+     * @brief Decode a field from a stream of compressed bits.
+     *
+     * @param src        Compressed bit stream.
+     * @param offset     Bit offset into src at which the field begins.
+     * @param m          Model entry for the field.
+     * @param field_bits Receives the serialized bits of the field. Its size
+     *                   determines the field width.
+     * @return Number of bits consumed from src, or zero if src ended before
+     * the field was complete.
+     */
+    static size_t decode(const std::vector<bool>& src, size_t offset, const FieldModel& m,
+        bit_array& field_bits);
+
+    /**
+     * @brief Fit a model entry to a set of recorded serialized codes of a
+     * field. The reference is the median code and k minimizes the total
+     * encoded size of the samples.
+     *
+     * @param name    Name of the field.
+     * @param bitsize Width of the field's serializer.
+     * @param codes   Recorded serialized codes.
+     * @param m       Receives the fitted model entry.
+     * @return True if the fitted model encodes the samples in fewer bits than
+     * sending them raw.
+     */
+    static bool train(const std::string& name, size_t bitsize,
+        const std::vector<unsigned long long>& codes, FieldModel* m);
+
+  protected:
+    /**
+     * @brief Model entries, sorted by field name.
+     */
+    std::vector<FieldModel> model;
+};
+
+#endif
@@ -6,6 +6,7 @@
 #include <string>
 
 #ifdef DESKTOP
+#include <common/ReplayLog.hpp>
 #include <thread>
 #include <chrono>
 #include <time.h>
@@ -55,7 +56,13 @@ class TimedControlTaskBase {
      */
     static sys_time_t get_system_time() {
       #ifdef DESKTOP
-        return std::chrono::steady_clock::now();
+        // The clock is an input of the flight software, so it goes through the
+        // replay log when recording or replaying a run.
+        if (ReplayLog::mode() == ReplayLog::mode_t::off)
+          return std::chrono::steady_clock::now();
+        const long long now_us = std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now().time_since_epoch()).count();
+        return sys_time_t(std::chrono::microseconds(ReplayLog::clock_us(now_us)));
       #else
         return micros();
       #endif
@@ -90,13 +97,19 @@ class TimedControlTaskBase {
     }
 
     static void wait_duration(const unsigned int& delta_t) {
-      const sys_time_t start = get_system_time();
-      // Wait until execution time
-      while(duration_to_us(get_system_time() - start) < delta_t) {
-        #ifndef DESKTOP
+      #ifdef DESKTOP
+        // Waits are skipped when replaying, and the clock readings they use
+        // aren't inputs.
+        if (ReplayLog::is_replaying()) return;
+        const sys_time_t start = std::chrono::steady_clock::now();
+        while(duration_to_us(std::chrono::steady_clock::now() - start) < delta_t) {}
+      #else
+        const sys_time_t start = get_system_time();
+        // Wait until execution time
+        while(duration_to_us(get_system_time() - start) < delta_t) {
           delayMicroseconds(10);
-        #endif
-      }
+        }
+      #endif
     }
 };
 
@@ -1,6 +1,18 @@
 #include "UplinkCommon.h"
 
-Uplink::Uplink(StateFieldRegistry& r) : registry(r), index_size(0)
+/**
+ * Reads num_bits bits of the packet starting at bit offset pos. Bits are
+ * stored LSB first within each byte, as in bitstream.
+ */
+static size_t read_bits(const uint8_t* packet, size_t pos, size_t num_bits)
+{
+    size_t val = 0;
+    for (size_t i = 0; i < num_bits; ++i, ++pos)
+        val |= static_cast<size_t>((packet[pos / 8] >> (pos % 8)) & 1) << i;
+    return val;
+}
+
+Uplink::Uplink(StateFieldRegistry& r) : registry(r), index_size(0), staged_packet(nullptr)
 {
 }
 
@@ -9,91 +21,107 @@ void Uplink::init_uplink()
     // calculate the maximum number of bits needed to represent the indices
     // target variable is index_size
     for (index_size = 1; (registry.writable_fields.size() + 1) / (1 << index_size) > 0; ++index_size){}
+
+    // Cache the width of each field so that decoding doesn't need to visit
+    // the fields themselves
+    const size_t num_fields = registry.writable_fields.size();
+    field_lengths.resize(num_fields);
+    for (size_t i = 0; i < num_fields; ++i)
+        field_lengths[i] = registry.writable_fields[i]->get_bit_array().size();
+
+    // A valid packet updates each field at most once
+    staged_updates.clear();
+    staged_updates.reserve(num_fields);
+    is_field_staged.assign(num_fields, false);
 }
 
 bool Uplink::_validate_packet(bitstream& bs)
 {
-    // Start validation at beginning of bs
-    bs.reset();
-    size_t packet_bytes = bs.max_len;
-    size_t field_index = 0, field_len = 0, bits_checked = 0, bits_consumed = 0;
-    // Keep a bit map to prevent updating the same field twice
-    static std::vector<bool> is_field_updated(registry.writable_fields.size(), 0);
-    // Clear the bit map
-    for (size_t i = 0; i < registry.writable_fields.size(); ++i)
-        is_field_updated[i] = 0;
-    while (bits_checked < 8*packet_bytes)
+    const bool is_valid = _stage_packet(bs);
+    _clear_staged();
+    return is_valid;
+}
+
+void Uplink::_update_fields(bitstream& bs)
+{
+    if (_stage_packet(bs))
+        _commit_staged();
+}
+
+bool Uplink::_stage_packet(bitstream& bs)
+{
+    _clear_staged();
+    staged_packet = bs.stream;
+    const size_t packet_bits = 8 * bs.max_len;
+    size_t pos = 0;
+
+    while (pos < packet_bits)
     {
-        // Get index from bitstream
-        bits_consumed = bs.nextN(index_size, reinterpret_cast<uint8_t*>(&field_index));
+        // Get index from the packet
+        const size_t index_bits = (packet_bits - pos < index_size) ? packet_bits - pos : index_size;
+        size_t field_index = read_bits(staged_packet, pos, index_bits);
+        pos += index_bits;
 
         if (field_index == 0) // reached end of the packet
             break;
         --field_index;
-        // Check if index is within writable_fields and get its length if it is      
-        field_len = get_field_length(field_index);
-        if (field_len == 0) 
-            return false;
-        // If we have already seen this field or if the number of bits consumed
-        // to get the next index is not index_size
-        if (is_field_updated[field_index] || bits_consumed != index_size)
+
+        // The index must be complete and refer to a writable field that
+        // hasn't been updated yet by this packet
+        if (index_bits != index_size || field_index >= field_lengths.size()
+            || field_lengths[field_index] == 0 || is_field_staged[field_index])
+        {
+            _clear_staged();
             return false;
+        }
 
-        bits_checked += bits_consumed;
-        is_field_updated[field_index] = true;
-        
-        bits_consumed = bs.seekG(field_len, bs_end);
-        // Return in this case because indicates that packet is not aligned since
-        // we reached the end earlier than expected
-        if (bits_consumed != field_len) 
+        // The packet is not aligned if it ends before the field's value
+        const size_t field_len = field_lengths[field_index];
+        if (pos + field_len > packet_bits)
+        {
+            _clear_staged();
             return false;
+        }
 
-        bits_checked += bits_consumed;
+        is_field_staged[field_index] = true;
+        staged_updates.push_back({field_index, pos});
+        pos += field_len;
     }
 
-    // Consume the padding (there should be no more than 7 bits of padding)
-    uint8_t u8 = 0;
-    bits_consumed = bs.nextN(8, &u8);
-    
-    // Return false if there were more than 8 bits left in the stream or
-    // if padding was not 0
-    return (u8 != 0 || bits_consumed > 7) ? false : true;
+    // There should be no more than 7 bits of padding, and they must be zero
+    const size_t padding = packet_bits - pos;
+    if (padding > 7 || read_bits(staged_packet, pos, padding) != 0)
+    {
+        _clear_staged();
+        return false;
+    }
+    return true;
 }
 
-void Uplink::_update_fields(bitstream& bs)
+void Uplink::_commit_staged()
 {
-    size_t packet_size = bs.max_len*8;
-    size_t field_index = 0, field_len = 0, bits_consumed = 0;
-    // Start updates at beginning of bs
-    bs.reset();
-    while (bits_consumed < packet_size)
+    for (const StagedUpdate& update : staged_updates)
     {
-        // Get index from the bitstream
-        bits_consumed += bs.nextN(index_size, reinterpret_cast<uint8_t*>(&field_index));
-        if (field_index == 0) // reached end of the packet
-            return;
-        --field_index;
-
-        // Get field length from the index
-        field_len = get_field_length(field_index);
-        auto field_p = registry.writable_fields[field_index];
+        auto field_p = registry.writable_fields[update.field_index];
         bit_array& field_bit_arr = field_p->get_bit_array();
-
-        // Clear field's bit array
+        const size_t field_len = field_lengths[update.field_index];
         for (size_t i = 0; i < field_len; ++i)
-          field_bit_arr[i] = 0;
-
-        // Dump into bit_array
-        bits_consumed += bs.nextN(field_len, field_bit_arr);
-        field_p->set_bit_array(field_bit_arr);
+            field_bit_arr[i] = read_bits(staged_packet, update.offset + i, 1);
         field_p->deserialize();
     }
+    _clear_staged();
+}
+
+void Uplink::_clear_staged()
+{
+    for (const StagedUpdate& update : staged_updates)
+        is_field_staged[update.field_index] = false;
+    staged_updates.clear();
 }
 
 size_t Uplink::get_field_length(size_t field_index)
 {
-    if (field_index >= registry.writable_fields.size())
+    if (field_index >= field_lengths.size())
         return 0;
-    return registry.writable_fields[field_index]->get_bit_array().size();
+    return field_lengths[field_index];
 }
-
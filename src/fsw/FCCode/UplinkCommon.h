@@ -2,9 +2,11 @@
 #pragma once
 #include <common/bitstream.h>
 #include <common/StateFieldRegistry.hpp>
+#include <vector>
 
 /**
- * Uplink provides operations on an Uplink Packet and is stateless
+ * Uplink provides operations on an Uplink Packet. Its only state is a
+ * table of field widths and the requests of the most recently staged packet.
  * 
  */
 class Uplink {
@@ -33,6 +35,12 @@ class Uplink {
    */
   size_t index_size;
 
+  /**
+   * @brief Width in bits of each writable field, indexed like
+   * registry.writable_fields. Built by init_uplink.
+   */
+  std::vector<size_t> field_lengths;
+
   /**
    * Validates the packet
    */
@@ -40,8 +48,46 @@ class Uplink {
 
   /**
    * Updates the fields of the registry with the uplink packet described by bs
+   * if the packet is valid. Either all or none of the fields are updated.
    * This function is here in order to sync producer and consumer
    */
   void _update_fields(bitstream& bs);
 
+  /**
+   * @brief Validates the packet in a single pass and stages its requests, so
+   * that they can be applied by _commit_staged without decoding the packet
+   * again. Nothing is staged if the packet is invalid.
+   * @return true if the packet is valid
+   */
+  bool _stage_packet(bitstream& bs);
+
+  /**
+   * @brief Applies the requests staged by the last successful _stage_packet.
+   * The packet passed to _stage_packet must still be in scope.
+   */
+  void _commit_staged();
+
+  protected:
+  /**
+   * @brief A request of a staged packet: the index of the field to update and
+   * the bit offset of its new value within the packet.
+   */
+  struct StagedUpdate {
+    size_t field_index;
+    size_t offset;
+  };
+
+  /**
+   * @brief Discards the staged requests.
+   */
+  void _clear_staged();
+
+  // Requests of the staged packet, in packet order
+  std::vector<StagedUpdate> staged_updates;
+
+  // Whether each writable field has a staged request, to reject duplicates
+  std::vector<bool> is_field_staged;
+
+  // Packet that the staged requests refer to
+  const uint8_t* staged_packet;
 };
\ No newline at end of file
@@ -16,8 +16,11 @@ void UplinkConsumer::execute()
     if ( !radio_mt_packet_len_fp->get() || !radio_mt_packet_fp->get())
         return;
     
-    if (validate_packet())
-        update_fields();
+    // Validate and apply the packet in a single pass over it. Fields are
+    // only updated if the whole packet is valid.
+    bitstream bs (radio_mt_packet_fp->get(), radio_mt_packet_len_fp->get());
+    if (_stage_packet(bs))
+        _commit_staged();
 
     // clear len always
     radio_mt_packet_len_fp->set(0);
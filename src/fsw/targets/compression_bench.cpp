@@ -0,0 +1,116 @@
+/**
+ * @file compression_bench.cpp
+ *
+ * Measures the cost of snapshot compression on the flight computer. The
+ * Downlink Producer runs over the flight flows with and without
+ * downlink.compress, and prints its execution time over USB serial as
+ *
+ *   <raw|compressed>,<mean us>,<max us>,<mean snapshot bytes>
+ *
+ * The shipped telemetry model is empty, so a model is fitted at startup
+ * instead: every field that can be modeled is referenced to its serialized
+ * code at startup, and each snapshot moves it a few codes away from there.
+ */
+
+#include <fsw/FCCode/MainControlLoop.hpp>
+#include <common/StateFieldRegistry.hpp>
+#include "flow_data.hpp"
+#include "telemetry_model.hpp"
+
+#include <Arduino.h>
+
+#ifndef UNIT_TEST
+TRACKED_CONSTANT_SC(unsigned int, bench_snapshots, 500);
+
+/**
+ * @brief Fits a model entry to every downlinked field narrow enough to be
+ * modeled, referenced to the field's current value.
+ */
+static std::vector<TelemetryCompressor::FieldModel> fit_model(const StateFieldRegistry& r) {
+    std::vector<TelemetryCompressor::FieldModel> model;
+    for (const DownlinkProducer::FlowData& flow : PAN::flow_data) {
+        for (const std::string& name : flow.field_list) {
+            ReadableStateFieldBase* field = r.find_readable_field(name);
+            if (!field || r.find_event(name)) continue;
+            if (field->bitsize() > TelemetryCompressor::max_field_bits) continue;
+            field->serialize();
+            model.push_back({name, field->get_bit_array().to_ullong(), 2});
+        }
+    }
+    return model;
+}
+
+/**
+ * @brief Moves every modeled field up to three codes away from its reference.
+ */
+static void perturb(const StateFieldRegistry& r,
+    const std::vector<TelemetryCompressor::FieldModel>& model)
+{
+    for (const TelemetryCompressor::FieldModel& m : model) {
+        ReadableStateFieldBase* field = r.find_readable_field(m.name);
+        const size_t bits = field->bitsize();
+        const unsigned long long max_code = bits >= 64 ? ~0ULL : (1ULL << bits) - 1;
+        const long delta = random(-3, 4);
+        unsigned long long code = m.reference;
+        if (delta < 0) code = code < (unsigned long long)-delta ? 0 : code + delta;
+        else code = max_code - code < (unsigned long long)delta ? max_code : code + delta;
+
+        bit_array arr(bits);
+        arr.set_ullong(code);
+        field->set_bit_array(arr);
+        field->deserialize();
+    }
+}
+
+static void run(StateFieldRegistry& r, DownlinkProducer& producer,
+    const std::vector<TelemetryCompressor::FieldModel>& model, const bool compress)
+{
+    static_cast<WritableStateField<bool>*>(r.find_writable_field("downlink.compress"))->set(compress);
+    InternalStateField<size_t>* snap_size_fp =
+        static_cast<InternalStateField<size_t>*>(r.find_internal_field("downlink.snap_size"));
+
+    // Both runs see the same snapshots
+    randomSeed(0);
+    unsigned long total_us = 0, max_us = 0, total_bytes = 0;
+    for (unsigned int i = 0; i < bench_snapshots; i++) {
+        perturb(r, model);
+        const unsigned long start = micros();
+        producer.execute();
+        const unsigned long us = micros() - start;
+        total_us += us;
+        if (us > max_us) max_us = us;
+        total_bytes += snap_size_fp->get();
+    }
+    Serial.printf("%s,%lu,%lu,%lu\n", compress ? "compressed" : "raw",
+        total_us / bench_snapshots, max_us, total_bytes / bench_snapshots);
+}
+
+void setup() {}
+
+void loop() {
+    // The flight software creates every downlinked field. Its own producer
+    // keeps the shipped model, so the benchmark runs a second one that
+    // shares the fields.
+    static StateFieldRegistry registry;
+    static MainControlLoop fcp(registry, PAN::flow_data, PAN::telemetry_model);
+    static StateFieldRegistry bench_registry;
+    static std::vector<TelemetryCompressor::FieldModel> model;
+    static DownlinkProducer* producer = nullptr;
+    if (!producer) {
+        for (ReadableStateFieldBase* field : registry.readable_fields) {
+            if (field->name().compare(0, 9, "downlink.") != 0)
+                bench_registry.add_readable_field(field);
+        }
+        for (Event* event : registry.events) bench_registry.add_event(event);
+
+        model = fit_model(bench_registry);
+        producer = new DownlinkProducer(bench_registry);
+        producer->init_flows(PAN::flow_data, model);
+        Serial.printf("modeled fields: %u\n", (unsigned int)model.size());
+    }
+
+    run(bench_registry, *producer, model, false);
+    run(bench_registry, *producer, model, true);
+    delay(5000);
+}
+#endif
@@ -1,11 +1,106 @@
 #include <fsw/FCCode/MainControlLoop.hpp>
 #include <common/StateFieldRegistry.hpp>
+#include <common/ReplayLog.hpp>
+#include <fsw/FCCode/Drivers/QLocateModem.hpp>
+#include <fsw/FCCode/Drivers/PiksiSbpLog.hpp>
+#include <fsw/FCCode/Drivers/ADCSBoxEmulator.hpp>
 #include "flow_data.hpp"
+#include "telemetry_model.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
 
+/**
+ * Usage: native [--record <log> [--checkpoint-period <cycles>]]
+ *               [--replay <log> [--from <ccno>]]
+ *               [--quake-mailbox <dir> [--quake-latency <ms>]
+ *                [--quake-failure-rate <p>] [--quake-mo-depth <n>]
+ *                [--quake-mt-depth <n>] [--quake-byte-rate <bytes/s>]
+ *                [--quake-seed <n>]]
+ *               [--piksi-log <sbp log> [--piksi-speed <x>] [--piksi-loop]]
+ *               [--adcs-box [--adcs-realtime]]
+ *               [--eeprom <image>]
+ *
+ * With --record, every external input of the run is logged so that the run
+ * can be reproduced with --replay. A replay runs at CPU speed, optionally
+ * starting from the newest checkpoint at or before the given control cycle.
+ *
+ * With --quake-mailbox, the Quake radio talks to an emulated Iridium modem
+ * whose mailbox is the given directory. See Devices::QLocateModem.
+ *
+ * With --piksi-log, the Piksi reads the given raw SBP log at the given
+ * multiple of its serial rate instead of returning canned values. See
+ * Devices::PiksiSbpLog.
+ *
+ * With --adcs-box, the ADCS driver talks to an emulated ADCS box, optionally
+ * taking as long as the I2C bus would. See Devices::ADCSBoxEmulator.
+ *
+ * With --eeprom, the EEPROM image is the given file instead of
+ * eeprom_leader.bin or eeprom_follower.bin in the working directory.
+ */
 #ifndef UNIT_TEST
-int main() {
+int main(int argc, char* argv[]) {
+    std::string record_path, replay_path;
+    unsigned int checkpoint_period = 1000;
+    unsigned int from_ccno = 0;
+    std::string quake_mailbox;
+    Devices::QLocateModem::config_t quake_config;
+    std::string piksi_log_path;
+    Devices::PiksiSbpLog::config_t piksi_config;
+    bool adcs_box = false;
+    Devices::ADCSBoxEmulator::config_t adcs_box_config;
+
+    for (int i = 1; i < argc; i++) {
+        const bool has_value = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--record") && has_value) record_path = argv[++i];
+        else if (!std::strcmp(argv[i], "--replay") && has_value) replay_path = argv[++i];
+        else if (!std::strcmp(argv[i], "--checkpoint-period") && has_value) checkpoint_period = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--from") && has_value) from_ccno = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--quake-mailbox") && has_value) quake_mailbox = argv[++i];
+        else if (!std::strcmp(argv[i], "--quake-latency") && has_value) quake_config.session_latency_ms = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--quake-failure-rate") && has_value) quake_config.failure_rate = std::atof(argv[++i]);
+        else if (!std::strcmp(argv[i], "--quake-mo-depth") && has_value) quake_config.mo_queue_depth = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--quake-mt-depth") && has_value) quake_config.mt_queue_depth = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--quake-byte-rate") && has_value) quake_config.byte_rate = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--quake-seed") && has_value) quake_config.seed = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--piksi-log") && has_value) piksi_log_path = argv[++i];
+        else if (!std::strcmp(argv[i], "--piksi-speed") && has_value) piksi_config.speed = std::atof(argv[++i]);
+        else if (!std::strcmp(argv[i], "--piksi-loop")) piksi_config.loop = true;
+        else if (!std::strcmp(argv[i], "--adcs-box")) adcs_box = true;
+        else if (!std::strcmp(argv[i], "--adcs-realtime")) adcs_box_config.realtime = true;
+        else if (!std::strcmp(argv[i], "--eeprom") && has_value) EEPROMController::set_default_image_path(argv[++i]);
+        else {
+            std::cerr << "unrecognized argument: " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+
+    if (!record_path.empty() && !replay_path.empty()) {
+        std::cerr << "cannot record and replay at the same time" << std::endl;
+        return 1;
+    }
+    if (!record_path.empty()) ReplayLog::record(record_path, checkpoint_period);
+    if (!replay_path.empty()) ReplayLog::replay(replay_path, from_ccno);
+
+    Devices::QLocateModem quake_modem(quake_config);
+    if (!quake_mailbox.empty()) {
+        quake_modem.set_mailbox_dir(quake_mailbox);
+        Devices::QLocateModem::attach(&quake_modem);
+    }
+
+    std::vector<unsigned char> piksi_bytes;
+    if (!piksi_log_path.empty() && !Devices::PiksiSbpLog::load(piksi_log_path, piksi_bytes)) {
+        std::cerr << "cannot read " << piksi_log_path << std::endl;
+        return 1;
+    }
+    Devices::PiksiSbpLog piksi_log(piksi_bytes, piksi_config);
+    if (!piksi_log_path.empty()) Devices::PiksiSbpLog::attach(&piksi_log);
+
+    Devices::ADCSBoxEmulator adcs_box_emulator(adcs_box_config);
+    if (adcs_box) Devices::ADCSBoxEmulator::attach(&adcs_box_emulator);
+
     StateFieldRegistry registry;
-    MainControlLoop fcp(registry, PAN::flow_data);
+    MainControlLoop fcp(registry, PAN::flow_data, PAN::telemetry_model);
 
     while (true) {
         fcp.execute();
@@ -0,0 +1,83 @@
+/**
+ * @file piksi_bench.cpp
+ *
+ * Measures the throughput of the Piksi ingest path on desktop: SBP bytes go
+ * through the driver's ring buffer, the libsbp parser and the driver's
+ * callbacks exactly as they do on hardware, as fast as the CPU allows.
+ *
+ * Usage: piksi_bench [<sbp log>] [--epochs <n>] [--rtk]
+ *
+ * Without a log, one is generated with the given number of 100 ms epochs.
+ */
+
+#include <fsw/FCCode/Drivers/Piksi.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#ifndef UNIT_TEST
+
+/**
+ * @brief Number of SBP frames in a log, found the same way the driver finds
+ * frame boundaries.
+ */
+static size_t count_frames(const std::vector<unsigned char>& bytes) {
+    size_t frames = 0;
+    size_t i = 0;
+    while (i + 6 <= bytes.size()) {
+        if (bytes[i] != 0x55) {
+            i++;
+            continue;
+        }
+        frames++;
+        i += 8 + bytes[i + 5];
+    }
+    return frames;
+}
+
+int main(int argc, char* argv[]) {
+    std::string path;
+    unsigned int epochs = 100000;
+    bool rtk = false;
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--epochs") && i + 1 < argc) epochs = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--rtk")) rtk = true;
+        else path = argv[i];
+    }
+
+    std::vector<unsigned char> bytes;
+    if (path.empty()) Devices::PiksiSbpLog::generate(epochs, rtk, bytes);
+    else if (!Devices::PiksiSbpLog::load(path, bytes)) {
+        std::cerr << "cannot read " << path << std::endl;
+        return 1;
+    }
+
+    Devices::PiksiSbpLog::config_t config;
+    config.speed = 0;
+    Devices::PiksiSbpLog log(bytes, config);
+    Devices::Piksi piksi("piksi", &log);
+    piksi.setup();
+
+    unsigned int reads = 0, fixes = 0, crc_errors = 0;
+    const auto start = std::chrono::steady_clock::now();
+    while (!log.done() || piksi.bytes_available() > 0) {
+        const unsigned char result = piksi.read_all();
+        reads++;
+        if (result <= 1) fixes++;
+        if (result == 3) crc_errors++;
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const size_t frames = count_frames(bytes);
+    std::cout << "bytes: " << bytes.size() << "\n"
+              << "messages: " << frames << "\n"
+              << "read_all calls: " << reads << " (" << fixes << " with a fix, "
+              << crc_errors << " with CRC errors)\n"
+              << "seconds: " << seconds << "\n"
+              << "messages/s: " << frames / seconds << "\n"
+              << "MB/s: " << bytes.size() / seconds / 1e6 << std::endl;
+    return 0;
+}
+
+#endif
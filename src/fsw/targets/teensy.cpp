@@ -8,6 +8,7 @@
 #include <fsw/FCCode/MainControlLoop.hpp>
 #include <common/StateFieldRegistry.hpp>
 #include "flow_data.hpp"
+#include "telemetry_model.hpp"
 
 #include <core_pins.h>
 #include <wiring.h>
@@ -19,7 +20,7 @@ void setup() {}
 
 void loop() {
     static StateFieldRegistry registry;
-    static MainControlLoop fcp(registry, PAN::flow_data);
+    static MainControlLoop fcp(registry, PAN::flow_data, PAN::telemetry_model);
 
     fcp.execute();
 }
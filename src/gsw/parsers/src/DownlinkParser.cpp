@@ -1,14 +1,17 @@
 #include "DownlinkParser.hpp"
 #include <common/Serializer.hpp>
+#include <common/EventStorage.hpp>
 #include <vector>
 #include <fstream>
 #include <json.hpp>
 
 DownlinkParser::DownlinkParser(StateFieldRegistry& r,
-                               const std::vector<DownlinkProducer::FlowData>& flow_data) :
-    fcp(r, flow_data),
+                               const std::vector<DownlinkProducer::FlowData>& flow_data,
+                               const std::vector<TelemetryCompressor::FieldModel>& telemetry_model) :
+    fcp(r, flow_data, telemetry_model),
     registry(r),
     flow_data(fcp.get_downlink_producer()->get_flows()),
+    compressor(fcp.get_downlink_producer()->get_compressor()),
     packet_num(0) {}
 
 std::string DownlinkParser::process_downlink_file(const std::string& filename) {
@@ -20,6 +23,44 @@ std::string DownlinkParser::process_downlink_file(const std::string& filename) {
     return process_downlink_packet(packet);
 }
 
+unsigned int DownlinkParser::consume_cycle_count(std::vector<bool>& frame_bits,
+                                                 bool& compressed) const
+{
+    unsigned int cycle_count;
+    Serializer<unsigned int> cycle_count_sr;
+    const std::vector<bool> cycle_count_bits(frame_bits.begin(), frame_bits.begin() + 32);
+    cycle_count_sr.set_bit_array(cycle_count_bits);
+    cycle_count_sr.deserialize(&cycle_count);
+    frame_bits.erase(frame_bits.begin(), frame_bits.begin() + 32);
+
+    const unsigned int flag = 1U << DownlinkProducer::compressed_flag_bit;
+    compressed = (cycle_count & flag) != 0;
+    return cycle_count & ~flag;
+}
+
+bool DownlinkParser::consume_field_bits(std::vector<bool>& frame_bits,
+                                        ReadableStateFieldBase* field,
+                                        const bool compressed) const
+{
+    bit_array& field_bits = field->get_bit_array();
+
+    const TelemetryCompressor::FieldModel* model =
+        compressed ? compressor.find(field->name()) : nullptr;
+    if (model && field_bits.size() <= TelemetryCompressor::max_field_bits) {
+        const size_t consumed = TelemetryCompressor::decode(frame_bits, 0, *model, field_bits);
+        if (consumed == 0) return false;
+        frame_bits.erase(frame_bits.begin(), frame_bits.begin() + consumed);
+        return true;
+    }
+
+    if (field_bits.size() > frame_bits.size()) return false;
+    const std::vector<bool>::iterator field_end_it = frame_bits.begin() + field_bits.size();
+    const std::vector<bool> raw_bits(frame_bits.begin(), field_end_it);
+    field->set_bit_array(raw_bits);
+    frame_bits.erase(frame_bits.begin(), field_end_it);
+    return true;
+}
+
 bool DownlinkParser::check_is_first_packet(const std::vector<char>& packet, nlohmann::json& ret){
     // packet is a downlink packet to check, ret is the json object to modify with debugging data if required.
 
@@ -44,14 +85,10 @@ bool DownlinkParser::check_is_first_packet(const std::vector<char>& packet, nloh
     }
 
     // Step 3: Process control cycle count
-    unsigned int cycle_count;
-    Serializer<unsigned int> cycle_count_sr;
-    const std::vector<bool> cycle_count_bits(frame_bits.begin(), frame_bits.begin() + 32);
-    cycle_count_sr.set_bit_array(cycle_count_bits);
-    cycle_count_sr.deserialize(&cycle_count);
+    bool compressed;
+    consume_cycle_count(frame_bits, compressed);
     // ret["data"]["pan.cycle_no"] = std::to_string(cycle_count);
     // ret["metadata"]["cycle_no"] = cycle_count;
-    frame_bits.erase(frame_bits.begin(), frame_bits.begin() + 32);
 
     // Step 4: Process flows by ID. If, at any point, the expected
     // size of a field exceeds the number of bits available in the
@@ -165,15 +202,15 @@ bool DownlinkParser::check_is_first_packet(const std::vector<char>& packet, nloh
                 frame_bits.erase(frame_bits.begin(), event_end_it);
             }
             else {
-                const std::vector<bool>::iterator field_end_it =
-                    frame_bits.begin() + field->get_bit_array().size();
-
-                const std::vector<bool> field_bits(frame_bits.begin(), field_end_it);
-                field->set_bit_array(field_bits);
+                if (!consume_field_bits(frame_bits, field, compressed)) {
+                    log_str += "Field incomplete: " + field->name();
+                    ret["metadata"]["check_log"] = log_str;
+                    frame_bits.clear();
+                    break;
+                }
                 field->deserialize();
 
                 // ret["data"][field->name()] = std::string(field->print());
-                frame_bits.erase(frame_bits.begin(), field_end_it);
             }
         }
     }
@@ -256,14 +293,11 @@ std::string DownlinkParser::process_downlink_packet(const std::vector<char>& pac
     }
 
     // Step 3: Process control cycle count
-    unsigned int cycle_count;
-    Serializer<unsigned int> cycle_count_sr;
-    const std::vector<bool> cycle_count_bits(frame_bits.begin(), frame_bits.begin() + 32);
-    cycle_count_sr.set_bit_array(cycle_count_bits);
-    cycle_count_sr.deserialize(&cycle_count);
+    bool compressed;
+    const unsigned int cycle_count = consume_cycle_count(frame_bits, compressed);
     ret["data"]["pan.cycle_no"] = std::to_string(cycle_count);
     ret["metadata"]["cycle_no"] = cycle_count;
-    frame_bits.erase(frame_bits.begin(), frame_bits.begin() + 32);
+    if (compressed) ret["metadata"]["compressed"] = true;
 
     // Step 4: Process flows by ID. If, at any point, the expected
     // size of a field exceeds the number of bits available in the
@@ -335,8 +369,14 @@ std::string DownlinkParser::process_downlink_packet(const std::vector<char>& pac
          *              "field3_name": field3 value
          *          }
          *      },
+         *      "event_log_name": [
+         *          { "control_cycle_number": ..., "field_data": { ... } },
+         *          ...
+         *      ],
          *      "readable_field_name": readable field value
          * }
+         *
+         * Event logs carry a window of records, each of which is listed.
          */
         for(ReadableStateFieldBase* field : flow->field_list) {
             Event* event = registry.find_event(field->name());
@@ -354,13 +394,28 @@ std::string DownlinkParser::process_downlink_packet(const std::vector<char>& pac
                 
                 const std::vector<bool> event_bits(frame_bits.begin(), event_end_it);
                 event->set_bit_array(event_bits);
-                
-                event->deserialize();
-                unsigned int event_ccno = event->ccno->get();
 
-                ret["data"][event->name()]["control_cycle_number"] = event_ccno;
-                for (ReadableStateFieldBase* data_field: event->_data_fields()) {
-                    ret["data"][event->name()]["field_data"][data_field->name()] = std::string(data_field->print());
+                // Reads the occurrence currently stored in the event's fields
+                const auto occurrence = [event]() {
+                    json occ;
+                    occ["control_cycle_number"] = event->ccno->get();
+                    for (ReadableStateFieldBase* data_field: event->_data_fields()) {
+                        occ["field_data"][data_field->name()] = std::string(data_field->print());
+                    }
+                    return occ;
+                };
+
+                EventStorage* log = dynamic_cast<EventStorage*>(event);
+                if (log) {
+                    ret["data"][event->name()] = json::array();
+                    for (size_t i = 0; i < log->window_count(); i++) {
+                        log->deserialize_record(i);
+                        ret["data"][event->name()].push_back(occurrence());
+                    }
+                }
+                else {
+                    event->deserialize();
+                    ret["data"][event->name()] = occurrence();
                 }
 
                 // Reapply the original values to the control cycle count and data fields
@@ -373,15 +428,13 @@ std::string DownlinkParser::process_downlink_packet(const std::vector<char>& pac
                 frame_bits.erase(frame_bits.begin(), event_end_it);
             }
             else {
-                const std::vector<bool>::iterator field_end_it =
-                    frame_bits.begin() + field->get_bit_array().size();
-
-                const std::vector<bool> field_bits(frame_bits.begin(), field_end_it);
-                field->set_bit_array(field_bits);
+                if (!consume_field_bits(frame_bits, field, compressed)) {
+                    ret["metadata"]["error"] = "field incomplete: " + field->name();
+                    return ret.dump();
+                }
                 field->deserialize();
 
                 ret["data"][field->name()] = std::string(field->print());
-                frame_bits.erase(frame_bits.begin(), field_end_it);
             }
         }
     }
@@ -15,9 +15,13 @@ class DownlinkParser {
     /**
      * @brief Construct a new Downlink Parser.
      * 
+     * @param telemetry_model Ground-trained model used by flight software to
+     *                        compress snapshots. Must match the flight model
+     *                        in order to decode compressed snapshots.
      */
     DownlinkParser(StateFieldRegistry& r,
-        const std::vector<DownlinkProducer::FlowData>& flow_data);
+        const std::vector<DownlinkProducer::FlowData>& flow_data,
+        const std::vector<TelemetryCompressor::FieldModel>& telemetry_model = {});
 
     /**
      * @brief Process a file containing a downlink, and return a JSON
@@ -46,8 +50,33 @@ class DownlinkParser {
      */
     const std::vector<DownlinkProducer::Flow>& flow_data;
 
+    /**
+     * @brief Compressor used by the Downlink Producer, which holds the model
+     * needed to decode compressed snapshots.
+     */
+    const TelemetryCompressor& compressor;
+
     bool check_is_first_packet(const std::vector<char>& packet, nlohmann::json& json_packet);
 
+    /**
+     * @brief Removes the control cycle count from the front of the frame bits.
+     *
+     * @param frame_bits Frame bits, with packet headers already removed.
+     * @param compressed Set to whether or not the rest of the frame is compressed.
+     * @return The control cycle count.
+     */
+    unsigned int consume_cycle_count(std::vector<bool>& frame_bits, bool& compressed) const;
+
+    /**
+     * @brief Removes a readable field's bits from the front of the frame bits
+     * and stores them into the field's bit array, decoding them first if the
+     * frame is compressed and the field is modeled.
+     *
+     * @return False if the frame ended before the field was complete.
+     */
+    bool consume_field_bits(std::vector<bool>& frame_bits, ReadableStateFieldBase* field,
+        const bool compressed) const;
+
     /**
      * @brief Processes the most recent downlink packet.
      * 
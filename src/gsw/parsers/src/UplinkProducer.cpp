@@ -5,6 +5,8 @@
 #include <json.hpp>
 #include <exception>
 #include <lin/views.hpp>
+#include <algorithm>
+#include <numeric>
 
 UplinkProducer::UplinkProducer(StateFieldRegistry& r):
     Uplink(r),
@@ -13,23 +15,51 @@ UplinkProducer::UplinkProducer(StateFieldRegistry& r):
     max_possible_packet_size = 0;
     // initialize index_size
     init_uplink();
-    // Setup field_map
+    // Setup field_map and the encoder of each field
+    field_map.reserve(registry.writable_fields.size());
+    encoders.reserve(registry.writable_fields.size());
     for (size_t i = 0; i < registry.writable_fields.size(); ++i)
     {
         auto w = registry.writable_fields[i];
-        field_map[w->name().c_str()] = i;
+        field_map[w->name()] = i;
+        encoders.push_back(make_encoder(w, i));
         max_possible_packet_size += index_size + w->bitsize();
     }
+    packet_buffer.resize((max_possible_packet_size + 7) / 8);
  }
 
-template<typename UnderlyingType>
-size_t UplinkProducer::try_add_field(bitstream &bs, std::string key, nlohmann::json j) {
-    // Get pointer to that field in the registry
-    WritableStateField<UnderlyingType>* ptr = dynamic_cast<WritableStateField<UnderlyingType>*>(registry.find_writable_field(key));
+UplinkProducer::FieldEncoder UplinkProducer::make_encoder(WritableStateFieldBase* w, size_t index) {
+    using namespace lin;
+    FieldEncoder e {w, index, nullptr};
+
+    // Resolve the type of the field once, so that encoding a value doesn't
+    // have to try every supported type.
+    if (dynamic_cast<WritableStateField<unsigned int>*>(w)) e.encode = &UplinkProducer::encode_field<unsigned int>;
+    else if (dynamic_cast<WritableStateField<signed int>*>(w)) e.encode = &UplinkProducer::encode_field<signed int>;
+    else if (dynamic_cast<WritableStateField<unsigned char>*>(w)) e.encode = &UplinkProducer::encode_field<unsigned char>;
+    else if (dynamic_cast<WritableStateField<signed char>*>(w)) e.encode = &UplinkProducer::encode_field<signed char>;
+    else if (dynamic_cast<WritableStateField<float>*>(w)) e.encode = &UplinkProducer::encode_field<float>;
+    else if (dynamic_cast<WritableStateField<double>*>(w)) e.encode = &UplinkProducer::encode_field<double>;
+    else if (dynamic_cast<WritableStateField<bool>*>(w)) e.encode = &UplinkProducer::encode_field<bool>;
+    else if (dynamic_cast<WritableStateField<std::array<float, 3>>*>(w)) e.encode = &UplinkProducer::encode_vector_field<float>;
+    else if (dynamic_cast<WritableStateField<std::array<double, 3>>*>(w)) e.encode = &UplinkProducer::encode_vector_field<double>;
+    else if (dynamic_cast<WritableStateField<Vector3f>*>(w)) e.encode = &UplinkProducer::encode_linvector_field<float>;
+    else if (dynamic_cast<WritableStateField<Vector3d>*>(w)) e.encode = &UplinkProducer::encode_linvector_field<double>;
+    else if (dynamic_cast<WritableStateField<std::array<float, 4>>*>(w)) e.encode = &UplinkProducer::encode_quat_field<float>;
+    else if (dynamic_cast<WritableStateField<std::array<double, 4>>*>(w)) e.encode = &UplinkProducer::encode_quat_field<double>;
+    else if (dynamic_cast<WritableStateField<Vector4f>*>(w)) e.encode = &UplinkProducer::encode_linquat_field<float>;
+    else if (dynamic_cast<WritableStateField<Vector4d>*>(w)) e.encode = &UplinkProducer::encode_linquat_field<double>;
+    else if (dynamic_cast<WritableStateField<gps_time_t>*>(w)) e.encode = &UplinkProducer::encode_gps_time;
+    else throw std::runtime_error("Writable field " + w->name() + " is of a type that can't be uplinked.");
+
+    return e;
+}
 
-    // If the statefield of the given underlying type doesn't exist in the registry, return 0 bits written. Otherwise, get the value of the key
-    if (!ptr) return 0;
-    UnderlyingType val = j[key];
+template<typename UnderlyingType>
+size_t UplinkProducer::encode_field(bitstream &bs, const FieldEncoder& e, const nlohmann::json& j) {
+    auto ptr = static_cast<WritableStateField<UnderlyingType>*>(e.field);
+    const std::string& key = ptr->name();
+    UnderlyingType val = j;
 
     // Check that the value specified in the JSON file is within that serializer bounds of the statefield
     UnderlyingType min = ptr->get_serializer_min();
@@ -40,29 +70,23 @@ size_t UplinkProducer::try_add_field(bitstream &bs, std::string key, nlohmann::j
 
     // Make sure the value we want to set does not exceed the max possible
     // value that the field can be set to
-    size_t field_index=field_map[key];
-    uint64_t max_val = (1ul << (get_field_length(field_index) + 1)) - 1;
+    uint64_t max_val = (1ul << (get_field_length(e.index) + 1)) - 1;
     if (static_cast<unsigned int>(val) > max_val) {
         throw std::runtime_error("cannot assign " + std::to_string(val) + " to field " + key + ". max value: " + std::to_string(max_val));
-        return false;
     }
 
     ptr->set(val);
     ptr->serialize();
 
     // Add the updated value to the bitstream
-    return add_entry(bs, ptr->get_bit_array(), field_index);
+    return add_entry(bs, ptr->get_bit_array(), e.index);
 }
 
 template<typename UnderlyingType>
-size_t UplinkProducer::try_add_vector_field(bitstream& bs, std::string key, nlohmann::json j) {
-    // Get pointer to that field in the registry
+size_t UplinkProducer::encode_vector_field(bitstream& bs, const FieldEncoder& e, const nlohmann::json& j) {
     using UnderlyingVectorType = std::array<UnderlyingType, 3>;
-    WritableStateField<UnderlyingVectorType>* ptr = dynamic_cast<WritableStateField<UnderlyingVectorType>*>(registry.find_writable_field(key));
-
-    // If the statefield of the given underlying type doesn't exist in the registry, return 0 bits written.
-    if (!ptr) return 0;
-    UnderlyingVectorType vals = j[key];
+    auto ptr = static_cast<WritableStateField<UnderlyingVectorType>*>(e.field);
+    UnderlyingVectorType vals = j;
 
     // Check that the magnitude of the values in the JSON file is within the statefield's serializer bounds
     UnderlyingType min = ptr->get_serializer_min()[0];
@@ -75,20 +99,15 @@ size_t UplinkProducer::try_add_vector_field(bitstream& bs, std::string key, nloh
     ptr->serialize();
 
     // Add the updated value to the bitstream
-    size_t field_index=field_map[key];
-    return add_entry(bs, ptr->get_bit_array(), field_index);
+    return add_entry(bs, ptr->get_bit_array(), e.index);
 }
 
 template<typename UnderlyingType>
-size_t UplinkProducer::try_add_linvector_field(bitstream& bs, std::string key, nlohmann::json j) {
-    // Get pointer to that field in the registry
+size_t UplinkProducer::encode_linvector_field(bitstream& bs, const FieldEncoder& e, const nlohmann::json& j) {
     using UnderlyingVectorType = lin::Vector<UnderlyingType, 3>;
     using UnderlyingArrayVectorType = std::array<UnderlyingType, 3>;
-    WritableStateField<UnderlyingVectorType>* ptr = dynamic_cast<WritableStateField<UnderlyingVectorType>*>(registry.find_writable_field(key));
-
-    // If the statefield of the given underlying type doesn't exist in the registry, return 0 bits written.
-    if (!ptr) return 0;
-    UnderlyingArrayVectorType vals = j[key];
+    auto ptr = static_cast<WritableStateField<UnderlyingVectorType>*>(e.field);
+    UnderlyingArrayVectorType vals = j;
 
     // Check that the magnitude of the values in the JSON file is within the statefield's serializer bounds
     UnderlyingType min = ptr->get_serializer_min()[0];
@@ -101,21 +120,16 @@ size_t UplinkProducer::try_add_linvector_field(bitstream& bs, std::string key, n
     ptr->serialize();
 
     // Add the updated value to the bitstream
-    size_t field_index=field_map[key];
-    return add_entry(bs, ptr->get_bit_array(), field_index);
+    return add_entry(bs, ptr->get_bit_array(), e.index);
 }
 
 template<typename UnderlyingType>
-size_t UplinkProducer::try_add_quat_field(bitstream& bs, std::string key, nlohmann::json j) {
-    // Get pointer to that field in the registry
+size_t UplinkProducer::encode_quat_field(bitstream& bs, const FieldEncoder& e, const nlohmann::json& j) {
     static_assert(std::is_same<UnderlyingType, double>::value || std::is_same<UnderlyingType, float>::value,
         "Can't collect quaternion field info for a vector of non-float or non-double type.");
     using UnderlyingQuatType = std::array<UnderlyingType, 4>;
-    WritableStateField<UnderlyingQuatType>* ptr = dynamic_cast<WritableStateField<UnderlyingQuatType>*>(registry.find_writable_field(key));
-
-    // If the quaternion statefield of the given underlying type doesn't exist in the registry, return 0 bits written. Otherwise, get the values of the key
-    if (!ptr) return 0;
-    std::array<UnderlyingType, 4> vals = j[key];
+    auto ptr = static_cast<WritableStateField<UnderlyingQuatType>*>(e.field);
+    UnderlyingQuatType vals = j;
 
     // Check that the magnitude of the values in the JSON file is 1 ± some margin of error
     UnderlyingType quat_mag = std::sqrt(std::pow(vals[0], 2) + std::pow(vals[1], 2) + std::pow(vals[2], 2) + std::pow(vals[3], 2));
@@ -127,22 +141,17 @@ size_t UplinkProducer::try_add_quat_field(bitstream& bs, std::string key, nlohma
     ptr->serialize();
 
     // Add the updated value to the bitstream
-    size_t field_index=field_map[key];
-    return add_entry(bs, ptr->get_bit_array(), field_index);
+    return add_entry(bs, ptr->get_bit_array(), e.index);
 }
 
 template<typename UnderlyingType>
-size_t UplinkProducer::try_add_linquat_field(bitstream& bs, std::string key, nlohmann::json j) {
-    // Get pointer to that field in the registry
+size_t UplinkProducer::encode_linquat_field(bitstream& bs, const FieldEncoder& e, const nlohmann::json& j) {
     static_assert(std::is_same<UnderlyingType, double>::value || std::is_same<UnderlyingType, float>::value,
         "Can't collect quaternion field info for a vector of non-float or non-double type.");
     using UnderlyingQuatType = lin::Vector<UnderlyingType, 4>;
     using UnderlyingArrayQuatType = std::array<UnderlyingType, 4>;
-    WritableStateField<UnderlyingQuatType>* ptr = dynamic_cast<WritableStateField<UnderlyingQuatType>*>(registry.find_writable_field(key));
-
-    // If the quaternion statefield of the given underlying type doesn't exist in the registry, return 0 bits written. Otherwise, get the values of the key
-    if (!ptr) return 0;
-    UnderlyingArrayQuatType vals = j[key];
+    auto ptr = static_cast<WritableStateField<UnderlyingQuatType>*>(e.field);
+    UnderlyingArrayQuatType vals = j;
 
     // Check that the magnitude of the values in the JSON file is 1 ± some margin of error
     UnderlyingType quat_mag = std::sqrt(std::pow(vals[0], 2) + std::pow(vals[1], 2) + std::pow(vals[2], 2) + std::pow(vals[3], 2));
@@ -154,48 +163,30 @@ size_t UplinkProducer::try_add_linquat_field(bitstream& bs, std::string key, nlo
     ptr->serialize();
 
     // Add the updated value to the bitstream
-    size_t field_index=field_map[key];
-    return add_entry(bs, ptr->get_bit_array(), field_index);
+    return add_entry(bs, ptr->get_bit_array(), e.index);
 }
 
-size_t UplinkProducer::try_add_gps_time(bitstream& bs, std::string key, nlohmann::json j) {
-    // Get pointer to that field in the registry
-    WritableStateField<gps_time_t>* ptr = dynamic_cast<WritableStateField<gps_time_t>*>(registry.find_writable_field(key));
-
-    // If the time statefield doesn't exist in the registry, return 0 bits written. Otherwise, get the values of the key
-    if (!ptr) return 0;
-    unsigned short wn = j[key][0];
-    unsigned int tow = j[key][1];
-    unsigned long ns = j[key][2];
+size_t UplinkProducer::encode_gps_time(bitstream& bs, const FieldEncoder& e, const nlohmann::json& j) {
+    auto ptr = static_cast<WritableStateField<gps_time_t>*>(e.field);
+    unsigned short wn = j[0];
+    unsigned int tow = j[1];
+    unsigned long ns = j[2];
 
     // Set the statefield pointer to the new time.
     ptr->set(gps_time_t(wn,tow,ns));
     ptr->serialize();
 
     // Add the updated value to the bitstream
-    size_t field_index=field_map[key];
-    return add_entry(bs, ptr->get_bit_array(), field_index);
+    return add_entry(bs, ptr->get_bit_array(), e.index);
 }
 
-size_t UplinkProducer::add_field_to_bitstream(bitstream& bs, std::string key, nlohmann::json j) {
-    size_t bits_written = 0;
-    bits_written += try_add_field<unsigned int>(bs, key, j);
-    bits_written += try_add_field<signed int>(bs, key, j);
-    bits_written += try_add_field<unsigned char>(bs, key, j);
-    bits_written += try_add_field<signed char>(bs, key, j);
-    bits_written += try_add_field<float>(bs, key, j);
-    bits_written += try_add_field<double>(bs, key, j);
-    bits_written += try_add_field<bool>(bs, key, j);
-    bits_written += try_add_vector_field<float>(bs, key, j);
-    bits_written += try_add_vector_field<double>(bs, key, j);
-    bits_written += try_add_linvector_field<float>(bs, key, j);
-    bits_written += try_add_linvector_field<double>(bs, key, j);
-    bits_written += try_add_quat_field<float>(bs, key, j);
-    bits_written += try_add_quat_field<double>(bs, key, j);
-    bits_written += try_add_linquat_field<float>(bs, key, j);
-    bits_written += try_add_linquat_field<double>(bs, key, j);
-    bits_written += try_add_gps_time(bs, key, j);
-    return bits_written;
+size_t UplinkProducer::add_field_to_bitstream(bitstream& bs, const std::string& key, const nlohmann::json& val) {
+    auto it = field_map.find(key);
+    if (it == field_map.end())
+        throw std::runtime_error("field map key not found: " + key);
+
+    const FieldEncoder& e = encoders[it->second];
+    return (this->*e.encode)(bs, e, val);
 }
 
 void UplinkProducer::create_from_json(bitstream& bs, const std::string& filename)
@@ -206,21 +197,23 @@ void UplinkProducer::create_from_json(bitstream& bs, const std::string& filename
         fs >> j;
         fs.close();
 
+        create_from_json_object(bs, j);
+ }
+
+void UplinkProducer::create_from_json_object(bitstream& bs, const nlohmann::json& commands)
+ {
         // Start writing at the beginning of the bitstream
         bs.reset();
         memset(bs.stream, 0, bs.max_len);
         
-        for (auto& e : j.items())
+        for (auto& e : commands.items())
         {
             if (!bs.has_next())
                 throw std::runtime_error("bitstream is not large enough");
 
-            // Check whether the requested field exists
-            std::string key = e.key();
-            if (field_map.find(key) == field_map.end())
-                throw std::runtime_error("field map key not found: " + key);
-
-            size_t bits_written = add_field_to_bitstream(bs, key, j);
+            // Look up the field's encoder and add its value to the bitstream
+            const std::string& key = e.key();
+            size_t bits_written = add_field_to_bitstream(bs, key, e.value());
 
             if (bits_written == 0) 
                 throw std::runtime_error("Unable to find write " + key + " to bitstream.");
@@ -232,6 +225,140 @@ void UplinkProducer::create_from_json(bitstream& bs, const std::string& filename
     bs.reset();
  }
 
+std::string UplinkProducer::create_packet(const nlohmann::json& commands)
+{
+    bitstream bs(packet_buffer.data(), packet_buffer.size());
+    create_from_json_object(bs, commands);
+
+    if (bs.max_len > QuakeManager::packet_size)
+        throw std::runtime_error("uplink packet of " + std::to_string(bs.max_len) +
+            " bytes does not fit in an MT message of " + std::to_string(QuakeManager::packet_size) + " bytes");
+    if (!_validate_packet(bs))
+        throw std::runtime_error("Uplink Producer: Packet you created is not valid");
+
+    return std::string(packet_buffer.data(), bs.max_len);
+}
+
+std::vector<std::string> UplinkProducer::create_packets(const nlohmann::json& commands,
+    const std::vector<std::vector<std::string>>& groups)
+{
+    // Collect the field writes into items that must share a packet
+    std::unordered_map<std::string, size_t> item_of;
+    std::vector<std::vector<std::string>> items;
+    for (const auto& group : groups) {
+        std::vector<std::string> item;
+        for (const std::string& key : group) {
+            if (!commands.contains(key)) continue;
+            if (!item_of.emplace(key, items.size()).second)
+                throw std::runtime_error("field " + key + " appears in more than one group");
+            item.push_back(key);
+        }
+        if (!item.empty()) items.push_back(std::move(item));
+    }
+    for (auto& e : commands.items()) {
+        if (item_of.count(e.key())) continue;
+        item_of.emplace(e.key(), items.size());
+        items.push_back({e.key()});
+    }
+
+    // Size each item by the index/field-length layout of the packet
+    const size_t capacity = 8 * QuakeManager::packet_size;
+    std::vector<size_t> sizes;
+    sizes.reserve(items.size());
+    for (const auto& item : items) {
+        size_t size = 0;
+        for (const std::string& key : item) {
+            auto it = field_map.find(key);
+            if (it == field_map.end())
+                throw std::runtime_error("field map key not found: " + key);
+            size += index_size + get_field_length(it->second);
+        }
+        if (size > capacity)
+            throw std::runtime_error("fields grouped with " + item[0] + " do not fit in a single MT message");
+        sizes.push_back(size);
+    }
+
+    // Assign the items to packets and encode each packet
+    const std::vector<size_t> bins = pack_bins(sizes, capacity);
+    const size_t num_packets = bins.empty() ? 0 : *std::max_element(bins.begin(), bins.end()) + 1;
+    std::vector<nlohmann::json> packet_commands(num_packets, nlohmann::json::object());
+    for (size_t i = 0; i < items.size(); ++i) {
+        for (const std::string& key : items[i])
+            packet_commands[bins[i]][key] = commands[key];
+    }
+
+    std::vector<std::string> packets;
+    packets.reserve(num_packets);
+    for (const nlohmann::json& c : packet_commands)
+        packets.push_back(create_packet(c));
+    return packets;
+}
+
+/**
+ * Tries to assign the items in order[pos:] to the bins without exceeding
+ * their capacity. Bins with equal loads are interchangeable, so only the
+ * first of them is tried for each item.
+ */
+static bool fill_bins(const std::vector<size_t>& order, const std::vector<size_t>& sizes,
+    const std::vector<size_t>& remaining, size_t capacity, size_t pos,
+    std::vector<size_t>& bins, std::vector<size_t>& loads, size_t& budget)
+{
+    if (pos == order.size()) return true;
+    if (budget == 0) return false;
+    --budget;
+
+    // Give up if the remaining items can't fit in the free space
+    size_t free_space = 0;
+    for (size_t load : loads) free_space += capacity - load;
+    if (remaining[pos] > free_space) return false;
+
+    const size_t item = order[pos];
+    for (size_t j = 0; j < loads.size(); ++j) {
+        if (loads[j] + sizes[item] > capacity) continue;
+        if (std::find(loads.begin(), loads.begin() + j, loads[j]) != loads.begin() + j) continue;
+
+        loads[j] += sizes[item];
+        bins[item] = j;
+        if (fill_bins(order, sizes, remaining, capacity, pos + 1, bins, loads, budget)) return true;
+        loads[j] -= sizes[item];
+    }
+    return false;
+}
+
+std::vector<size_t> UplinkProducer::pack_bins(const std::vector<size_t>& sizes, size_t capacity)
+{
+    // Maximum number of search nodes spent on trying to beat first fit
+    static constexpr size_t max_search_nodes = 100000;
+
+    const size_t n = sizes.size();
+    std::vector<size_t> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+        [&sizes](size_t a, size_t b) { return sizes[a] > sizes[b]; });
+
+    // First fit decreasing gives an upper bound on the number of bins
+    std::vector<size_t> bins(n), loads;
+    for (size_t item : order) {
+        size_t j = 0;
+        while (j < loads.size() && loads[j] + sizes[item] > capacity) ++j;
+        if (j == loads.size()) loads.push_back(0);
+        loads[j] += sizes[item];
+        bins[item] = j;
+    }
+
+    // Search for an assignment to fewer bins, starting from the lower bound
+    // given by the total size of the items
+    std::vector<size_t> remaining(n + 1, 0);
+    for (size_t pos = n; pos > 0; --pos) remaining[pos - 1] = remaining[pos] + sizes[order[pos - 1]];
+    size_t budget = max_search_nodes;
+    for (size_t k = (remaining[0] + capacity - 1) / capacity; k < loads.size() && budget > 0; ++k) {
+        std::vector<size_t> trial_bins(n), trial_loads(k, 0);
+        if (fill_bins(order, sizes, remaining, capacity, 0, trial_bins, trial_loads, budget))
+            return trial_bins;
+    }
+    return bins;
+}
+
 size_t UplinkProducer::add_entry(bitstream& bs, const bit_array& val, size_t index)
 {
     size_t bits_written = 0;
@@ -303,9 +430,7 @@ const size_t UplinkProducer::get_max_possible_packet_size()
  {
     try
     {
-        size_t arr_size = get_max_possible_packet_size();
-        char tmp [arr_size];
-        bitstream bs(tmp, arr_size);
+        bitstream bs(packet_buffer.data(), packet_buffer.size());
         create_from_json(bs, json_file);
         to_file(bs, dst_file);
     }
@@ -2,7 +2,8 @@
 
 #include <fsw/FCCode/MainControlLoop.hpp>
 #include <fsw/FCCode/UplinkCommon.h>
-#include <map>
+#include <unordered_map>
+#include <vector>
 #include <json.hpp>
 
 /**
@@ -24,6 +25,42 @@ class UplinkProducer : public Uplink{
      */
     void create_from_json(bitstream& bs, const std::string& filename);
 
+    /**
+     * Creates an UplinkPacket from an already parsed json object that maps
+     * field names to values
+     * Discards any old data in the packet and overwrites with data in commands
+     * @throw runtime_error if a field can't be written to the packet
+     */
+    void create_from_json_object(bitstream& bs, const nlohmann::json& commands);
+
+    /**
+     * Creates and verifies an uplink packet from a parsed json object, without
+     * going through the filesystem. The packet is assembled in a buffer owned
+     * by the producer, so repeated calls don't allocate a new stream.
+     * @throw runtime_error if the packet is invalid or doesn't fit in a single
+     * MT message
+     * @return the bytes of the packet
+     */
+    std::string create_packet(const nlohmann::json& commands);
+
+    /**
+     * Compiles an arbitrary set of field writes into the smallest number of
+     * uplink packets that each fit in a single MT message.
+     *
+     * Fields listed together in one of the groups are always placed in the
+     * same packet, e.g. so that a command and its parameters take effect in
+     * the same control cycle. Fields that aren't in any group may be placed in
+     * any packet.
+     *
+     * @param commands json object that maps field names to values
+     * @param groups lists of field names that must share a packet
+     * @throw runtime_error if a field can't be written, a field appears in
+     * more than one group, or a group doesn't fit in a single MT message
+     * @return the bytes of each packet
+     */
+    std::vector<std::string> create_packets(const nlohmann::json& commands,
+        const std::vector<std::vector<std::string>>& groups = {});
+
     /**
      * Prints the UplinkPacket to STDOUT
      */
@@ -47,74 +84,82 @@ class UplinkProducer : public Uplink{
     const size_t get_max_possible_packet_size();
 
     /**
-     * Helper function for add_field_to_bitstream.
-     * Check that the field/key of a given type is in the statefield registry.
-     * If it is, add the value of the field/key to the bitstream
+     * Encodes the value of a single field and adds it to the bitstream.
+     * @param key Name of the field
+     * @param val Value of the field, as specified in the uplink JSON
+     * @throw runtime_error if the field is not writable or the value is out of bounds
+     * @return number of bits written if successful
      */
-    template<typename UnderlyingType>
-    size_t try_add_field(bitstream& bs, std::string key, nlohmann::json j);
+    size_t add_field_to_bitstream(bitstream& bs, const std::string& key, const nlohmann::json& val);
 
-    /**
-     * Helper function for add_field_to_bitstream.
-     * Check that the vector statefield of a given type is in the statefield registry.
-     * If it is, add the value of the field/key to the bitstream
-     */
-    template<typename UnderlyingType>
-    size_t try_add_vector_field(bitstream& bs, std::string key, nlohmann::json j);
+#ifndef DEBUG
+  private:
+#endif
 
     /**
-     * Helper function for add_field_to_bitstream.
-     * Check that the vector statefield of a given type is in the statefield registry.
-     * If it is, add the value of the field/key to the bitstream
-     */
-    template<typename UnderlyingType>
-    size_t try_add_linvector_field(bitstream& bs, std::string key, nlohmann::json j);
+     * Add an entry to the bitstream
+     * @throw runtime_error if invalid index is specified
+     * @return the number of bits written
+     */ 
+    size_t add_entry(bitstream& bs, const bit_array& val, size_t index);
 
     /**
-     * Helper function for add_field_to_bitstream.
-     * Check that the quaternion statefield of a given type is in the statefield registry.
-     * If it is, add the value of the field/key to the bitstream
+     * Assigns items of the given sizes to the smallest number of bins of the
+     * given capacity that the search can find within its node budget.
+     * Items must be no larger than the capacity.
+     * @return the bin of each item
      */
-    template<typename UnderlyingType>
-    size_t try_add_quat_field(bitstream& bs, std::string key, nlohmann::json j);
+    static std::vector<size_t> pack_bins(const std::vector<size_t>& sizes, size_t capacity);
 
     /**
-     * Helper function for add_field_to_bitstream.
-     * Check that the quaternion statefield of a given type is in the statefield registry.
-     * If it is, add the value of the field/key to the bitstream
+     * Encoder for a single writable field, built once at construction so that
+     * each uplinked value costs one name lookup and one typed encode.
      */
-    template<typename UnderlyingType>
-    size_t try_add_linquat_field(bitstream& bs, std::string key, nlohmann::json j);
+    struct FieldEncoder {
+        //! Field, with its type already resolved by the encode function.
+        WritableStateFieldBase* field;
 
-    /**
-     * Helper function for add_field_to_bitstream.
-     * Check that the time statefield of a given type is in the statefield registry.
-     * If it is, add the value of the field/key to the bitstream
-     */
-    size_t try_add_gps_time(bitstream& bs, std::string key, nlohmann::json j);
+        //! Index of the field in registry.writable_fields.
+        size_t index;
+
+        //! Encodes a JSON value into the field and adds it to the bitstream.
+        size_t (UplinkProducer::*encode)(bitstream& bs, const FieldEncoder& e,
+            const nlohmann::json& val);
+    };
 
     /**
-     * Check that a field is in the registry. If it is, add the value to the bitstream.
-     * @return number of bits written if successful
+     * Select the encode function for a field based on its type.
+     * @throw runtime_error if the field is of an unsupported type
      */
-    size_t add_field_to_bitstream(bitstream& bs, std::string key, nlohmann::json j);
-
-#ifndef DEBUG
-  private:
-#endif
+    FieldEncoder make_encoder(WritableStateFieldBase* field, size_t index);
 
     /**
-     * Add an entry to the bitstream
-     * @throw runtime_error if invalid index is specified
-     * @return the number of bits written
-     */ 
-    size_t add_entry(bitstream& bs, const bit_array& val, size_t index);
+     * Typed encode functions. The field of the encoder is guaranteed to be of
+     * the matching type by make_encoder.
+     */
+    template<typename UnderlyingType>
+    size_t encode_field(bitstream& bs, const FieldEncoder& e, const nlohmann::json& val);
+    template<typename UnderlyingType>
+    size_t encode_vector_field(bitstream& bs, const FieldEncoder& e, const nlohmann::json& val);
+    template<typename UnderlyingType>
+    size_t encode_linvector_field(bitstream& bs, const FieldEncoder& e, const nlohmann::json& val);
+    template<typename UnderlyingType>
+    size_t encode_quat_field(bitstream& bs, const FieldEncoder& e, const nlohmann::json& val);
+    template<typename UnderlyingType>
+    size_t encode_linquat_field(bitstream& bs, const FieldEncoder& e, const nlohmann::json& val);
+    size_t encode_gps_time(bitstream& bs, const FieldEncoder& e, const nlohmann::json& val);
 
     MainControlLoop fcp;
 
     // maps field names to indices
-    std::map<std::string, size_t> field_map;
+    std::unordered_map<std::string, size_t> field_map;
+
+    // encoders of the writable fields, in the same order as registry.writable_fields
+    std::vector<FieldEncoder> encoders;
 
     size_t max_possible_packet_size;
 
+    // Buffer that create_packet assembles packets in
+    std::vector<char> packet_buffer;
+
 };
@@ -1,5 +1,6 @@
 #include <gsw/parsers/src/DownlinkParser.hpp>
 #include <flow_data.hpp>
+#include <telemetry_model.hpp>
 #include <iostream>
 #include <chrono>
 #include <thread>
@@ -7,7 +8,7 @@
 #ifndef UNIT_TEST
 int main() {
     StateFieldRegistry reg;
-    DownlinkParser dp(reg, PAN::flow_data);
+    DownlinkParser dp(reg, PAN::flow_data, PAN::telemetry_model);
     std::string filename;
     while(true) {
         std::getline(std::cin, filename);
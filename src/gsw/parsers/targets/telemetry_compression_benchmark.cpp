@@ -0,0 +1,159 @@
+#include <gsw/parsers/src/DownlinkParser.hpp>
+#include <flow_data.hpp>
+#include <telemetry_model.hpp>
+#include <json.hpp>
+#include <chrono>
+#include <iostream>
+#include <map>
+
+/**
+ * Trains the telemetry compression model on recorded downlink snapshots and
+ * benchmarks the Downlink Producer with the trained model.
+ *
+ * Usage: telemetry_compression_benchmark <snapshot files...>
+ *
+ * Each file must contain a complete downlink snapshot, as written by the
+ * radio session logs. The tool prints a JSON object containing the trained
+ * model, which can be pasted into src/telemetry_model.cpp, along with the
+ * compression ratio and the producer's execution time with and without
+ * compression.
+ *
+ * The execution times are measured on the host. Flash the
+ * fsw_teensy36_compression_bench environment to measure them on the flight
+ * computer.
+ */
+
+using json = nlohmann::json;
+
+// Serialized bits of each field found in a parsed snapshot.
+using RecordedSnapshot = std::map<std::string, std::vector<bool>>;
+
+/**
+ * @brief Downlink parser that exposes the fields of the most recently parsed
+ * snapshot.
+ */
+class RecordingParser : public DownlinkParser {
+  public:
+    using DownlinkParser::DownlinkParser;
+
+    bool record(const std::string& filename, RecordedSnapshot& snapshot) {
+        const json parsed = json::parse(process_downlink_file(filename));
+        if (parsed["metadata"]["error"] != false || !parsed.contains("data")) return false;
+
+        for (auto& entry : parsed["data"].items()) {
+            ReadableStateFieldBase* field = registry.find_readable_field(entry.key());
+            if (!field || entry.key() == "pan.cycle_no") continue;
+            const bit_array& bits = field->get_bit_array();
+            snapshot[entry.key()] = std::vector<bool>(bits.begin(), bits.end());
+        }
+        return true;
+    }
+};
+
+static unsigned long long to_code(const std::vector<bool>& bits) {
+    unsigned long long code = 0;
+    for (size_t i = 0; i < bits.size(); i++) code |= static_cast<unsigned long long>(bits[i]) << i;
+    return code;
+}
+
+/**
+ * @brief Replays the recorded snapshots through the producer and collects the
+ * snapshot sizes and execution times.
+ */
+static json run_producer(StateFieldRegistry& r, DownlinkProducer* producer,
+    const std::vector<RecordedSnapshot>& snapshots, const bool compress)
+{
+    WritableStateField<bool>* compress_fp =
+        static_cast<WritableStateField<bool>*>(r.find_writable_field("downlink.compress"));
+    InternalStateField<size_t>* snap_size_fp =
+        static_cast<InternalStateField<size_t>*>(r.find_internal_field("downlink.snap_size"));
+    compress_fp->set(compress);
+
+    unsigned long long total_bytes = 0;
+    double total_us = 0, max_us = 0;
+    for (const RecordedSnapshot& snapshot : snapshots) {
+        for (const auto& field_bits : snapshot) {
+            ReadableStateFieldBase* field = r.find_readable_field(field_bits.first);
+            if (!field) continue;
+            field->set_bit_array(field_bits.second);
+            field->deserialize();
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        producer->execute();
+        const auto end = std::chrono::steady_clock::now();
+
+        const double us = std::chrono::duration<double, std::micro>(end - start).count();
+        total_us += us;
+        if (us > max_us) max_us = us;
+        total_bytes += snap_size_fp->get();
+    }
+
+    json ret;
+    ret["mean_snap_size"] = static_cast<double>(total_bytes) / snapshots.size();
+    ret["mean_execute_us"] = total_us / snapshots.size();
+    ret["max_execute_us"] = max_us;
+    return ret;
+}
+
+#ifndef UNIT_TEST
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cout << "Need to specify at least one snapshot file." << std::endl;
+        return 1;
+    }
+
+    // Parse the recorded snapshots using the currently deployed model.
+    StateFieldRegistry parser_registry;
+    RecordingParser parser(parser_registry, PAN::flow_data, PAN::telemetry_model);
+    std::vector<RecordedSnapshot> snapshots;
+    for (int i = 1; i < argc; i++) {
+        RecordedSnapshot snapshot;
+        if (parser.record(argv[i], snapshot)) snapshots.push_back(std::move(snapshot));
+        else std::cerr << "Skipping unparseable snapshot " << argv[i] << std::endl;
+    }
+    if (snapshots.empty()) {
+        std::cout << "No parseable snapshots." << std::endl;
+        return 1;
+    }
+
+    // Fit a model entry to every field narrow enough to be modeled.
+    std::map<std::string, std::pair<size_t, std::vector<unsigned long long>>> codes;
+    for (const RecordedSnapshot& snapshot : snapshots) {
+        for (const auto& field_bits : snapshot) {
+            if (field_bits.second.size() > TelemetryCompressor::max_field_bits) continue;
+            auto& samples = codes[field_bits.first];
+            samples.first = field_bits.second.size();
+            samples.second.push_back(to_code(field_bits.second));
+        }
+    }
+
+    std::vector<TelemetryCompressor::FieldModel> model;
+    for (const auto& samples : codes) {
+        TelemetryCompressor::FieldModel m;
+        if (TelemetryCompressor::train(samples.first, samples.second.first,
+                samples.second.second, &m))
+            model.push_back(m);
+    }
+
+    // Benchmark the producer with the trained model.
+    StateFieldRegistry bench_registry;
+    MainControlLoop fcp(bench_registry, PAN::flow_data, model);
+    DownlinkProducer* producer = fcp.get_downlink_producer();
+
+    json ret;
+    ret["snapshots"] = snapshots.size();
+    ret["raw"] = run_producer(bench_registry, producer, snapshots, false);
+    ret["compressed"] = run_producer(bench_registry, producer, snapshots, true);
+    ret["compression_ratio"] =
+        ret["raw"]["mean_snap_size"].get<double>() / ret["compressed"]["mean_snap_size"].get<double>();
+
+    ret["model"] = json::array();
+    for (const TelemetryCompressor::FieldModel& m : producer->get_compressor().get_model()) {
+        ret["model"].push_back({{"name", m.name}, {"reference", m.reference}, {"k", m.k}});
+    }
+
+    std::cout << ret.dump(4) << std::endl;
+    return 0;
+}
+#endif
@@ -1,39 +1,113 @@
 #include <gsw/parsers/src/UplinkProducer.h>
 #include <flow_data.hpp>
 #include <iostream>
-#include <chrono>
-#include <thread>
 #include <json.hpp>
 #include <fstream>
+#include <cstring>
 
-#ifndef UNIT_TEST
-int main() {
-    StateFieldRegistry reg;
-    UplinkProducer producer(reg);
+/**
+ * Creates uplink packets from JSON descriptions of field writes.
+ *
+ * Usage: uplink_producer [--server]
+ *
+ * By default, the producer reads pairs of lines from stdin: the name of a
+ * JSON file containing the field writes, and the name of the SBD file to write
+ * the packet to. It responds to each pair with a JSON status line.
+ *
+ * With --server, the producer instead reads one JSON object of field writes per
+ * line of stdin and responds to each with a single line on stdout, containing
+ * either the hex-encoded packet or an error:
+ *
+ *   {"adcs.state": 3}  -->  {"packet":"<hex bytes>","size":<bytes>}
+ *                      -->  {"error":"<reason>"}
+ *
+ * A line may instead ask for a set of field writes to be split over as few
+ * MT messages as possible, optionally keeping groups of fields together:
+ *
+ *   {"fields": {...}, "groups": [["a", "b"], ...]}
+ *                      -->  {"packets":["<hex bytes>", ...]}
+ *
+ * No files are touched in server mode, so a single producer process can serve
+ * many uplinks per second.
+ */
+
+using json = nlohmann::json;
+
+static std::string to_hex(const std::string& bytes) {
+    static const char digits[] = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(2 * bytes.size());
+    for (unsigned char c : bytes) {
+        hex.push_back(digits[c >> 4]);
+        hex.push_back(digits[c & 0xf]);
+    }
+    return hex;
+}
+
+static void serve(UplinkProducer& producer) {
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        if (line.empty()) continue;
+
+        json response;
+        try {
+            const json request = json::parse(line);
+            if (request.contains("fields") && request["fields"].is_object()) {
+                std::vector<std::vector<std::string>> groups;
+                if (request.contains("groups")) groups = request["groups"].get<std::vector<std::vector<std::string>>>();
+                response["packets"] = json::array();
+                for (const std::string& packet : producer.create_packets(request["fields"], groups))
+                    response["packets"].push_back(to_hex(packet));
+            }
+            else {
+                const std::string packet = producer.create_packet(request);
+                response["packet"] = to_hex(packet);
+                response["size"] = packet.size();
+            }
+        }
+        catch (const std::exception& e) {
+            response["error"] = e.what();
+        }
+        std::cout << response.dump() << std::endl;
+    }
+}
+
+static void serve_files(UplinkProducer& producer) {
     std::string json_filename;
     std::string uplink_packet_filename;
 
-    while(true) {
-        std::getline(std::cin, json_filename);
-        std::getline(std::cin, uplink_packet_filename);
-        
+    while (std::getline(std::cin, json_filename) && std::getline(std::cin, uplink_packet_filename)) {
         std::ifstream fs (json_filename);
-        if (fs) {
-            char packet[70];
-            bitstream bs(packet, 70);
-            try {
-                producer.create_from_json(bs, json_filename);
-                producer.to_file(bs, uplink_packet_filename);
-                std::cout << "{\"status\":\"success\"}";
-            }
-            catch (const std::exception& e) {
-                std::cout << "{\"error\":\"";
-                std::cout << e.what();
-                std::cout << "\"}";
-            }
+        if (!fs) {
+            json response;
+            response["error"] = "Unable to open " + json_filename;
+            std::cout << response.dump() << std::endl;
+            continue;
         }
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        try {
+            json commands;
+            fs >> commands;
+            const std::string packet = producer.create_packet(commands);
+            std::ofstream new_file (uplink_packet_filename, std::ios::out | std::ios::binary);
+            new_file.write(packet.data(), packet.size());
+            std::cout << "{\"status\":\"success\"}" << std::endl;
+        }
+        catch (const std::exception& e) {
+            json response;
+            response["error"] = e.what();
+            std::cout << response.dump() << std::endl;
+        }
     }
 }
+
+#ifndef UNIT_TEST
+int main(int argc, char* argv[]) {
+    StateFieldRegistry reg;
+    UplinkProducer producer(reg);
+
+    if (argc > 1 && std::strcmp(argv[1], "--server") == 0) serve(producer);
+    else serve_files(producer);
+    return 0;
+}
 #endif
@@ -0,0 +1,16 @@
+/**
+ * Ground-trained model used to compress downlink snapshots.
+ *
+ * Regenerate this table by running the gsw_telemetry_compression_benchmark
+ * target over a set of recorded downlink snapshots and pasting the "model"
+ * entries it prints. Fields that are not listed here are always downlinked
+ * uncompressed.
+ *
+ * The table is currently empty, so snapshot compression is off regardless of
+ * downlink.compress.
+ */
+
+#include "telemetry_model.hpp"
+
+const std::vector<TelemetryCompressor::FieldModel> PAN::telemetry_model = {
+};
@@ -0,0 +1,10 @@
+#ifndef telemetry_model_hpp_
+#define telemetry_model_hpp_
+
+#include <fsw/FCCode/TelemetryCompressor.hpp>
+
+namespace PAN {
+    extern const std::vector<TelemetryCompressor::FieldModel> telemetry_model;
+}
+
+#endif
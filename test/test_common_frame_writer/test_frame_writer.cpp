@@ -0,0 +1,150 @@
+#include "../custom_assertions.hpp"
+#include <common/FrameWriter.hpp>
+#include <common/fixed_array.hpp>
+#include <common/Serializer.hpp>
+#include <common/StaticSerializer.hpp>
+#include <common/StateField.hpp>
+#include <cstring>
+
+void test_write_codes() {
+    char frame[6];
+    memset(frame, '\xff', sizeof(frame));
+
+    FrameWriter writer(frame, 560);
+    writer.start_frame();
+    TEST_ASSERT_EQUAL(1, writer.offset());
+
+    // Codes are written LSB first; 20 = 0b10100
+    writer.write(20, 32);
+    writer.write(1, 1);
+    writer.write(400, 9);
+    TEST_ASSERT_EQUAL(43, writer.offset());
+    writer.finish();
+    TEST_ASSERT_EQUAL(48, writer.offset());
+    TEST_ASSERT_EQUAL(6, writer.size_bytes());
+
+    const char expected[6] = {'\x94', '\x00', '\x00', '\x00', '\x42', '\x60'};
+    TEST_ASSERT_EQUAL_MEMORY(expected, frame, 6);
+}
+
+void test_write_bit_array() {
+    char frame1[3] = {0};
+    char frame2[3] = {0};
+
+    bit_array bits(17);
+    bits.set_ullong(0x1a5a5);
+
+    FrameWriter writer1(frame1, 560);
+    writer1.start_frame();
+    writer1.write(bits);
+    writer1.finish();
+
+    FrameWriter writer2(frame2, 560);
+    writer2.start_frame();
+    writer2.write(bits.to_ullong(), bits.size());
+    writer2.finish();
+
+    TEST_ASSERT_EQUAL_MEMORY(frame1, frame2, 3);
+}
+
+void test_packet_boundary() {
+    char frame[4];
+    memset(frame, '\xff', sizeof(frame));
+
+    // Packets of 16 bits, including the header bit.
+    FrameWriter writer(frame, 16);
+    writer.start_frame();
+    writer.write(0xfffff, 20);
+    TEST_ASSERT_EQUAL(22, writer.offset());
+    writer.finish();
+
+    // 1 header bit and 15 bits of the value, then a continuation header bit
+    // and the 5 remaining bits of the value. The last byte is untouched.
+    const char expected[4] = {'\xff', '\xff', '\x7c', '\xff'};
+    TEST_ASSERT_EQUAL_MEMORY(expected, frame, 4);
+
+    // A value that ends exactly on a packet boundary doesn't start a new
+    // packet until something else is written.
+    writer.start_frame();
+    writer.write(0, 15);
+    TEST_ASSERT_EQUAL(16, writer.offset());
+    writer.write(1, 1);
+    TEST_ASSERT_EQUAL(18, writer.offset());
+    writer.finish();
+
+    const char expected2[3] = {'\x80', '\x00', '\x40'};
+    TEST_ASSERT_EQUAL_MEMORY(expected2, frame, 3);
+}
+
+// Serializing into a frame leaves the serializer's bit array as serialize()
+// would, and writes that bit array into the frame.
+template <typename T>
+static void check_serialize_into(Serializer<T>& s, const T& val) {
+    char frame[64] = {0};
+    FrameWriter writer(frame, 560);
+    writer.start_frame();
+    s.serialize_into(val, writer);
+    writer.finish();
+    const bit_array into_bits = s.get_bit_array();
+
+    s.set_bit_array(bit_array(s.bitsize()));
+    s.serialize(val);
+    TEST_ASSERT_TRUE(into_bits == s.get_bit_array());
+
+    char expected[64] = {0};
+    FrameWriter expected_writer(expected, 560);
+    expected_writer.start_frame();
+    expected_writer.write(s.get_bit_array());
+    expected_writer.finish();
+    TEST_ASSERT_EQUAL_MEMORY(expected, frame, sizeof(frame));
+}
+
+void test_serialize_into_updates_bit_array() {
+    Serializer<bool> bool_s;
+    check_serialize_into(bool_s, true);
+    Serializer<unsigned int> uint_s(0, 1000, 10);
+    check_serialize_into(uint_s, 777u);
+    Serializer<signed char> char_s(-100, 100, 8);
+    check_serialize_into<signed char>(char_s, -37);
+    Serializer<float> float_s(0, 180, 16);
+    check_serialize_into(float_s, 91.3f);
+    Serializer<double> double_s(-5, 5, 20);
+    check_serialize_into(double_s, 1.234);
+    Serializer<std::array<double, 3>> vec_s(0, 10, 30);
+    check_serialize_into(vec_s, std::array<double, 3>{{1.0, -2.0, 3.0}});
+    Serializer<std::array<float, 4>> quat_s;
+    check_serialize_into(quat_s, std::array<float, 4>{{0.5f, 0.5f, -0.5f, 0.5f}});
+
+    StaticReadableStateField<StaticSerializer<float, 0, 180, 16>> field("foo");
+    field.set(91.3f);
+    char frame[4] = {0};
+    FrameWriter writer(frame, 560);
+    writer.start_frame();
+    field.serialize_into(writer);
+    TEST_ASSERT_TRUE(float_s.get_bit_array() == field.get_bit_array());
+}
+
+void test_frame_writer() {
+    UNITY_BEGIN();
+    RUN_TEST(test_write_codes);
+    RUN_TEST(test_write_bit_array);
+    RUN_TEST(test_packet_boundary);
+    RUN_TEST(test_serialize_into_updates_bit_array);
+    UNITY_END();
+}
+
+#ifdef DESKTOP
+int main(int argc, char *argv[]) {
+    test_frame_writer();
+    return 0;
+}
+#else
+#include <Arduino.h>
+void setup() {
+    delay(10000);
+    Serial.begin(9600);
+    test_frame_writer();
+}
+
+void loop() {}
+#endif
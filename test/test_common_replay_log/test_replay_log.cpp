@@ -0,0 +1,112 @@
+#include "../StateFieldRegistryMock.hpp"
+#include "../custom_assertions.hpp"
+
+#ifdef DESKTOP
+#include <common/ReplayLog.hpp>
+#include <cstdio>
+
+static const char* log_path = "replay_log_test.bin";
+
+/**
+ * @brief Records a short run: one boot input, then three control cycles with
+ * clock readings and console lines. A checkpoint is written every two cycles.
+ */
+static void record_run(StateFieldRegistryMock& registry,
+    std::shared_ptr<ReadableStateField<unsigned int>>& field_fp)
+{
+    ReplayLog::record(log_path, 2);
+
+    unsigned int boot_input = 42;
+    ReplayLog::input(&boot_input, sizeof(boot_input));
+
+    for (unsigned int ccno = 0; ccno < 3; ccno++) {
+        field_fp->set(100 + ccno);
+        ReplayLog::start_cycle(registry, ccno);
+
+        TEST_ASSERT_EQUAL(1000000 + 500 * ccno, ReplayLog::clock_us(1000000 + 500 * ccno));
+        std::string line = "{\"cycle\":" + std::to_string(ccno) + "}";
+        TEST_ASSERT_TRUE(ReplayLog::console_line(line, true));
+        TEST_ASSERT_FALSE(ReplayLog::console_line(line, false));
+    }
+
+    // Flush the last cycle
+    unsigned int ccno = 3;
+    ReplayLog::start_cycle(registry, ccno);
+}
+
+void test_replay_from_start() {
+    StateFieldRegistryMock registry;
+    auto field_fp = registry.create_readable_field<unsigned int>("foo", 0, 1023, 10);
+    record_run(registry, field_fp);
+
+    ReplayLog::replay(log_path);
+    TEST_ASSERT_TRUE(ReplayLog::is_replaying());
+
+    unsigned int boot_input = 0;
+    ReplayLog::input(&boot_input, sizeof(boot_input));
+    TEST_ASSERT_EQUAL(42, boot_input);
+
+    for (unsigned int ccno = 0; ccno < 3; ccno++) {
+        ReplayLog::start_cycle(registry, ccno);
+
+        // Inputs come from the log rather than from the arguments.
+        TEST_ASSERT_EQUAL(1000000 + 500 * ccno, ReplayLog::clock_us(0));
+        std::string line;
+        TEST_ASSERT_TRUE(ReplayLog::console_line(line, false));
+        TEST_ASSERT_EQUAL_STRING(("{\"cycle\":" + std::to_string(ccno) + "}").c_str(), line.c_str());
+        TEST_ASSERT_FALSE(ReplayLog::console_line(line, true));
+    }
+}
+
+void test_replay_from_checkpoint() {
+    StateFieldRegistryMock registry;
+    auto field_fp = registry.create_readable_field<unsigned int>("foo", 0, 1023, 10);
+    record_run(registry, field_fp);
+
+    ReplayLog::replay(log_path, 2);
+    field_fp->set(0);
+
+    // The boot inputs are replayed, then the log skips to the checkpoint at
+    // cycle 2, which restores the registry.
+    unsigned int boot_input = 0;
+    ReplayLog::input(&boot_input, sizeof(boot_input));
+    TEST_ASSERT_EQUAL(42, boot_input);
+
+    unsigned int ccno = 0;
+    ReplayLog::start_cycle(registry, ccno);
+    TEST_ASSERT_EQUAL(2, ccno);
+    TEST_ASSERT_EQUAL(102, field_fp->get());
+    TEST_ASSERT_EQUAL(1001000, ReplayLog::clock_us(0));
+
+    std::string line;
+    TEST_ASSERT_TRUE(ReplayLog::console_line(line, false));
+    TEST_ASSERT_EQUAL_STRING("{\"cycle\":2}", line.c_str());
+
+    std::remove(log_path);
+}
+#endif
+
+void test_replay_log() {
+    UNITY_BEGIN();
+    #ifdef DESKTOP
+    RUN_TEST(test_replay_from_start);
+    RUN_TEST(test_replay_from_checkpoint);
+    #endif
+    UNITY_END();
+}
+
+#ifdef DESKTOP
+int main(int argc, char *argv[]) {
+    test_replay_log();
+    return 0;
+}
+#else
+#include <Arduino.h>
+void setup() {
+    delay(10000);
+    Serial.begin(9600);
+    test_replay_log();
+}
+
+void loop() {}
+#endif
@@ -0,0 +1,66 @@
+#include "../custom_assertions.hpp"
+#include <common/RingBuffer.hpp>
+
+void test_push_pop() {
+    RingBuffer<int, 4> buf;
+    TEST_ASSERT_TRUE(buf.empty());
+    int value = 0;
+    TEST_ASSERT_FALSE(buf.pop(value));
+
+    for (int i = 0; i < 4; i++) TEST_ASSERT_TRUE(buf.push(i));
+    TEST_ASSERT_FALSE(buf.push(4));
+    TEST_ASSERT_EQUAL(4, buf.size());
+
+    TEST_ASSERT_TRUE(buf.peek(value));
+    TEST_ASSERT_EQUAL(0, value);
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_TRUE(buf.pop(value));
+        TEST_ASSERT_EQUAL(i, value);
+    }
+    TEST_ASSERT_TRUE(buf.empty());
+}
+
+void test_wrap_around() {
+    // Elements keep their order as the indices wrap around the storage, and
+    // the counts give each element its position in the stream.
+    RingBuffer<unsigned char, 8> buf;
+    unsigned char out[8];
+    for (unsigned char round = 0; round < 5; round++) {
+        for (unsigned char i = 0; i < 5; i++) buf.push(round * 5 + i);
+        TEST_ASSERT_EQUAL(round * 5u, buf.popped());
+        TEST_ASSERT_EQUAL(3, buf.pop(out, 3));
+        TEST_ASSERT_EQUAL(2, buf.pop(out + 3, 8));
+        for (unsigned char i = 0; i < 5; i++) TEST_ASSERT_EQUAL(round * 5 + i, out[i]);
+    }
+    TEST_ASSERT_EQUAL(25, buf.pushed());
+    TEST_ASSERT_EQUAL(25, buf.popped());
+
+    buf.push(1);
+    buf.push(2);
+    buf.clear();
+    TEST_ASSERT_TRUE(buf.empty());
+    TEST_ASSERT_EQUAL(27, buf.popped());
+}
+
+void test_ring_buffer() {
+    UNITY_BEGIN();
+    RUN_TEST(test_push_pop);
+    RUN_TEST(test_wrap_around);
+    UNITY_END();
+}
+
+#ifdef DESKTOP
+int main(int argc, char *argv[]) {
+    test_ring_buffer();
+    return 0;
+}
+#else
+#include <Arduino.h>
+void setup() {
+    delay(10000);
+    Serial.begin(9600);
+    test_ring_buffer();
+}
+
+void loop() {}
+#endif
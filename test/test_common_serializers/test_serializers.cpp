@@ -1,5 +1,7 @@
 #include "../custom_assertions.hpp"
 #include <common/Serializer.hpp>
+#include <common/StaticSerializer.hpp>
+#include <common/StateField.hpp>
 #include <stdlib.h>
 #include <memory>
 
@@ -642,6 +644,125 @@ void test_gpstime_serializer() {
     TEST_ASSERT_EQUAL_STRING("2500,4,4", gpstime_serializer->print(input4));
 }
 
+/**
+ * @brief Check that writing vectors and quaternions straight into a frame
+ * produces the same bits as their bitsets.
+ */
+template<typename T, size_t N>
+void test_vec_quat_into_frame(Serializer<std::array<T, N>>& sr) {
+    constexpr size_t count = 10;
+    std::array<std::array<T, N>, count> inputs;
+    std::vector<bool> bits;
+    char frame[100] = {0};
+    FrameWriter writer(frame, 8 * sizeof(frame) + 1);
+    writer.start_frame();
+
+    srand(3);
+    for (size_t i = 0; i < count; i++) {
+        for (size_t j = 0; j < N; j++) inputs[i][j] = (rand() % 2000 - 1000) / 100.0;
+        sr.serialize(inputs[i]);
+        bits.insert(bits.end(), sr.get_bit_array().begin(), sr.get_bit_array().end());
+        sr.serialize_into(inputs[i], writer);
+    }
+
+    // The frame holds a header bit followed by the same bits as the bitsets.
+    for (size_t i = 0; i < bits.size(); i++) {
+        const size_t offset = i + 1;
+        TEST_ASSERT_EQUAL(bits[i], (frame[offset / 8] >> (7 - offset % 8)) & 1);
+    }
+}
+
+void test_vec_quat_into_frame_serializers() {
+    Serializer<f_vector_t> f_vec_sr(0, 20, 12);
+    test_vec_quat_into_frame(f_vec_sr);
+    Serializer<d_vector_t> d_vec_sr(0, 20, 16);
+    test_vec_quat_into_frame(d_vec_sr);
+    Serializer<f_quat_t> f_quat_sr;
+    test_vec_quat_into_frame(f_quat_sr);
+    Serializer<d_quat_t> d_quat_sr;
+    test_vec_quat_into_frame(d_quat_sr);
+}
+
+/**
+ * @brief Check that a static serializer produces the same bits and the same
+ * deserialized values as the equivalent dynamic serializer.
+ */
+template <typename S>
+void test_static_matches_dynamic(const std::vector<typename S::value_type>& values) {
+    using T = typename S::value_type;
+    Serializer<T> dynamic_serializer = S::make_serializer();
+    TEST_ASSERT_EQUAL(S::bitsize, dynamic_serializer.bitsize());
+
+    bit_array static_bits(S::bitsize);
+    for (const T& val : values) {
+        dynamic_serializer.serialize(val);
+        S::serialize(val, static_bits);
+        TEST_ASSERT_TRUE(dynamic_serializer.get_bit_array() == static_bits);
+
+        T dynamic_val, static_val;
+        dynamic_serializer.deserialize(&dynamic_val);
+        S::deserialize(static_bits, &static_val);
+        TEST_ASSERT_TRUE(dynamic_val == static_val);
+    }
+}
+
+void test_static_serializer() {
+    test_static_matches_dynamic<StaticSerializer<bool, 0, 1, 1>>({false, true});
+    test_static_matches_dynamic<StaticSerializer<unsigned int, 0, 1000, 10>>(
+        {0, 1, 2, 500, 999, 1000, 1001, 4294967295});
+    test_static_matches_dynamic<StaticSerializer<unsigned int, 0, 4294967295, 32>>(
+        {0, 1, 2147483648, 4294967295});
+    test_static_matches_dynamic<StaticSerializer<unsigned int, 100, 100, 4>>({0, 100, 200});
+    test_static_matches_dynamic<StaticSerializer<signed int, -1000, 1000, 11>>(
+        {-2000, -1000, -1, 0, 1, 999, 1000, 2000});
+    test_static_matches_dynamic<StaticSerializer<unsigned char, 10, 200, 5>>({0, 10, 11, 100, 200, 255});
+    test_static_matches_dynamic<StaticSerializer<signed char, -100, 100, 8>>({-128, -100, 0, 50, 100, 127});
+    test_static_matches_dynamic<StaticSerializer<float, 0, 180, 16>>(
+        {-1.0f, 0.0f, 0.032f, 45.0f, 90.12345f, 180.0f, 200.0f});
+    test_static_matches_dynamic<StaticSerializer<double, -5, 5, 20>>(
+        {-6.0, -5.0, -1.23456, 0.0, 0.5, 4.99999, 5.0});
+
+    // Static fields serialize through the static serializer but are otherwise
+    // indistinguishable from their base field type.
+    StaticWritableStateField<StaticSerializer<float, 0, 180, 16>> field("foo");
+    WritableStateField<float>& base_field = field;
+    TEST_ASSERT_EQUAL(16, base_field.bitsize());
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 180, base_field.get_serializer_max());
+
+    field.set(90.0f);
+    base_field.serialize();
+    field.set(0.0f);
+    base_field.deserialize();
+    TEST_ASSERT_FLOAT_WITHIN(180.0 / 65535, 90.0f, field.get());
+
+    TEST_ASSERT_TRUE(base_field.deserialize("45.0"));
+    TEST_ASSERT_FLOAT_WITHIN(180.0 / 65535, 45.0f, field.get());
+}
+
+void test_serializer_move() {
+    // Moving a serializer takes over its bit array rather than copying it.
+    Serializer<float> src(0, 180, 16);
+    src.serialize(90.0f);
+    const bit_array expected = src.get_bit_array();
+
+    Serializer<float> moved(std::move(src));
+    TEST_ASSERT_EQUAL(16, moved.bitsize());
+    TEST_ASSERT_TRUE(expected == moved.get_bit_array());
+    TEST_ASSERT_EQUAL(0, src.bitsize());
+
+    Serializer<float> assigned(-10, 10, 16);
+    assigned = std::move(moved);
+    TEST_ASSERT_TRUE(expected == assigned.get_bit_array());
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 180, assigned.max());
+    TEST_ASSERT_EQUAL(0, moved.bitsize());
+
+    Serializer<bool> bool_src;
+    bool_src.serialize(true);
+    Serializer<bool> bool_moved(std::move(bool_src));
+    TEST_ASSERT_EQUAL(1, bool_moved.bitsize());
+    TEST_ASSERT_EQUAL(0, bool_src.bitsize());
+}
+
 void test_serializers() {
     UNITY_BEGIN();
     RUN_TEST(test_bool_serializer);
@@ -656,6 +777,9 @@ void test_serializers() {
     RUN_TEST(test_f_quat_serializer);
     RUN_TEST(test_d_quat_serializer);
     RUN_TEST(test_gpstime_serializer);
+    RUN_TEST(test_vec_quat_into_frame_serializers);
+    RUN_TEST(test_static_serializer);
+    RUN_TEST(test_serializer_move);
     UNITY_END();
 }
 
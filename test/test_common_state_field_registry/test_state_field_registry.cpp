@@ -69,11 +69,77 @@ void test_faults() {
     TEST_ASSERT_FALSE(registry.find_fault("fake_fault"));
 }
 
+void test_checkpoint() {
+    StateFieldRegistry registry;
+    unsigned int control_cycle_count = 1;
+    Fault::cc = &control_cycle_count;
+    ReadableStateField<unsigned int> ccno_f("pan.cycle_no", Serializer<unsigned int>(100));
+    Event::ccno = &ccno_f;
+
+    InternalStateField<double> internal_f("internal");
+    ReadableStateField<float> readable_f("readable", Serializer<float>(0, 10, 4));
+    WritableStateField<unsigned int> writable_f("writable", Serializer<unsigned int>(100));
+    Fault fault("fault", 5);
+    std::vector<ReadableStateFieldBase*> event_data = {&readable_f};
+    Event event("event", event_data, print_fn);
+    registry.add_internal_field(&internal_f);
+    registry.add_readable_field(&readable_f);
+    registry.add_writable_field(&writable_f);
+    registry.add_fault(&fault);
+    registry.add_event(&event);
+
+    // Values are saved exactly, even if their serializer would round them.
+    internal_f.set(1.0 / 3.0);
+    readable_f.set(3.14159f);
+    writable_f.set(42);
+    ccno_f.set(7);
+    event.signal();
+    fault.signal();
+    control_cycle_count++;
+    fault.signal();
+
+    std::vector<unsigned char> blob;
+    registry.save_checkpoint(blob);
+
+    internal_f.set(0);
+    readable_f.set(0);
+    writable_f.set(0);
+    ccno_f.set(0);
+    event.signal();
+    fault.unsignal();
+    fault.persistence_f.set(0);
+
+    // The persistence is part of the checkpoint since it's a writable field.
+    TEST_ASSERT_TRUE(registry.load_checkpoint(blob));
+    TEST_ASSERT_EQUAL(1.0 / 3.0, internal_f.get());
+    TEST_ASSERT_EQUAL_FLOAT(3.14159f, readable_f.get());
+    TEST_ASSERT_EQUAL(42, writable_f.get());
+    TEST_ASSERT_EQUAL(5, fault.persistence_f.get());
+    TEST_ASSERT_EQUAL(2, fault.get_num_consecutive_signals());
+    event.deserialize();
+    TEST_ASSERT_EQUAL(7, ccno_f.get());
+
+    // A registry with different fields rejects the checkpoint and is left unchanged.
+    StateFieldRegistry other_registry;
+    InternalStateField<double> other_internal_f("internal");
+    ReadableStateField<float> renamed_f("renamed", Serializer<float>(0, 10, 4));
+    other_internal_f.set(2.0);
+    other_registry.add_internal_field(&other_internal_f);
+    other_registry.add_readable_field(&renamed_f);
+    TEST_ASSERT_FALSE(other_registry.load_checkpoint(blob));
+    TEST_ASSERT_EQUAL(2.0, other_internal_f.get());
+
+    // So does a registry with the same fields if the checkpoint is truncated.
+    blob.pop_back();
+    TEST_ASSERT_FALSE(registry.load_checkpoint(blob));
+}
+
 void test_state_field_registry() {
     UNITY_BEGIN();
     RUN_TEST(test_foo);
     RUN_TEST(test_events);
     RUN_TEST(test_faults);
+    RUN_TEST(test_checkpoint);
     UNITY_END();
 }
 
@@ -5,14 +5,17 @@
 #include "../custom_assertions.hpp"
 
 #ifdef DESKTOP
-    #include <json.hpp>
+    #include <cstdio>
     #include <fstream>
-#else
-    #include <EEPROM.h>
+    #include <iterator>
 #endif
 
 class TestFixture {
   public:
+    #ifdef DESKTOP
+        static constexpr const char* image_path = "eeprom_test.bin";
+    #endif
+
     StateFieldRegistryMock registry;
 
     //Create the statefields that the EEPROM will eventually collect and store
@@ -22,6 +25,10 @@ class TestFixture {
 
     std::unique_ptr<EEPROMController> eeprom_controller;
 
+    // Second controller on the same EEPROM, used to read the log back without
+    // changing the state of the controller under test.
+    StateFieldRegistryMock reader_registry;
+    std::unique_ptr<EEPROMController> reader;
 
     /**
      * @brief Construct a new Test Fixture.
@@ -29,8 +36,6 @@ class TestFixture {
      * @param clr If true, clears the EEPROM.
      */
     TestFixture(bool clr) : registry() {
-        if (clr) clear_data();
-
         mission_mode_fp = registry.create_readable_field<unsigned char, 2>("pan.state");
         mission_mode_fp->set(1);
 
@@ -40,53 +45,70 @@ class TestFixture {
         control_cycle_count_fp = registry.create_readable_field<unsigned int, 7>("pan.cycle_no");
         control_cycle_count_fp->set(4);
 
-        eeprom_controller = std::make_unique<EEPROMController>(registry);
+        eeprom_controller = make_controller(registry);
+        if (clr) clear_data();
 
         // Initialize the controller
         eeprom_controller->init();
+
+        reader_registry.create_readable_field<unsigned char, 2>("pan.state");
+        reader_registry.create_readable_field<bool, 3>("pan.deployed");
+        reader_registry.create_readable_field<unsigned int, 7>("pan.cycle_no");
+        reader = make_controller(reader_registry);
+        reader->init();
     }
 
     /**
-     * @brief Clear data from the EEPROM.
+     * @brief Creates a controller on the test EEPROM.
      */
-    void clear_data() {
+    static std::unique_ptr<EEPROMController> make_controller(StateFieldRegistryMock &r) {
         #ifdef DESKTOP
-            EEPROMController::data.clear();
-            save_data();
+            return std::make_unique<EEPROMController>(r, image_path);
         #else
-            for (unsigned int i = 0 ; i < EEPROM.length() ; i++) {
-                EEPROM.write(i, 255);
-            }
+            return std::make_unique<EEPROMController>(r);
         #endif
     }
 
     /**
-     * @brief Save data to the EEPROM. Only does anything in desktop mode.
+     * @brief Clear data from the EEPROM.
      */
-    void save_data() {
-        #ifdef DESKTOP
-            EEPROMController::save_data(0);
-        #endif
+    void clear_data() {
+        for (unsigned int i = 0; i < EEPROMController::eeprom_size; i++)
+            write_byte(i, 255);
     }
 
     /**
-     * @brief Reads data from EEPROM for the statefield at index idx.
+     * @brief Reads the newest value saved in the EEPROM log for the statefield
+     * at index idx, or 255 if it was never saved. The log is read by the
+     * second controller, as it would be after a reboot.
      * 
      * @param idx 
      * @return unsigned int 
      */
     unsigned int read(size_t idx) {
-        #ifdef DESKTOP
-            const std::string& field_name = registry.eeprom_saved_fields[idx]->name();
-            if (EEPROMController::data.find(field_name) != EEPROMController::data.end()) {
-                return EEPROMController::data[field_name];
-            }
-            else {
-                return 255;
-            }
-        #else
-            return EEPROM.read(eeprom_controller->addresses[idx]);
-        #endif
+        reader->load_log();
+        if (!reader->is_saved[idx]) return 255;
+        return reader->saved_values[idx];
+    }
+
+    /**
+     * @brief Start of the active half of the log, and address of the next record.
+     */
+    unsigned int log_start() { return eeprom_controller->log_start; }
+    unsigned int write_address() { return eeprom_controller->write_address; }
+
+    /**
+     * @brief Reads a raw byte of the EEPROM.
+     */
+    unsigned char read_byte(unsigned int address) {
+        return eeprom_controller->read_byte(address);
+    }
+
+    /**
+     * @brief Writes a raw byte of the EEPROM.
+     */
+    void write_byte(unsigned int address, unsigned char value) {
+        eeprom_controller->write_byte(address, value);
     }
 
     /**
@@ -100,6 +122,10 @@ class TestFixture {
     }
 };
 
+#ifdef DESKTOP
+    constexpr const char* TestFixture::image_path;
+#endif
+
 void test_task_initialization() {
     TestFixture tf(true);
 
@@ -146,7 +172,6 @@ void test_task_execute() {
 
     // Now we pretend the satellite just rebooted. Everytime the satellite reboots, another 
     // eeprom control task is instantiated.
-    tf.save_data();
     TestFixture tf2(false);
 
     // Check if the new eeprom controller set the statefield values to the values that 
@@ -184,10 +209,115 @@ void test_task_execute() {
     TEST_ASSERT_EQUAL(12, tf.read(2));
 }
 
+void test_task_compaction() {
+    TestFixture tf(true);
+    const unsigned int half_size = EEPROMController::eeprom_size / 2;
+
+    // The cycle count is saved every 7 cycles, and the other fields whenever
+    // they change. Run for long enough that the log wraps around both halves
+    // several times.
+    unsigned int last_log_start = tf.log_start();
+    unsigned int num_compactions = 0;
+    for (unsigned int cc = 1; cc <= 20000; cc++) {
+        TimedControlTaskBase::control_cycle_count = cc;
+        tf.mission_mode_fp->set((cc / 100) % 2 == 0 ? 9 : 10);
+        tf.is_deployed_fp->set(cc % 84 == 0);
+        tf.control_cycle_count_fp->set(cc);
+        tf.eeprom_controller->execute();
+
+        if (tf.log_start() != last_log_start) {
+            num_compactions++;
+            last_log_start = tf.log_start();
+        }
+        TEST_ASSERT_LESS_OR_EQUAL(tf.log_start() + half_size, tf.write_address());
+    }
+    TEST_ASSERT_GREATER_THAN(4, num_compactions);
+
+    // Nothing should be lost by compacting the log.
+    const unsigned int saved_mission_mode = tf.read(0);
+    const unsigned int saved_deployed = tf.read(1);
+    const unsigned int saved_cycle_no = tf.read(2);
+    TEST_ASSERT_EQUAL(9, saved_mission_mode);
+    TEST_ASSERT_EQUAL(0, saved_deployed);
+    TEST_ASSERT_EQUAL(19999, saved_cycle_no);
+
+    TestFixture tf2(false);
+    TEST_ASSERT_EQUAL(9, tf2.get_ptr<unsigned char>(0)->get());
+    TEST_ASSERT_FALSE(tf2.get_ptr<bool>(1)->get());
+    TEST_ASSERT_EQUAL(19999, tf2.get_ptr<unsigned int>(2)->get());
+}
+
+void test_task_corrupted_record() {
+    TestFixture tf(true);
+
+    tf.control_cycle_count_fp->set(8);
+    TimedControlTaskBase::control_cycle_count = 7;
+    tf.eeprom_controller->execute();
+    const unsigned int second_record = tf.write_address();
+
+    tf.control_cycle_count_fp->set(12);
+    TimedControlTaskBase::control_cycle_count = 14;
+    tf.eeprom_controller->execute();
+    TEST_ASSERT_EQUAL(12, tf.read(2));
+
+    // If the newest record is corrupted, e.g. by a reset while it was being
+    // written, the previous value of the field is restored.
+    tf.write_byte(second_record + 6, 0);
+    TEST_ASSERT_EQUAL(8, tf.read(2));
+
+    // After the reboot, the next record overwrites the corrupted record.
+    TestFixture tf2(false);
+    TEST_ASSERT_EQUAL(8, tf2.get_ptr<unsigned int>(2)->get());
+    TEST_ASSERT_EQUAL(second_record, tf2.write_address());
+    tf2.control_cycle_count_fp->set(16);
+    TimedControlTaskBase::control_cycle_count = 21;
+    tf2.eeprom_controller->execute();
+    TEST_ASSERT_EQUAL(16, tf.read(2));
+}
+
+#ifdef DESKTOP
+void test_task_file_persistence() {
+    TestFixture tf(true);
+
+    tf.control_cycle_count_fp->set(8);
+    TimedControlTaskBase::control_cycle_count = 7;
+    tf.eeprom_controller->execute();
+
+    // The record is in the EEPROM file as soon as it's written, without the
+    // controller having to save anything before the process exits.
+    std::ifstream in(TestFixture::image_path, std::ios::binary);
+    const std::vector<unsigned char> file_data((std::istreambuf_iterator<char>(in)),
+                                               std::istreambuf_iterator<char>());
+    TEST_ASSERT_EQUAL(EEPROMController::eeprom_size, file_data.size());
+    for (unsigned int i = 0; i < file_data.size(); i++)
+        TEST_ASSERT_EQUAL(tf.read_byte(i), file_data[i]);
+    TEST_ASSERT_EQUAL(8, file_data[6]);
+
+    // A controller on another image doesn't see the record.
+    std::remove("eeprom_other.bin");
+    StateFieldRegistryMock other_registry;
+    other_registry.create_readable_field<unsigned char, 2>("pan.state");
+    other_registry.create_readable_field<bool, 3>("pan.deployed");
+    std::shared_ptr<ReadableStateField<unsigned int>> other_cycle_no_fp =
+        other_registry.create_readable_field<unsigned int, 7>("pan.cycle_no");
+    other_cycle_no_fp->set(4);
+    EEPROMController other(other_registry, "eeprom_other.bin");
+    other.init();
+    TEST_ASSERT_EQUAL(4, other_cycle_no_fp->get());
+    TEST_ASSERT_TRUE(other.check_empty());
+    std::remove("eeprom_other.bin");
+}
+#endif
+
 int test_control_task() {
     UNITY_BEGIN();
     RUN_TEST(test_task_initialization);
     RUN_TEST(test_task_execute);
+    RUN_TEST(test_task_compaction);
+    RUN_TEST(test_task_corrupted_record);
+    #ifdef DESKTOP
+        RUN_TEST(test_task_file_persistence);
+    #endif
     return UNITY_END();
 }
 
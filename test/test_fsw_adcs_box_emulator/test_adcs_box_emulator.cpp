@@ -0,0 +1,270 @@
+#include <fsw/FCCode/Drivers/ADCS.hpp>
+#include <adcs/constants.hpp>
+#include <adcs/havt_devices.hpp>
+#include <cmath>
+
+#include "../custom_assertions.hpp"
+
+using namespace Devices;
+
+#ifdef DESKTOP
+
+static long long now_us = 0;
+static long long fake_clock() { return now_us; }
+
+class TestFixture {
+  public:
+    ADCSBoxEmulator box;
+    ADCS adcs;
+
+    TestFixture(const ADCSBoxEmulator::config_t &config) : box(config), adcs(&box)
+    {
+        now_us = 0;
+        box.set_clock(fake_clock);
+    }
+};
+
+void test_registers()
+{
+    TestFixture tf(ADCSBoxEmulator::config_t{});
+    TEST_ASSERT_TRUE(tf.adcs.i2c_ping());
+
+    tf.adcs.set_mode(adcs::ADCSMode::ADCS_ACTIVE);
+    tf.adcs.set_mtr_mode(adcs::MTRMode::MTR_ENABLED);
+    tf.adcs.set_mtr_limit(0.01f);
+    tf.adcs.set_imu_gyr_temp_desired(30.0f);
+
+    const adcs::Registers &regs = tf.box.registers();
+    TEST_ASSERT_EQUAL(adcs::ADCSMode::ADCS_ACTIVE, regs.mode);
+    TEST_ASSERT_EQUAL(adcs::MTRMode::MTR_ENABLED, regs.mtr.mode);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5, 0.01f, regs.mtr.moment_limit);
+    TEST_ASSERT_FLOAT_WITHIN(0.5, 30.0f, regs.imu.gyr_desired_temp);
+}
+
+void test_wheels()
+{
+    TestFixture tf(ADCSBoxEmulator::config_t{});
+    const double wheel_inertia = adcs::rwa::moment_of_inertia;
+    const double torque = 0.5 * adcs::rwa::max_torque;
+
+    // Actuators only run in the active mode
+    tf.adcs.set_rwa_mode(adcs::RWAMode::RWA_ACCEL_CTRL, {0, 0, (float)torque});
+    now_us += 1000000;
+    TEST_ASSERT_TRUE(tf.adcs.i2c_ping());
+    TEST_ASSERT_EQUAL_FLOAT(0, tf.box.wheel_speed()[2]);
+
+    tf.adcs.set_mode(adcs::ADCSMode::ADCS_ACTIVE);
+    now_us += 1000000;
+    std::array<float, 3> speed, ramp;
+    tf.adcs.get_rwa(&speed, &ramp);
+    TEST_ASSERT_FLOAT_WITHIN(0.05, torque / wheel_inertia, speed[2]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, torque, ramp[2]);
+
+    // The body takes up the momentum the wheel gains
+    const double inertia = ADCSBoxEmulator::config_t{}.inertia[2];
+    TEST_ASSERT_FLOAT_WITHIN(1e-9, 0, inertia * tf.box.rate()[2] + wheel_inertia * tf.box.wheel_speed()[2]);
+
+    // Speed control settles on the commanded speed
+    tf.adcs.set_rwa_mode(adcs::RWAMode::RWA_SPEED_CTRL, {0, 0, 100.0f});
+    now_us += 1000000;
+    tf.adcs.get_rwa(&speed, &ramp);
+    TEST_ASSERT_FLOAT_WITHIN(1e-1, 100.0f, speed[2]);
+}
+
+void test_imu()
+{
+    ADCSBoxEmulator::config_t config;
+    config.rate = {{0, 0, 0.1}};
+    config.mag_field = {{4e-5, 0, 0}};
+    TestFixture tf(config);
+
+    TEST_ASSERT_TRUE(tf.adcs.i2c_ping());
+    now_us += 5000000; // catching up is capped at a second
+    TEST_ASSERT_TRUE(tf.adcs.i2c_ping());
+    now_us += 1000000;
+
+    // Spinning about +z, an inertial +x field turns towards -y
+    std::array<float, 3> mag1, mag2, gyr;
+    float temp;
+    tf.adcs.get_imu(&mag1, &mag2, &gyr, &temp);
+    const double theta = 0.2;
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, 0.1, gyr[2]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 4e-5 * std::cos(theta), mag1[0]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, -4e-5 * std::sin(theta), mag1[1]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 4e-5 * std::cos(theta), mag2[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.1, 25.0f, temp);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, std::cos(theta / 2), tf.box.q_body_eci()[3]);
+}
+
+void test_ssa()
+{
+    ADCSBoxEmulator::config_t config;
+    config.sun_vec = {{0, 0.6, 0.8}};
+    TestFixture tf(config);
+
+    unsigned char mode;
+    std::array<float, 3> sun_vec;
+    tf.adcs.set_ssa_mode(adcs::SSAMode::SSA_IN_PROGRESS);
+    tf.adcs.get_ssa_mode(&mode);
+    TEST_ASSERT_EQUAL(adcs::SSAMode::SSA_COMPLETE, mode);
+    tf.adcs.get_ssa_vector(&sun_vec);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, 0, sun_vec[0]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, 0.6, sun_vec[1]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, 0.8, sun_vec[2]);
+
+    std::array<float, 20> voltages;
+    tf.adcs.get_ssa_voltage(&voltages);
+    for (float v : voltages) TEST_ASSERT_TRUE(v >= 0);
+
+    // No sensor is in view of the sun in eclipse
+    config.sun_vec = {{0, 0, 0}};
+    TestFixture dark(config);
+    dark.adcs.set_ssa_mode(adcs::SSAMode::SSA_IN_PROGRESS);
+    dark.adcs.get_ssa_mode(&mode);
+    TEST_ASSERT_EQUAL(adcs::SSAMode::SSA_FAILURE, mode);
+}
+
+void test_havt()
+{
+    TestFixture tf(ADCSBoxEmulator::config_t{});
+    std::bitset<adcs::havt::max_devices> table;
+    tf.adcs.get_havt(&table);
+    TEST_ASSERT_EQUAL(adcs::havt::Index::_LENGTH, table.count());
+
+    tf.box.fail_devices(1u << adcs::havt::Index::IMU_GYR);
+    std::bitset<adcs::havt::max_devices> disable;
+    disable.set(adcs::havt::Index::RWA_POT);
+    tf.adcs.set_havt_disable(disable);
+    tf.adcs.get_havt(&table);
+    TEST_ASSERT_FALSE(table.test(adcs::havt::Index::IMU_GYR));
+    TEST_ASSERT_FALSE(table.test(adcs::havt::Index::RWA_POT));
+    TEST_ASSERT_EQUAL(adcs::havt::Index::_LENGTH - 2, table.count());
+
+    std::bitset<adcs::havt::max_devices> reset;
+    reset.set();
+    tf.adcs.set_havt_reset(reset);
+    tf.adcs.get_havt(&table);
+    TEST_ASSERT_EQUAL(adcs::havt::Index::_LENGTH, table.count());
+}
+
+void test_telemetry()
+{
+    ADCSBoxEmulator::config_t config;
+    config.rate = {{0.01, -0.02, 0.03}};
+    TestFixture tf(config);
+    tf.box.fail_devices(1u << adcs::havt::Index::IMU_MAG1);
+    tf.adcs.set_ssa_mode(adcs::SSAMode::SSA_IN_PROGRESS);
+
+    ADCS::telemetry_t telem;
+    TEST_ASSERT_TRUE(tf.adcs.get_telemetry(&telem));
+    TEST_ASSERT_EQUAL(adcs::SSAMode::SSA_COMPLETE, telem.ssa_mode);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, 1, telem.ssa_sun_vec[0]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, 0.01, telem.gyr_rd[0]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, -0.02, telem.gyr_rd[1]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, 0.03, telem.gyr_rd[2]);
+    TEST_ASSERT_FALSE(telem.havt_table.test(adcs::havt::Index::IMU_MAG1));
+    TEST_ASSERT_EQUAL(adcs::havt::Index::_LENGTH - 1, telem.havt_table.count());
+
+    // Setting the read pointer and reading the block take two transactions,
+    // which at 400 kHz take 73 us and 1535 us
+    const ADCSBoxEmulator::stats_t before = tf.box.stats();
+    TEST_ASSERT_TRUE(tf.adcs.get_telemetry(&telem));
+    TEST_ASSERT_EQUAL(before.writes + 1, tf.box.stats().writes);
+    TEST_ASSERT_EQUAL(before.reads + 1, tf.box.stats().reads);
+    TEST_ASSERT_EQUAL(73 + 1535, tf.box.stats().bus_us - before.bus_us);
+
+    // which is less than reading the registers one by one
+    const ADCSBoxEmulator::stats_t single = tf.box.stats();
+    unsigned char mode;
+    std::array<float, 3> speed, ramp, sun_vec, mag1, mag2, gyr;
+    std::array<float, 20> voltages;
+    std::bitset<adcs::havt::max_devices> table;
+    float temp;
+    tf.adcs.get_rwa(&speed, &ramp);
+    tf.adcs.get_ssa_mode(&mode);
+    tf.adcs.get_ssa_vector(&sun_vec);
+    tf.adcs.get_ssa_voltage(&voltages);
+    tf.adcs.get_imu(&mag1, &mag2, &gyr, &temp);
+    tf.adcs.get_havt(&table);
+    TEST_ASSERT_TRUE(tf.box.stats().bus_us - single.bus_us > 73 + 1535);
+}
+
+void test_queued_telemetry()
+{
+    ADCSBoxEmulator::config_t config;
+    config.rate = {{0.01, -0.02, 0.03}};
+    TestFixture tf(config);
+    I2CScheduler scheduler;
+    scheduler.set_clock(fake_clock);
+    scheduler.attach_target(ADCS::ADDRESS, &tf.box);
+
+    ADCS::telemetry_t telem;
+    const ADCSBoxEmulator::stats_t before = tf.box.stats();
+    TEST_ASSERT_TRUE(tf.adcs.queue_telemetry(scheduler));
+    TEST_ASSERT_FALSE(tf.adcs.queue_telemetry(scheduler));
+    TEST_ASSERT_FALSE(tf.adcs.take_telemetry(&telem));
+
+    // The block arrives once both transactions are off the bus and the
+    // scheduler has dispatched them
+    now_us += 73 + 1535 - 1;
+    scheduler.dispatch();
+    TEST_ASSERT_FALSE(tf.adcs.take_telemetry(&telem));
+    now_us += 1;
+    scheduler.dispatch();
+    TEST_ASSERT_TRUE(tf.adcs.take_telemetry(&telem));
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, -0.02, telem.gyr_rd[1]);
+    TEST_ASSERT_EQUAL(adcs::havt::Index::_LENGTH, telem.havt_table.count());
+    TEST_ASSERT_EQUAL(73 + 1535, scheduler.stats().bus_us);
+
+    // The box sees both transactions, but their bus time is only counted by
+    // the scheduler
+    TEST_ASSERT_EQUAL(before.writes + 1, tf.box.stats().writes);
+    TEST_ASSERT_EQUAL(before.reads + 1, tf.box.stats().reads);
+    TEST_ASSERT_EQUAL(before.bus_us, tf.box.stats().bus_us);
+
+    // A block is taken once
+    TEST_ASSERT_FALSE(tf.adcs.take_telemetry(&telem));
+
+    // A box that doesn't answer fails the read
+    I2CScheduler silent;
+    silent.set_clock(fake_clock);
+    TEST_ASSERT_TRUE(tf.adcs.queue_telemetry(silent));
+    now_us += 10000;
+    silent.dispatch();
+    TEST_ASSERT_FALSE(tf.adcs.take_telemetry(&telem));
+    TEST_ASSERT_EQUAL(2, silent.stats().failures);
+}
+
+#endif
+
+int test_adcs_box_emulator()
+{
+    UNITY_BEGIN();
+#ifdef DESKTOP
+    RUN_TEST(test_registers);
+    RUN_TEST(test_wheels);
+    RUN_TEST(test_imu);
+    RUN_TEST(test_ssa);
+    RUN_TEST(test_havt);
+    RUN_TEST(test_telemetry);
+    RUN_TEST(test_queued_telemetry);
+#endif
+    return UNITY_END();
+}
+
+#ifdef DESKTOP
+int main()
+{
+    return test_adcs_box_emulator();
+}
+#else
+#include <Arduino.h>
+void setup()
+{
+    delay(2000);
+    Serial.begin(9600);
+    test_adcs_box_emulator();
+}
+
+void loop() {}
+#endif
@@ -49,13 +49,13 @@ class TestFixture {
         // Create a TestFixture instance of ADCSBoxMonitor with pointers to statefields
         // Compile conditionally for either hootl or hitl
         #ifdef DESKTOP
-        TestFixture() : registry(), adcs(){
+        TestFixture(Devices::I2CScheduler* scheduler = nullptr) : registry(), adcs(){
         #else
-        TestFixture() : registry(), adcs(Wire, Devices::ADCS::ADDRESS) 
+        TestFixture(Devices::I2CScheduler* scheduler = nullptr) : registry(), adcs(Wire, Devices::ADCS::ADDRESS) 
         {
         #endif
             Fault::cc = &TimedControlTaskBase::control_cycle_count;
-            adcs_box = std::make_unique<ADCSBoxMonitor>(registry, adcs);  
+            adcs_box = std::make_unique<ADCSBoxMonitor>(registry, adcs, scheduler);  
 
             // initialize pointers to statefields
             rwa_speed_rd_fp = registry.find_readable_field_t<lin::Vector3f>("adcs_monitor.rwa_speed_rd");
@@ -339,6 +339,133 @@ void test_execute_havt_faults() {
     TEST_ASSERT_FALSE(tf.wheel_pot_fault_p->is_faulted());
 }
 
+/**
+ * @brief Testing suite for the single transaction telemetry read
+ * 
+ */
+void test_execute_telemetry(){
+    TestFixture tf;
+    std::bitset<adcs::havt::max_devices> every_other("00000000000000110101010101010101");
+    tf.set_mock_havt_read(every_other);
+    tf.set_mock_ssa_mode(adcs::SSAMode::SSA_COMPLETE);
+
+    // the block decodes to the same readings as the individual registers
+    Devices::ADCS::telemetry_t telem;
+    TEST_ASSERT_TRUE(tf.adcs.get_telemetry(&telem));
+    TEST_ASSERT_EQUAL(adcs::SSAMode::SSA_COMPLETE, telem.ssa_mode);
+    TEST_ASSERT_EQUAL_STRING(every_other.to_string().c_str(), telem.havt_table.to_string().c_str());
+    TEST_ASSERT_EQUAL_FLOAT(adcs::rwa::max_speed_read, telem.rwa_speed_rd[2]);
+    TEST_ASSERT_EQUAL_FLOAT(adcs::rwa::max_ramp_rd, telem.rwa_ramp_rd[0]);
+    TEST_ASSERT_EQUAL_FLOAT(1, telem.ssa_sun_vec[1]);
+    TEST_ASSERT_EQUAL_FLOAT(adcs::ssa::max_voltage_rd, telem.ssa_voltages[19]);
+    TEST_ASSERT_EQUAL_FLOAT(adcs::imu::max_mag2_rd_mag, telem.mag2_rd[0]);
+    TEST_ASSERT_EQUAL_FLOAT(adcs::imu::max_rd_temp, telem.gyr_temp_rd);
+
+    // a block that fails its CRC is rejected
+    tf.adcs.set_mock_telemetry_corrupt(true);
+    TEST_ASSERT_FALSE(tf.adcs.get_telemetry(&telem));
+
+    // and the monitor falls back to the individual registers
+    tf.adcs_box->execute();
+    std::bitset<adcs::havt::max_devices> havt_read(0);
+    tf.get_havt_as_table(&havt_read);
+    TEST_ASSERT_EQUAL_STRING(every_other.to_string().c_str(), havt_read.to_string().c_str());
+    TEST_ASSERT_EQUAL(adcs::SSAMode::SSA_COMPLETE, tf.ssa_mode_fp->get());
+    PAN_TEST_ASSERT_EQUAL_FLOAT_LIN_VEC(lin::Vector3f({1,1,1}), tf.ssa_vec_fp->get(), 0);
+    TEST_ASSERT_EQUAL(adcs::ssa::max_voltage_rd, tf.ssa_voltages_fp[0]->get());
+    TEST_ASSERT_EQUAL(adcs::imu::max_rd_temp, tf.gyr_temp_fp->get());
+}
+
+#ifdef DESKTOP
+static long long frozen_clock() { return 0; }
+
+/**
+ * @brief Testing suite for the monitor reading an emulated ADCS box
+ * 
+ */
+void test_execute_box_emulator(){
+    Devices::ADCSBoxEmulator::config_t config;
+    config.rate = {{0.01, 0.02, -0.03}};
+    config.sun_vec = {{0, 0, 1}};
+    Devices::ADCSBoxEmulator box(config);
+    box.set_clock(frozen_clock);
+    box.fail_devices(1u << adcs::havt::Index::RWA_WHEEL2);
+
+    Devices::ADCSBoxEmulator::attach(&box);
+    TestFixture tf;
+    Devices::ADCSBoxEmulator::attach(nullptr);
+
+    tf.adcs.set_ssa_mode(adcs::SSAMode::SSA_IN_PROGRESS);
+    const Devices::ADCSBoxEmulator::stats_t before = box.stats();
+    tf.adcs_box->execute();
+
+    // a ping and the telemetry block, each a write and a read
+    TEST_ASSERT_EQUAL(before.writes + 2, box.stats().writes);
+    TEST_ASSERT_EQUAL(before.reads + 2, box.stats().reads);
+
+    TEST_ASSERT_TRUE(tf.adcs_functional_p->get());
+    PAN_TEST_ASSERT_EQUAL_FLOAT_LIN_VEC(lin::Vector3f({0.01, 0.02, -0.03}), tf.gyr_vec_fp->get(), 1e-4);
+    TEST_ASSERT_EQUAL(adcs::SSAMode::SSA_COMPLETE, tf.ssa_mode_fp->get());
+    PAN_TEST_ASSERT_EQUAL_FLOAT_LIN_VEC(lin::Vector3f({0, 0, 1}), tf.ssa_vec_fp->get(), 1e-4);
+    TEST_ASSERT_FALSE(tf.havt_read_vector_fp[adcs::havt::Index::RWA_WHEEL2]->get());
+    TEST_ASSERT_TRUE(tf.havt_read_vector_fp[adcs::havt::Index::RWA_WHEEL1]->get());
+}
+
+static long long now_us = 0;
+static long long fake_clock() { return now_us; }
+
+/**
+ * @brief Testing suite for the monitor reading the telemetry block in the
+ * background of the control cycle
+ * 
+ */
+void test_execute_queued(){
+    Devices::ADCSBoxEmulator::config_t config;
+    config.rate = {{0.01, 0.02, -0.03}};
+    Devices::ADCSBoxEmulator box(config);
+    now_us = 0;
+    box.set_clock(fake_clock);
+    Devices::I2CScheduler scheduler;
+    scheduler.set_clock(fake_clock);
+    scheduler.attach_target(Devices::ADCS::ADDRESS, &box);
+
+    Devices::ADCSBoxEmulator::attach(&box);
+    TestFixture tf(&scheduler);
+    Devices::ADCSBoxEmulator::attach(nullptr);
+
+    // nothing has been read in the background yet, so the first cycle reads
+    // blocking and queues the next block
+    tf.adcs_box->execute();
+    TEST_ASSERT_EQUAL(2, box.stats().writes);
+    TEST_ASSERT_EQUAL(2, box.stats().reads);
+    TEST_ASSERT_FALSE(scheduler.idle());
+    TEST_ASSERT_TRUE(tf.adcs_functional_p->get());
+
+    // later cycles only take the block read since the last one
+    for (unsigned int i = 0; i < 3; i++) {
+        now_us += 10000;
+        scheduler.dispatch();
+        const Devices::ADCSBoxEmulator::stats_t before = box.stats();
+        tf.adcs_box->execute();
+        TEST_ASSERT_EQUAL(before.writes, box.stats().writes);
+        TEST_ASSERT_EQUAL(before.reads, box.stats().reads);
+        TEST_ASSERT_TRUE(tf.adcs_functional_p->get());
+        PAN_TEST_ASSERT_EQUAL_FLOAT_LIN_VEC(lin::Vector3f({0.01, 0.02, -0.03}), tf.gyr_vec_fp->get(), 1e-4);
+    }
+    // a pointer write and a block read for each of the three blocks taken
+    TEST_ASSERT_EQUAL(6, scheduler.stats().transactions);
+    TEST_ASSERT_EQUAL(0, scheduler.stats().failures);
+
+    // a failed background read falls back to reading blocking
+    scheduler.attach_target(Devices::ADCS::ADDRESS, nullptr);
+    now_us += 10000;
+    scheduler.dispatch();
+    const Devices::ADCSBoxEmulator::stats_t before = box.stats();
+    tf.adcs_box->execute();
+    TEST_ASSERT_EQUAL(before.reads + 2, box.stats().reads);
+}
+#endif
+
 int test_control_task()
 {
     UNITY_BEGIN();
@@ -346,6 +473,11 @@ int test_control_task()
     RUN_TEST(test_execute_ssa);
     RUN_TEST(test_execute_havt);
     RUN_TEST(test_execute_havt_faults);
+    RUN_TEST(test_execute_telemetry);
+#ifdef DESKTOP
+    RUN_TEST(test_execute_box_emulator);
+    RUN_TEST(test_execute_queued);
+#endif
     return UNITY_END();
 }
 
@@ -0,0 +1,92 @@
+#include <adcs/utl/convert.hpp>
+#include <adcs/constants.hpp>
+
+#include "../custom_assertions.hpp"
+
+#include <cmath>
+#include <limits>
+
+using namespace adcs;
+
+// Difference allowed between the array and scalar conversions, in units in
+// the last place of the largest value of the range.
+static constexpr float max_ulps = 4.0f;
+
+// Checks that the lowest and highest values of T convert to the ends of the
+// range.
+template <typename T>
+static void check_endpoints(float min, float max) {
+    const T t[2] = {std::numeric_limits<T>::min(), std::numeric_limits<T>::max()};
+    float f[2];
+    utl::fp(t, f, 2, min, max);
+    TEST_ASSERT_FLOAT_WITHIN(0.0f, min, f[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.0f, max, f[1]);
+}
+
+// Checks that every value of T converts to within max_ulps of the scalar
+// conversion. Values are converted in blocks to keep the buffers small.
+template <typename T>
+static void check_matches_scalar(float min, float max) {
+    const float mag = std::fmax(std::fabs(min), std::fabs(max));
+    const float delta = max_ulps * (std::nextafter(mag, 2.0f * mag + 1.0f) - mag);
+
+    constexpr unsigned int block = 256;
+    T t[block];
+    float f[block];
+    long code = std::numeric_limits<T>::min();
+    while (code <= std::numeric_limits<T>::max()) {
+        unsigned int n = 0;
+        for (; n < block && code <= std::numeric_limits<T>::max(); n++, code++) t[n] = static_cast<T>(code);
+        utl::fp(t, f, n, min, max);
+        for (unsigned int i = 0; i < n; i++)
+            TEST_ASSERT_FLOAT_WITHIN(delta, utl::fp(t[i], min, max), f[i]);
+    }
+}
+
+// Ranges of the ADCS registers decoded with the array conversions.
+void test_fp_array_endpoints() {
+    check_endpoints<unsigned short>(rwa::min_speed_read, rwa::max_speed_read);
+    check_endpoints<unsigned short>(rwa::min_ramp_rd, rwa::max_ramp_rd);
+    check_endpoints<unsigned short>(imu::min_mag1_rd_mag, imu::max_mag1_rd_mag);
+    check_endpoints<unsigned short>(imu::min_mag2_rd_mag, imu::max_mag2_rd_mag);
+    check_endpoints<unsigned short>(imu::min_rd_omega, imu::max_rd_omega);
+    check_endpoints<signed short>(imu::min_mag1_rd_mag, imu::max_mag1_rd_mag);
+    check_endpoints<signed short>(imu::min_mag2_rd_mag, imu::max_mag2_rd_mag);
+    check_endpoints<signed short>(imu::min_rd_omega, imu::max_rd_omega);
+    check_endpoints<unsigned char>(ssa::min_voltage_rd, ssa::max_voltage_rd);
+    check_endpoints<signed char>(imu::min_rd_temp, imu::max_rd_temp);
+}
+
+void test_fp_array_matches_scalar() {
+    check_matches_scalar<unsigned short>(rwa::min_speed_read, rwa::max_speed_read);
+    check_matches_scalar<unsigned short>(rwa::min_ramp_rd, rwa::max_ramp_rd);
+    check_matches_scalar<unsigned short>(imu::min_mag1_rd_mag, imu::max_mag1_rd_mag);
+    check_matches_scalar<unsigned short>(imu::min_mag2_rd_mag, imu::max_mag2_rd_mag);
+    check_matches_scalar<unsigned short>(imu::min_rd_omega, imu::max_rd_omega);
+    check_matches_scalar<signed short>(imu::min_mag1_rd_mag, imu::max_mag1_rd_mag);
+    check_matches_scalar<signed short>(imu::min_rd_omega, imu::max_rd_omega);
+    check_matches_scalar<unsigned char>(ssa::min_voltage_rd, ssa::max_voltage_rd);
+    check_matches_scalar<signed char>(imu::min_rd_temp, imu::max_rd_temp);
+}
+
+int test_adcs_convert() {
+    UNITY_BEGIN();
+    RUN_TEST(test_fp_array_endpoints);
+    RUN_TEST(test_fp_array_matches_scalar);
+    return UNITY_END();
+}
+
+#ifdef DESKTOP
+int main() {
+    return test_adcs_convert();
+}
+#else
+#include <Arduino.h>
+void setup() {
+    delay(2000);
+    Serial.begin(9600);
+    test_adcs_convert();
+}
+
+void loop() {}
+#endif
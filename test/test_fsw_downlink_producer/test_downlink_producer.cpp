@@ -17,10 +17,12 @@ struct TestFixture {
     WritableStateField<unsigned char>* shift_flows_id1_fp;
     WritableStateField<unsigned char>* shift_flows_id2_fp;
     WritableStateField<unsigned char>* toggle_flow_id_fp;
+    WritableStateField<bool>* compress_fp;
 
     TestFixture() : registry() {}
 
-    void init(const std::vector<DownlinkProducer::FlowData>& flow_data) {
+    void init(const std::vector<DownlinkProducer::FlowData>& flow_data,
+              const std::vector<TelemetryCompressor::FieldModel>& telemetry_model = {}) {
         // Create required field(s)
         cycle_count_fp = registry.create_readable_field<unsigned int>("pan.cycle_no");
 
@@ -31,13 +33,14 @@ struct TestFixture {
         foo1_fp->set(400);
 
         downlink_producer = std::make_unique<DownlinkProducer>(registry);
-        downlink_producer->init_flows(flow_data);
+        downlink_producer->init_flows(flow_data, telemetry_model);
         snapshot_ptr_fp = registry.find_internal_field_t<char*>("downlink.ptr");
         snapshot_size_bytes_fp = registry.find_internal_field_t<size_t>(
                                     "downlink.snap_size");
         shift_flows_id1_fp = registry.find_writable_field_t<unsigned char>("downlink.shift_id1");
         shift_flows_id2_fp = registry.find_writable_field_t<unsigned char>("downlink.shift_id2");
         toggle_flow_id_fp = registry.find_writable_field_t<unsigned char>("downlink.toggle_id");
+        compress_fp = registry.find_writable_field_t<bool>("downlink.compress");
     }
 };
 
@@ -502,6 +505,82 @@ void test_toggle() {
     TEST_ASSERT_EQUAL(0, tf.toggle_flow_id_fp->get()); 
 }
 
+/**
+ * @brief Test that fields round trip through the compressor, whether they are
+ * close to the reference or not.
+ */
+void test_compressor_roundtrip() {
+    const TelemetryCompressor::FieldModel m {"foo", 1000, 2};
+    std::vector<bool> encoded;
+    encoded.reserve(TelemetryCompressor::max_encoded_size(16));
+
+    const unsigned long long codes[4] = {1000, 1003, 997, 60000};
+    // Mode bit, unary quotient, stop bit and 2 remainder bits; the last code
+    // is too far from the reference and is sent raw.
+    const size_t expected_sizes[4] = {4, 5, 5, 17};
+    for (size_t i = 0; i < 4; i++) {
+        bit_array field_bits(16);
+        field_bits.set_ullong(codes[i]);
+
+        TEST_ASSERT_EQUAL(expected_sizes[i], TelemetryCompressor::encode(field_bits, m, encoded));
+        TEST_ASSERT_EQUAL(expected_sizes[i], TelemetryCompressor::encoded_size(codes[i], 16, m));
+
+        bit_array decoded_bits(16);
+        TEST_ASSERT_EQUAL(expected_sizes[i], TelemetryCompressor::decode(encoded, 0, m, decoded_bits));
+        TEST_ASSERT_EQUAL(codes[i], decoded_bits.to_ullong());
+
+        // A truncated field can't be decoded
+        encoded.pop_back();
+        TEST_ASSERT_EQUAL(0, TelemetryCompressor::decode(encoded, 0, m, decoded_bits));
+    }
+}
+
+void test_compressor_train() {
+    TelemetryCompressor::FieldModel m;
+
+    // Clustered codes are worth compressing
+    const std::vector<unsigned long long> clustered = {498, 500, 501, 503, 500, 499};
+    TEST_ASSERT_TRUE(TelemetryCompressor::train("foo", 16, clustered, &m));
+    TEST_ASSERT_EQUAL_STRING("foo", m.name.c_str());
+    TEST_ASSERT_EQUAL(500, m.reference);
+    TEST_ASSERT_LESS_THAN(4, m.k);
+
+    // Codes spread over the full range of the field are not
+    std::vector<unsigned long long> spread;
+    for (unsigned long long code = 0; code < 65536; code += 2048) spread.push_back(code);
+    TEST_ASSERT_FALSE(TelemetryCompressor::train("foo", 16, spread, &m));
+    TEST_ASSERT_FALSE(TelemetryCompressor::train("foo", 2, clustered, &m));
+}
+
+void test_compressed_downlink() {
+    TestFixture tf;
+
+    std::vector<DownlinkProducer::FlowData> flow_data = {
+        {
+            1, true, {"foo1"}
+        }
+    };
+    tf.init(flow_data, {{"foo1", 400, 0}});
+
+    // Compression is off by default, so the snapshot is unchanged
+    tf.downlink_producer->execute();
+    TEST_ASSERT_EQUAL(9, tf.snapshot_size_bytes_fp->get());
+    const char expected_outputs[9] = {'\x94', '\x00', '\x00', '\x00', '\x42', '\x60', '\x00', '\x00', '\x00'};
+    TEST_ASSERT_EQUAL_MEMORY(expected_outputs, tf.snapshot_ptr_fp->get(), 9);
+
+    // With compression on, foo1 matches the reference and takes up two bits:
+    // ceil((1 + 32 + 1 + 2)/8). The cycle count's MSB flags the compression.
+    tf.compress_fp->set(true);
+    tf.downlink_producer->execute();
+    TEST_ASSERT_EQUAL(5, tf.snapshot_size_bytes_fp->get());
+    const char expected_compressed_outputs[5] = {'\x94', '\x00', '\x00', '\x00', '\xe0'};
+    TEST_ASSERT_EQUAL_MEMORY(expected_compressed_outputs, tf.snapshot_ptr_fp->get(), 5);
+
+    // The buffer is still sized for the worst case, where every modeled field
+    // is sent raw.
+    TEST_ASSERT_EQUAL(9, tf.downlink_producer->compute_max_downlink_size());
+}
+
 int test_downlink_producer_task() {
     UNITY_BEGIN();
     RUN_TEST(test_task_initialization);
@@ -514,6 +593,9 @@ int test_downlink_producer_task() {
     RUN_TEST(test_shift_priorities);
     RUN_TEST(test_shift_statefield_cmd);
     RUN_TEST(test_toggle);
+    RUN_TEST(test_compressor_roundtrip);
+    RUN_TEST(test_compressor_train);
+    RUN_TEST(test_compressed_downlink);
     return UNITY_END();
 }
 
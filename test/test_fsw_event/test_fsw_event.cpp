@@ -14,7 +14,6 @@ struct TestFixtureEvent {
     std::vector<ReadableStateFieldBase*> event_data;
     ReadableStateField<unsigned int> *control_cycle_count_ptr;
     Event event;
-    size_t *event_ptr = nullptr;
 
     static char print_data[40];
     static const char* print_fn(const unsigned int ccno, std::vector<ReadableStateFieldBase*>& data) {
@@ -49,23 +48,11 @@ void test_single_event(TestFixtureEvent &tf, EventBase &event, unsigned int ccno
     tf.control_cycle_count_ptr->set(ccno);
     tf.data1_f.set(true);
     tf.data2_f.set(false);
-    
-    //save pointer before signaling
-    size_t event_ptr_prev = 0;
-    size_t event_ptr_curr = 0;
+
 
     // Verify that upon serialization, the values are written into the event's bitset in the way
     // that we would expect
-    if (tf.event_ptr != nullptr)
-    {
-        event_ptr_prev = *tf.event_ptr;
-    }
     event.signal();
-    if (tf.event_ptr != nullptr)
-    {
-        event_ptr_curr = *tf.event_ptr;
-        *tf.event_ptr = event_ptr_prev;
-    }
     const bit_array &ba = event.get_bit_array();
     TEST_ASSERT_EQUAL(ccno, ba.to_uint());
     TEST_ASSERT_EQUAL(true, ba[32]);
@@ -85,31 +72,13 @@ void test_single_event(TestFixtureEvent &tf, EventBase &event, unsigned int ccno
     TEST_ASSERT_EQUAL(tf.data1_f.get(), true);
     TEST_ASSERT_EQUAL(tf.data2_f.get(), false);
 
-    if (tf.event_ptr != nullptr)
-    {
-        *tf.event_ptr = event_ptr_curr;
-    }
-
     // Test that changes in the event values are picked up
     tf.data1_f.set(false);
     tf.data2_f.set(true);
-    if (tf.event_ptr != nullptr)
-    {
-        event_ptr_prev = *tf.event_ptr;
-    }
     event.signal();
-    if (tf.event_ptr != nullptr)
-    {
-        event_ptr_curr = *tf.event_ptr;
-        *tf.event_ptr = event_ptr_prev;
-    }
     const bit_array& ba2 = event.get_bit_array();
     TEST_ASSERT_EQUAL(false, ba2[32]);
     TEST_ASSERT_EQUAL(true, ba2[33]);
-    if (tf.event_ptr != nullptr)
-    {
-        *tf.event_ptr = event_ptr_curr;
-    }
 
     // Test that the event is correctly printed when a print is requested.
     const char *print_result = event.print();
@@ -131,34 +100,153 @@ public:
     EventStorage event_storage;
     StateFieldRegistryMock registry;
 
-    TestFixtureEventStorage(unsigned int num_events) : TestFixtureEvent(),
-                                                       event_storage("event", num_events, event_data, print_fn)
+    // Records are 34 bits long, so each one takes 5 bytes of the log.
+    TestFixtureEventStorage(size_t capacity_bytes, size_t window_size) : TestFixtureEvent(),
+        event_storage("event", capacity_bytes, window_size, event_data, print_fn)
     {
         event_storage.add_events_to_registry(registry);
-        event_ptr = &event_storage.event_ptr;
     }
 
-protected:
-    using TestFixtureEvent::event;
+    void signal(unsigned int ccno, bool data1, bool data2) {
+        control_cycle_count_ptr->set(ccno);
+        data1_f.set(data1);
+        data2_f.set(data2);
+        event_storage.signal();
+    }
+
+    // Check that the i-th record of the downlink window holds the given values
+    void check_record(size_t i, unsigned int ccno, bool data1, bool data2) {
+        event_storage.deserialize_record(i);
+        TEST_ASSERT_EQUAL(ccno, control_cycle_count_ptr->get());
+        TEST_ASSERT_EQUAL(data1, data1_f.get());
+        TEST_ASSERT_EQUAL(data2, data2_f.get());
+    }
 };
 
-// Test that the event storage correctly manages pointers for event storage.
+// Test that the event log is registered as a single event whose bitset is
+// its downlink window.
 void test_event_storage()
 {
-    TestFixtureEventStorage tf(99);
-    // Fields should have been created inside the state field registry.
-    tf.registry.find_event("event.1");
-    tf.registry.find_event("event.2");
-    tf.registry.find_event("event.3");
-    // Test that a field was added to the registry for every single sub-event.
-    TEST_ASSERT_EQUAL(99, tf.registry.events.size());
-
-    // Event storage should behave the same as an event.
-    for (int i = 0; i < 200; i++)
-    {
-        TEST_ASSERT_EQUAL((2 * i) % 99, *tf.event_ptr); //event signaled twice per single event, storage size 99
-        test_single_event(tf, tf.event_storage, i);
-    }
+    TestFixtureEventStorage tf(20, 3);
+    TEST_ASSERT_EQUAL(1, tf.registry.events.size());
+    TEST_ASSERT_NOT_NULL(tf.registry.find_event("event"));
+    TEST_ASSERT_EQUAL(4, tf.event_storage.capacity());
+
+    // 2 bits of record count followed by three 34-bit records
+    TEST_ASSERT_EQUAL(2 + 3 * 34, tf.event_storage.bitsize());
+    TEST_ASSERT_EQUAL(tf.event_storage.bitsize(), tf.event_storage.get_bit_array().size());
+
+    // An empty log downlinks an empty window
+    tf.event_storage.prepare_downlink();
+    TEST_ASSERT_EQUAL(0, tf.event_storage.window_count());
+    for (bool b : tf.event_storage.get_bit_array()) TEST_ASSERT_FALSE(b);
+
+    // Records are downlinked in the order they were signaled
+    tf.signal(20, true, false);
+    tf.signal(21, false, true);
+    TEST_ASSERT_EQUAL(2, tf.event_storage.num_unseen());
+    tf.event_storage.prepare_downlink();
+    TEST_ASSERT_EQUAL(2, tf.event_storage.window_count());
+    TEST_ASSERT_EQUAL(0, tf.event_storage.num_unseen());
+    tf.check_record(0, 20, true, false);
+    tf.check_record(1, 21, false, true);
+
+    // Records are only downlinked once
+    tf.event_storage.prepare_downlink();
+    TEST_ASSERT_EQUAL(0, tf.event_storage.window_count());
+
+    // Test that the event is correctly printed when a print is requested.
+    tf.signal(22, false, true);
+    tf.event_storage.prepare_downlink();
+    tf.event_storage.deserialize();
+    TEST_ASSERT_EQUAL_STRING("E: time: 22, data: 0, 1", tf.event_storage.print());
+}
+
+// Test that the oldest records are overwritten once the log is full, and that
+// the remaining records are drained over several windows.
+void test_event_storage_overwrite()
+{
+    TestFixtureEventStorage tf(20, 3);
+    for (unsigned int i = 0; i < 6; i++) tf.signal(100 + i, i % 2, i % 3 == 0);
+    TEST_ASSERT_EQUAL(4, tf.event_storage.num_unseen());
+
+    tf.event_storage.prepare_downlink();
+    TEST_ASSERT_EQUAL(3, tf.event_storage.window_count());
+    for (unsigned int i = 0; i < 3; i++) tf.check_record(i, 102 + i, (2 + i) % 2, (2 + i) % 3 == 0);
+
+    tf.event_storage.prepare_downlink();
+    TEST_ASSERT_EQUAL(1, tf.event_storage.window_count());
+    tf.check_record(0, 105, true, false);
+
+    // Unused records of the window are cleared
+    for (size_t i = 2 + 34; i < tf.event_storage.bitsize(); i++)
+        TEST_ASSERT_FALSE(tf.event_storage.get_bit_array()[i]);
+}
+
+// Test that records stay in the log until the snapshot carrying them is
+// confirmed, and are loaded again if a snapshot carrying them is dropped.
+void test_event_storage_confirm()
+{
+    TestFixtureEventStorage tf(20, 2);
+    tf.signal(10, true, false);
+    tf.signal(11, false, true);
+    tf.signal(12, true, true);
+
+    // Two windows are loaded in cycles 30 and 31
+    tf.control_cycle_count_ptr->set(30);
+    TEST_ASSERT_EQUAL(2, tf.event_storage.prepare_downlink());
+    tf.control_cycle_count_ptr->set(31);
+    TEST_ASSERT_EQUAL(1, tf.event_storage.prepare_downlink());
+    TEST_ASSERT_EQUAL(0, tf.event_storage.num_unseen());
+    TEST_ASSERT_EQUAL(3, tf.event_storage.num_unconfirmed());
+
+    // Confirming a snapshot that carried no records changes nothing
+    tf.event_storage.confirm_downlink(29);
+    TEST_ASSERT_EQUAL(3, tf.event_storage.num_unconfirmed());
+
+    // The first window reaches the ground, the second is dropped
+    tf.event_storage.confirm_downlink(30);
+    TEST_ASSERT_EQUAL(1, tf.event_storage.num_unconfirmed());
+    tf.event_storage.rewind_downlink(31);
+    TEST_ASSERT_EQUAL(1, tf.event_storage.num_unseen());
+
+    tf.control_cycle_count_ptr->set(32);
+    TEST_ASSERT_EQUAL(1, tf.event_storage.prepare_downlink());
+    tf.check_record(0, 12, true, true);
+    tf.event_storage.confirm_downlink(32);
+    TEST_ASSERT_EQUAL(0, tf.event_storage.num_unconfirmed());
+
+    // Dropping a snapshot only loads again the records it carried and those
+    // loaded after it. The windows before it can still be confirmed.
+    tf.signal(14, true, false);
+    tf.signal(15, false, false);
+    tf.signal(16, true, true);
+    tf.control_cycle_count_ptr->set(34);
+    TEST_ASSERT_EQUAL(2, tf.event_storage.prepare_downlink());
+    tf.control_cycle_count_ptr->set(35);
+    TEST_ASSERT_EQUAL(1, tf.event_storage.prepare_downlink());
+    tf.event_storage.rewind_downlink(33);
+    TEST_ASSERT_EQUAL(0, tf.event_storage.num_unseen());
+    tf.event_storage.rewind_downlink(35);
+    TEST_ASSERT_EQUAL(1, tf.event_storage.num_unseen());
+    tf.event_storage.confirm_downlink(34);
+    TEST_ASSERT_EQUAL(1, tf.event_storage.num_unconfirmed());
+    tf.control_cycle_count_ptr->set(36);
+    TEST_ASSERT_EQUAL(1, tf.event_storage.prepare_downlink());
+    tf.check_record(0, 16, true, true);
+    tf.event_storage.confirm_downlink(36);
+    TEST_ASSERT_EQUAL(0, tf.event_storage.num_unconfirmed());
+
+    // A restored log loads its unconfirmed records again
+    tf.signal(13, false, false);
+    tf.control_cycle_count_ptr->set(33);
+    tf.event_storage.prepare_downlink();
+    std::vector<unsigned char> checkpoint(tf.event_storage.checkpoint_size());
+    tf.event_storage.save_checkpoint(checkpoint.data());
+    tf.event_storage.load_checkpoint(checkpoint.data());
+    TEST_ASSERT_EQUAL(1, tf.event_storage.num_unseen());
+    TEST_ASSERT_EQUAL(1, tf.event_storage.prepare_downlink());
+    tf.check_record(0, 13, false, false);
 }
 
 #ifdef DESKTOP
@@ -166,6 +254,8 @@ int main() {
     UNITY_BEGIN();
     RUN_TEST(test_event);
     RUN_TEST(test_event_storage);
+    RUN_TEST(test_event_storage_overwrite);
+    RUN_TEST(test_event_storage_confirm);
     return UNITY_END();
 }
 #else
@@ -176,6 +266,8 @@ void setup() {
     UNITY_BEGIN();
     RUN_TEST(test_event);
     RUN_TEST(test_event_storage);
+    RUN_TEST(test_event_storage_overwrite);
+    RUN_TEST(test_event_storage_confirm);
     UNITY_END();
 }
 
@@ -36,10 +36,15 @@ void TestFixtureMainFHBase::set_fault_handling(bool state)
 
 TestFixtureMainFHMocked::TestFixtureMainFHMocked() : TestFixtureMainFHBase()
 {
-    num_fault_handler_machines = fault_handler->fault_handler_machines.size();
+    num_simple_faults = fault_handler->simple_faults.size();
+    num_fault_handler_machines = num_simple_faults + fault_handler->fault_handler_machines.size();
+
+    // Every simple fault is active in standby, so their responses are only
+    // controlled by overriding or suppressing the faults.
+    mission_state_fp->set(static_cast<unsigned char>(mission_state_t::standby));
 
     // Replace all fault handler submachines with mocks
-    for (size_t i = 0; i < num_fault_handler_machines; i++)
+    for (size_t i = 0; i < fault_handler->fault_handler_machines.size(); i++)
     {
         fault_handler->fault_handler_machines[i] = std::make_unique<FaultHandlerMachineMock>(registry);
     }
@@ -47,8 +52,25 @@ TestFixtureMainFHMocked::TestFixtureMainFHMocked() : TestFixtureMainFHBase()
 
 void TestFixtureMainFHMocked::set_fault_machine_response(size_t idx, fault_response_t response)
 {
+    if (idx < num_simple_faults)
+    {
+        Fault *fault = fault_handler->simple_faults.faults[idx];
+        if (response == fault_response_t::none)
+        {
+            fault->un_override();
+            fault->suppress();
+        }
+        else
+        {
+            fault->unsuppress();
+            fault->override();
+            fault_handler->simple_faults.responses[idx] = response;
+        }
+        return;
+    }
+
     static_cast<FaultHandlerMachineMock *>(
-        fault_handler->fault_handler_machines[idx].get())
+        fault_handler->fault_handler_machines[idx - num_simple_faults].get())
         ->set(response);
 }
 
@@ -56,13 +56,18 @@ public:
 
 /**
  * @brief This test fixture replaces the submachines of the main fault
- * handler with mocked fault handlers so that it's easy to control
- * the submachine responses. This allows exhaustive testing of all fault
- * combinations underneath the MainFaultHandler.
+ * handler with mocked fault handlers, and overrides or suppresses the faults
+ * in its simple fault table, so that it's easy to control the submachine
+ * responses. This allows exhaustive testing of all fault combinations
+ * underneath the MainFaultHandler.
+ *
+ * The simple faults come first in the indexing of the responses, followed by
+ * the fault handler machines.
  */
 class TestFixtureMainFHMocked : public TestFixtureMainFHBase
 {
 public:
+    size_t num_simple_faults = 0;
     size_t num_fault_handler_machines = 0;
 
     /**
@@ -0,0 +1,211 @@
+#include <fsw/FCCode/Devices/I2CScheduler.hpp>
+#include <vector>
+
+#include "../custom_assertions.hpp"
+
+using namespace Devices;
+
+#ifdef DESKTOP
+
+static long long now_us = 0;
+static long long fake_clock() { return now_us; }
+
+// Records writes and answers reads with an incrementing count
+class FakeTarget : public I2CTarget {
+  public:
+    std::vector<std::vector<unsigned char>> writes;
+    unsigned int reads = 0;
+
+    void receive(const unsigned char *data, size_t len) override {
+        writes.emplace_back(data, data + len);
+    }
+    void request(unsigned char *data, size_t len) override {
+        for (size_t i = 0; i < len; i++) data[i] = i;
+        reads++;
+    }
+};
+
+// Logs the order callbacks ran in, as context index and result
+static std::vector<int> calls;
+static void log_call(void *context, bool ok) {
+    const int i = (int)(size_t)context;
+    calls.push_back(ok ? i : -i);
+}
+
+class TestFixture {
+  public:
+    I2CScheduler scheduler;
+    FakeTarget target;
+
+    TestFixture() {
+        now_us = 0;
+        calls.clear();
+        scheduler.set_clock(fake_clock);
+        scheduler.attach_target(0x4E, &target);
+    }
+};
+
+void test_deferred_callback()
+{
+    TestFixture tf;
+    const unsigned char data[2] = {0x01, 0x02};
+    TEST_ASSERT_TRUE(tf.scheduler.write(0x4E, data, 2, log_call, (void *)1));
+    TEST_ASSERT_FALSE(tf.scheduler.idle());
+
+    // A two byte write takes 29 bits, or 73 us at 400 kHz
+    now_us = 72;
+    tf.scheduler.dispatch();
+    TEST_ASSERT_EQUAL(0, calls.size());
+    TEST_ASSERT_EQUAL(0, tf.target.writes.size());
+
+    // The transaction completes as the clock passes its end, but its callback
+    // waits for dispatch
+    now_us = 73;
+    tf.scheduler.poll();
+    TEST_ASSERT_TRUE(tf.scheduler.idle());
+    TEST_ASSERT_EQUAL(1, tf.target.writes.size());
+    TEST_ASSERT_EQUAL(0, calls.size());
+
+    tf.scheduler.dispatch();
+    TEST_ASSERT_EQUAL(1, calls.size());
+    TEST_ASSERT_EQUAL(1, calls[0]);
+    TEST_ASSERT_EQUAL(2, tf.target.writes[0].size());
+    TEST_ASSERT_EQUAL(0x02, tf.target.writes[0][1]);
+    TEST_ASSERT_EQUAL(73, tf.scheduler.stats().bus_us);
+}
+
+void test_order()
+{
+    TestFixture tf;
+    const unsigned char pointer[2] = {0x00, 0x30};
+    const unsigned char subaddr = 0x10;
+    unsigned char block[4] = {0};
+    unsigned char reg[2] = {0};
+    tf.scheduler.write(0x4E, pointer, 2, log_call, (void *)1);
+    tf.scheduler.read(0x4E, nullptr, 0, block, 4, log_call, (void *)2);
+    tf.scheduler.read(0x4E, &subaddr, 1, reg, 2, log_call, (void *)3);
+
+    // Transactions run back to back, taking 73, 118 and 123 us
+    now_us = 73 + 117;
+    tf.scheduler.dispatch();
+    TEST_ASSERT_EQUAL(1, calls.size());
+    now_us = 73 + 118;
+    tf.scheduler.dispatch();
+    TEST_ASSERT_EQUAL(2, calls.size());
+    TEST_ASSERT_EQUAL(3, block[3]);
+    now_us = 1000;
+    tf.scheduler.dispatch();
+    TEST_ASSERT_EQUAL(3, calls.size());
+    TEST_ASSERT_EQUAL(2, calls[1]);
+    TEST_ASSERT_EQUAL(3, calls[2]);
+    TEST_ASSERT_EQUAL(1, reg[1]);
+
+    // The subaddress is written before the read
+    TEST_ASSERT_EQUAL(2, tf.target.writes.size());
+    TEST_ASSERT_EQUAL(1, tf.target.writes[1].size());
+    TEST_ASSERT_EQUAL(0x10, tf.target.writes[1][0]);
+    TEST_ASSERT_EQUAL(2, tf.target.reads);
+    TEST_ASSERT_EQUAL(73 + 118 + 123, tf.scheduler.stats().bus_us);
+    TEST_ASSERT_EQUAL(3, tf.scheduler.stats().transactions);
+
+    // An idle bus starts the next transaction when it is enqueued
+    now_us = 2000;
+    tf.scheduler.write(0x4E, pointer, 2, log_call, (void *)4);
+    now_us = 2073;
+    tf.scheduler.dispatch();
+    TEST_ASSERT_EQUAL(4, calls.size());
+}
+
+void test_nack()
+{
+    TestFixture tf;
+    unsigned char block[4] = {0xFF, 0xFF, 0xFF, 0xFF};
+    tf.scheduler.read(0x20, nullptr, 0, block, 4, log_call, (void *)1);
+    now_us = 1000;
+    tf.scheduler.dispatch();
+    TEST_ASSERT_EQUAL(1, calls.size());
+    TEST_ASSERT_EQUAL(-1, calls[0]);
+    TEST_ASSERT_EQUAL(0xFF, block[0]);
+    TEST_ASSERT_EQUAL(1, tf.scheduler.stats().failures);
+}
+
+void test_full()
+{
+    TestFixture tf;
+    const unsigned char data[I2CScheduler::MAX_WRITE_LEN + 1] = {0};
+    TEST_ASSERT_FALSE(tf.scheduler.write(0x4E, data, I2CScheduler::MAX_WRITE_LEN + 1));
+    for (unsigned int i = 0; i < I2CScheduler::MAX_TRANSACTIONS; i++)
+        TEST_ASSERT_TRUE(tf.scheduler.write(0x4E, data, 1));
+    TEST_ASSERT_FALSE(tf.scheduler.write(0x4E, data, 1));
+
+    // Completed transactions hold their slots until they are dispatched
+    now_us = 10000;
+    tf.scheduler.poll();
+    TEST_ASSERT_TRUE(tf.scheduler.idle());
+    TEST_ASSERT_FALSE(tf.scheduler.write(0x4E, data, 1));
+    tf.scheduler.dispatch();
+    TEST_ASSERT_TRUE(tf.scheduler.write(0x4E, data, 1));
+}
+
+void test_finish()
+{
+    TestFixture tf;
+    const unsigned char data[2] = {0x01, 0x02};
+    tf.scheduler.write(0x4E, data, 2, log_call, (void *)1);
+    tf.scheduler.write(0x4E, data, 2, log_call, (void *)2);
+
+    // Waiting drains the queue and counts the time left on the bus
+    now_us = 50;
+    tf.scheduler.finish();
+    TEST_ASSERT_TRUE(tf.scheduler.idle());
+    TEST_ASSERT_EQUAL(2, tf.target.writes.size());
+    TEST_ASSERT_EQUAL(2 * 73 - 50, tf.scheduler.stats().wait_us);
+    TEST_ASSERT_EQUAL(0, calls.size());
+    tf.scheduler.dispatch();
+    TEST_ASSERT_EQUAL(2, calls.size());
+
+    // Blocking calls wait on the attached scheduler only
+    tf.scheduler.write(0x4E, data, 2);
+    I2CScheduler::finish_attached();
+    TEST_ASSERT_FALSE(tf.scheduler.idle());
+    I2CScheduler::attach(&tf.scheduler);
+    I2CScheduler::finish_attached();
+    TEST_ASSERT_TRUE(tf.scheduler.idle());
+    {
+        TestFixture other;
+        I2CScheduler::attach(&other.scheduler);
+    }
+    TEST_ASSERT_NULL(I2CScheduler::attached());
+}
+
+#endif
+
+int test_i2c_scheduler()
+{
+    UNITY_BEGIN();
+#ifdef DESKTOP
+    RUN_TEST(test_deferred_callback);
+    RUN_TEST(test_order);
+    RUN_TEST(test_nack);
+    RUN_TEST(test_full);
+    RUN_TEST(test_finish);
+#endif
+    return UNITY_END();
+}
+
+#ifdef DESKTOP
+int main()
+{
+    return test_i2c_scheduler();
+}
+#else
+#include <Arduino.h>
+void setup()
+{
+    delay(2000);
+    Serial.begin(9600);
+    test_i2c_scheduler();
+}
+
+void loop() {}
+#endif
@@ -0,0 +1,141 @@
+#include <fsw/FCCode/Drivers/Piksi.hpp>
+#include <memory>
+
+#include "../custom_assertions.hpp"
+
+using namespace Devices;
+
+#ifdef DESKTOP
+
+static long long now_us = 0;
+static long long fake_clock() { return now_us; }
+
+// Time at which the first n bytes of the log have arrived at the serial rate
+static long long arrival_us(size_t n) { return (n * 10000000LL + Piksi::BAUD_RATE - 1) / Piksi::BAUD_RATE; }
+
+class TestFixture {
+  public:
+    std::vector<unsigned char> bytes;
+    std::unique_ptr<PiksiSbpLog> sbp_log;
+    std::unique_ptr<Piksi> piksi;
+
+    TestFixture(double speed, bool rtk, unsigned int epochs = 1)
+    {
+        PiksiSbpLog::generate(epochs, rtk, bytes);
+        init(speed);
+    }
+
+    void init(double speed)
+    {
+        PiksiSbpLog::config_t config;
+        config.speed = speed;
+        sbp_log = std::make_unique<PiksiSbpLog>(bytes, config);
+        now_us = 0;
+        sbp_log->set_clock(fake_clock);
+        piksi = std::make_unique<Piksi>("piksi", sbp_log.get());
+        TEST_ASSERT_TRUE(piksi->setup());
+    }
+};
+
+void test_canned_without_log()
+{
+    Piksi piksi("piksi", nullptr);
+    piksi.set_read_return(1);
+    TEST_ASSERT_EQUAL(1, piksi.read_all());
+}
+
+void test_spp()
+{
+    TestFixture tf(0, false);
+    TEST_ASSERT_EQUAL(0, tf.piksi->read_all());
+
+    msg_gps_time_t time;
+    tf.piksi->get_gps_time(&time);
+    TEST_ASSERT_EQUAL(2100, time.wn);
+    TEST_ASSERT_EQUAL(0, time.tow);
+
+    std::array<double, 3> pos;
+    tf.piksi->get_pos_ecef(&pos);
+    TEST_ASSERT_DOUBLE_WITHIN(1e-3, 6.778e6, pos[0]);
+    TEST_ASSERT_EQUAL(8, tf.piksi->get_pos_ecef_nsats());
+    TEST_ASSERT_TRUE(tf.piksi->is_functional());
+
+    // Nothing left to read
+    TEST_ASSERT_EQUAL(4, tf.piksi->read_all());
+}
+
+void test_rtk()
+{
+    TestFixture tf(0, true);
+    TEST_ASSERT_EQUAL(1, tf.piksi->read_all());
+
+    std::array<double, 3> baseline;
+    tf.piksi->get_baseline_ecef(&baseline);
+    TEST_ASSERT_DOUBLE_WITHIN(1e-9, 100000, baseline[0]);
+    TEST_ASSERT_EQUAL(1, tf.piksi->get_baseline_ecef_flags());
+}
+
+void test_partial_frames()
+{
+    // At the Piksi's serial rate, the epoch takes several control cycles to
+    // arrive, and frames are split between reads.
+    TestFixture tf(1, false, 2);
+    const size_t epoch_bytes = tf.bytes.size() / 2;
+
+    // Start the log's clock, then let the first 20 bytes arrive. The GPS time
+    // frame is 19 bytes long, and the position frame is cut short.
+    TEST_ASSERT_EQUAL(4, tf.piksi->read_all());
+    now_us = arrival_us(20);
+    TEST_ASSERT_EQUAL(2, tf.piksi->read_all());
+
+    // The rest of the epoch completes the position and velocity
+    now_us = arrival_us(epoch_bytes);
+    TEST_ASSERT_EQUAL(2, tf.piksi->read_all());
+    std::array<double, 3> pos;
+    tf.piksi->get_pos_ecef(&pos);
+    TEST_ASSERT_DOUBLE_WITHIN(1e-3, 6.778e6, pos[0]);
+
+    // An epoch read in one go has a fix again
+    now_us = arrival_us(2 * epoch_bytes);
+    TEST_ASSERT_EQUAL(0, tf.piksi->read_all());
+    TEST_ASSERT_TRUE(tf.sbp_log->done());
+}
+
+void test_crc_error()
+{
+    TestFixture tf(0, false);
+    tf.bytes[10] ^= 0xFF; // Inside the payload of the GPS time
+    tf.init(0);
+    TEST_ASSERT_EQUAL(3, tf.piksi->read_all());
+}
+#endif
+
+int test_piksi_sbp_log()
+{
+    UNITY_BEGIN();
+#ifdef DESKTOP
+    RUN_TEST(test_canned_without_log);
+    RUN_TEST(test_spp);
+    RUN_TEST(test_rtk);
+    RUN_TEST(test_partial_frames);
+    RUN_TEST(test_crc_error);
+#endif
+    return UNITY_END();
+}
+
+#ifdef DESKTOP
+int main()
+{
+    return test_piksi_sbp_log();
+}
+#else
+#include <Arduino.h>
+void setup()
+{
+    delay(2000);
+    Serial.begin(9600);
+    test_piksi_sbp_log();
+}
+
+void loop() {}
+#endif
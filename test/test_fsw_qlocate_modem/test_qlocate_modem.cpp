@@ -0,0 +1,197 @@
+#include <fsw/FCCode/Drivers/QLocate.hpp>
+#include <cstring>
+
+#include "../custom_assertions.hpp"
+
+using namespace Devices;
+
+#ifdef DESKTOP
+
+static long long now_us = 0;
+static long long fake_clock() { return now_us; }
+
+class TestFixture {
+  public:
+    QLocateModem modem;
+    QLocate quake;
+
+    TestFixture(const QLocateModem::config_t &config) : modem(config), quake("Quake", &modem)
+    {
+        now_us = 0;
+        modem.set_clock(fake_clock);
+    }
+
+    // Runs the configuration sequence of QuakeControlTask, one control
+    // cycle per step
+    void configure()
+    {
+        TEST_ASSERT_EQUAL(OK, quake.query_config_1());
+        now_us += 170000;
+        TEST_ASSERT_EQUAL(OK, quake.query_config_2());
+        now_us += 170000;
+        TEST_ASSERT_EQUAL(OK, quake.query_config_3());
+        now_us += 170000;
+        TEST_ASSERT_EQUAL(OK, quake.get_config());
+    }
+
+    void write(const char *msg)
+    {
+        TEST_ASSERT_EQUAL(OK, quake.query_sbdwb_1(strlen(msg)));
+        now_us += 170000;
+        TEST_ASSERT_EQUAL(OK, quake.query_sbdwb_2(msg, strlen(msg)));
+        now_us += 170000;
+        TEST_ASSERT_EQUAL(0, quake.get_sbdwb());
+    }
+
+    void transceive()
+    {
+        TEST_ASSERT_EQUAL(OK, quake.query_sbdix_1());
+        now_us += 1000000;
+        TEST_ASSERT_EQUAL(OK, quake.get_sbdix());
+    }
+};
+
+static QLocateModem::config_t default_config()
+{
+    QLocateModem::config_t config;
+    config.session_latency_ms = 1000;
+    return config;
+}
+
+void test_config()
+{
+    TestFixture tf(default_config());
+
+    // Before configuration, the modem echoes commands and answers verbosely.
+    TEST_ASSERT_EQUAL(OK, tf.quake.query_is_functional_1());
+    TEST_ASSERT_EQUAL(CONSUME_FAIL, tf.quake.get_is_functional());
+
+    tf.configure();
+    TEST_ASSERT_EQUAL(OK, tf.quake.query_is_functional_1());
+    TEST_ASSERT_EQUAL(OK, tf.quake.get_is_functional());
+}
+
+void test_session()
+{
+    TestFixture tf(default_config());
+    tf.configure();
+    TEST_ASSERT_TRUE(tf.modem.inject_mt("uplink", 6));
+    tf.write("hello");
+
+    // The session result only arrives after the session latency.
+    TEST_ASSERT_EQUAL(OK, tf.quake.query_sbdix_1());
+    now_us += 999000;
+    TEST_ASSERT_EQUAL(PORT_UNAVAILABLE, tf.quake.get_sbdix());
+    now_us += 1000;
+    TEST_ASSERT_EQUAL(OK, tf.quake.get_sbdix());
+    TEST_ASSERT_EQUAL(0, tf.quake.sbdix_r[0]);
+    TEST_ASSERT_EQUAL(1, tf.quake.sbdix_r[2]);
+    TEST_ASSERT_EQUAL(6, tf.quake.sbdix_r[4]);
+    TEST_ASSERT_EQUAL(0, tf.quake.sbdix_r[5]);
+
+    std::string mo;
+    TEST_ASSERT_TRUE(tf.modem.collect_mo(mo));
+    TEST_ASSERT_EQUAL_STRING("hello", mo.c_str());
+    TEST_ASSERT_FALSE(tf.modem.collect_mo(mo));
+
+    TEST_ASSERT_EQUAL(OK, tf.quake.query_sbdrb_1());
+    TEST_ASSERT_EQUAL(OK, tf.quake.get_sbdrb());
+    TEST_ASSERT_EQUAL_STRING("uplink", tf.quake.mt_message);
+
+    TEST_ASSERT_EQUAL(1, tf.modem.stats().sessions);
+    TEST_ASSERT_EQUAL(5, tf.modem.stats().mo_bytes);
+    TEST_ASSERT_EQUAL(6, tf.modem.stats().mt_bytes);
+}
+
+void test_failed_session()
+{
+    QLocateModem::config_t config = default_config();
+    config.failure_rate = 1.0;
+    TestFixture tf(config);
+    tf.configure();
+    tf.modem.inject_mt("uplink", 6);
+    tf.write("hello");
+    tf.transceive();
+
+    TEST_ASSERT_EQUAL(32, tf.quake.sbdix_r[0]);
+    TEST_ASSERT_EQUAL(2, tf.quake.sbdix_r[2]);
+    TEST_ASSERT_EQUAL(1, tf.quake.sbdix_r[5]);
+    std::string mo;
+    TEST_ASSERT_FALSE(tf.modem.collect_mo(mo));
+    TEST_ASSERT_EQUAL(1, tf.modem.stats().failed_sessions);
+}
+
+void test_queue_depth()
+{
+    QLocateModem::config_t config = default_config();
+    config.mo_queue_depth = 1;
+    config.mt_queue_depth = 1;
+    TestFixture tf(config);
+    tf.configure();
+
+    TEST_ASSERT_TRUE(tf.modem.inject_mt("a", 1));
+    TEST_ASSERT_FALSE(tf.modem.inject_mt("b", 1));
+
+    // The second message can't be delivered until the first is collected.
+    tf.write("first");
+    tf.transceive();
+    TEST_ASSERT_EQUAL(0, tf.quake.sbdix_r[0]);
+    tf.write("second");
+    tf.transceive();
+    TEST_ASSERT_EQUAL(10, tf.quake.sbdix_r[0]);
+
+    std::string mo;
+    TEST_ASSERT_TRUE(tf.modem.collect_mo(mo));
+    tf.transceive();
+    TEST_ASSERT_EQUAL(0, tf.quake.sbdix_r[0]);
+    TEST_ASSERT_TRUE(tf.modem.collect_mo(mo));
+    TEST_ASSERT_EQUAL_STRING("second", mo.c_str());
+}
+
+void test_byte_rate()
+{
+    QLocateModem::config_t config = default_config();
+    config.byte_rate = 1000;
+    TestFixture tf(config);
+    tf.configure();
+
+    // "READY\r\n" takes 7 ms to arrive at 1000 bytes per second.
+    TEST_ASSERT_EQUAL(OK, tf.quake.query_sbdwb_1(5));
+    now_us += 6000;
+    TEST_ASSERT_EQUAL(PORT_UNAVAILABLE, tf.quake.query_sbdwb_2("hello", 5));
+    now_us += 1000;
+    TEST_ASSERT_EQUAL(OK, tf.quake.query_sbdwb_2("hello", 5));
+    now_us += 5000;
+    TEST_ASSERT_EQUAL(0, tf.quake.get_sbdwb());
+}
+#endif
+
+int test_qlocate_modem()
+{
+    UNITY_BEGIN();
+#ifdef DESKTOP
+    RUN_TEST(test_config);
+    RUN_TEST(test_session);
+    RUN_TEST(test_failed_session);
+    RUN_TEST(test_queue_depth);
+    RUN_TEST(test_byte_rate);
+#endif
+    return UNITY_END();
+}
+
+#ifdef DESKTOP
+int main()
+{
+    return test_qlocate_modem();
+}
+#else
+#include <Arduino.h>
+void setup()
+{
+    delay(2000);
+    Serial.begin(9600);
+    test_qlocate_modem();
+}
+
+void loop() {}
+#endif
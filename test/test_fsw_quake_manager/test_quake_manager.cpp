@@ -7,6 +7,8 @@
 #include "../custom_assertions.hpp"
 
 #include <fsw/FCCode/GomspaceController.hpp>
+#include <fsw/FCCode/DownlinkProducer.hpp>
+#include <common/EventStorage.hpp>
 
 // Check that radio state x matches the current radio state
 #define assert_radio_state(x)                                                                   \
@@ -39,6 +41,7 @@ public:
     // Input state fields to quake manager
     std::shared_ptr<InternalStateField<char *>> radio_mo_packet_fp;
     std::shared_ptr<InternalStateField<size_t>> snapshot_size_fp;
+    std::shared_ptr<InternalStateField<unsigned char>> snapshot_priority_fp;
 
     // Output state fields from quake manager
     WritableStateField<unsigned int> *max_wait_cycles_fp;
@@ -48,6 +51,8 @@ public:
     ReadableStateField<int> *radio_err_fp;
     ReadableStateField<unsigned char> *radio_state_fp;
     ReadableStateField<unsigned int> *last_checkin_cycle_fp;
+    ReadableStateField<unsigned int> *mo_queue_depth_fp;
+    ReadableStateField<unsigned int> *mo_dropped_bytes_fp;
 
     //gomspace flag for power cycling power check
     std::shared_ptr<WritableStateField<bool>> radio_power_cycle_fp;
@@ -61,9 +66,11 @@ public:
         // Create external field dependencies
         snapshot_size_fp = registry.create_internal_field<size_t>("downlink.snap_size");
         radio_mo_packet_fp = registry.create_internal_field<char *>("downlink.ptr");
+        snapshot_priority_fp = registry.create_internal_field<unsigned char>("downlink.priority");
         // Initialize external fields
         snapshot_size_fp->set(static_cast<int>(350));
         radio_mo_packet_fp->set((char *)snap1);
+        snapshot_priority_fp->set(DownlinkProducer::normal_priority);
         TimedControlTaskBase::control_cycle_count = initCycles;
 
         //create gomspace power cycling field
@@ -80,6 +87,8 @@ public:
         radio_err_fp = registry.find_readable_field_t<int>("radio.err");
         radio_state_fp = registry.find_readable_field_t<unsigned char>("radio.state");
         last_checkin_cycle_fp = registry.find_readable_field_t<unsigned int>("radio.last_comms_ccno");
+        mo_queue_depth_fp = registry.find_readable_field_t<unsigned int>("radio.mo_depth");
+        mo_dropped_bytes_fp = registry.find_readable_field_t<unsigned int>("radio.mo_dropped");
 
         // Initialize internal fields
         radio_state_fp->set(radio_state);
@@ -364,6 +373,12 @@ char *snap2 = (char *)"111111111111111111111111111111111111111111111111111111111
                       "4444444444444444444444444444444444444444444444444444444444444444444444"
                       "5555555555555555555555555555555555555555555555555555555555555555555555";
 
+char *snap3 = (char *)"6666666666666666666666666666666666666666666666666666666666666666666666"
+                      "7777777777777777777777777777777777777777777777777777777777777777777777"
+                      "8888888888888888888888888888888888888888888888888888888888888888888888"
+                      "9999999999999999999999999999999999999999999999999999999999999999999999"
+                      "0000000000000000000000000000000000000000000000000000000000000000000000";
+
 void check_buf_bytes(const char *buf1, const char *buf2, size_t size)
 {
     for (size_t i = 0; i < size; i++)
@@ -516,10 +531,10 @@ void test_same_snap_after_sbdix_recovers()
     tf.execUntilChange(); // transcieve DDDDD
 }
 
-void test_new_snap_after_sbdix_fail()
+void test_resume_snap_after_sbdix_fail()
 {
     // Same setup as above, but now we keep failing SBDIX. Upon running out of transceive cycles, we should
-    // transition to write and then write a new snapshot
+    // transition to write, write the packet that failed again, and finish the snapshot before writing a new one
     TestFixture tf(static_cast<unsigned int>(radio_state_t::write));
     tf.execUntilChange();              // write AAA
     tf.execUntilChange();              // transcieve A
@@ -543,12 +558,277 @@ void test_new_snap_after_sbdix_fail()
     }
 
     assert_radio_state(radio_state_t::write); // then it will transition to write
-    tf.execUntilChange();                     // it should be writing the NEW snapshot now and not DDDDD or CCCCC
+    TEST_ASSERT_EQUAL(2, tf.mo_queue_depth_fp->get()); // and queue the new snapshot
+    tf.execUntilChange();                     // it should be writing CCCCC again
+    check_buf_bytes(
+        "CCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCC",
+        tf.quake_manager->dbg_get_qct().dbg_get_MO_msg(), tf.quake_manager->dbg_get_qct().dbg_get_MO_len());
+    tf.execUntilChange();                     // transceive C
+    tf.execUntilChange();                     // write DDDD
+    tf.execUntilChange();                     // transceive D
+    tf.execUntilChange();                     // write EEEE
+    tf.execUntilChange();                     // transceive E
+    tf.execUntilChange();                     // it should be writing the NEW snapshot now
+    check_buf_bytes(
+        "1111111111111111111111111111111111111111111111111111111111111111111111",
+        tf.quake_manager->dbg_get_qct().dbg_get_MO_msg(), tf.quake_manager->dbg_get_qct().dbg_get_MO_len());
+    TEST_ASSERT_EQUAL(1, tf.mo_queue_depth_fp->get());
+    TEST_ASSERT_EQUAL(0, tf.mo_dropped_bytes_fp->get());
+}
+
+void test_event_snap_first()
+{
+    // If a snapshot carrying new events is produced while another snapshot is being written
+    TestFixture tf(static_cast<unsigned int>(radio_state_t::write));
+    tf.execUntilChange(); // write AAA
+    tf.radio_mo_packet_fp->set(snap2);
+    tf.snapshot_priority_fp->set(DownlinkProducer::event_priority);
+    tf.realSteps();       // request to transceive A
+    tf.snapshot_priority_fp->set(DownlinkProducer::normal_priority);
+    tf.radio_mo_packet_fp->set(snap3);
+    TEST_ASSERT_EQUAL(2, tf.mo_queue_depth_fp->get());
+    tf.execUntilChange(); // transceive A
+
+    // then expect the current snapshot to be finished before the event snapshot
+    for (size_t i = 0; i < 4; i++)
+    {
+        tf.execUntilChange(); // write BBB to EEE
+        tf.execUntilChange(); // transceive
+    }
+    tf.execUntilChange();
+    check_buf_bytes(
+        "1111111111111111111111111111111111111111111111111111111111111111111111",
+        tf.quake_manager->dbg_get_qct().dbg_get_MO_msg(), tf.quake_manager->dbg_get_qct().dbg_get_MO_len());
+    TEST_ASSERT_EQUAL(1, tf.mo_queue_depth_fp->get());
+}
+
+void test_queue_replaces_normal_snapshot()
+{
+    // If several normal snapshots are queued while one is being downlinked
+    TestFixture tf(static_cast<unsigned int>(radio_state_t::write));
+    tf.execUntilChange(); // write AAA
+    tf.radio_mo_packet_fp->set(snap2);
+    for (unsigned int i = 0; i < QuakeManager::mo_queue_capacity; i++)
+        tf.quake_manager->dbg_enqueue_snapshot(DownlinkProducer::normal_priority);
+    tf.radio_mo_packet_fp->set(snap3);
+    tf.quake_manager->dbg_enqueue_snapshot(DownlinkProducer::normal_priority);
+
+    // then expect only the newest one to wait behind the current one, without counting a drop
+    TEST_ASSERT_EQUAL(2, tf.mo_queue_depth_fp->get());
+    TEST_ASSERT_EQUAL(0, tf.mo_dropped_bytes_fp->get());
+    for (size_t i = 0; i < 5; i++)
+    {
+        tf.execUntilChange(); // transceive
+        tf.execUntilChange(); // write BBB to EEE, then the newest snapshot
+    }
+    check_buf_bytes(
+        "6666666666666666666666666666666666666666666666666666666666666666666666",
+        tf.quake_manager->dbg_get_qct().dbg_get_MO_msg(), tf.quake_manager->dbg_get_qct().dbg_get_MO_len());
+    TEST_ASSERT_EQUAL(1, tf.mo_queue_depth_fp->get());
+}
+
+void test_queue_drops_oldest_low_priority()
+{
+    // If the queue fills up while snapshots can't be downlinked
+    TestFixture tf(static_cast<unsigned int>(radio_state_t::write));
+    tf.execUntilChange(); // write AAA
+    const unsigned int capacity = QuakeManager::mo_queue_capacity;
+
+    // Queue one event snapshot, then a normal one, then fill the queue with event snapshots
+    tf.radio_mo_packet_fp->set(snap2);
+    tf.snapshot_priority_fp->set(DownlinkProducer::event_priority);
+    tf.realSteps();
+    tf.snapshot_priority_fp->set(DownlinkProducer::normal_priority);
+    tf.radio_mo_packet_fp->set(snap3);
+    tf.quake_manager->dbg_enqueue_snapshot(DownlinkProducer::normal_priority);
+    for (unsigned int i = 0; i < capacity - 3; i++)
+        tf.quake_manager->dbg_enqueue_snapshot(DownlinkProducer::event_priority);
+    TEST_ASSERT_EQUAL(capacity, tf.mo_queue_depth_fp->get());
+    TEST_ASSERT_EQUAL(0, tf.mo_dropped_bytes_fp->get());
+
+    // then expect the normal snapshot to be dropped to make room for an event snapshot
+    tf.quake_manager->dbg_enqueue_snapshot(DownlinkProducer::event_priority);
+    TEST_ASSERT_EQUAL(capacity, tf.mo_queue_depth_fp->get());
+    TEST_ASSERT_EQUAL(350, tf.mo_dropped_bytes_fp->get());
+
+    // and expect new normal snapshots to be dropped while only event snapshots are queued
+    tf.quake_manager->dbg_enqueue_snapshot(DownlinkProducer::normal_priority);
+    TEST_ASSERT_EQUAL(capacity, tf.mo_queue_depth_fp->get());
+    TEST_ASSERT_EQUAL(700, tf.mo_dropped_bytes_fp->get());
+
+    // and new event snapshots to wait rather than push out queued ones
+    tf.quake_manager->dbg_enqueue_snapshot(DownlinkProducer::event_priority);
+    TEST_ASSERT_EQUAL(capacity, tf.mo_queue_depth_fp->get());
+    TEST_ASSERT_EQUAL(700, tf.mo_dropped_bytes_fp->get());
+
+    // The snapshot being written is never dropped
+    for (size_t i = 0; i < 4; i++)
+    {
+        tf.execUntilChange(); // transceive
+        tf.execUntilChange(); // write BBB to EEE
+    }
+    check_buf_bytes(
+        "EEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEE",
+        tf.quake_manager->dbg_get_qct().dbg_get_MO_msg(), tf.quake_manager->dbg_get_qct().dbg_get_MO_len());
+    tf.execUntilChange(); // transceive
+    tf.execUntilChange(); // write the oldest event snapshot
     check_buf_bytes(
         "1111111111111111111111111111111111111111111111111111111111111111111111",
         tf.quake_manager->dbg_get_qct().dbg_get_MO_msg(), tf.quake_manager->dbg_get_qct().dbg_get_MO_len());
 }
 
+static const char *print_event(const unsigned int ccno, std::vector<ReadableStateFieldBase *> &data)
+{
+    return "event";
+}
+
+void test_event_delivery_confirmed()
+{
+    TestFixture tf(static_cast<unsigned int>(radio_state_t::write));
+    std::shared_ptr<ReadableStateField<unsigned int>> cycle_no_fp =
+        tf.registry.create_readable_field<unsigned int>("pan.cycle_no");
+    std::shared_ptr<ReadableStateField<bool>> data_fp = tf.registry.create_readable_field<bool>("event.data");
+    std::vector<ReadableStateFieldBase *> event_data = {data_fp.get()};
+    Event::ccno = cycle_no_fp.get();
+    EventStorage storage("event", 20, 2, event_data, print_event);
+    storage.add_events_to_registry(tf.registry);
+    tf.execUntilChange(); // write AAA
+
+    // If an occurrence is loaded into an event snapshot
+    storage.signal();
+    cycle_no_fp->set(TimedControlTaskBase::control_cycle_count + 1);
+    TEST_ASSERT_EQUAL(1, storage.prepare_downlink());
+    tf.radio_mo_packet_fp->set(snap2);
+    tf.snapshot_priority_fp->set(DownlinkProducer::event_priority);
+    tf.realSteps(); // request to transceive A
+    tf.snapshot_priority_fp->set(DownlinkProducer::normal_priority);
+
+    // then expect it to stay unconfirmed until the last packet of the event snapshot is sent
+    tf.execUntilChange(); // transceive A
+    for (size_t i = 0; i < 4; i++)
+    {
+        tf.execUntilChange(); // write BBB to EEE
+        tf.execUntilChange(); // transceive
+    }
+    for (size_t i = 0; i < 4; i++)
+    {
+        tf.execUntilChange(); // write 111 to 444
+        tf.execUntilChange(); // transceive
+    }
+    TEST_ASSERT_EQUAL(1, storage.num_unconfirmed());
+    tf.execUntilChange(); // write 555
+    tf.execUntilChange(); // transceive
+    TEST_ASSERT_EQUAL(0, storage.num_unconfirmed());
+
+    Event::ccno = nullptr;
+}
+
+void test_event_snapshots_wait_for_room()
+{
+    TestFixture tf(static_cast<unsigned int>(radio_state_t::disabled));
+    std::shared_ptr<ReadableStateField<unsigned int>> cycle_no_fp =
+        tf.registry.create_readable_field<unsigned int>("pan.cycle_no");
+    std::shared_ptr<ReadableStateField<bool>> data_fp = tf.registry.create_readable_field<bool>("event.data");
+    std::vector<ReadableStateFieldBase *> event_data = {data_fp.get()};
+    Event::ccno = cycle_no_fp.get();
+    EventStorage storage("event", 100, 1, event_data, print_event);
+    storage.add_events_to_registry(tf.registry);
+    const unsigned int capacity = QuakeManager::mo_queue_capacity;
+
+    // Runs a cycle like the downlink producer followed by the quake manager
+    auto cycle = [&]() {
+        TimedControlTaskBase::control_cycle_count++;
+        cycle_no_fp->set(TimedControlTaskBase::control_cycle_count);
+        tf.snapshot_priority_fp->set(storage.prepare_downlink() > 0 ?
+            DownlinkProducer::event_priority : DownlinkProducer::normal_priority);
+        tf.quake_manager->execute();
+    };
+
+    // If more occurrences are logged than the queue has room for while the radio is disabled
+    const unsigned int num_occurrences = capacity + 3;
+    for (unsigned int i = 0; i < num_occurrences; i++)
+        storage.signal();
+    const unsigned int first_ccno = TimedControlTaskBase::control_cycle_count + 1;
+    for (unsigned int i = 0; i < capacity; i++)
+        cycle();
+    TEST_ASSERT_EQUAL(capacity, tf.mo_queue_depth_fp->get());
+    TEST_ASSERT_EQUAL(num_occurrences - capacity, storage.num_unseen());
+
+    // then expect the queued event snapshots to stay, and the next ones to wait without counting a drop
+    for (unsigned int i = 0; i < 10; i++)
+    {
+        cycle();
+        TEST_ASSERT_EQUAL(capacity, tf.mo_queue_depth_fp->get());
+        TEST_ASSERT_EQUAL(0, tf.mo_dropped_bytes_fp->get());
+        TEST_ASSERT_EQUAL(num_occurrences - capacity, storage.num_unseen());
+        TEST_ASSERT_EQUAL(num_occurrences, storage.num_unconfirmed());
+    }
+
+    // and expect the queued snapshots to still confirm their occurrences
+    storage.confirm_downlink(first_ccno);
+    TEST_ASSERT_EQUAL(num_occurrences - 1, storage.num_unconfirmed());
+    storage.confirm_downlink(first_ccno + capacity - 1);
+    TEST_ASSERT_EQUAL(num_occurrences - capacity, storage.num_unconfirmed());
+    Event::ccno = nullptr;
+}
+
+void test_link_stats()
+{
+    // If a whole snapshot is downlinked over successful sessions
+    TestFixture tf(static_cast<unsigned int>(radio_state_t::write));
+    unsigned int cycles = 0;
+    for (size_t i = 0; i < 5; i++)
+    {
+        cycles += tf.execUntilChange(); // write
+        cycles += tf.execUntilChange(); // transceive
+    }
+
+    // then expect every session and byte to be counted
+    TEST_ASSERT_EQUAL(5, tf.quake_manager->sbdix_attempts_f.get());
+    TEST_ASSERT_EQUAL(5, tf.quake_manager->sbdix_successes_f.get());
+    TEST_ASSERT_EQUAL(350, tf.quake_manager->mo_bytes_f.get());
+    TEST_ASSERT_EQUAL(0, tf.quake_manager->mt_bytes_f.get());
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, tf.quake_manager->sbdix_success_avg_f.get());
+    TEST_ASSERT_EQUAL(cycles, tf.quake_manager->write_cycles_f.get() + tf.quake_manager->transceive_cycles_f.get());
+    TEST_ASSERT_EQUAL(0, tf.quake_manager->wait_cycles_f.get());
+
+    // and the snapshot, queued in the first cycle, to be delivered in the last one
+    TEST_ASSERT_EQUAL(cycles - 1, tf.quake_manager->delivery_latency_f.get());
+    TEST_ASSERT_EQUAL_FLOAT(cycles - 1, tf.quake_manager->delivery_latency_avg_f.get());
+
+    // A session that doesn't reach the network lowers the success average
+    tf.execUntilChange();                                            // write
+    tf.realSteps();                                                  // request to transceive
+    tf.quake_manager->dbg_get_qct().dbg_get_quake().sbdix_r[0] = 32; // but we have no network
+    tf.realSteps();
+    TEST_ASSERT_EQUAL(6, tf.quake_manager->sbdix_attempts_f.get());
+    TEST_ASSERT_EQUAL(5, tf.quake_manager->sbdix_successes_f.get());
+    TEST_ASSERT_EQUAL_FLOAT(1.0f - QuakeManager::stats_avg_weight, tf.quake_manager->sbdix_success_avg_f.get());
+}
+
+void test_delivery_latency_avg()
+{
+    // If two snapshots are delivered
+    TestFixture tf(static_cast<unsigned int>(radio_state_t::write));
+    for (size_t i = 0; i < 5; i++)
+    {
+        tf.execUntilChange(); // write
+        tf.execUntilChange(); // transceive
+    }
+    const float first = tf.quake_manager->delivery_latency_f.get();
+    TEST_ASSERT_EQUAL_FLOAT(first, tf.quake_manager->delivery_latency_avg_f.get());
+    for (size_t i = 0; i < 5; i++)
+    {
+        tf.execUntilChange(); // write
+        tf.execUntilChange(); // transceive
+    }
+
+    // then expect the first one to seed the average and the second one to be averaged in
+    const float second = tf.quake_manager->delivery_latency_f.get();
+    TEST_ASSERT_EQUAL_FLOAT(QuakeManager::stats_avg_weight * second + (1 - QuakeManager::stats_avg_weight) * first,
+                            tf.quake_manager->delivery_latency_avg_f.get());
+}
+
 void test_valid_initialization()
 {
     // If QuakeManager has just been created in disabled mode
@@ -619,7 +899,14 @@ int test_quake_manager()
     RUN_TEST(test_update_mo_same_snap);
     RUN_TEST(test_same_snap_after_sbdix_recovers);
     RUN_TEST(test_update_mo_load_new_snap);
-    RUN_TEST(test_new_snap_after_sbdix_fail);
+    RUN_TEST(test_resume_snap_after_sbdix_fail);
+    RUN_TEST(test_event_snap_first);
+    RUN_TEST(test_queue_replaces_normal_snapshot);
+    RUN_TEST(test_queue_drops_oldest_low_priority);
+    RUN_TEST(test_event_delivery_confirmed);
+    RUN_TEST(test_event_snapshots_wait_for_room);
+    RUN_TEST(test_link_stats);
+    RUN_TEST(test_delivery_latency_avg);
     RUN_TEST(test_valid_initialization);
     RUN_TEST(test_sbdrb);
     return UNITY_END();
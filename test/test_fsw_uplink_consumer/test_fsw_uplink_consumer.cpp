@@ -404,6 +404,52 @@ void test_mixed_validity_updates()
 }
 
 
+void test_duplicate_updates()
+{
+    TestFixture tf;
+    // If a packet updates a valid field and then updates another field twice
+    size_t idx = tf.field_map["pan.state"];
+    auto field = tf.registry.writable_fields[idx];
+    uint64_t old1 = field->get_bit_array().to_ullong();
+
+    size_t idx2 = tf.field_map["adcs.state"];
+    auto field2 = tf.registry.writable_fields[idx2];
+    uint64_t old2 = field2->get_bit_array().to_ullong();
+
+    size_t packet_size = field->get_bit_array().size() + 2*field2->get_bit_array().size() + 3*3;
+    size_t packet_bytes = (packet_size + 7)/8;
+
+    char backer[packet_bytes];
+    memset(backer, 0, packet_bytes);
+    bitstream out(backer, packet_bytes);
+
+    uint8_t new_field = 0x12;
+    tf.create_uplink(out, reinterpret_cast<char*>(&new_field), idx);
+    uint8_t new_field_2 = 0x3;
+    tf.create_uplink(out, reinterpret_cast<char*>(&new_field_2), idx2);
+    tf.create_uplink(out, reinterpret_cast<char*>(&new_field_2), idx2);
+
+    memcpy(tf.radio_mt_packet_fp->get(), backer, packet_bytes);
+    tf.radio_mt_packet_len_fp->set(packet_bytes);
+    tf.uplink_consumer->execute();
+
+    // Then no field is updated, not even the ones before the duplicate
+    TEST_ASSERT_EQUAL(old1, field->get_bit_array().to_ullong());
+    TEST_ASSERT_EQUAL(old2, field2->get_bit_array().to_ullong());
+    TEST_ASSERT_EQUAL(0, tf.radio_mt_packet_len_fp->get());
+
+    // And the same packet without the duplicate is applied
+    memset(backer, 0, packet_bytes);
+    out.reset();
+    tf.create_uplink(out, reinterpret_cast<char*>(&new_field), idx);
+    tf.create_uplink(out, reinterpret_cast<char*>(&new_field_2), idx2);
+    memcpy(tf.radio_mt_packet_fp->get(), backer, packet_bytes);
+    tf.radio_mt_packet_len_fp->set((out.byte_offset*8 + out.bit_offset + 7)/8);
+    tf.uplink_consumer->execute();
+
+    TEST_ASSERT_EQUAL(new_field, field->get_bit_array().to_ullong());
+    TEST_ASSERT_EQUAL(new_field_2, field2->get_bit_array().to_ullong());
+}
 
 int test_uplink_consumer() {
     UNITY_BEGIN();
@@ -416,6 +462,7 @@ int test_uplink_consumer() {
     RUN_TEST(test_perisist_mt_packet_len);
     RUN_TEST(test_update_writable_field);
     RUN_TEST(test_mixed_validity_updates);
+    RUN_TEST(test_duplicate_updates);
     return UNITY_END();
 }
 
@@ -4,6 +4,7 @@
 #include <gsw/parsers/src/UplinkProducer.h>
 
 #include "../custom_assertions.hpp"
+#include <algorithm>
 #include <fstream>
 #include <json.hpp>
 
@@ -102,6 +103,141 @@ void test_invalid_values()
     TEST_ASSERT_THROW(tf.uplink_producer->create_from_json(bs, "test/test_gsw_uplink_producer/test_3.json"));
 }
 
+// Test that single fields can be encoded directly by name
+void test_add_field_to_bitstream()
+{
+    TestFixture tf;
+    size_t arr_size = tf.uplink_producer->get_max_possible_packet_size();
+    char tmp [arr_size];
+    bitstream bs(tmp, arr_size);
+    memset(bs.stream, 0, bs.max_len);
+
+    const size_t field_index = tf.uplink_producer->field_map["pan.state"];
+    const size_t expected_bits = tf.uplink_producer->index_size + tf.uplink_producer->get_field_length(field_index);
+    TEST_ASSERT_EQUAL(expected_bits, tf.uplink_producer->add_field_to_bitstream(bs, "pan.state", nlohmann::json(7)));
+    TEST_ASSERT_EQUAL(7, tf.registry.writable_fields[field_index]->get_bit_array().to_ulong());
+
+    TEST_ASSERT_THROW(tf.uplink_producer->add_field_to_bitstream(bs, "not.a.field", nlohmann::json(1)));
+}
+
+// Test that packets can be created inline from parsed json
+void test_create_packet()
+{
+    TestFixture tf;
+    nlohmann::json commands = {{"pan.state", 7}, {"docksys.config_cmd", true}};
+    std::string packet;
+    TEST_ASSERT_NO_THROW(packet = tf.uplink_producer->create_packet(commands));
+
+    const size_t index_size = tf.uplink_producer->index_size;
+    const size_t packet_bits = 2 * index_size
+        + tf.uplink_producer->get_field_length(tf.uplink_producer->field_map["pan.state"])
+        + tf.uplink_producer->get_field_length(tf.uplink_producer->field_map["docksys.config_cmd"]);
+    TEST_ASSERT_EQUAL((packet_bits + 7) / 8, packet.size());
+
+    // The packet must be identical to the one created from a file
+    size_t arr_size = tf.uplink_producer->get_max_possible_packet_size();
+    char tmp [arr_size];
+    bitstream bs(tmp, arr_size);
+    tf.uplink_producer->create_from_json_object(bs, commands);
+    TEST_ASSERT_EQUAL(packet.size(), bs.max_len);
+    TEST_ASSERT_EQUAL_MEMORY(bs.stream, packet.data(), packet.size());
+
+    TEST_ASSERT_THROW(tf.uplink_producer->create_packet({{"not.a.field", 1}}));
+}
+
+// Test that field writes are packed into the fewest packets
+void test_pack_bins()
+{
+    // First fit decreasing needs four bins for these, but three suffice
+    std::vector<size_t> sizes = {4, 4, 4, 3, 3, 3, 3, 3, 3};
+    std::vector<size_t> bins = UplinkProducer::pack_bins(sizes, 10);
+    std::vector<size_t> loads(sizes.size(), 0);
+    for (size_t i = 0; i < sizes.size(); ++i) loads[bins[i]] += sizes[i];
+    TEST_ASSERT_EQUAL(2, *std::max_element(bins.begin(), bins.end()));
+    for (size_t load : loads) TEST_ASSERT_TRUE(load <= 10);
+
+    TEST_ASSERT_EQUAL(0, UplinkProducer::pack_bins({}, 10).size());
+}
+
+// Test that grouped fields share a packet
+void test_create_packets()
+{
+    TestFixture tf;
+    nlohmann::json commands = {{"adcs.state", 3}, {"pan.state", 7}, {"docksys.config_cmd", true}};
+    std::vector<std::string> packets;
+    TEST_ASSERT_NO_THROW(packets = tf.uplink_producer->create_packets(commands, {{"pan.state", "docksys.config_cmd"}}));
+    TEST_ASSERT_EQUAL(1, packets.size());
+
+    // The fields fit in one MT message, so they share a single valid packet
+    std::vector<char> tmp(packets[0].begin(), packets[0].end());
+    bitstream bs(tmp.data(), tmp.size());
+    TEST_ASSERT_TRUE(tf.uplink_producer->_validate_packet(bs));
+
+    TEST_ASSERT_THROW(tf.uplink_producer->create_packets(commands, {{"pan.state"}, {"pan.state"}}));
+}
+
+// Test that field writes that don't fit in one MT message are split over
+// several packets, each of which decodes back to the fields it contains
+void test_create_packets_split()
+{
+    TestFixture tf;
+
+    // Command every boolean and unsigned integer field to a value with a
+    // nonzero serialized code
+    nlohmann::json commands;
+    std::vector<WritableStateFieldBase*> fields;
+    for (WritableStateFieldBase* w : tf.registry.writable_fields) {
+        if (dynamic_cast<WritableStateField<bool>*>(w)) commands[w->name()] = true;
+        else if (auto f = dynamic_cast<WritableStateField<unsigned int>*>(w)) {
+            if (f->get_serializer_max() == f->get_serializer_min()) continue;
+            commands[w->name()] = f->get_serializer_max();
+        }
+        else if (auto f = dynamic_cast<WritableStateField<unsigned char>*>(w)) {
+            if (f->get_serializer_max() == f->get_serializer_min()) continue;
+            commands[w->name()] = f->get_serializer_max();
+        }
+        else continue;
+        fields.push_back(w);
+    }
+
+    const std::vector<std::vector<std::string>> groups = {{"pan.state", "docksys.config_cmd"}};
+    std::vector<std::string> packets;
+    TEST_ASSERT_NO_THROW(packets = tf.uplink_producer->create_packets(commands, groups));
+    TEST_ASSERT_TRUE(packets.size() > 1);
+
+    // Encoding leaves each field's code in its bit array
+    std::vector<bit_array> expected;
+    for (WritableStateFieldBase* w : fields) expected.push_back(w->get_bit_array());
+
+    // Decode each packet into cleared fields. The fields it sets must hold
+    // their commanded codes, and every field must be set by exactly one packet.
+    std::vector<int> packet_of(fields.size(), -1);
+    for (size_t p = 0; p < packets.size(); ++p) {
+        TEST_ASSERT_TRUE(packets[p].size() <= QuakeManager::packet_size);
+        for (WritableStateFieldBase* w : fields) w->set_bit_array(bit_array(w->bitsize()));
+
+        std::vector<char> tmp(packets[p].begin(), packets[p].end());
+        bitstream bs(tmp.data(), tmp.size());
+        TEST_ASSERT_TRUE(tf.uplink_producer->_validate_packet(bs));
+        tf.uplink_producer->_update_fields(bs);
+
+        for (size_t i = 0; i < fields.size(); ++i) {
+            if (fields[i]->get_bit_array().to_ullong() == 0) continue;
+            TEST_ASSERT_EQUAL(-1, packet_of[i]);
+            TEST_ASSERT_TRUE(expected[i] == fields[i]->get_bit_array());
+            packet_of[i] = p;
+        }
+    }
+    for (int p : packet_of) TEST_ASSERT_NOT_EQUAL(-1, p);
+
+    // Grouped fields land in the same packet
+    const auto index_of = [&](const std::string& name) {
+        return std::find_if(fields.begin(), fields.end(),
+            [&](WritableStateFieldBase* w) { return w->name() == name; }) - fields.begin();
+    };
+    TEST_ASSERT_EQUAL(packet_of[index_of("pan.state")], packet_of[index_of("docksys.config_cmd")]);
+}
+
 int main() {
     UNITY_BEGIN();
     RUN_TEST(test_task_initialization);
@@ -110,5 +246,10 @@ int main() {
     RUN_TEST(test_to_file_invalid);
     RUN_TEST(test_create_sbd_from_json);
     RUN_TEST(test_invalid_values);
+    RUN_TEST(test_add_field_to_bitstream);
+    RUN_TEST(test_create_packet);
+    RUN_TEST(test_pack_bins);
+    RUN_TEST(test_create_packets);
+    RUN_TEST(test_create_packets_split);
     return UNITY_END();
 }